@@ -40,6 +40,32 @@
 
 #include "ParseSUMDRawFrame.h"
 
+/*
+ * fixed block pool of frames, a frame is taken by parseSUMDFrame() and
+ * returned by destroySUMDFrame(). No heap is used, so parsing a frame
+ * takes constant time and can not fragment the memory.
+ */
+static struct SUMD_Frame sumdFramePool[SUMD_FRAME_POOL_SIZE];
+static struct SUMD_Frame* sumdFreeFrames[SUMD_FRAME_POOL_SIZE];
+static int sumdFreeCount = -1; //-1 until the free list is built
+
+/*
+ * takes a frame of the pool
+ * @return
+ * 	pointer on a free frame, NULL if all frames are in use
+ */
+static struct SUMD_Frame* getSUMDFrame(void) {
+	int i=0;
+	if (sumdFreeCount < 0) {
+		for (i = 0; i < SUMD_FRAME_POOL_SIZE; i++)
+			sumdFreeFrames[i] = &sumdFramePool[i];
+		sumdFreeCount = SUMD_FRAME_POOL_SIZE;
+	}
+	if (sumdFreeCount == 0)
+		return NULL;
+	return sumdFreeFrames[--sumdFreeCount];
+}
+
 /*
  * checks crc 16 of received raw frame data
  * @parameters
@@ -75,15 +101,15 @@ uint8_t crcRawFrameData(uchar_t* receivedRawFrameData) {
  * 	raw byte data of a recieved sumd frame as unsigned char pointer
  * @return
  * 	pointer on filled sumd_frame struct if crc was good
- *	-1 if crc was wrong
+ *	0 if crc was wrong or all SUMD_FRAME_POOL_SIZE frames are in use
  */
 struct SUMD_Frame* parseSUMDFrame(uchar_t* receivedRawFrameData) {
 
 	/* check the frame and crc for a valid HoTT SUMD data */
 	if (crcRawFrameData(receivedRawFrameData)) {
 
-		//allocate memory for sumdFrame
-		struct SUMD_Frame* sumdFrame = malloc(sizeof(struct SUMD_Frame));
+		//take a frame of the pool
+		struct SUMD_Frame* sumdFrame = getSUMDFrame();
 
 		if (sumdFrame != NULL) {
 			//fill sumdFrame
@@ -111,13 +137,16 @@ struct SUMD_Frame* parseSUMDFrame(uchar_t* receivedRawFrameData) {
 }
 
 /*
- * destroys and frees the memory of a SUMD_Frame Pointer
+ * destroys a SUMD_Frame Pointer and returns the frame to the pool
  * @parameters
  * 	pointer on SUMD_Frame
  */
 void destroySUMDFrame(struct SUMD_Frame* sumdFrame) {
-	if (sumdFrame != NULL) {
-		free(sumdFrame);
+	//ignore pointers which are not part of the pool
+	if (sumdFrame >= &sumdFramePool[0]
+			&& sumdFrame < &sumdFramePool[SUMD_FRAME_POOL_SIZE]
+			&& sumdFreeCount >= 0 && sumdFreeCount < SUMD_FRAME_POOL_SIZE) {
+		sumdFreeFrames[sumdFreeCount++] = sumdFrame;
 	}
 }
 
@@ -7,6 +7,9 @@
 
 #include "SUMD.h"
 
+//number of frames which can be in use at the same time
+#define SUMD_FRAME_POOL_SIZE 4
+
 /**
  * HSUM protocol documentation
  *
@@ -64,7 +67,7 @@ uint8_t crcRawFrameData(uchar_t* receivedRawFrameData);
  * 	raw byte data of a recieved sumd frame as unsigned char pointer
  * @return
  * 	pointer on filled sumd_frame struct if crc was good
- *	-1 if crc was wrong
+ *	0 if crc was wrong or all SUMD_FRAME_POOL_SIZE frames are in use
  */
 struct SUMD_Frame* parseSUMDFrame(uchar_t* receivedRawFrameData);
 
@@ -76,7 +79,7 @@ struct SUMD_Frame* parseSUMDFrame(uchar_t* receivedRawFrameData);
 void printSUMDFrame(struct SUMD_Frame* sumdFrame);
 
 /*
- * destroys and frees the memory of a SUMD_Frame Pointer
+ * destroys a SUMD_Frame Pointer and returns the frame to the pool
  * @parameters
  * 	pointer on SUMD_Frame
  */
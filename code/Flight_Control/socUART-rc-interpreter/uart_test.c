@@ -117,7 +117,7 @@ int main()
 				channel2 = (parsedFrame->channel_data[2] - 8800) * 0.03984375; //15200 - 8800 = 6400
 				//printf("normalized Channel 2: %d \n", channel2);
 				PWMDriver_setSignalWidth(channel2, PWM_1);
-				destroySUMDFrame(parsedFrame); //free the in parseSUMDFrame() allocated Memory. Required to prevent a Memoryleak
+				destroySUMDFrame(parsedFrame); //return the frame taken by parseSUMDFrame() to the pool. Required, the pool has only SUMD_FRAME_POOL_SIZE frames
 			}else
 			{
 				printf("CRC ERROR");
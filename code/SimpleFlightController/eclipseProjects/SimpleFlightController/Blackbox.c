@@ -0,0 +1,136 @@
+/*
+ * Blackbox flight recorder.
+ * <p>
+ * Only the mixer stage writes frames and changes the state from recording
+ * to frozen. Blackbox_trigger() only posts the reason, Blackbox_dump() and
+ * Blackbox_rearm() only work on a frozen record.
+ */
+
+//-----------------------Includes----------------------------------------------
+#include <stddef.h>
+#include "Blackbox.h"
+#include "Drivers/Driver_Timer.h"
+#include "b_errorcodes.h"
+
+//-----------------------Defines-----------------------------------------------
+#define BB_FRAME_MASK	(BB_FRAME_COUNT - 1)
+
+// The layout is precomputed, fail the build if the frame does not match.
+typedef char Blackbox_frameSizeCheck[
+		(sizeof(struct BlackboxFrame) == BB_FRAME_SIZE) ? 1 : -1];
+
+//-----------------------Attributes--------------------------------------------
+static struct BlackboxFrame Blackbox_frames[BB_FRAME_COUNT];
+static uint32_t Blackbox_head = 0;		// frames written since the last rearm
+static uint32_t Blackbox_triggerFrame = 0;
+static uint32_t Blackbox_remaining = 0;	// frames to record until frozen
+static volatile enum BlackboxTrigger Blackbox_pendingTrigger = BB_TRIGGER_NONE;
+static enum BlackboxTrigger Blackbox_reason = BB_TRIGGER_NONE;
+static volatile enum BlackboxState Blackbox_state = BB_RECORDING;
+
+//-----------------------Method Implementation---------------------------------
+struct BlackboxFrame *Blackbox_begin() {
+	struct BlackboxFrame *frame;
+
+	if (Blackbox_state == BB_FROZEN) {
+		return NULL;
+	}
+	frame = &Blackbox_frames[Blackbox_head & BB_FRAME_MASK];
+	frame->timestamp = TimerDriver_getTimestamp();
+	return frame;
+}
+
+void Blackbox_end() {
+	struct BlackboxFrame *frame;
+	uint32_t accSquared;
+
+	if (Blackbox_state == BB_FROZEN) {
+		return;
+	}
+	frame = &Blackbox_frames[Blackbox_head & BB_FRAME_MASK];
+	accSquared = (uint32_t) ((int32_t) frame->acc[0] * frame->acc[0])
+			+ (uint32_t) ((int32_t) frame->acc[1] * frame->acc[1])
+			+ (uint32_t) ((int32_t) frame->acc[2] * frame->acc[2]);
+	if (accSquared > BB_CRASH_ACC_SQUARED) {
+		Blackbox_trigger(BB_TRIGGER_CRASH);
+	}
+
+	if (Blackbox_state == BB_RECORDING
+			&& Blackbox_pendingTrigger != BB_TRIGGER_NONE) {
+		Blackbox_reason = Blackbox_pendingTrigger;
+		Blackbox_triggerFrame = Blackbox_head;
+		Blackbox_remaining = BB_POST_TRIGGER_FRAMES;
+		Blackbox_state = BB_TRIGGERED;
+	}
+	Blackbox_head++;
+	if (Blackbox_state == BB_TRIGGERED && --Blackbox_remaining == 0) {
+		Blackbox_state = BB_FROZEN;
+	}
+}
+
+void Blackbox_trigger(enum BlackboxTrigger trigger) {
+	if (Blackbox_pendingTrigger == BB_TRIGGER_NONE) {
+		Blackbox_pendingTrigger = trigger;
+	}
+}
+
+/*
+ * Sends length bytes with the sink, retries partial writes.
+ */
+static int8_t Blackbox_send(TelemetrySink sink, const uint8_t *buffer,
+		uint32_t length) {
+	int32_t sent;
+
+	while (length > 0) {
+		sent = sink(buffer, length);
+		if (sent < 0) {
+			return ERR_BB_DUMP;
+		}
+		buffer += sent;
+		length -= sent;
+	}
+	return NO_ERR;
+}
+
+int8_t Blackbox_dump(TelemetrySink sink) {
+	struct BlackboxHeader header;
+	uint32_t first;
+	uint32_t i;
+
+	if (Blackbox_state != BB_FROZEN) {
+		return ERR_BB_WRONG_STATE;
+	}
+	// The oldest frame is at index 0 until the ring wrapped around once.
+	first = (Blackbox_head > BB_FRAME_COUNT) ? Blackbox_head - BB_FRAME_COUNT : 0;
+
+	header.magic = BB_MAGIC;
+	header.frameSize = BB_FRAME_SIZE;
+	header.trigger = Blackbox_reason;
+	header.reserved = 0;
+	header.frameCount = Blackbox_head - first;
+	header.triggerFrame = Blackbox_triggerFrame - first;
+	if (Blackbox_send(sink, (const uint8_t *) &header, sizeof(header)) != NO_ERR) {
+		return ERR_BB_DUMP;
+	}
+	for (i = first; i != Blackbox_head; i++) {
+		if (Blackbox_send(sink, (const uint8_t *) &Blackbox_frames[i & BB_FRAME_MASK],
+				BB_FRAME_SIZE) != NO_ERR) {
+			return ERR_BB_DUMP;
+		}
+	}
+	return NO_ERR;
+}
+
+void Blackbox_rearm() {
+	if (Blackbox_state != BB_FROZEN) {
+		return;
+	}
+	Blackbox_head = 0;
+	Blackbox_reason = BB_TRIGGER_NONE;
+	Blackbox_pendingTrigger = BB_TRIGGER_NONE;
+	Blackbox_state = BB_RECORDING;
+}
+
+enum BlackboxState Blackbox_getState() {
+	return Blackbox_state;
+}
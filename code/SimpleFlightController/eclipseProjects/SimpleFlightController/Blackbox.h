@@ -0,0 +1,124 @@
+/*
+ * Blackbox flight recorder.
+ * <p>
+ * The mixer stage writes one frame with a fixed layout per control cycle
+ * into a large ring in SDRAM. The frame is filled in place, so recording
+ * costs a timestamp, the stores of the values and an index increment.
+ * After a trigger (crash, disarm, rc switch) BB_POST_TRIGGER_FRAMES more
+ * frames are recorded, then the ring is frozen until it has been dumped
+ * and Blackbox_rearm() is called.
+ * <p>
+ * Dump format (little endian): struct BlackboxHeader followed by
+ * frameCount frames of BB_FRAME_SIZE bytes, oldest frame first.
+ * tools/blackboxdecode.py converts a dump to CSV.
+ */
+
+#ifndef BLACKBOX_H_
+#define BLACKBOX_H_
+
+//-----------------------Includes----------------------------------------------
+#include "stdint.h" // Include stdint.h for the use of Integers with a defined size
+#include "Telemetry.h"
+
+//-----------------------Defines-----------------------------------------------
+#define BB_FRAME_SIZE			64		// bytes, sizeof(struct BlackboxFrame)
+#define BB_FRAME_COUNT			65536	// 4 MB, 131 seconds at 500 Hz, has to be a power of two
+#define BB_POST_TRIGGER_FRAMES	500		// frames recorded after a trigger
+
+#define BB_MAGIC				0x31424258	// "XBB1"
+
+// A frame with |acc|^2 above this value triggers BB_TRIGGER_CRASH.
+// Raw accelerometer values, 256 LSB/g: 8 g.
+#define BB_CRASH_ACC_SQUARED	(8UL * 256 * 8 * 256)
+
+//-----------------------Attributes--------------------------------------------
+enum BlackboxState {
+	BB_RECORDING, BB_TRIGGERED, BB_FROZEN
+};
+
+enum BlackboxTrigger {
+	BB_TRIGGER_NONE, BB_TRIGGER_CRASH, BB_TRIGGER_DISARM, BB_TRIGGER_RC_SWITCH
+};
+
+/*
+ * One control cycle. The layout is fixed, tools/blackboxdecode.py has to
+ * match it.
+ */
+struct BlackboxFrame {
+	uint32_t timestamp;		// see Driver_Timer.h
+	int16_t acc[3];			// raw sensor values
+	int16_t gyro[3];
+	int16_t mag[3];
+	int16_t attitude[3];	// estimator output
+	int16_t rate[3];
+	int16_t setpoint[3];	// controller input
+	int16_t throttle;
+	uint16_t rc[6];			// rc channels
+	uint8_t motor[6];		// motor speed
+	uint8_t flags;
+	uint8_t reserved[3];
+};
+
+struct BlackboxHeader {
+	uint32_t magic;
+	uint16_t frameSize;
+	uint8_t trigger;
+	uint8_t reserved;
+	uint32_t frameCount;
+	uint32_t triggerFrame;	// index of the trigger frame in the dump
+};
+
+//-----------------------Method Declaration------------------------------------
+/**
+ * This function gets the frame for the current control cycle.
+ * <p>
+ * The caller fills the frame and calls Blackbox_end() afterwards. The
+ * timestamp is already set. It has to be called by one task only.
+ *
+ * @return	The frame or NULL if the recorder is frozen.
+ */
+struct BlackboxFrame *Blackbox_begin();
+
+/**
+ * This function appends the frame of Blackbox_begin() to the record.
+ * <p>
+ * It checks the frame for a crash.
+ */
+void Blackbox_end();
+
+/**
+ * This function triggers the recorder.
+ * <p>
+ * The recorder freezes after BB_POST_TRIGGER_FRAMES further frames.
+ * Following triggers are ignored until Blackbox_rearm().
+ *
+ * @param	trigger	The reason.
+ */
+void Blackbox_trigger(enum BlackboxTrigger trigger);
+
+/**
+ * This function sends the frozen record to a sink.
+ * <p>
+ * It blocks until everything is sent and should be called by a low
+ * priority task.
+ *
+ * @param	sink	The function the bytes are sent with.
+ * @return	ERR_BB_WRONG_STATE	If the recorder is not frozen.
+ * 			ERR_BB_DUMP			If the sink reported an error.
+ * 			NO_ERR				If everything is fine.
+ */
+int8_t Blackbox_dump(TelemetrySink sink);
+
+/**
+ * This function discards the record and starts recording again.
+ */
+void Blackbox_rearm();
+
+/**
+ * This function gets the state of the recorder.
+ *
+ * @return	The state.
+ */
+enum BlackboxState Blackbox_getState();
+
+#endif /* BLACKBOX_H_ */
@@ -0,0 +1,144 @@
+/*
+ * Zero-copy message channels between tasks.
+ * <p>
+ * Every channel has one producer, which is the only writer of its counters.
+ */
+
+//-----------------------Includes----------------------------------------------
+#include <stddef.h>
+#include "Channel.h"
+#include "Logger.h"
+#include "b_errorcodes.h"
+
+//-----------------------Method Implementation---------------------------------
+int8_t Channel_initPool(struct ChannelPool *pool) {
+	INT8U err;
+
+	if (pool->blocks < 2 || pool->blocks > 0xFFFF) {
+		return ERR_CH_ILLEGAL_RANGE;
+	}
+	pool->partition = OSMemCreate(pool->memory, pool->blocks, pool->blockSize,
+			&err);
+	if (err != OS_NO_ERR) {
+		return ERR_CH_OS;
+	}
+	pool->free = OSSemCreate((INT16U) pool->blocks);
+	if (pool->free == NULL) {
+		return ERR_CH_OS;
+	}
+	return NO_ERR;
+}
+
+int8_t Channel_init(struct Channel *channel) {
+	channel->queue = OSQCreate(channel->entries, channel->depth);
+	if (channel->queue == NULL) {
+		return ERR_CH_OS;
+	}
+	channel->statistic.posted = 0;
+	channel->statistic.dropped = 0;
+	channel->statistic.exhausted = 0;
+	channel->statistic.highWater = 0;
+	return NO_ERR;
+}
+
+void *Channel_alloc(struct Channel *channel, uint32_t timeout) {
+	struct ChannelPool *pool = channel->pool;
+	INT8U err;
+
+	if (OSSemAccept(pool->free) == 0) {
+		channel->statistic.exhausted++;
+		if (timeout == CHANNEL_NO_WAIT) {
+			return NULL;
+		}
+		OSSemPend(pool->free, timeout > 0xFFFF ? 0xFFFF : (INT16U) timeout,
+				&err);
+		if (err != OS_NO_ERR) {
+			return NULL;
+		}
+	}
+	// The semaphore guarantees a free block.
+	return OSMemGet(pool->partition, &err);
+}
+
+int8_t Channel_post(struct Channel *channel, void *message) {
+	struct ChannelStatistic *statistic = &channel->statistic;
+	void *oldest;
+	INT16U entries;
+	INT8U err;
+
+	if (OSQPost(channel->queue, message) == OS_Q_FULL) {
+		statistic->dropped++;
+		if (channel->mode == CHANNEL_QUEUE) {
+			Channel_release(channel, message);
+			return ERR_CH_FULL;
+		}
+		oldest = OSQAccept(channel->queue, &err);
+		if (oldest != NULL) {
+			Channel_release(channel, oldest);
+		}
+		if (OSQPost(channel->queue, message) == OS_Q_FULL) {
+			Channel_release(channel, message);
+			return ERR_CH_FULL;
+		}
+	}
+	statistic->posted++;
+
+	// A consumer with a higher priority already took the message, so this
+	// is the depth seen by consumers with a lower priority.
+	entries = ((OS_Q *) channel->queue->OSEventPtr)->OSQEntries;
+	if (entries > statistic->highWater) {
+		statistic->highWater = entries;
+	}
+	return NO_ERR;
+}
+
+void *Channel_receive(struct Channel *channel, uint32_t timeout) {
+	void *message;
+	INT8U err;
+
+	if (timeout == CHANNEL_NO_WAIT) {
+		return OSQAccept(channel->queue, &err);
+	}
+	message = OSQPend(channel->queue,
+			timeout > 0xFFFF ? 0xFFFF : (INT16U) timeout, &err);
+	if (err != OS_NO_ERR) {
+		return NULL;
+	}
+	return message;
+}
+
+int8_t Channel_release(struct Channel *channel, void *message) {
+	struct ChannelPool *pool = channel->pool;
+	uint8_t *memory = pool->memory;
+
+	if ((uint8_t *) message < memory
+			|| (uint8_t *) message >= memory + pool->blocks * pool->blockSize) {
+		return ERR_CH_ILLEGAL_BLOCK;
+	}
+	if (OSMemPut(pool->partition, message) != OS_NO_ERR) {
+		return ERR_CH_ILLEGAL_BLOCK;
+	}
+	OSSemPost(pool->free);
+	return NO_ERR;
+}
+
+int8_t Channel_publish(struct Channel * const *channels, uint8_t count) {
+	const struct ChannelStatistic *statistic;
+	uint32_t exhausted;
+	int8_t result = NO_ERR;
+	uint8_t i;
+
+	for (i = 0; i < count; i++) {
+		statistic = &channels[i]->statistic;
+		exhausted = statistic->exhausted;
+		if (exhausted > 0xFFFF) {
+			exhausted = 0xFFFF;
+		}
+		if (Logger_write(LOG_PRODUCER_SYSTEM, LOG_ID_CHANNEL + i,
+				((uint32_t) statistic->highWater << 16) | exhausted,
+				statistic->dropped) != NO_ERR) {
+			result = ERR_LOG_RING_FULL;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,179 @@
+/*
+ * Zero-copy message channels between tasks.
+ * <p>
+ * A channel pool is a uC/OS-II memory partition of blocks of one message
+ * type, a channel is a uC/OS-II queue of pointers to these blocks. The
+ * producer takes a block with Channel_alloc(), fills it and posts the
+ * pointer with Channel_post(). The consumer takes it with Channel_receive()
+ * and returns it with Channel_release(). A consumer can also post the block
+ * to the next channel of the same pool, so a message is never copied.
+ * <p>
+ * A counting semaphore of the free blocks gives back-pressure: when the
+ * pool is exhausted, Channel_alloc() waits until a consumer releases a
+ * block. A channel in CHANNEL_LATEST mode never blocks its producer, when
+ * its queue is full the oldest message is dropped and the new one is
+ * queued, e.g. for sensor data where only the latest value counts. A
+ * channel in CHANNEL_QUEUE mode keeps the oldest messages and drops the new
+ * one.
+ * <p>
+ * The counters of every channel are logged (producer LOG_PRODUCER_SYSTEM)
+ * by Channel_publish() with LOG_ID_CHANNEL + index in the table, data[0]:
+ * queue depth high water mark << 16 | allocations that found the pool
+ * exhausted, data[1]: dropped messages.
+ * <p>
+ * Usage:
+ *   CHANNEL_POOL(samplePool, struct Sample, 4);
+ *   CHANNEL(sampleChannel, samplePool, 1, CHANNEL_LATEST);
+ *   Channel_initPool(&samplePool); Channel_init(&sampleChannel);
+ *   producer:
+ *     struct Sample *sample = Channel_alloc(&sampleChannel, CHANNEL_NO_WAIT);
+ *     ... Channel_post(&sampleChannel, sample);
+ *   consumer:
+ *     struct Sample *sample = Channel_receive(&sampleChannel, CHANNEL_FOREVER);
+ *     ... Channel_release(&sampleChannel, sample);
+ */
+
+#ifndef CHANNEL_H_
+#define CHANNEL_H_
+
+//-----------------------Includes----------------------------------------------
+#include "stdint.h" // Include stdint.h for the use of Integers with a defined size
+#include "includes.h"
+
+//-----------------------Defines-----------------------------------------------
+/* ---- Timeouts in OS ticks ---- */
+#define CHANNEL_FOREVER			0
+#define CHANNEL_NO_WAIT			0xFFFFFFFF
+
+/* ---- Log record ids ---- */
+#define LOG_ID_CHANNEL			0x0160
+
+/*
+ * Defines a pool of blocks of a message type. Every producer and consumer
+ * holding a block and every queue entry of the channels of the pool needs
+ * one block.
+ */
+#define CHANNEL_POOL(pool, type, count) \
+	static uint32_t pool##_memory[count][(sizeof(type) + 3) / 4]; \
+	static struct ChannelPool pool = { pool##_memory, count, \
+			((sizeof(type) + 3) / 4) * 4 }
+
+/*
+ * Defines a channel of depth messages of the blocks of pool.
+ */
+#define CHANNEL(channel, pool, depth, mode) \
+	static void *channel##_entries[depth]; \
+	static struct Channel channel = { #channel, &pool, mode, \
+			channel##_entries, depth }
+
+//-----------------------Attributes--------------------------------------------
+enum ChannelMode {
+	CHANNEL_QUEUE,	// a full channel drops the new message
+	CHANNEL_LATEST	// a full channel drops the oldest message
+};
+
+struct ChannelPool {
+	void *memory;
+	uint32_t blocks;
+	uint32_t blockSize;			// in bytes, a multiple of 4
+	OS_MEM *partition;			// set by Channel_initPool()
+	OS_EVENT *free;				// counts the free blocks
+};
+
+struct ChannelStatistic {
+	uint32_t posted;
+	uint32_t dropped;			// messages dropped because the channel was full
+	uint32_t exhausted;			// Channel_alloc() calls that found no free block
+	uint16_t highWater;			// maximum number of queued messages
+};
+
+struct Channel {
+	const char *name;
+	struct ChannelPool *pool;
+	enum ChannelMode mode;
+	void **entries;
+	uint16_t depth;
+	OS_EVENT *queue;			// set by Channel_init()
+	struct ChannelStatistic statistic;
+};
+
+//-----------------------Method Declaration------------------------------------
+/**
+ * This function creates the memory partition and the semaphore of a pool.
+ * <p>
+ * It has to be called before the channels of the pool are used.
+ *
+ * @param	pool	The pool.
+ * @return	ERR_CH_ILLEGAL_RANGE	If the pool has less than two blocks.
+ * 			ERR_CH_OS				If the partition or the semaphore could
+ * 									not be created.
+ * 			NO_ERR					If everything is fine.
+ */
+int8_t Channel_initPool(struct ChannelPool *pool);
+
+/**
+ * This function creates the queue of a channel.
+ *
+ * @param	channel	The channel.
+ * @return	ERR_CH_OS	If the queue could not be created.
+ * 			NO_ERR		If everything is fine.
+ */
+int8_t Channel_init(struct Channel *channel);
+
+/**
+ * This function takes a free block of the pool of a channel.
+ * <p>
+ * If the pool is exhausted it waits until a block is released.
+ *
+ * @param	channel	The channel.
+ * 			timeout	The maximum time to wait in OS ticks, CHANNEL_FOREVER
+ * 					or CHANNEL_NO_WAIT.
+ * @return	The block or NULL if no block was released in time.
+ */
+void *Channel_alloc(struct Channel *channel, uint32_t timeout);
+
+/**
+ * This function posts a block to a channel.
+ * <p>
+ * The block has to be taken from the pool of the channel. It is owned by
+ * the channel afterwards, also if it was dropped.
+ *
+ * @param	channel	The channel.
+ * 			message	The block.
+ * @return	ERR_CH_FULL	If the channel is in CHANNEL_QUEUE mode and full, the
+ * 						block was released.
+ * 			NO_ERR		If the block was queued.
+ */
+int8_t Channel_post(struct Channel *channel, void *message);
+
+/**
+ * This function takes the oldest message of a channel.
+ *
+ * @param	channel	The channel.
+ * 			timeout	The maximum time to wait in OS ticks, CHANNEL_FOREVER
+ * 					or CHANNEL_NO_WAIT.
+ * @return	The message or NULL if no message was posted in time.
+ */
+void *Channel_receive(struct Channel *channel, uint32_t timeout);
+
+/**
+ * This function returns a block to the pool of a channel.
+ *
+ * @param	channel	The channel.
+ * 			message	The block.
+ * @return	ERR_CH_ILLEGAL_BLOCK	If the block is not part of the pool.
+ * 			NO_ERR					If everything is fine.
+ */
+int8_t Channel_release(struct Channel *channel, void *message);
+
+/**
+ * This function sends the counters of the channels to the logger.
+ *
+ * @param	channels	The table of the channels.
+ * 			count		The number of channels.
+ * @return	ERR_LOG_RING_FULL	If records were dropped.
+ * 			NO_ERR				If everything is fine.
+ */
+int8_t Channel_publish(struct Channel * const *channels, uint8_t count);
+
+#endif /* CHANNEL_H_ */
@@ -0,0 +1,270 @@
+/*
+ * Non-blocking console on the JTAG UART.
+ * <p>
+ * The tasks write the ring under the scheduler lock and only move head, the
+ * interrupt handler only moves tail. Both indexes run freely and are masked
+ * on access. The console lock is a semaphore with the priority of its
+ * owner, so the owner can write and nest Console_lock() without waiting
+ * for itself. Only the owner sets or clears Console_owner to its priority.
+ */
+
+//-----------------------Includes----------------------------------------------
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/alt_irq.h>
+#include <sys/alt_dev.h>
+#include <priv/alt_file.h>
+#include <priv/alt_irq_table.h>
+#include "altera_avalon_jtag_uart.h"
+#include "altera_avalon_jtag_uart_regs.h"
+#include "includes.h"
+#include "Console.h"
+#include "Logger.h"
+#include "b_errorcodes.h"
+
+//-----------------------Defines-----------------------------------------------
+#define CONSOLE_TX_MASK		(CONSOLE_TX_SIZE - 1)
+
+// Keeps the compiler from moving the ring stores behind the head update.
+#define CONSOLE_BARRIER()	__asm__ __volatile__("" ::: "memory")
+
+#define CONSOLE_NO_OWNER	OS_PRIO_SELF
+
+//-----------------------Attributes--------------------------------------------
+static int Console_writeFd(alt_fd *fd, const char *buffer, int length);
+
+static char Console_ring[CONSOLE_TX_SIZE];
+static volatile uint32_t Console_head = 0;	// written by the tasks
+static volatile uint32_t Console_tail = 0;	// written by the interrupt handler
+static struct ConsoleStatistic Console_statistic;
+static uint8_t Console_realtimePriority;
+static OS_EVENT *Console_lockSem;
+static volatile INT8U Console_owner = CONSOLE_NO_OWNER;	// priority of the task holding the lock
+static uint8_t Console_nesting = 0;
+
+static altera_avalon_jtag_uart_state *Console_uart;	// state of the HAL driver
+static void (*Console_halIsr)(void *context);		// receive side
+
+static alt_dev Console_dev = {
+	ALT_LLIST_ENTRY, CONSOLE_NAME, NULL, NULL, NULL, Console_writeFd, NULL,
+	NULL, NULL
+};
+
+//-----------------------Method Implementation---------------------------------
+static int Console_writeFd(alt_fd *fd, const char *buffer, int length) {
+	return Console_write(buffer, length);
+}
+
+/*
+ * Handler of the JTAG UART interrupt. The HAL driver reads the receive
+ * FIFO and turns the write interrupt off when its own buffer is empty,
+ * so the console turns it on again as long as the ring has data.
+ */
+static void Console_isr(void *context) {
+	uint32_t base = Console_uart->base;
+	uint32_t head = Console_head;
+	uint32_t tail = Console_tail;
+	uint32_t space;
+
+	Console_halIsr(context);
+
+	space = (IORD_ALTERA_AVALON_JTAG_UART_CONTROL(base)
+			& ALTERA_AVALON_JTAG_UART_CONTROL_WSPACE_MSK)
+			>> ALTERA_AVALON_JTAG_UART_CONTROL_WSPACE_OFST;
+	while (space > 0 && tail != head) {
+		IOWR_ALTERA_AVALON_JTAG_UART_DATA(base, Console_ring[tail & CONSOLE_TX_MASK]);
+		tail++;
+		space--;
+	}
+	Console_tail = tail;
+
+	if (tail != head) {
+		Console_uart->irq_enable |= ALTERA_AVALON_JTAG_UART_CONTROL_WE_MSK;
+		IOWR_ALTERA_AVALON_JTAG_UART_CONTROL(base, Console_uart->irq_enable);
+	}
+}
+
+/*
+ * Turns the write interrupt on, the interrupt handler sends the ring.
+ */
+static void Console_kick() {
+	alt_irq_context context = alt_irq_disable_all();
+
+	Console_uart->irq_enable |= ALTERA_AVALON_JTAG_UART_CONTROL_WE_MSK;
+	IOWR_ALTERA_AVALON_JTAG_UART_CONTROL(Console_uart->base,
+			Console_uart->irq_enable);
+	alt_irq_enable_all(context);
+}
+
+/*
+ * Copies length bytes to the ring, the caller holds the scheduler lock and
+ * checked the space.
+ */
+static void Console_copy(const char *buffer, uint32_t length) {
+	uint32_t head = Console_head;
+	uint32_t offset = head & CONSOLE_TX_MASK;
+	uint32_t first = CONSOLE_TX_SIZE - offset;
+
+	if (first > length) {
+		first = length;
+	}
+	memcpy(&Console_ring[offset], buffer, first);
+	memcpy(Console_ring, buffer + first, length - first);
+	CONSOLE_BARRIER();
+	Console_head = head + length;
+
+	if (Console_head - Console_tail > Console_statistic.highWater) {
+		Console_statistic.highWater = Console_head - Console_tail;
+	}
+}
+
+/*
+ * Takes the console lock without waiting, returns 0 if another task holds
+ * it.
+ */
+static uint8_t Console_tryLock() {
+	if (Console_owner == OSTCBCur->OSTCBPrio) {
+		Console_nesting++;
+		return 1;
+	}
+	if (OSSemAccept(Console_lockSem) == 0) {
+		return 0;
+	}
+	Console_owner = OSTCBCur->OSTCBPrio;
+	Console_nesting = 1;
+	return 1;
+}
+
+int8_t Console_init(uint8_t realtimePriority) {
+	Console_realtimePriority = realtimePriority;
+	Console_lockSem = OSSemCreate(1);
+	if (Console_lockSem == NULL) {
+		return ERR_CON_OS;
+	}
+	Console_halIsr = alt_irq[JTAG_UART_CPU_S0_IRQ].handler;
+	Console_uart = alt_irq[JTAG_UART_CPU_S0_IRQ].context;
+	if (Console_halIsr == NULL || Console_uart == NULL) {
+		return ERR_CON_IRQ;
+	}
+	if (alt_ic_isr_register(JTAG_UART_CPU_S0_IRQ_INTERRUPT_CONTROLLER_ID,
+			JTAG_UART_CPU_S0_IRQ, Console_isr, Console_uart, NULL) != 0) {
+		return ERR_CON_IRQ;
+	}
+	alt_dev_reg(&Console_dev);
+	alt_fd_list[STDOUT_FILENO].dev = &Console_dev;
+	alt_fd_list[STDERR_FILENO].dev = &Console_dev;
+	return NO_ERR;
+}
+
+int Console_write(const char *buffer, int length) {
+	uint32_t remaining = length;
+	uint32_t chunk;
+
+	if (length <= 0) {
+		return length;
+	}
+
+	// The ring is not locked against interrupts.
+	if (OSIntNesting > 0) {
+		Console_statistic.droppedWrites++;
+		Console_statistic.droppedBytes += length;
+		return length;
+	}
+
+	// Before OSStart() the scheduler lock does nothing, but main() is the
+	// only writer.
+	if (!OSRunning) {
+		if (remaining > CONSOLE_TX_SIZE - (Console_head - Console_tail)) {
+			Console_statistic.droppedWrites++;
+			Console_statistic.droppedBytes += remaining;
+			return length;
+		}
+		Console_copy(buffer, remaining);
+		Console_kick();
+		return length;
+	}
+
+	if (OSTCBCur->OSTCBPrio <= Console_realtimePriority) {
+		if (!Console_tryLock()) {
+			OSSchedLock();
+			Console_statistic.droppedWrites++;
+			Console_statistic.droppedBytes += remaining;
+			OSSchedUnlock();
+			return length;
+		}
+		OSSchedLock();
+		if (remaining > CONSOLE_TX_SIZE - (Console_head - Console_tail)) {
+			Console_statistic.droppedWrites++;
+			Console_statistic.droppedBytes += remaining;
+			OSSchedUnlock();
+			Console_unlock();
+			return length;
+		}
+		Console_copy(buffer, remaining);
+		OSSchedUnlock();
+		Console_unlock();
+		Console_kick();
+		return length;
+	}
+
+	// The lock keeps the other writers out while this one waits for space.
+	Console_lock();
+	while (remaining > 0) {
+		OSSchedLock();
+		chunk = CONSOLE_TX_SIZE - (Console_head - Console_tail);
+		if (chunk > remaining) {
+			chunk = remaining;
+		}
+		if (chunk > 0) {
+			Console_copy(buffer, chunk);
+		}
+		OSSchedUnlock();
+
+		if (chunk > 0) {
+			Console_kick();
+			buffer += chunk;
+			remaining -= chunk;
+		} else {
+			OSTimeDly(1);
+		}
+	}
+	Console_unlock();
+	return length;
+}
+
+void Console_lock() {
+	INT8U err;
+
+	if (Console_owner == OSTCBCur->OSTCBPrio) {
+		Console_nesting++;
+		return;
+	}
+	OSSemPend(Console_lockSem, 0, &err);
+	Console_owner = OSTCBCur->OSTCBPrio;
+	Console_nesting = 1;
+}
+
+void Console_unlock() {
+	if (Console_owner != OSTCBCur->OSTCBPrio) {
+		return;
+	}
+	if (--Console_nesting == 0) {
+		Console_owner = CONSOLE_NO_OWNER;
+		OSSemPost(Console_lockSem);
+	}
+}
+
+void Console_getStatistic(struct ConsoleStatistic *statistic) {
+	OSSchedLock();
+	*statistic = Console_statistic;
+	OSSchedUnlock();
+}
+
+int8_t Console_publish() {
+	struct ConsoleStatistic statistic;
+
+	Console_getStatistic(&statistic);
+	return Logger_write(LOG_PRODUCER_SYSTEM, LOG_ID_CONSOLE,
+			statistic.droppedWrites, statistic.droppedBytes);
+}
@@ -0,0 +1,111 @@
+/*
+ * Non-blocking console on the JTAG UART.
+ * <p>
+ * Console_init() registers the device CONSOLE_NAME and connects stdout and
+ * stderr to it, so every printf() goes through the console. The text is
+ * copied into a large transmit ring (CONSOLE_TX_SIZE bytes in SDRAM) and
+ * sent to the JTAG UART by its write interrupt. The HAL driver of the
+ * JTAG UART keeps handling the receive side (stdin).
+ * <p>
+ * Real-time callers never wait: tasks with the real-time priority passed to
+ * Console_init() or a higher one drop the whole write if it does not fit
+ * into the ring. Other tasks wait with OSTimeDly() until the ring has
+ * space. Writes from interrupt service routines are always dropped.
+ * <p>
+ * Every write is kept in one piece: the writers hold the console lock
+ * while they copy, so a write of a task that waits for space is not split
+ * by another task. A real-time caller drops its write while another task
+ * holds the lock. Console_lock() keeps the console for a sequence of writes
+ * (e.g. a binary dump), the writes of other tasks wait or are dropped
+ * until Console_unlock().
+ * Dropped writes and bytes are counted and logged (producer
+ * LOG_PRODUCER_SYSTEM) by Console_publish() with LOG_ID_CONSOLE,
+ * data[0]: dropped writes, data[1]: dropped bytes.
+ * <p>
+ * The logger shares the JTAG UART with the console, it has to be started
+ * with LOG_OUTPUT_CONSOLE, the HAL driver would interleave its bytes with
+ * the console. The logger writes every batch of records with one write, so
+ * the records and the text lines do not split each other.
+ */
+
+#ifndef CONSOLE_H_
+#define CONSOLE_H_
+
+//-----------------------Includes----------------------------------------------
+#include "stdint.h" // Include stdint.h for the use of Integers with a defined size
+
+//-----------------------Defines-----------------------------------------------
+#define CONSOLE_NAME			"/dev/console"
+
+// bytes, has to be a power of two. Can be set with APP_CFLAGS_DEFINED_SYMBOLS.
+#ifndef CONSOLE_TX_SIZE
+#define CONSOLE_TX_SIZE			32768
+#endif
+
+/* ---- Log record ids ---- */
+#define LOG_ID_CONSOLE			0x0170
+
+//-----------------------Attributes--------------------------------------------
+struct ConsoleStatistic {
+	uint32_t droppedWrites;
+	uint32_t droppedBytes;
+	uint32_t highWater;		// maximum number of bytes in the ring
+};
+
+//-----------------------Method Declaration------------------------------------
+/**
+ * This function registers the console, connects stdout and stderr to it
+ * and takes over the write interrupt of the JTAG UART.
+ * <p>
+ * It has to be called in main() before the first output.
+ *
+ * @param	realtimePriority	Tasks with this or a higher priority never
+ * 								wait for the ring.
+ * @return	ERR_CON_OS	If the lock could not be created.
+ * 			ERR_CON_IRQ	If the interrupt handler could not be registered.
+ * 			NO_ERR		If everything is fine.
+ */
+int8_t Console_init(uint8_t realtimePriority);
+
+/**
+ * This function writes to the console.
+ * <p>
+ * It is also called by the HAL for writes to stdout, stderr and every file
+ * descriptor opened with CONSOLE_NAME.
+ *
+ * @param	buffer	The bytes.
+ * 			length	The number of bytes.
+ * @return	length, also if the bytes were dropped.
+ */
+int Console_write(const char *buffer, int length);
+
+/**
+ * This function takes the console for a sequence of writes.
+ * <p>
+ * It waits until no other task writes. The calls can be nested, the
+ * console is free again after the same number of Console_unlock() calls.
+ * It must not be called by real-time tasks.
+ */
+void Console_lock();
+
+/**
+ * This function frees the console taken with Console_lock().
+ */
+void Console_unlock();
+
+/**
+ * This function returns the statistic of the console.
+ *
+ * @param	statistic	The statistic is written to this struct.
+ */
+void Console_getStatistic(struct ConsoleStatistic *statistic);
+
+/**
+ * This function sends the drop counters to the logger.
+ *
+ * @return	ERR_LOG_RING_FULL	If the record was dropped.
+ * 			NO_ERR				If everything is fine.
+ */
+int8_t Console_publish();
+
+#endif /* CONSOLE_H_ */
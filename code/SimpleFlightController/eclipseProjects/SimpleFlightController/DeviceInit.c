@@ -0,0 +1,64 @@
+/*
+ * Parallel initialization of devices.
+ */
+
+//-----------------------Includes----------------------------------------------
+#include "DeviceInit.h"
+#include "Logger.h"
+#include "Trace.h"
+#include "HiresTimer.h"
+#include "includes.h"
+#include "Drivers/Driver_Timer.h"
+#include "b_errorcodes.h"
+
+//-----------------------Method Implementation---------------------------------
+int8_t DeviceInit_run(struct DeviceInitStep *devices, uint8_t count) {
+	uint32_t now = TimerDriver_getTimestamp();
+	uint32_t wait;
+	uint32_t nextWait;
+	uint32_t nextReadyAt = now;
+	uint8_t pending = count;
+	int8_t result = NO_ERR;
+	uint8_t i;
+
+	for (i = 0; i < count; i++) {
+		devices[i].readyAt = now;
+		devices[i].result = INIT_PENDING;
+	}
+
+	while (pending > 0) {
+		nextWait = 0xFFFFFFFF;
+		for (i = 0; i < count; i++) {
+			if (devices[i].result != INIT_PENDING) {
+				continue;
+			}
+			wait = TimerDriver_usUntil(devices[i].readyAt);
+			if (wait == 0) {
+				devices[i].result = devices[i].step(&devices[i].readyAt);
+				if (devices[i].result != INIT_PENDING) {
+					pending--;
+					Logger_write(LOG_PRODUCER_SYSTEM, LOG_ID_DEVICE_READY + i,
+							TimerDriver_ticksToUs(TimerDriver_getTimestamp()),
+							(uint32_t) (int32_t) devices[i].result);
+					if (devices[i].result != NO_ERR) {
+						TRACE("DeviceInit: device %u failed with %d\n", i,
+								devices[i].result);
+						if (result == NO_ERR) {
+							result = devices[i].result;
+						}
+					}
+					continue;
+				}
+				wait = TimerDriver_usUntil(devices[i].readyAt);
+			}
+			if (wait < nextWait) {
+				nextWait = wait;
+				nextReadyAt = devices[i].readyAt;
+			}
+		}
+		if (pending > 0) {
+			HiresTimer_sleepUntil(nextReadyAt);
+		}
+	}
+	return result;
+}
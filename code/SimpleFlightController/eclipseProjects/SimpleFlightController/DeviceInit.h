@@ -0,0 +1,48 @@
+/*
+ * Parallel initialization of devices.
+ * <p>
+ * Every device provides an init step function. A step never blocks: while
+ * the device is settling it returns INIT_PENDING and the timestamp (see
+ * Driver_Timer.h) at which it has to be called again. DeviceInit_run()
+ * calls the steps of all devices that are due and sleeps with
+ * HiresTimer_sleepUntil() until the next one is due, so the settle times
+ * of the devices overlap and the whole initialization takes about as long
+ * as the slowest device.
+ * <p>
+ * Every finished device is logged (producer LOG_PRODUCER_SYSTEM) with
+ * LOG_ID_DEVICE_READY + index in the table, data[0]: time since start in
+ * us, data[1]: result of the init step.
+ */
+
+#ifndef DEVICEINIT_H_
+#define DEVICEINIT_H_
+
+//-----------------------Includes----------------------------------------------
+#include "stdint.h" // Include stdint.h for the use of Integers with a defined size
+
+//-----------------------Defines-----------------------------------------------
+#define LOG_ID_DEVICE_READY		0x0130
+
+//-----------------------Attributes--------------------------------------------
+struct DeviceInitStep {
+	const char *name;
+	int8_t (*step)(uint32_t *readyAt);	// NO_ERR, INIT_PENDING or an error code
+	uint32_t readyAt;					// set by DeviceInit_run()
+	int8_t result;						// set by DeviceInit_run()
+};
+
+//-----------------------Method Declaration------------------------------------
+/**
+ * This function initializes all devices of the table in parallel.
+ * <p>
+ * It returns when every device is initialized or failed. A failed device
+ * does not stop the other devices. It has to be called from a task.
+ *
+ * @param	devices	The table of the devices.
+ * 			count	The number of devices.
+ * @return	The error code of the first device that failed or NO_ERR if
+ * 			every device is initialized.
+ */
+int8_t DeviceInit_run(struct DeviceInitStep *devices, uint8_t count);
+
+#endif /* DEVICEINIT_H_ */
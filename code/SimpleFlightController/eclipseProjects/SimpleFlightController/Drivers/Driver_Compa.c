@@ -8,11 +8,13 @@
 //-----------------------Includes----------------------------------------------
 #include "Driver_Compa.h"
 #include "Driver_I2C.h"
+#include "Driver_Timer.h"
 #include "../b_errorcodes.h"
 #include <unistd.h>
 
 //-----------------------Attributes--------------------------------------------
 enum CompassState compassState = COMPASS_NOTAVAILABLE;
+static uint32_t compassReadyAt;
 
 const int counts_per_milligauss[8] =
 		{ 1370, 1090, 820, 660, 440, 390, 330, 230 };
@@ -27,44 +29,75 @@ float x_scale, y_scale, z_scale, x_max, y_max, z_max;
 
 //-----------------------Method Implementation---------------------------------
 int8_t Compass_init() {
-	/* Check if module was already initialized */
-	if (compassState == COMPASS_INITIALIZED) {
-		return NO_ERR;
-	}
-	I2CDriver_init();
+	uint32_t readyAt;
+	int8_t result;
 
-	if (I2CDriver_open(I2C_400) == ERR_I2C_WRONG_STATE) {
-		I2CDriver_close();
-		return ERR_I2C_ACCESS_DENIED;
+	while ((result = Compass_initStep(&readyAt)) == INIT_PENDING) {
+		usleep(TimerDriver_usUntil(readyAt));
 	}
+	return result;
+}
 
-	usleep(5000); // wait 5ms to initialize the magnetometer
+int8_t Compass_initStep(uint32_t *readyAt) {
+	switch (compassState) {
+	case COMPASS_INITIALIZED:
+		/* Check if module was already initialized */
+		return NO_ERR;
 
-	// Set 8-average, 15 Hz default
-	if (I2CDriver_write2Bytes(HMC5883L_DEVICE_ADDR,
-			HMC5883L_CONFIGURATION_REGISTER_A, 0x70) != NO_ERR) {
-		I2CDriver_close();
-		return ERR_I2C_CONNECTION;
-	}
+	case COMPASS_NOTAVAILABLE:
+		// wait 5ms to initialize the magnetometer
+		compassReadyAt = TimerDriver_getTimestamp()
+				+ COMPASS_POWERUP_TIME * TIMERDRIVER_TICKS_PER_US;
+		compassState = COMPASS_POWERUP;
+		break;
 
-	// Set Gain = 5
-	if (I2CDriver_write2Bytes(HMC5883L_DEVICE_ADDR,
-			HMC5883L_CONFIGURATION_REGISTER_B, 0xA0) != NO_ERR) {
-		I2CDriver_close();
-		return ERR_I2C_CONNECTION;
-	}
+	case COMPASS_POWERUP:
+		if (TimerDriver_usUntil(compassReadyAt) > 0) {
+			break;
+		}
+		I2CDriver_init();
+
+		if (I2CDriver_open(I2C_400) == ERR_I2C_WRONG_STATE) {
+			I2CDriver_close();
+			return ERR_I2C_ACCESS_DENIED;
+		}
+
+		// Set 8-average, 15 Hz default
+		if (I2CDriver_write2Bytes(HMC5883L_DEVICE_ADDR,
+				HMC5883L_CONFIGURATION_REGISTER_A, 0x70) != NO_ERR) {
+			I2CDriver_close();
+			return ERR_I2C_CONNECTION;
+		}
+
+		// Set Gain = 5
+		if (I2CDriver_write2Bytes(HMC5883L_DEVICE_ADDR,
+				HMC5883L_CONFIGURATION_REGISTER_B, 0xA0) != NO_ERR) {
+			I2CDriver_close();
+			return ERR_I2C_CONNECTION;
+		}
+
+		// continuous measurement mode
+		if (I2CDriver_write2Bytes(HMC5883L_DEVICE_ADDR, HMC5883L_MODE_REGISTER,
+				0x00) != NO_ERR) {
+			I2CDriver_close();
+			return ERR_I2C_CONNECTION;
+		}
 
-	// continuous measurement mode
-	if (I2CDriver_write2Bytes(HMC5883L_DEVICE_ADDR, HMC5883L_MODE_REGISTER,
-			0x00) != NO_ERR) {
 		I2CDriver_close();
-		return ERR_I2C_CONNECTION;
-	}
+		compassReadyAt = TimerDriver_getTimestamp()
+				+ COMPASS_SETTLE_TIME * TIMERDRIVER_TICKS_PER_US;
+		compassState = COMPASS_SETTLING;
+		break;
 
-	I2CDriver_close();
-	usleep(100000);
-	compassState = COMPASS_INITIALIZED;
-	return NO_ERR;
+	case COMPASS_SETTLING:
+		if (TimerDriver_usUntil(compassReadyAt) > 0) {
+			break;
+		}
+		compassState = COMPASS_INITIALIZED;
+		return NO_ERR;
+	}
+	*readyAt = compassReadyAt;
+	return INIT_PENDING;
 }
 
 int8_t Compass_getRawValues(int16_t *Xdata, int16_t *Ydata, int16_t *Zdata) {
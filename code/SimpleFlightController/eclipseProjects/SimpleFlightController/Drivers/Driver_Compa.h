@@ -36,9 +36,12 @@
 #define HMC_POS_BIAS 1
 #define HMC_NEG_BIAS 2
 
+#define COMPASS_POWERUP_TIME	5000	// us before the first access
+#define COMPASS_SETTLE_TIME		100000	// us after the configuration until the values are valid
+
 //-----------------------Attributes--------------------------------------------
 enum CompassState {
-	COMPASS_NOTAVAILABLE, COMPASS_INITIALIZED
+	COMPASS_NOTAVAILABLE, COMPASS_POWERUP, COMPASS_SETTLING, COMPASS_INITIALIZED
 };
 
 //-----------------------Method Declaration------------------------------------
@@ -46,6 +49,8 @@ enum CompassState {
  * This function initialize the compass sensor and all needed other components.
  * <p>
  * You have to call this Function before you first use the Compass Sensor.
+ * It waits until the sensor has settled, see Compass_initStep() for an
+ * initialization that does not block.
  *
  * @return  ERR_I2C_ACCESS_DENIED	If the I2C driver could not be opened.
  * 			ERR_I2C_CONNECTION		If an error happened while a transaction.
@@ -53,6 +58,22 @@ enum CompassState {
  */
 int8_t Compass_init();
 
+/**
+ * This function does the next step of the compass initialization.
+ * <p>
+ * The sensor is configured after COMPASS_POWERUP_TIME and is ready
+ * COMPASS_SETTLE_TIME later. Until then the function returns INIT_PENDING
+ * and the time it has to be called again.
+ *
+ * @param	readyAt	Stores the timestamp (see Driver_Timer.h) of the next
+ * 					step if INIT_PENDING is returned.
+ * @return  ERR_I2C_ACCESS_DENIED	If the I2C driver could not be opened.
+ * 			ERR_I2C_CONNECTION		If an error happened while a transaction.
+ * 			INIT_PENDING			If the compass is not ready yet.
+ * 			NO_ERR					If the compass is initialized.
+ */
+int8_t Compass_initStep(uint32_t *readyAt);
+
 /**
  * Call this function to get all raw values of the compass sensor.
  *
@@ -8,6 +8,7 @@
 #include <unistd.h>
 #include "Driver_I2C.h"
 #include "Driver_Gyro.h"
+#include "Driver_Timer.h"
 #include "../b_errorcodes.h"
 
 //-----------------------Constants---------------------------------------------
@@ -19,12 +20,31 @@ char DLPF_FS_SEL_1 = 1 << 4;
 
 //-----------------------Attributes--------------------------------------------
 enum GyroscopeState Gyroscope_state = GYRO_NOTAVAILABLE;
+static uint32_t Gyroscope_readyAt;
 
 //-----------------------Method Implementation---------------------------------
 int8_t Gyroscope_init() {
+	uint32_t readyAt;
+	int8_t result;
+
+	while ((result = Gyroscope_initStep(&readyAt)) == INIT_PENDING) {
+		usleep(TimerDriver_usUntil(readyAt));
+	}
+	return result;
+}
+
+int8_t Gyroscope_initStep(uint32_t *readyAt) {
 	if (Gyroscope_state == GYRO_INITIALIZED) {
 		return NO_ERR;
 	}
+	if (Gyroscope_state == GYRO_SETTLING) {
+		if (TimerDriver_usUntil(Gyroscope_readyAt) > 0) {
+			*readyAt = Gyroscope_readyAt;
+			return INIT_PENDING;
+		}
+		Gyroscope_state = GYRO_INITIALIZED;
+		return NO_ERR;
+	}
 	I2CDriver_init();
 	if (I2CDriver_open(I2C_400) == ERR_I2C_WRONG_STATE) {
 		I2CDriver_close();
@@ -67,9 +87,12 @@ int8_t Gyroscope_init() {
 	}
 
 	I2CDriver_close();
-	Gyroscope_state = GYRO_INITIALIZED;
-	usleep(80000);
-	return NO_ERR;
+	// The PLL needs GYRO_SETTLE_TIME to lock.
+	Gyroscope_readyAt = TimerDriver_getTimestamp()
+			+ GYRO_SETTLE_TIME * TIMERDRIVER_TICKS_PER_US;
+	Gyroscope_state = GYRO_SETTLING;
+	*readyAt = Gyroscope_readyAt;
+	return INIT_PENDING;
 }
 
 int8_t getGyroAll(int16_t *dataTemp, int16_t *dataX, int16_t *dataY,
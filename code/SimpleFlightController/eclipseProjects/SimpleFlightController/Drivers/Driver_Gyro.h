@@ -27,16 +27,20 @@
 #define GYRO_ZOUT_L        0x22
 
 #define PWR_MGM            0x3E  // RW	Power Management
+
+#define GYRO_SETTLE_TIME	80000	// us after the configuration until the values are valid
 //-----------------------Attributes--------------------------------------------
 enum GyroscopeState {
-	GYRO_NOTAVAILABLE, GYRO_INITIALIZED
+	GYRO_NOTAVAILABLE, GYRO_SETTLING, GYRO_INITIALIZED
 };
 
 //-----------------------Method Declaration------------------------------------
 /**
  * This function initializes the gyroscope sensor.
  * <p>
- * It has to be called before reading the values.
+ * It has to be called before reading the values. It waits until the
+ * gyroscope has settled, see Gyroscope_initStep() for an initialization
+ * that does not block.
  *
  * @return	ERR_I2C_ACCESS_DENIED	If the I2C driver could not be opened.
  * 			ERR_I2C_CONNECTION		If an error happened while a transaction.
@@ -44,6 +48,21 @@ enum GyroscopeState {
  */
 int8_t Gyroscope_init();
 
+/**
+ * This function does the next step of the gyroscope initialization.
+ * <p>
+ * The first call configures the gyroscope. Until it has settled the
+ * function returns INIT_PENDING and the time it has to be called again.
+ *
+ * @param	readyAt	Stores the timestamp (see Driver_Timer.h) of the next
+ * 					step if INIT_PENDING is returned.
+ * @return	ERR_I2C_ACCESS_DENIED	If the I2C driver could not be opened.
+ * 			ERR_I2C_CONNECTION		If an error happened while a transaction.
+ * 			INIT_PENDING			If the gyroscope is settling.
+ * 			NO_ERR					If the gyroscope is initialized.
+ */
+int8_t Gyroscope_initStep(uint32_t *readyAt);
+
 /**
  * This function reads all values of the gyroscope.
  *
@@ -5,9 +5,14 @@
 //-----------------------Includes----------------------------------------------
 #include "Driver_Motor.h"
 #include "Driver_PWM.h"
+#include "Driver_Timer.h"
 #include "../b_errorcodes.h"
 #include <stdio.h>
 
+//-----------------------Attributes--------------------------------------------
+enum MotorDriverState MotorDriver_state = MOTOR_NOTARMED;
+static uint32_t MotorDriver_readyAt;
+
 //-----------------------Method Implementation---------------------------------
 /*
  * Function init initializes the Motordriver.
@@ -28,6 +33,30 @@ int8_t MotorDriver_init() {
 	return NO_ERR;
 }
 
+/*
+ * Arms the controllers with the lowest speed.
+ */
+int8_t MotorDriver_armStep(uint32_t *readyAt) {
+	switch (MotorDriver_state) {
+	case MOTOR_NOTARMED:
+		MotorDriver_setSpeedOfAllMotors(1);
+		MotorDriver_readyAt = TimerDriver_getTimestamp()
+				+ MOTORDRIVER_ARM_TIME * TIMERDRIVER_TICKS_PER_US;
+		MotorDriver_state = MOTOR_ARMING;
+		break;
+	case MOTOR_ARMING:
+		if (TimerDriver_usUntil(MotorDriver_readyAt) > 0) {
+			break;
+		}
+		MotorDriver_state = MOTOR_ARMED;
+		return NO_ERR;
+	case MOTOR_ARMED:
+		return NO_ERR;
+	}
+	*readyAt = MotorDriver_readyAt;
+	return INIT_PENDING;
+}
+
 /*
  * Sets the motor speed in a range of 1 to 254.
  */
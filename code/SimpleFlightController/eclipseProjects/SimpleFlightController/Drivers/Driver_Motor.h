@@ -11,6 +11,9 @@
 //-----------------------Includes----------------------------------------------
 #include "../stdint.h"
 
+//-----------------------Defines-----------------------------------------------
+#define MOTORDRIVER_ARM_TIME	2000000	// us of lowest speed until the controllers are armed
+
 //-----------------------Attributes--------------------------------------------
 enum Motor {
 	Motor_Front_Left,
@@ -21,6 +24,10 @@ enum Motor {
 	Motor_Back_Right
 };
 
+enum MotorDriverState {
+	MOTOR_NOTARMED, MOTOR_ARMING, MOTOR_ARMED
+};
+
 //-----------------------Method Declaration------------------------------------
 /**
  * Function init initializes the Motordriver.
@@ -32,6 +39,21 @@ enum Motor {
  */
 int8_t MotorDriver_init();
 
+/**
+ * Function armStep does the next step of arming the motor controllers.
+ * <p>
+ * The first call sets all motors to the lowest speed. The controllers are
+ * armed after MOTORDRIVER_ARM_TIME, until then the function returns
+ * INIT_PENDING and the time it has to be called again. The controllers have
+ * to be calibrated once with MotorDriver_init().
+ *
+ * @param	readyAt	Stores the timestamp (see Driver_Timer.h) of the next
+ * 					step if INIT_PENDING is returned.
+ * @return	INIT_PENDING	If the controllers are arming.
+ * 			NO_ERR			If the controllers are armed.
+ */
+int8_t MotorDriver_armStep(uint32_t *readyAt);
+
 /**
  * Function setSpeed.
  * <p>
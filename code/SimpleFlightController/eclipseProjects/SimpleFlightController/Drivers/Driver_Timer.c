@@ -0,0 +1,448 @@
+/*
+ * This driver provides a high resolution timestamp and the control loop
+ * timebase based on the system timer of the cpu (timer_cpu_s0).
+ */
+
+//-----------------------Includes----------------------------------------------
+#include <stddef.h>
+#include "Driver_Timer.h"
+#include <altera_avalon_timer_regs.h>
+#include <sys/alt_irq.h>
+#include <sys/alt_alarm.h>
+#include "includes.h"
+#include "../b_errorcodes.h"
+
+//-----------------------Defines-----------------------------------------------
+#define TIMERDRIVER_CONTROL_RUN	(ALTERA_AVALON_TIMER_CONTROL_ITO_MSK \
+		| ALTERA_AVALON_TIMER_CONTROL_CONT_MSK \
+		| ALTERA_AVALON_TIMER_CONTROL_START_MSK)
+
+//-----------------------Attributes--------------------------------------------
+enum TimerDriverState TimerDriver_state = TIMER_SYSTEMTICK;
+
+static volatile uint32_t TimerDriver_period;		// length of the running period
+static volatile uint32_t TimerDriver_base;			// timestamp of the last interrupt
+static volatile uint32_t TimerDriver_loaded = TIMERDRIVER_PERIOD;	// period register of the timer
+static uint32_t TimerDriver_nextTick;				// timestamp of the next OS tick
+static uint8_t TimerDriver_inIsr = 0;
+
+static uint32_t TimerDriver_controlPeriod;			// timestamp ticks per release
+static uint32_t TimerDriver_nextRelease;			// timestamp of the next release
+static volatile int32_t TimerDriver_phaseShift = 0;	// requested shift in ticks
+
+static OS_EVENT *TimerDriver_release;
+static volatile uint32_t TimerDriver_releaseTimestamp;
+static volatile uint32_t TimerDriver_overruns = 0;
+static uint32_t TimerDriver_minLatency = 0xFFFFFFFF;
+static uint32_t TimerDriver_maxLatency = 0;
+
+static uint8_t TimerDriver_samples = 0;			// sample interrupts per control period
+static uint8_t TimerDriver_sampleIndex;
+static uint8_t TimerDriver_samplePending = 0;
+static uint32_t TimerDriver_slot;					// ticks per sample slot
+static uint32_t TimerDriver_lastRelease;			// timestamp of the last release
+static uint32_t TimerDriver_nextSample;				// timestamp of the next sample
+static uint32_t TimerDriver_random = 0x2545F491;
+static void (*TimerDriver_sampleHook)(void);
+
+static uint32_t TimerDriver_oneShotAt;				// timestamp of the one-shot interrupt
+static void (*volatile TimerDriver_oneShotHook)(void);	// NULL if not armed
+
+//-----------------------Method Implementation---------------------------------
+/*
+ * Reads the counter, the timer counts down from the loaded period - 1 to 0.
+ */
+static uint32_t TimerDriver_readSnapshot() {
+	// A write to one of the snapshot registers latches the current counter.
+	IOWR_ALTERA_AVALON_TIMER_SNAPL(TIMERDRIVER_BASE, 0);
+	return (IORD_ALTERA_AVALON_TIMER_SNAPL(TIMERDRIVER_BASE) & 0xFFFF)
+			| ((IORD_ALTERA_AVALON_TIMER_SNAPH(TIMERDRIVER_BASE) & 0xFFFF) << 16);
+}
+
+/*
+ * Loads a new period, writing the period registers stops and reloads the
+ * counter, so the timer has to be started again.
+ */
+static void TimerDriver_loadPeriod(uint32_t period) {
+	TimerDriver_loaded = period;
+	IOWR_ALTERA_AVALON_TIMER_PERIODL(TIMERDRIVER_BASE, (period - 1) & 0xFFFF);
+	IOWR_ALTERA_AVALON_TIMER_PERIODH(TIMERDRIVER_BASE, (period - 1) >> 16);
+	IOWR_ALTERA_AVALON_TIMER_CONTROL(TIMERDRIVER_BASE, TIMERDRIVER_CONTROL_RUN);
+}
+
+/*
+ * Releases the control task.
+ */
+static void TimerDriver_releaseControl() {
+	TimerDriver_releaseTimestamp = TimerDriver_base;
+	// Release only if the last release was consumed, otherwise the task
+	// would run several jobs back to back.
+	if (TimerDriver_release->OSEventCnt == 0) {
+		OSSemPost(TimerDriver_release);
+	} else {
+		TimerDriver_overruns++;
+	}
+}
+
+/*
+ * Loads the time to the next interrupt. The ticks the counter ran since
+ * the last interrupt are subtracted, so the next interrupt happens next
+ * ticks after the last one.
+ */
+static void TimerDriver_loadNext(uint32_t next) {
+	uint32_t elapsed = TimerDriver_period - 1 - TimerDriver_readSnapshot();
+
+	if (next < elapsed + TIMERDRIVER_MIN_GAP) {
+		next = elapsed + TIMERDRIVER_MIN_GAP;
+	}
+	TimerDriver_loadPeriod(next - elapsed);
+	TimerDriver_period = next;
+}
+
+/*
+ * Loads the full period of a periodic deadline again after an interrupt of
+ * another deadline, so the following interrupts keep the period register.
+ * Changing the period restarts the counter, the ticks since the interrupt
+ * are added to this period and the deadline is shifted by them.
+ */
+static void TimerDriver_restorePeriod(uint32_t period, uint32_t *deadline) {
+	uint32_t elapsed = TimerDriver_period - 1 - TimerDriver_readSnapshot();
+
+	TimerDriver_loadPeriod(period);
+	TimerDriver_period = elapsed + period;
+	*deadline += elapsed;
+}
+
+/*
+ * Schedules the next sample. Every control period is divided into
+ * TimerDriver_samples slots with one sample at a random position in each
+ * slot, so the samples are not locked to the phase of the control loop.
+ * The release always ends the control period exactly.
+ */
+static void TimerDriver_scheduleSample() {
+	if (TimerDriver_sampleIndex < TimerDriver_samples) {
+		// xorshift32
+		TimerDriver_random ^= TimerDriver_random << 13;
+		TimerDriver_random ^= TimerDriver_random >> 17;
+		TimerDriver_random ^= TimerDriver_random << 5;
+		TimerDriver_nextSample = TimerDriver_lastRelease
+				+ TimerDriver_sampleIndex * TimerDriver_slot
+				+ (((TimerDriver_random & 0xFFFF) * TimerDriver_slot) >> 16);
+		TimerDriver_sampleIndex++;
+		TimerDriver_samplePending = 1;
+	} else {
+		TimerDriver_samplePending = 0;
+	}
+}
+
+/*
+ * Returns the time from now to the earliest deadline, 0 if it has passed.
+ * While the control timebase runs the OS tick is no deadline of its own,
+ * it is notified with the first interrupt after it is due.
+ */
+static uint32_t TimerDriver_nextInterrupt(uint32_t now) {
+	int32_t next;
+
+	if (TimerDriver_state == TIMER_CONTROLTIMEBASE) {
+		next = (int32_t) (TimerDriver_nextRelease - now);
+		if (TimerDriver_samplePending
+				&& (int32_t) (TimerDriver_nextSample - now) < next) {
+			next = (int32_t) (TimerDriver_nextSample - now);
+		}
+	} else {
+		next = (int32_t) (TimerDriver_nextTick - now);
+	}
+	if (TimerDriver_oneShotHook != NULL
+			&& (int32_t) (TimerDriver_oneShotAt - now) < next) {
+		next = (int32_t) (TimerDriver_oneShotAt - now);
+	}
+	return next > 0 ? next : 0;
+}
+
+/*
+ * Moves the next interrupt forward if a deadline before it was added.
+ * Called with interrupts disabled from outside of the interrupt handler.
+ */
+static void TimerDriver_reschedule() {
+	uint32_t next = TimerDriver_nextInterrupt(TimerDriver_base);
+
+	if (next >= TimerDriver_period) {
+		return;
+	}
+	// The interrupt is pending or too close to move it, the interrupt
+	// handler schedules the new deadline.
+	if ((IORD_ALTERA_AVALON_TIMER_STATUS(TIMERDRIVER_BASE)
+			& ALTERA_AVALON_TIMER_STATUS_TO_MSK)
+			|| TimerDriver_readSnapshot() < TIMERDRIVER_MIN_GAP) {
+		return;
+	}
+	TimerDriver_loadNext(next);
+}
+
+/*
+ * Interrupt service routine of the timer. It serves every deadline that is
+ * due and loads the time to the next one.
+ */
+static void TimerDriver_isr(void *context) {
+	alt_irq_context cpu_sr;
+	void (*expired)(void);
+	uint32_t *deadline;
+	uint32_t period;
+	uint32_t now;
+	uint32_t next;
+
+	IOWR_ALTERA_AVALON_TIMER_STATUS(TIMERDRIVER_BASE, 0);
+	// Dummy read to ensure the IRQ is negated before the ISR returns.
+	IORD_ALTERA_AVALON_TIMER_CONTROL(TIMERDRIVER_BASE);
+
+	// The counter restarted with the period register.
+	TimerDriver_base += TimerDriver_period;
+	TimerDriver_period = TimerDriver_loaded;
+	now = TimerDriver_base;
+	TimerDriver_inIsr = 1;
+
+	if (TimerDriver_state == TIMER_CONTROLTIMEBASE) {
+		if ((int32_t) (TimerDriver_nextRelease - now) <= 0) {
+			TimerDriver_lastRelease = TimerDriver_nextRelease;
+			TimerDriver_nextRelease += TimerDriver_controlPeriod
+					+ TimerDriver_phaseShift;
+			TimerDriver_phaseShift = 0;
+			TimerDriver_releaseControl();
+			if (TimerDriver_samples != 0) {
+				TimerDriver_sampleIndex = 0;
+				TimerDriver_scheduleSample();
+			}
+		} else if (TimerDriver_samplePending
+				&& (int32_t) (TimerDriver_nextSample - now) <= 0) {
+			TimerDriver_sampleHook();
+			TimerDriver_scheduleSample();
+		}
+	}
+
+	if (TimerDriver_oneShotHook != NULL
+			&& (int32_t) (TimerDriver_oneShotAt - now) <= 0) {
+		expired = TimerDriver_oneShotHook;
+		TimerDriver_oneShotHook = NULL;
+		expired();
+	}
+
+	while ((int32_t) (TimerDriver_nextTick - now) <= 0) {
+		TimerDriver_nextTick += TIMERDRIVER_PERIOD;
+		// Notify the system of a clock tick, like the HAL timer driver.
+		cpu_sr = alt_irq_disable_all();
+		alt_tick();
+		alt_irq_enable_all(cpu_sr);
+	}
+	TimerDriver_inIsr = 0;
+
+	// The periodic deadline keeps the period register, every reload loses
+	// a few ticks.
+	if (TimerDriver_state == TIMER_CONTROLTIMEBASE) {
+		deadline = &TimerDriver_nextRelease;
+		period = TimerDriver_controlPeriod;
+	} else {
+		deadline = &TimerDriver_nextTick;
+		period = TIMERDRIVER_PERIOD;
+	}
+	next = TimerDriver_nextInterrupt(now);
+	if (next == TimerDriver_period) {
+		// The counter already restarted with it.
+	} else if (next == period && *deadline - now == period) {
+		TimerDriver_restorePeriod(period, deadline);
+	} else {
+		TimerDriver_loadNext(next);
+	}
+}
+
+/*
+ * Takes the timer over from the HAL, it keeps the OS tick running. Called
+ * with interrupts disabled.
+ */
+static void TimerDriver_takeOver() {
+	uint32_t now = TimerDriver_getTimestamp();
+
+	// A pending OS tick is already counted in now, it is notified with the
+	// first interrupt.
+	TimerDriver_nextTick = (OSTime + 1) * TIMERDRIVER_PERIOD;
+	IOWR_ALTERA_AVALON_TIMER_STATUS(TIMERDRIVER_BASE, 0);
+	TimerDriver_base = now;
+	TimerDriver_period = TimerDriver_nextTick - now;
+	if ((int32_t) TimerDriver_period < TIMERDRIVER_MIN_GAP) {
+		TimerDriver_period = TIMERDRIVER_MIN_GAP;
+	}
+	TimerDriver_loadPeriod(TimerDriver_period);
+	alt_ic_isr_register(TIMERDRIVER_IRQ_IC_ID, TIMERDRIVER_IRQ,
+			TimerDriver_isr, NULL, NULL);
+	TimerDriver_state = TIMER_ONESHOT;
+}
+
+uint32_t TimerDriver_getTimestamp() {
+	alt_irq_context context;
+	uint32_t snapshot;
+	uint32_t base;
+	uint32_t period;
+	uint32_t loaded;
+
+	context = alt_irq_disable_all();
+	snapshot = TimerDriver_readSnapshot();
+	if (TimerDriver_state != TIMER_SYSTEMTICK) {
+		base = TimerDriver_base;
+		period = TimerDriver_period;
+		loaded = TimerDriver_loaded;
+	} else {
+		base = OSTime * TIMERDRIVER_PERIOD;
+		period = TIMERDRIVER_PERIOD;
+		loaded = TIMERDRIVER_PERIOD;
+	}
+	// The counter reloaded but the interrupt has not been served yet.
+	// If the snapshot is in the upper half the reload happened before the
+	// snapshot was taken and the pending period has to be counted, the
+	// counter restarted with the period register.
+	if ((IORD_ALTERA_AVALON_TIMER_STATUS(TIMERDRIVER_BASE)
+			& ALTERA_AVALON_TIMER_STATUS_TO_MSK) && snapshot > (loaded / 2)) {
+		base += period;
+		period = loaded;
+	}
+	alt_irq_enable_all(context);
+
+	return base + (period - 1 - snapshot);
+}
+
+uint32_t TimerDriver_ticksToUs(uint32_t ticks) {
+	return ticks / TIMERDRIVER_TICKS_PER_US;
+}
+
+uint32_t TimerDriver_usUntil(uint32_t timestamp) {
+	int32_t ticks = (int32_t) (timestamp - TimerDriver_getTimestamp());
+
+	if (ticks <= 0) {
+		return 0;
+	}
+	return (ticks + TIMERDRIVER_TICKS_PER_US - 1) / TIMERDRIVER_TICKS_PER_US;
+}
+
+int8_t TimerDriver_initOneShot() {
+	alt_irq_context context;
+
+	if (TimerDriver_state != TIMER_SYSTEMTICK) {
+		return ERR_TIMER_WRONG_STATE;
+	}
+	context = alt_irq_disable_all();
+	TimerDriver_takeOver();
+	alt_irq_enable_all(context);
+	return NO_ERR;
+}
+
+int8_t TimerDriver_setOneShot(uint32_t timestamp, void (*expired)(void)) {
+	alt_irq_context context;
+
+	if (TimerDriver_state == TIMER_SYSTEMTICK) {
+		return ERR_TIMER_WRONG_STATE;
+	}
+	if (expired == NULL) {
+		return ERR_TIMER_ILLEGAL_RANGE;
+	}
+	context = alt_irq_disable_all();
+	TimerDriver_oneShotAt = timestamp;
+	TimerDriver_oneShotHook = expired;
+	// The interrupt handler loads the next interrupt when it returns.
+	if (!TimerDriver_inIsr) {
+		TimerDriver_reschedule();
+	}
+	alt_irq_enable_all(context);
+	return NO_ERR;
+}
+
+void TimerDriver_cancelOneShot() {
+	// A scheduled interrupt finds nothing to do.
+	TimerDriver_oneShotHook = NULL;
+}
+
+int8_t TimerDriver_initControlTimebase(uint16_t rateHz) {
+	alt_irq_context context;
+
+	if (TimerDriver_state == TIMER_CONTROLTIMEBASE) {
+		return ERR_TIMER_WRONG_STATE;
+	}
+	if (rateHz < TIMERDRIVER_MIN_RATE || rateHz > TIMERDRIVER_MAX_RATE) {
+		return ERR_TIMER_ILLEGAL_RANGE;
+	}
+	TimerDriver_release = OSSemCreate(0);
+	if (TimerDriver_release == NULL) {
+		return ERR_TIMER_OS;
+	}
+	TimerDriver_controlPeriod = TIMERDRIVER_FREQ / rateHz;
+
+	context = alt_irq_disable_all();
+	if (TimerDriver_state == TIMER_SYSTEMTICK) {
+		TimerDriver_takeOver();
+	}
+	TimerDriver_nextRelease = TimerDriver_getTimestamp()
+			+ TimerDriver_controlPeriod;
+	TimerDriver_state = TIMER_CONTROLTIMEBASE;
+	TimerDriver_reschedule();
+	alt_irq_enable_all(context);
+
+	return NO_ERR;
+}
+
+int8_t TimerDriver_waitControlRelease() {
+	uint32_t latency;
+	INT8U err;
+
+	if (TimerDriver_state != TIMER_CONTROLTIMEBASE) {
+		return ERR_TIMER_WRONG_STATE;
+	}
+	OSSemPend(TimerDriver_release, 0, &err);
+	latency = TimerDriver_getTimestamp() - TimerDriver_releaseTimestamp;
+	if (latency < TimerDriver_minLatency) {
+		TimerDriver_minLatency = latency;
+	}
+	if (latency > TimerDriver_maxLatency) {
+		TimerDriver_maxLatency = latency;
+	}
+	return NO_ERR;
+}
+
+int8_t TimerDriver_shiftControlPhase(int32_t us) {
+	int32_t shift = us * TIMERDRIVER_TICKS_PER_US;
+
+	if (TimerDriver_state != TIMER_CONTROLTIMEBASE) {
+		return ERR_TIMER_WRONG_STATE;
+	}
+	if (shift >= (int32_t) TimerDriver_controlPeriod / 2
+			|| -shift >= (int32_t) TimerDriver_controlPeriod / 2) {
+		return ERR_TIMER_ILLEGAL_RANGE;
+	}
+	TimerDriver_phaseShift = shift;
+	return NO_ERR;
+}
+
+int8_t TimerDriver_initSampling(uint8_t samples, void (*sample)(void)) {
+	alt_irq_context context;
+
+	if (TimerDriver_state != TIMER_CONTROLTIMEBASE || TimerDriver_samples != 0) {
+		return ERR_TIMER_WRONG_STATE;
+	}
+	if (samples == 0 || samples > TIMERDRIVER_MAX_SAMPLES || sample == NULL) {
+		return ERR_TIMER_ILLEGAL_RANGE;
+	}
+	context = alt_irq_disable_all();
+	TimerDriver_sampleHook = sample;
+	TimerDriver_slot = TimerDriver_controlPeriod / samples;
+	// The first sample is scheduled by the next release.
+	TimerDriver_sampleIndex = samples;
+	TimerDriver_samplePending = 0;
+	TimerDriver_samples = samples;
+	alt_irq_enable_all(context);
+	return NO_ERR;
+}
+
+void TimerDriver_getControlLatency(uint32_t *minLatency, uint32_t *maxLatency,
+		uint32_t *overruns) {
+	*minLatency = TimerDriver_minLatency;
+	*maxLatency = TimerDriver_maxLatency;
+	*overruns = TimerDriver_overruns;
+	TimerDriver_minLatency = 0xFFFFFFFF;
+	TimerDriver_maxLatency = 0;
+}
@@ -0,0 +1,187 @@
+/*
+ * This driver provides a high resolution timestamp and the control loop
+ * timebase based on the system timer of the cpu (timer_cpu_s0).
+ * <p>
+ * The timestamp combines a tick counter with the snapshot register of the
+ * timer and counts with the timer frequency (25 MHz, 40 ns).
+ * <p>
+ * The system has no spare interval timer, so the driver takes over
+ * timer_cpu_s0 from the HAL (TimerDriver_initOneShot() or
+ * TimerDriver_initControlTimebase()) and loads it with the time to the
+ * next deadline: the release of the control task, a sample, the one-shot
+ * interrupt or, without the control timebase, the OS tick. The OS tick
+ * (OS_TICKS_PER_SEC) is derived from the timestamp and notified with the
+ * first interrupt after it is due. A periodic control timebase without
+ * other deadlines keeps the period register, so it is not reloaded. If a
+ * dedicated timer is added to the system only TIMERDRIVER_BASE/IRQ have to
+ * be changed and the OS tick derivation can be dropped.
+ */
+
+#ifndef B_TIMERDRIVER_H_
+#define B_TIMERDRIVER_H_
+
+//-----------------------Includes----------------------------------------------
+#include "../stdint.h" // Include stdint.h for the use of Integers with a defined size
+#include <system.h>
+
+//-----------------------Defines-----------------------------------------------
+#define TIMERDRIVER_BASE		TIMER_CPU_S0_BASE
+#define TIMERDRIVER_IRQ			TIMER_CPU_S0_IRQ
+#define TIMERDRIVER_IRQ_IC_ID	TIMER_CPU_S0_IRQ_INTERRUPT_CONTROLLER_ID
+#define TIMERDRIVER_FREQ		TIMER_CPU_S0_FREQ		// timestamp ticks per second
+#define TIMERDRIVER_PERIOD		(TIMER_CPU_S0_LOAD_VALUE + 1)	// timestamp ticks per OS tick
+
+#define TIMERDRIVER_TICKS_PER_US	(TIMERDRIVER_FREQ / 1000000)
+
+#define TIMERDRIVER_MIN_RATE	250		// Hz
+#define TIMERDRIVER_MAX_RATE	2000	// Hz
+
+#define TIMERDRIVER_MAX_SAMPLES	8		// sample interrupts per control period
+#define TIMERDRIVER_MIN_GAP		(10 * TIMERDRIVER_TICKS_PER_US)	// ticks between two interrupts
+
+//-----------------------Attributes--------------------------------------------
+enum TimerDriverState {
+	TIMER_SYSTEMTICK, TIMER_ONESHOT, TIMER_CONTROLTIMEBASE
+};
+
+//-----------------------Method Declaration------------------------------------
+/**
+ * This function returns the current timestamp.
+ * <p>
+ * The value counts with TIMERDRIVER_FREQ and wraps around after 2^32 ticks
+ * (about 171 seconds). Differences of two timestamps are valid as long as
+ * they are computed with unsigned arithmetic.
+ * It can be called from tasks and from interrupt service routines.
+ *
+ * @return	The current timestamp.
+ */
+uint32_t TimerDriver_getTimestamp();
+
+/**
+ * This function converts a timestamp difference into microseconds.
+ *
+ * @param	ticks	The timestamp difference.
+ * @return	The difference in microseconds.
+ */
+uint32_t TimerDriver_ticksToUs(uint32_t ticks);
+
+/**
+ * This function returns the time until a timestamp is reached.
+ *
+ * @param	timestamp	The timestamp, at most 2^31 ticks in the future.
+ * @return	The time in microseconds, rounded up, or 0 if the timestamp
+ * 			has passed.
+ */
+uint32_t TimerDriver_usUntil(uint32_t timestamp);
+
+/**
+ * This function takes the timer over from the HAL for one-shot interrupts.
+ * <p>
+ * The OS tick keeps its rate. It has to be called before OSStart() or from
+ * a task. TimerDriver_initControlTimebase() takes the timer over itself.
+ *
+ * @return	ERR_TIMER_WRONG_STATE	If the timer is already taken over.
+ * 			NO_ERR					If everything is fine.
+ */
+int8_t TimerDriver_initOneShot();
+
+/**
+ * This function arms the one-shot interrupt.
+ * <p>
+ * expired is called once from the timer interrupt when the timestamp is
+ * reached, at the earliest TIMERDRIVER_MIN_GAP from now. A timestamp that
+ * has passed expires with the next possible interrupt. Arming again
+ * replaces the timestamp and the function, also from expired. It can be
+ * called from tasks and from interrupt service routines. Timer queues are
+ * built on it (see HiresTimer.h).
+ *
+ * @param	timestamp	The timestamp, at most 2^31 ticks in the future.
+ * 			expired		The function called at the timestamp.
+ * @return	ERR_TIMER_WRONG_STATE	If the timer is not taken over.
+ * 			ERR_TIMER_ILLEGAL_RANGE	If expired is NULL.
+ * 			NO_ERR					If everything is fine.
+ */
+int8_t TimerDriver_setOneShot(uint32_t timestamp, void (*expired)(void));
+
+/**
+ * This function disarms the one-shot interrupt.
+ */
+void TimerDriver_cancelOneShot();
+
+/**
+ * This function starts the control timebase.
+ * <p>
+ * The timer interrupt releases the task waiting in
+ * TimerDriver_waitControlRelease() with rateHz. The OS tick keeps its rate.
+ * It has to be called before OSStart() or from a task.
+ *
+ * @param	rateHz	The control rate from TIMERDRIVER_MIN_RATE to TIMERDRIVER_MAX_RATE.
+ * @return	ERR_TIMER_WRONG_STATE	If the timebase is already running.
+ * 			ERR_TIMER_ILLEGAL_RANGE	If the rate is not supported.
+ * 			ERR_TIMER_OS			If the semaphore could not be created.
+ * 			NO_ERR					If everything is fine.
+ */
+int8_t TimerDriver_initControlTimebase(uint16_t rateHz);
+
+/**
+ * This function waits for the next release of the control timebase.
+ * <p>
+ * It measures the release latency, the time from the timer reload to the
+ * return of this function. It has to be called by one task only.
+ *
+ * @return	ERR_TIMER_WRONG_STATE	If the timebase is not running.
+ * 			NO_ERR					If everything is fine.
+ */
+int8_t TimerDriver_waitControlRelease();
+
+/**
+ * This function shifts the phase of the control timebase.
+ * <p>
+ * The next control period is extended (or shortened) once by us, so the
+ * following releases happen shifted. It is used to align the release to
+ * the data ready time of the sensors.
+ *
+ * @param	us	The shift in microseconds, less than half a period.
+ * @return	ERR_TIMER_WRONG_STATE	If the timebase is not running.
+ * 			ERR_TIMER_ILLEGAL_RANGE	If the shift is too large.
+ * 			NO_ERR					If everything is fine.
+ */
+int8_t TimerDriver_shiftControlPhase(int32_t us);
+
+/**
+ * This function starts sample interrupts of the control timebase.
+ * <p>
+ * Every control period gets samples additional timer interrupts at random
+ * times, one in each of samples equal slots, which call sample from the
+ * interrupt context. It is used by the pc sampling profiler (Profiler.h),
+ * the system has no spare timer for it.
+ * <p>
+ * The timer has to be reloaded at every interrupt then. The release of the
+ * control task stays exact, but the few ticks of a reload are not counted,
+ * so the timebase runs slightly slow while sampling.
+ *
+ * @param	samples	The number of samples per control period, 1 to
+ * 					TIMERDRIVER_MAX_SAMPLES.
+ * 			sample	The function called at every sample interrupt.
+ * @return	ERR_TIMER_WRONG_STATE	If the timebase is not running or
+ * 									sampling is already started.
+ * 			ERR_TIMER_ILLEGAL_RANGE	If samples is not supported.
+ * 			NO_ERR					If everything is fine.
+ */
+int8_t TimerDriver_initSampling(uint8_t samples, void (*sample)(void));
+
+/**
+ * This function gets the release latency since the last call.
+ * <p>
+ * The jitter of the release is maxLatency - minLatency. The values are
+ * reset afterwards.
+ *
+ * @param	minLatency	Stores the shortest latency in timestamp ticks.
+ * 			maxLatency	Stores the longest latency in timestamp ticks.
+ * 			overruns	Stores the number of releases that were missed
+ * 						because the task was still running.
+ */
+void TimerDriver_getControlLatency(uint32_t *minLatency, uint32_t *maxLatency,
+		uint32_t *overruns);
+
+#endif /* B_TIMERDRIVER_H_ */
@@ -0,0 +1,130 @@
+/*
+ * High resolution one-shot timers.
+ * <p>
+ * The queue is changed with interrupts disabled, the expiry functions run
+ * in the timer interrupt.
+ */
+
+//-----------------------Includes----------------------------------------------
+#include <stddef.h>
+#include <sys/alt_irq.h>
+#include "includes.h"
+#include "HiresTimer.h"
+#include "Drivers/Driver_Timer.h"
+
+//-----------------------Defines-----------------------------------------------
+#define HT_TICK_US		(1000000 / OS_TICKS_PER_SEC)
+
+//-----------------------Attributes--------------------------------------------
+static struct HiresTimer *HiresTimer_queue = NULL;	// sorted by expiry
+
+//-----------------------Method Implementation---------------------------------
+/*
+ * One-shot interrupt, calls the functions of all expired timers.
+ */
+static void HiresTimer_expire() {
+	struct HiresTimer *timer;
+	uint32_t now = TimerDriver_getTimestamp();
+
+	while (HiresTimer_queue != NULL
+			&& (int32_t) (HiresTimer_queue->expiry - now) <= 0) {
+		timer = HiresTimer_queue;
+		HiresTimer_queue = timer->next;
+		timer->armed = 0;
+		timer->expired(timer->context);
+	}
+	if (HiresTimer_queue != NULL) {
+		TimerDriver_setOneShot(HiresTimer_queue->expiry, HiresTimer_expire);
+	}
+}
+
+/*
+ * Removes a timer from the queue, called with interrupts disabled.
+ */
+static uint8_t HiresTimer_unlink(struct HiresTimer *timer) {
+	struct HiresTimer **link = &HiresTimer_queue;
+
+	if (!timer->armed) {
+		return 0;
+	}
+	while (*link != timer) {
+		link = &(*link)->next;
+	}
+	*link = timer->next;
+	timer->armed = 0;
+	return 1;
+}
+
+/*
+ * Wakes the task sleeping in HiresTimer_sleepUntil().
+ */
+static void HiresTimer_wake(void *context) {
+	OSSemPost((OS_EVENT *) context);
+}
+
+int8_t HiresTimer_init() {
+	return TimerDriver_initOneShot();
+}
+
+void HiresTimer_start(struct HiresTimer *timer, uint32_t timestamp) {
+	alt_irq_context context;
+	struct HiresTimer **link = &HiresTimer_queue;
+
+	context = alt_irq_disable_all();
+	HiresTimer_unlink(timer);
+	timer->expiry = timestamp;
+	// Behind the timers with the same expiry, they expire in start order.
+	while (*link != NULL && (int32_t) ((*link)->expiry - timestamp) <= 0) {
+		link = &(*link)->next;
+	}
+	timer->next = *link;
+	*link = timer;
+	timer->armed = 1;
+	if (HiresTimer_queue == timer) {
+		TimerDriver_setOneShot(timestamp, HiresTimer_expire);
+	}
+	alt_irq_enable_all(context);
+}
+
+uint8_t HiresTimer_stop(struct HiresTimer *timer) {
+	alt_irq_context context;
+	uint8_t wasFirst;
+	uint8_t armed;
+
+	context = alt_irq_disable_all();
+	wasFirst = HiresTimer_queue == timer;
+	armed = HiresTimer_unlink(timer);
+	if (wasFirst) {
+		if (HiresTimer_queue != NULL) {
+			TimerDriver_setOneShot(HiresTimer_queue->expiry, HiresTimer_expire);
+		} else {
+			TimerDriver_cancelOneShot();
+		}
+	}
+	alt_irq_enable_all(context);
+	return armed;
+}
+
+void HiresTimer_sleepUntil(uint32_t timestamp) {
+	struct HiresTimer timer;
+	OS_EVENT *wake;
+	uint32_t us = TimerDriver_usUntil(timestamp);
+	INT8U err;
+
+	if (us == 0) {
+		return;
+	}
+	wake = OSSemCreate(0);
+	if (wake == NULL) {
+		OSTimeDly((INT16U) (us / HT_TICK_US + 1));
+		return;
+	}
+	timer.expired = HiresTimer_wake;
+	timer.context = wake;
+	timer.armed = 0;
+	HiresTimer_start(&timer, timestamp);
+	OSSemPend(wake, (INT16U) (us / HT_TICK_US + 2), &err);
+	// The timer must not post the semaphore after it is deleted.
+	HiresTimer_stop(&timer);
+	OSSemDel(wake, OS_DEL_ALWAYS, &err);
+}
@@ -0,0 +1,85 @@
+/*
+ * High resolution one-shot timers.
+ * <p>
+ * The timers are kept in a queue sorted by their expiry timestamp (see
+ * Driver_Timer.h), the one-shot interrupt of the timer driver is armed for
+ * the first timer only. So a timer expires within a few microseconds of its
+ * timestamp instead of with the next OS tick, and a started timer costs no
+ * work per tick. The expiry function is called from the timer interrupt,
+ * it may only use functions that can be called from interrupt service
+ * routines, e.g. OSSemPost() or HiresTimer_start() to restart the timer.
+ * <p>
+ * Tasks sleep until a timestamp with HiresTimer_sleepUntil(), e.g. for the
+ * settle times of the sensors.
+ * <p>
+ * Usage:
+ *   static struct HiresTimer rcTimeout = { rcLost, NULL };
+ *   HiresTimer_start(&rcTimeout, TimerDriver_getTimestamp()
+ *           + 50000 * TIMERDRIVER_TICKS_PER_US);
+ *   ... every frame restarts it, HiresTimer_stop(&rcTimeout) ends it.
+ */
+
+#ifndef HIRESTIMER_H_
+#define HIRESTIMER_H_
+
+//-----------------------Includes----------------------------------------------
+#include "stdint.h" // Include stdint.h for the use of Integers with a defined size
+
+//-----------------------Attributes--------------------------------------------
+struct HiresTimer {
+	void (*expired)(void *context);
+	void *context;
+	uint32_t expiry;			// set by HiresTimer_start()
+	uint8_t armed;
+	struct HiresTimer *next;	// queue
+};
+
+//-----------------------Method Declaration------------------------------------
+/**
+ * This function takes the timer over for the one-shot interrupts.
+ * <p>
+ * It has to be called in main() before the first timer is started.
+ *
+ * @return	ERR_TIMER_WRONG_STATE	If the timer driver already runs the
+ * 									control timebase.
+ * 			NO_ERR					If everything is fine.
+ */
+int8_t HiresTimer_init();
+
+/**
+ * This function starts a timer.
+ * <p>
+ * A running timer is restarted with the new timestamp. It can be called
+ * from tasks and from interrupt service routines.
+ *
+ * @param	timer		The timer, expired and context have to be set.
+ * 			timestamp	The expiry timestamp, at most 2^31 timestamp ticks
+ * 						in the future.
+ */
+void HiresTimer_start(struct HiresTimer *timer, uint32_t timestamp);
+
+/**
+ * This function stops a timer.
+ * <p>
+ * It can be called from tasks and from interrupt service routines.
+ *
+ * @param	timer	The timer.
+ * @return	1 if the timer was running, 0 if it had expired or was not
+ * 			started.
+ */
+uint8_t HiresTimer_stop(struct HiresTimer *timer);
+
+/**
+ * This function lets the calling task sleep until a timestamp.
+ * <p>
+ * The task pends on a semaphore that the timer posts, with a timeout one
+ * tick longer than the sleep. A timer that expires before the task pends
+ * leaves the semaphore posted, so the task does not wait. If no semaphore
+ * is free the task sleeps with OSTimeDly() on the OS tick.
+ *
+ * @param	timestamp	The timestamp, at most 2^31 timestamp ticks in the
+ * 						future.
+ */
+void HiresTimer_sleepUntil(uint32_t timestamp);
+
+#endif /* HIRESTIMER_H_ */
@@ -1,8 +1,204 @@
 /*
- * PID_Yaw.c
- *
- *  Created on: 28.10.2015
- *      Author: aott
+ * Binary flight logger.
+ * <p>
+ * The rings are single producer / single consumer rings. The producer only
+ * writes head and dropped, the drain task only writes tail. Both indexes
+ * run freely and are masked on access, so no lock is needed.
  */
 
+//-----------------------Includes----------------------------------------------
+#include <fcntl.h>
+#include <unistd.h>
+#include "includes.h"
+#include "Logger.h"
+#include "Drivers/Driver_Timer.h"
+#include "b_errorcodes.h"
 
+//-----------------------Defines-----------------------------------------------
+#define LOG_RING_MASK	(LOG_RING_SIZE - 1)
+
+// Keeps the compiler from moving the record stores behind the head update.
+#define LOG_BARRIER()	__asm__ __volatile__("" ::: "memory")
+
+//-----------------------Attributes--------------------------------------------
+struct LogRing {
+	struct LogRecord records[LOG_RING_SIZE];
+	volatile uint32_t head;		// written by the producer
+	volatile uint32_t tail;		// written by the drain task
+	volatile uint32_t dropped;	// written by the producer
+	uint32_t reportedDropped;	// used by the drain task
+};
+
+enum LoggerState Logger_state = LOGGER_NOTAVAILABLE;
+
+static struct LogRing Logger_rings[LOG_PRODUCER_COUNT];
+static struct LogRecord Logger_batch[LOG_DRAIN_BATCH];
+static int Logger_fd = -1;
+static OS_STK Logger_drainTask_stk[LOG_TASK_STACKSIZE];
+
+//-----------------------Method Implementation---------------------------------
+/*
+ * Writes the collected records of the batch to the output device. The
+ * console takes a write in one piece, so the records are not split by
+ * text of other tasks.
+ */
+static void Logger_flush(uint32_t count) {
+	const char *buffer = (const char *) Logger_batch;
+	int length = count * LOG_RECORD_SIZE;
+	int written;
+
+	while (length > 0) {
+		written = write(Logger_fd, buffer, length);
+		if (written <= 0) {
+			OSTimeDly(1);
+			continue;
+		}
+		buffer += written;
+		length -= written;
+	}
+}
+
+/*
+ * Task with the lowest application priority that drains all rings.
+ */
+static void Logger_drainTask(void *pdata) {
+	struct LogRing *ring;
+	uint32_t count;
+	uint32_t dropped;
+	uint8_t producer;
+	uint8_t drained;
+
+	while (1) {
+		drained = 0;
+		for (producer = 0; producer < LOG_PRODUCER_COUNT; producer++) {
+			ring = &Logger_rings[producer];
+			count = 0;
+			while (ring->tail != ring->head && count < LOG_DRAIN_BATCH) {
+				Logger_batch[count] = ring->records[ring->tail & LOG_RING_MASK];
+				Logger_batch[count].sync = LOG_SYNC;
+				count++;
+				LOG_BARRIER();
+				ring->tail++;
+			}
+			dropped = ring->dropped;
+			if (dropped != ring->reportedDropped && count < LOG_DRAIN_BATCH) {
+				Logger_batch[count].sync = LOG_SYNC;
+				Logger_batch[count].producer = producer;
+				Logger_batch[count].id = LOG_ID_DROPPED;
+				Logger_batch[count].timestamp = TimerDriver_getTimestamp();
+				Logger_batch[count].data[0] = dropped;
+				Logger_batch[count].data[1] = 0;
+				ring->reportedDropped = dropped;
+				count++;
+			}
+			if (count > 0) {
+				Logger_flush(count);
+				drained = 1;
+			}
+		}
+		if (!drained) {
+			OSTimeDly(1);
+		}
+	}
+}
+
+int8_t Logger_init(const char *output) {
+	uint8_t producer;
+	INT8U err;
+
+	if (Logger_state == LOGGER_INITIALIZED) {
+		return NO_ERR;
+	}
+	for (producer = 0; producer < LOG_PRODUCER_COUNT; producer++) {
+		Logger_rings[producer].head = 0;
+		Logger_rings[producer].tail = 0;
+		Logger_rings[producer].dropped = 0;
+		Logger_rings[producer].reportedDropped = 0;
+	}
+
+	Logger_fd = open(output, O_WRONLY);
+	if (Logger_fd < 0) {
+		return ERR_LOG_OUTPUT;
+	}
+
+	err = OSTaskCreateExt(Logger_drainTask, NULL,
+			(void *) &Logger_drainTask_stk[LOG_TASK_STACKSIZE - 1],
+			LOG_TASK_PRIORITY, LOG_TASK_PRIORITY, Logger_drainTask_stk,
+			LOG_TASK_STACKSIZE, NULL, OS_TASK_OPT_STK_CHK);
+	if (err != OS_NO_ERR) {
+		close(Logger_fd);
+		Logger_fd = -1;
+		return ERR_LOG_TASK;
+	}
+
+	Logger_state = LOGGER_INITIALIZED;
+	return NO_ERR;
+}
+
+int8_t Logger_write(enum LogProducer producer, uint16_t id, uint32_t data0,
+		uint32_t data1) {
+	struct LogRing *ring = &Logger_rings[producer];
+	struct LogRecord *record;
+	uint32_t head;
+
+	if (Logger_state != LOGGER_INITIALIZED) {
+		return ERR_LOG_WRONG_STATE;
+	}
+	head = ring->head;
+	if (head - ring->tail >= LOG_RING_SIZE) {
+		ring->dropped++;
+		return ERR_LOG_RING_FULL;
+	}
+	record = &ring->records[head & LOG_RING_MASK];
+	record->producer = producer;
+	record->id = id;
+	record->timestamp = TimerDriver_getTimestamp();
+	record->data[0] = data0;
+	record->data[1] = data1;
+	LOG_BARRIER();
+	ring->head = head + 1;
+	return NO_ERR;
+}
+
+int8_t Logger_writeTrace(enum LogProducer producer, uint32_t format,
+		uint8_t argc, const uint32_t *argv) {
+	struct LogRing *ring = &Logger_rings[producer];
+	struct LogRecord *record;
+	uint32_t head;
+	uint32_t count;
+	uint8_t arg;
+
+	if (Logger_state != LOGGER_INITIALIZED) {
+		return ERR_LOG_WRONG_STATE;
+	}
+	// One record for the format and the first argument, three arguments
+	// in every further record.
+	count = (argc > 1) ? 1 + (argc + 1) / 3 : 1;
+	head = ring->head;
+	if (head - ring->tail + count > LOG_RING_SIZE) {
+		ring->dropped += count;
+		return ERR_LOG_RING_FULL;
+	}
+	record = &ring->records[head & LOG_RING_MASK];
+	record->producer = producer;
+	record->id = LOG_ID_TRACE;
+	record->timestamp = TimerDriver_getTimestamp();
+	record->data[0] = ((uint32_t) argc << 24) | (format & 0xFFFFFF);
+	record->data[1] = (argc > 0) ? argv[0] : 0;
+	for (arg = 1; arg < argc; arg += 3) {
+		head++;
+		record = &ring->records[head & LOG_RING_MASK];
+		record->producer = producer;
+		record->id = LOG_ID_TRACE_ARGS;
+		record->timestamp = argv[arg];
+		record->data[0] = (arg + 1 < argc) ? argv[arg + 1] : 0;
+		record->data[1] = (arg + 2 < argc) ? argv[arg + 2] : 0;
+	}
+	LOG_BARRIER();
+	ring->head = head + 1;
+	return NO_ERR;
+}
+
+uint32_t Logger_getDropped(enum LogProducer producer) {
+	return Logger_rings[producer].dropped;
+}
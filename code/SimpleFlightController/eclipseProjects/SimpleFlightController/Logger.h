@@ -1,8 +1,124 @@
 /*
- * PID_Yaw.h
+ * Binary flight logger.
+ * <p>
+ * Every producer (one task or one interrupt service routine) owns a single
+ * producer / single consumer ring buffer of fixed size records. Writing a
+ * record takes a timestamp and a few stores, it never formats and never
+ * blocks. If the ring of a producer is full the record is dropped and counted.
+ * A task with the lowest application priority drains the rings to the
+ * UART or the JTAG UART.
+ * <p>
+ * Every record is sent as LOG_RECORD_SIZE bytes in little endian order:
+ * sync (0xA5), producer, id (2 bytes), timestamp (4 bytes, see Driver_Timer.h),
+ * data[0] (4 bytes), data[1] (4 bytes).
+ * <p>
+ * Trace messages (see Trace.h) use a LOG_ID_TRACE record with
+ * data[0] = argument count << 24 | format string offset and data[1] = first
+ * argument, followed by LOG_ID_TRACE_ARGS records that carry three further
+ * arguments each in timestamp, data[0] and data[1].
+ */
+
+#ifndef LOGGER_H_
+#define LOGGER_H_
+
+//-----------------------Includes----------------------------------------------
+#include "stdint.h" // Include stdint.h for the use of Integers with a defined size
+#include <system.h>
+
+//-----------------------Defines-----------------------------------------------
+#define LOG_RING_SIZE			256		// records per producer, has to be a power of two
+#define LOG_RECORD_SIZE			16		// bytes per record
+#define LOG_SYNC				0xA5	// first byte of every record on the output
+
+#define LOG_TASK_PRIORITY		(OS_LOWEST_PRIO - 2) // lowest priority after idle and statistic task
+#define LOG_TASK_STACKSIZE		1024
+#define LOG_DRAIN_BATCH			16		// records sent with one write call
+
+#define LOG_OUTPUT_JTAG_UART	JTAG_UART_CPU_S0_NAME
+#define LOG_OUTPUT_UART			UART_0_NAME
+#define LOG_OUTPUT_CONSOLE		"/dev/console"	// JTAG UART shared with the console, see Console.h
+
+/* ---- Record ids reserved by the logger ---- */
+#define LOG_ID_DROPPED			0xFFFF	// data[0]: dropped records of the producer since start
+#define LOG_ID_TRACE			0xFFFE	// start of a trace message
+#define LOG_ID_TRACE_ARGS		0xFFFD	// further arguments of a trace message
+
+//-----------------------Attributes--------------------------------------------
+enum LoggerState {
+	LOGGER_NOTAVAILABLE, LOGGER_INITIALIZED
+};
+
+/*
+ * Every producer has its own ring. A producer must not be used by more than
+ * one task or interrupt service routine.
+ */
+enum LogProducer {
+	LOG_PRODUCER_CONTROL, LOG_PRODUCER_SENSOR, LOG_PRODUCER_RC, LOG_PRODUCER_SYSTEM,
+	LOG_PRODUCER_PROFILER, LOG_PRODUCER_COUNT
+};
+
+struct LogRecord {
+	uint8_t sync;
+	uint8_t producer;
+	uint16_t id;
+	uint32_t timestamp;
+	uint32_t data[2];
+};
+
+//-----------------------Method Declaration------------------------------------
+/**
+ * This function initializes the logger and creates the drain task.
+ * <p>
+ * It has to be called before OSStart() or from a running task.
+ *
+ * @param	output	The device the records are drained to
+ * 					(LOG_OUTPUT_CONSOLE, LOG_OUTPUT_JTAG_UART or
+ * 					LOG_OUTPUT_UART).
+ * @return	ERR_LOG_OUTPUT		If the output device could not be opened.
+ * 			ERR_LOG_TASK		If the drain task could not be created.
+ * 			NO_ERR				If everything is fine.
+ */
+int8_t Logger_init(const char *output);
+
+/**
+ * This function writes one record into the ring of the producer.
+ * <p>
+ * It never blocks and can be called from interrupt service routines.
  *
- *  Created on: 28.10.2015
- *      Author: aott
+ * @param	producer	The ring the record is written to.
+ * 			id			The id of the record.
+ * 			data0		First payload word.
+ * 			data1		Second payload word.
+ * @return	ERR_LOG_WRONG_STATE	If the logger is not initialized.
+ * 			ERR_LOG_RING_FULL	If the ring is full, the record is dropped.
+ * 			NO_ERR				If everything is fine.
  */
+int8_t Logger_write(enum LogProducer producer, uint16_t id, uint32_t data0,
+		uint32_t data1);
 
+/**
+ * This function writes a trace message into the ring of the producer.
+ * <p>
+ * It is used by the TRACE macro of Trace.h. The message is either written
+ * completely or dropped completely.
+ *
+ * @param	producer	The ring the message is written to.
+ * 			format		The offset of the format string in .trace_fmt.
+ * 			argc		The number of arguments.
+ * 			argv		The arguments.
+ * @return	ERR_LOG_WRONG_STATE	If the logger is not initialized.
+ * 			ERR_LOG_RING_FULL	If the ring is full, the message is dropped.
+ * 			NO_ERR				If everything is fine.
+ */
+int8_t Logger_writeTrace(enum LogProducer producer, uint32_t format,
+		uint8_t argc, const uint32_t *argv);
+
+/**
+ * This function gets the number of dropped records of a producer.
+ *
+ * @param	producer	The ring of interest.
+ * @return	The number of records dropped since Logger_init().
+ */
+uint32_t Logger_getDropped(enum LogProducer producer);
 
+#endif /* LOGGER_H_ */
@@ -0,0 +1,62 @@
+/*
+ * Heap lock of the flight build.
+ */
+
+//-----------------------Includes----------------------------------------------
+#include <stddef.h>
+#include <sys/alt_irq.h>
+#include "MemPool.h"
+
+//-----------------------Attributes--------------------------------------------
+#ifdef MEMPOOL_TRAP_MALLOC
+static volatile uint8_t MemPool_heapLocked = 0;
+volatile void *MemPool_trapCaller = NULL;	// caller of the trapped allocation
+#endif
+
+//-----------------------Method Implementation---------------------------------
+void MemPool_lockHeap() {
+#ifdef MEMPOOL_TRAP_MALLOC
+	MemPool_heapLocked = 1;
+#endif
+}
+
+#ifdef MEMPOOL_TRAP_MALLOC
+/*
+ * The wrappers of the reentrant allocation functions of newlib, which are
+ * called by malloc(), calloc(), realloc() and the stdio functions.
+ */
+struct _reent;
+
+void *__real__malloc_r(struct _reent *reent, size_t size);
+void *__real__calloc_r(struct _reent *reent, size_t count, size_t size);
+void *__real__realloc_r(struct _reent *reent, void *pointer, size_t size);
+
+static void MemPool_trap(void *caller) {
+	MemPool_trapCaller = caller;
+	alt_irq_disable_all();
+	while (1) {
+		// Heap allocation after init, see MemPool_trapCaller.
+	}
+}
+
+void *__wrap__malloc_r(struct _reent *reent, size_t size) {
+	if (MemPool_heapLocked) {
+		MemPool_trap(__builtin_return_address(0));
+	}
+	return __real__malloc_r(reent, size);
+}
+
+void *__wrap__calloc_r(struct _reent *reent, size_t count, size_t size) {
+	if (MemPool_heapLocked) {
+		MemPool_trap(__builtin_return_address(0));
+	}
+	return __real__calloc_r(reent, count, size);
+}
+
+void *__wrap__realloc_r(struct _reent *reent, void *pointer, size_t size) {
+	if (MemPool_heapLocked) {
+		MemPool_trap(__builtin_return_address(0));
+	}
+	return __real__realloc_r(reent, pointer, size);
+}
+#endif
@@ -0,0 +1,30 @@
+/*
+ * Heap lock of the flight build.
+ * <p>
+ * The flight controller takes no buffer from the heap after init. The
+ * blocks passed between the stages come from the fixed-block pools of the
+ * channels (uC/OS-II memory partitions, see Channel.h), all other buffers
+ * are static. The heap of newlib is only used during init.
+ * <p>
+ * Built with TRAP_MALLOC=1 (make TRAP_MALLOC=1), malloc, calloc and realloc
+ * are wrapped by the linker (--wrap). After MemPool_lockHeap() every heap
+ * allocation stops the system with interrupts disabled, the caller is left
+ * in MemPool_trapCaller for the debugger. A flight with this build proves
+ * that no heap allocation happens after init.
+ */
+
+#ifndef MEMPOOL_H_
+#define MEMPOOL_H_
+
+//-----------------------Includes----------------------------------------------
+#include "stdint.h" // Include stdint.h for the use of Integers with a defined size
+
+//-----------------------Method Declaration------------------------------------
+/**
+ * This function ends the init phase, from now on every heap allocation
+ * traps if the application was built with TRAP_MALLOC=1. Without the
+ * option it does nothing.
+ */
+void MemPool_lockHeap();
+
+#endif /* MEMPOOL_H_ */
@@ -0,0 +1,44 @@
+/*
+ * Statistical pc sampling profiler.
+ */
+
+//-----------------------Includes----------------------------------------------
+#include "Profiler.h"
+#include "Logger.h"
+#include "includes.h"
+#include "Drivers/Driver_Timer.h"
+
+//-----------------------Attributes--------------------------------------------
+static uint8_t Profiler_pending = 0;
+static uint8_t Profiler_pendingTask;
+static uint32_t Profiler_pendingPc;
+
+//-----------------------Method Implementation---------------------------------
+/*
+ * Called by the timer interrupt. The exception return address (ea) still
+ * holds the address after the interrupted instruction, the interrupts are
+ * not nested.
+ */
+static void Profiler_sample() {
+	uint32_t pc;
+	uint8_t task;
+
+	__asm__ volatile ("mov %0, ea" : "=r" (pc));
+	pc -= 4;
+	task = OSRunning ? OSTCBCur->OSTCBPrio : PROFILER_NO_TASK;
+
+	if (Profiler_pending) {
+		Logger_write(LOG_PRODUCER_PROFILER,
+				((uint16_t) Profiler_pendingTask << 8) | task, Profiler_pendingPc,
+				pc);
+		Profiler_pending = 0;
+	} else {
+		Profiler_pendingTask = task;
+		Profiler_pendingPc = pc;
+		Profiler_pending = 1;
+	}
+}
+
+int8_t Profiler_start(uint8_t samples) {
+	return TimerDriver_initSampling(samples, Profiler_sample);
+}
@@ -0,0 +1,43 @@
+/*
+ * Statistical pc sampling profiler.
+ * <p>
+ * The sample interrupts of the control timebase (see
+ * TimerDriver_initSampling()) record the interrupted program counter and
+ * the priority of the running task. Two samples are packed into one log
+ * record of the producer LOG_PRODUCER_PROFILER:
+ * id: priority of the first sample << 8 | priority of the second sample,
+ * data[0]: pc of the first sample, data[1]: pc of the second sample.
+ * Samples taken before OSStart() have the priority PROFILER_NO_TASK.
+ * <p>
+ * Code that runs with disabled interrupts (critical sections, interrupt
+ * service routines) is never sampled, its time is accounted to the
+ * instruction that enables the interrupts again.
+ * tools/pcprofile.py symbolizes the samples.
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+//-----------------------Includes----------------------------------------------
+#include "stdint.h" // Include stdint.h for the use of Integers with a defined size
+
+//-----------------------Defines-----------------------------------------------
+#define PROFILER_NO_TASK	0x7F	// keeps the ids clear of the ids reserved by the logger
+
+//-----------------------Method Declaration------------------------------------
+/**
+ * This function starts the profiler.
+ * <p>
+ * The control timebase and the logger have to be running. With a control
+ * rate of 500 Hz and 2 samples per period the profiler sends 8 kB/s.
+ *
+ * @param	samples	The number of samples per control period, 1 to
+ * 					TIMERDRIVER_MAX_SAMPLES.
+ * @return	ERR_TIMER_WRONG_STATE	If the timebase is not running or the
+ * 									profiler is already started.
+ * 			ERR_TIMER_ILLEGAL_RANGE	If samples is not supported.
+ * 			NO_ERR					If everything is fine.
+ */
+int8_t Profiler_start(uint8_t samples);
+
+#endif /* PROFILER_H_ */
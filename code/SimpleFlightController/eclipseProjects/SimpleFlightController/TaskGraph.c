@@ -0,0 +1,145 @@
+/*
+ * Rate monotonic task graph.
+ */
+
+//-----------------------Includes----------------------------------------------
+#include <stdio.h>
+#include "TaskGraph.h"
+#include "Trace.h"
+#include "Drivers/Driver_Timer.h"
+#include "b_errorcodes.h"
+
+//-----------------------Constants---------------------------------------------
+// Rate monotonic bound n(2^(1/n) - 1) in per mille, rounded down.
+static const uint16_t TaskGraph_bound[TG_MAX_STAGES] = {
+	1000, 828, 779, 756, 743, 734, 728, 724, 720, 717
+};
+
+//-----------------------Attributes--------------------------------------------
+static const struct TaskGraphStage *TaskGraph_stages;
+static struct TaskGraphStatistic TaskGraph_statistics[TG_MAX_STAGES];
+static uint8_t TaskGraph_count = 0;
+static OS_FLAG_GRP *TaskGraph_flags;
+
+//-----------------------Method Implementation---------------------------------
+/*
+ * Task of one stage.
+ */
+static void TaskGraph_task(void *pdata) {
+	const struct TaskGraphStage *stage = pdata;
+	struct TaskGraphStatistic *statistic =
+			&TaskGraph_statistics[stage - TaskGraph_stages];
+	INT32U release = OSTimeGet();
+	INT32U now;
+	uint32_t start;
+	uint32_t duration;
+	INT8U err;
+
+	while (1) {
+		if (stage->waitFlags != 0) {
+			OSFlagPend(TaskGraph_flags, stage->waitFlags,
+					OS_FLAG_WAIT_SET_ALL + OS_FLAG_CONSUME, 0, &err);
+		} else if (stage->release != NULL && stage->release() == NO_ERR) {
+			// released by its own timebase
+		} else {
+			release += (stage->periodUs + TG_TICK_US - 1) / TG_TICK_US;
+			now = OSTimeGet();
+			if ((INT32S) (release - now) > 0) {
+				OSTimeDly((INT16U) (release - now));
+			} else {
+				statistic->overruns++;
+				release = now;
+			}
+		}
+
+		start = TimerDriver_getTimestamp();
+		stage->job();
+		duration = TimerDriver_ticksToUs(TimerDriver_getTimestamp() - start);
+
+		statistic->jobs++;
+		if (duration > statistic->maxUs) {
+			statistic->maxUs = duration;
+		}
+		if (duration > stage->wcetUs) {
+			statistic->budgetOverruns++;
+		}
+		if (stage->postFlags != 0) {
+			OSFlagPost(TaskGraph_flags, stage->postFlags, OS_FLAG_SET, &err);
+		}
+	}
+}
+
+int8_t TaskGraph_check(const struct TaskGraphStage *stages, uint8_t count) {
+	uint32_t utilisation = 0;
+	uint32_t stageUtilisation;
+	uint8_t i;
+	uint8_t j;
+
+	if (count == 0 || count > TG_MAX_STAGES) {
+		return ERR_TG_ILLEGAL_RANGE;
+	}
+	for (i = 0; i < count; i++) {
+		if (stages[i].periodUs == 0 || (stages[i].waitFlags == 0
+				&& stages[i].release == NULL
+				&& stages[i].periodUs % TG_TICK_US != 0)) {
+			printf("TaskGraph: %s needs a release function for its period\n",
+					stages[i].name);
+			return ERR_TG_ILLEGAL_RANGE;
+		}
+		for (j = 0; j < count; j++) {
+			if (stages[i].periodUs < stages[j].periodUs
+					&& stages[i].priority > stages[j].priority) {
+				printf("TaskGraph: %s has a shorter period but a lower priority than %s\n",
+						stages[i].name, stages[j].name);
+				return ERR_TG_NOT_RATE_MONOTONIC;
+			}
+		}
+		stageUtilisation = stages[i].wcetUs * 1000 / stages[i].periodUs;
+		utilisation += stageUtilisation;
+		TRACE("TaskGraph: stage %u prio %2d period %7lu us wcet %5lu us U %3lu/1000\n",
+				i, stages[i].priority, stages[i].periodUs, stages[i].wcetUs,
+				stageUtilisation);
+	}
+	TRACE("TaskGraph: U %lu/1000, rate monotonic bound %u/1000\n", utilisation,
+			TaskGraph_bound[count - 1]);
+	if (utilisation > TaskGraph_bound[count - 1]) {
+		return ERR_TG_NOT_SCHEDULABLE;
+	}
+	return NO_ERR;
+}
+
+int8_t TaskGraph_start(const struct TaskGraphStage *stages, uint8_t count) {
+	int8_t result;
+	uint8_t i;
+	INT8U err;
+
+	result = TaskGraph_check(stages, count);
+	if (result != NO_ERR) {
+		return result;
+	}
+
+	TaskGraph_stages = stages;
+	TaskGraph_count = count;
+	TaskGraph_flags = OSFlagCreate(0, &err);
+	if (err != OS_NO_ERR) {
+		return ERR_TG_OS;
+	}
+	for (i = 0; i < count; i++) {
+		err = OSTaskCreateExt(TaskGraph_task, (void *) &stages[i],
+				&stages[i].stack[stages[i].stackSize - 1], stages[i].priority,
+				stages[i].priority, stages[i].stack, stages[i].stackSize, NULL,
+				OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
+		if (err != OS_NO_ERR) {
+			return ERR_TG_OS;
+		}
+		OSTaskNameSet(stages[i].priority, (INT8U *) stages[i].name, &err);
+	}
+	return NO_ERR;
+}
+
+const struct TaskGraphStatistic *TaskGraph_getStatistic(uint8_t stage) {
+	if (stage >= TaskGraph_count) {
+		return NULL;
+	}
+	return &TaskGraph_statistics[stage];
+}
@@ -0,0 +1,97 @@
+/*
+ * Rate monotonic task graph.
+ * <p>
+ * A task graph is a table of stages. Every stage is a uC/OS-II task that
+ * runs one job per activation. A stage is released by its release function
+ * (e.g. the control timebase of Driver_Timer.h or the message of its
+ * predecessor, see Channel.h) or, without one, every periodUs with
+ * OSTimeDly(). An event triggered stage waits until all
+ * of its waitFlags are posted by its predecessors. After a job the stage
+ * posts its postFlags, so every stage wakes exactly when its input is ready.
+ * <p>
+ * Event and message triggered stages run with the period of the stage that
+ * triggers them, so periodUs is also set for them and used for the analysis.
+ * TaskGraph_start() checks that the priorities are rate monotonic and that
+ * the utilisation of the worst case execution times is below the rate
+ * monotonic bound n(2^(1/n) - 1) before any task is created. The analysis
+ * only holds while the jobs stay within wcetUs, every longer job is counted
+ * as budget overrun of its stage.
+ */
+
+#ifndef TASKGRAPH_H_
+#define TASKGRAPH_H_
+
+//-----------------------Includes----------------------------------------------
+#include "stdint.h" // Include stdint.h for the use of Integers with a defined size
+#include "includes.h"
+
+//-----------------------Defines-----------------------------------------------
+#define TG_MAX_STAGES		10
+#define TG_TICK_US			(1000000 / OS_TICKS_PER_SEC)
+
+//-----------------------Attributes--------------------------------------------
+struct TaskGraphStage {
+	const char *name;
+	void (*job)(void);		// one activation of the stage
+	INT8U priority;
+	uint32_t periodUs;		// release period, or period of the trigger
+	int8_t (*release)(void);	// waits for the release, NULL for OSTimeDly()
+	OS_FLAGS waitFlags;		// 0 for periodic stages
+	OS_FLAGS postFlags;		// posted after every job
+	uint32_t wcetUs;		// worst case execution time, budget of a job
+	OS_STK *stack;
+	INT32U stackSize;		// in OS_STK entries
+};
+
+struct TaskGraphStatistic {
+	uint32_t jobs;
+	uint32_t maxUs;			// longest job including preemption
+	uint32_t overruns;		// jobs that missed their next release
+	uint32_t budgetOverruns;	// jobs longer than wcetUs
+};
+
+//-----------------------Method Declaration------------------------------------
+/**
+ * This function checks the schedulability of a task graph.
+ * <p>
+ * It prints the utilisation of every stage.
+ *
+ * @param	stages	The table of the stages.
+ * 			count	The number of stages.
+ * @return	ERR_TG_ILLEGAL_RANGE		If count is above TG_MAX_STAGES or a
+ * 										period can not be released.
+ * 			ERR_TG_NOT_RATE_MONOTONIC	If a stage with a shorter period has a
+ * 										lower priority.
+ * 			ERR_TG_NOT_SCHEDULABLE		If the utilisation is above the bound.
+ * 			NO_ERR						If everything is fine.
+ */
+int8_t TaskGraph_check(const struct TaskGraphStage *stages, uint8_t count);
+
+/**
+ * This function checks the task graph and creates the tasks of all stages.
+ * <p>
+ * It has to be called before OSStart() or from a task with a higher
+ * priority than all stages. The table has to stay valid.
+ *
+ * @param	stages	The table of the stages.
+ * 			count	The number of stages.
+ * @return	ERR_TG_ILLEGAL_RANGE		If count is above TG_MAX_STAGES or a
+ * 										period can not be released.
+ * 			ERR_TG_NOT_RATE_MONOTONIC	If a stage with a shorter period has a
+ * 										lower priority.
+ * 			ERR_TG_NOT_SCHEDULABLE		If the utilisation is above the bound.
+ * 			ERR_TG_OS					If the event flags or a task could not
+ * 										be created.
+ * 			NO_ERR						If everything is fine.
+ */
+int8_t TaskGraph_start(const struct TaskGraphStage *stages, uint8_t count);
+
+/**
+ * This function gets the runtime statistic of a stage.
+ *
+ * @param	stage	The index of the stage in the table.
+ * @return	The statistic or NULL if the index is not valid.
+ */
+const struct TaskGraphStatistic *TaskGraph_getStatistic(uint8_t stage);
+
+#endif /* TASKGRAPH_H_ */
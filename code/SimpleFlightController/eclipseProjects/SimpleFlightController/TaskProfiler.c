@@ -0,0 +1,171 @@
+/*
+ * Per task cpu and stack profiler.
+ */
+
+//-----------------------Includes----------------------------------------------
+#include <stddef.h>
+#include <sys/alt_irq.h>
+#include "TaskProfiler.h"
+#include "Logger.h"
+#include "includes.h"
+#include "Drivers/Driver_Timer.h"
+#include "b_errorcodes.h"
+
+//-----------------------Defines-----------------------------------------------
+#define TP_TASKS	(OS_LOWEST_PRIO + 1)	// indexed by priority
+
+//-----------------------Attributes--------------------------------------------
+static volatile uint32_t TaskProfiler_isrTicks = 0;	// total interrupt time
+static uint32_t TaskProfiler_isrStart;
+static uint32_t TaskProfiler_isrAtSwitch;		// TaskProfiler_isrTicks at the last switch
+
+static uint32_t TaskProfiler_activation[TP_TASKS];	// first dispatch after blocking
+static uint8_t TaskProfiler_active[TP_TASKS];
+static uint32_t TaskProfiler_maxResponse[TP_TASKS];
+
+// values of the last snapshot
+static uint32_t TaskProfiler_lastCycles[TP_TASKS];
+static uint32_t TaskProfiler_lastSwitches[TP_TASKS];
+static uint32_t TaskProfiler_lastIsrTicks = 0;
+static uint32_t TaskProfiler_lastPublish = 0;
+
+/*
+ * The wrapped functions of uC/OS-II (see APP_LDFLAGS_USER in the Makefile).
+ */
+void __real_OSTaskSwHook(void);
+void __real_OSIntEnter(void);
+void __real_OSIntExit(void);
+
+//-----------------------Method Implementation---------------------------------
+/*
+ * Called instead of OSTaskSwHook() with interrupts disabled. OSTCBCur is
+ * switched out, OSTCBHighRdy is switched in.
+ */
+void __wrap_OSTaskSwHook(void) {
+	uint32_t now = TimerDriver_getTimestamp();
+	uint32_t isrTicks = TaskProfiler_isrTicks;
+	OS_TCB *current = OSTCBCur;
+	OS_TCB *next = OSTCBHighRdy;
+
+	// OSStart() calls the hook before the first task runs.
+	if (OSRunning) {
+		current->OSTCBCyclesTot += (now - current->OSTCBCyclesStart)
+				- (isrTicks - TaskProfiler_isrAtSwitch);
+		// A task that is not ready any more has finished its activation,
+		// otherwise it was preempted.
+		if (current->OSTCBStat != OS_STAT_RDY || current->OSTCBDly != 0) {
+			if (now - TaskProfiler_activation[current->OSTCBPrio]
+					> TaskProfiler_maxResponse[current->OSTCBPrio]) {
+				TaskProfiler_maxResponse[current->OSTCBPrio] = now
+						- TaskProfiler_activation[current->OSTCBPrio];
+			}
+			TaskProfiler_active[current->OSTCBPrio] = 0;
+		}
+	}
+
+	next->OSTCBCyclesStart = now;
+	TaskProfiler_isrAtSwitch = isrTicks;
+	if (!TaskProfiler_active[next->OSTCBPrio]) {
+		TaskProfiler_activation[next->OSTCBPrio] = now;
+		TaskProfiler_active[next->OSTCBPrio] = 1;
+	}
+	__real_OSTaskSwHook();
+}
+
+/*
+ * Called by the HAL interrupt handler instead of OSIntEnter().
+ */
+void __wrap_OSIntEnter(void) {
+	__real_OSIntEnter();
+	if (OSIntNesting == 1) {
+		TaskProfiler_isrStart = TimerDriver_getTimestamp();
+	}
+}
+
+/*
+ * Called by the HAL interrupt handler instead of OSIntExit(). The interrupt
+ * time is added before OSIntExit() switches the task.
+ */
+void __wrap_OSIntExit(void) {
+	if (OSIntNesting == 1) {
+		TaskProfiler_isrTicks += TimerDriver_getTimestamp()
+				- TaskProfiler_isrStart;
+	}
+	__real_OSIntExit();
+}
+
+int8_t TaskProfiler_publish() {
+	alt_irq_context context;
+	OS_STK_DATA stack;
+	OS_TCB *tcb;
+	uint32_t cycles;
+	uint32_t switches;
+	uint32_t response;
+	uint32_t used;
+	uint32_t size;
+	uint32_t name[2];
+	uint32_t now;
+	uint32_t isrTicks;
+	int8_t result = NO_ERR;
+	uint8_t prio;
+	uint8_t i;
+
+	for (prio = 0; prio < TP_TASKS; prio++) {
+		context = alt_irq_disable_all();
+		tcb = OSTCBPrioTbl[prio];
+		if (tcb == NULL || tcb == OS_TCB_RESERVED) {
+			alt_irq_enable_all(context);
+			continue;
+		}
+		cycles = tcb->OSTCBCyclesTot;
+		switches = tcb->OSTCBCtxSwCtr;
+		response = TaskProfiler_maxResponse[prio];
+		TaskProfiler_maxResponse[prio] = 0;
+		name[0] = 0;
+		name[1] = 0;
+		for (i = 0; i < 8 && i < OS_TASK_NAME_SIZE
+				&& tcb->OSTCBTaskName[i] != '\0'; i++) {
+			name[i / 4] |= (uint32_t) tcb->OSTCBTaskName[i] << (8 * (i % 4));
+		}
+		alt_irq_enable_all(context);
+
+		// Tasks created without OS_TASK_OPT_STK_CHK are reported with size 0.
+		used = 0;
+		size = 0;
+		if (OSTaskStkChk(prio, &stack) == OS_NO_ERR) {
+			used = stack.OSUsed;
+			size = stack.OSUsed + stack.OSFree;
+		}
+		if (size > 0xFFFF) {
+			size = 0xFFFF;
+		}
+		if (used > 0xFFFF) {
+			used = 0xFFFF;
+		}
+
+		if (Logger_write(LOG_PRODUCER_SYSTEM, LOG_ID_TASK_CPU,
+				((uint32_t) prio << 24)
+						| ((switches - TaskProfiler_lastSwitches[prio]) & 0xFFFFFF),
+				cycles - TaskProfiler_lastCycles[prio]) != NO_ERR
+				|| Logger_write(LOG_PRODUCER_SYSTEM, LOG_ID_TASK_STACK,
+						TimerDriver_ticksToUs(response), (used << 16) | size)
+						!= NO_ERR
+				|| Logger_write(LOG_PRODUCER_SYSTEM, LOG_ID_TASK_NAME, name[0],
+						name[1]) != NO_ERR) {
+			result = ERR_LOG_RING_FULL;
+		}
+		TaskProfiler_lastCycles[prio] = cycles;
+		TaskProfiler_lastSwitches[prio] = switches;
+	}
+
+	now = TimerDriver_getTimestamp();
+	isrTicks = TaskProfiler_isrTicks;
+	if (Logger_write(LOG_PRODUCER_SYSTEM, LOG_ID_TASK_WINDOW,
+			now - TaskProfiler_lastPublish, isrTicks - TaskProfiler_lastIsrTicks)
+			!= NO_ERR) {
+		result = ERR_LOG_RING_FULL;
+	}
+	TaskProfiler_lastPublish = now;
+	TaskProfiler_lastIsrTicks = isrTicks;
+	return result;
+}
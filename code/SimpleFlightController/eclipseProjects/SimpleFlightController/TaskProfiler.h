@@ -0,0 +1,54 @@
+/*
+ * Per task cpu and stack profiler.
+ * <p>
+ * OSTaskSwHook(), OSIntEnter() and OSIntExit() are wrapped by the linker
+ * (--wrap in the Makefile) and take a timestamp of Driver_Timer.h at every
+ * context switch and interrupt, the BSP is not changed. The execution time of
+ * a task is accumulated in OSTCBCyclesTot of its TCB in timestamp ticks
+ * (TIMERDRIVER_FREQ), without the time spent in interrupt service routines,
+ * which is accumulated separately.
+ * <p>
+ * The response time of a task is measured from the first dispatch after
+ * the task blocked until it blocks again, including the preemption by
+ * higher priority tasks and interrupts.
+ * <p>
+ * TaskProfiler_publish() sends a snapshot of all tasks as log records
+ * (producer LOG_PRODUCER_SYSTEM). For every task:
+ * LOG_ID_TASK_CPU		data[0]: priority << 24 | context switches,
+ * 						data[1]: execution time in timestamp ticks,
+ * LOG_ID_TASK_STACK	data[0]: max response time in us,
+ * 						data[1]: used stack bytes << 16 | stack size in bytes,
+ * LOG_ID_TASK_NAME		data[0..1]: the first 8 characters of the task name,
+ * all since the last snapshot, followed by
+ * LOG_ID_TASK_WINDOW	data[0]: length of the snapshot in timestamp ticks,
+ * 						data[1]: interrupt time in timestamp ticks.
+ * tools/tasktop.py shows the snapshots like top.
+ */
+
+#ifndef TASKPROFILER_H_
+#define TASKPROFILER_H_
+
+//-----------------------Includes----------------------------------------------
+#include "stdint.h" // Include stdint.h for the use of Integers with a defined size
+
+//-----------------------Defines-----------------------------------------------
+/* ---- Log record ids ---- */
+#define LOG_ID_TASK_CPU			0x0120
+#define LOG_ID_TASK_STACK		0x0121
+#define LOG_ID_TASK_NAME		0x0122
+#define LOG_ID_TASK_WINDOW		0x0123
+
+//-----------------------Method Declaration------------------------------------
+/**
+ * This function sends a snapshot of all tasks to the logger.
+ * <p>
+ * It checks the stacks of all tasks, so it should be called by a low
+ * priority task, e.g. once per second. The maximum response times are
+ * reset afterwards.
+ *
+ * @return	ERR_LOG_RING_FULL	If records of the snapshot were dropped.
+ * 			NO_ERR				If everything is fine.
+ */
+int8_t TaskProfiler_publish();
+
+#endif /* TASKPROFILER_H_ */
@@ -0,0 +1,283 @@
+/*
+ * Compact telemetry stream.
+ * <p>
+ * Telemetry_commit() is the only producer and the send task the only
+ * consumer of the byte ring, so no lock is needed.
+ * Telemetry_setDecimation() only writes the next schedule, Telemetry_commit()
+ * takes it over at the start of a packet and restarts with a key packet, so
+ * the decoder never parses a packet with the wrong schedule.
+ */
+
+//-----------------------Includes----------------------------------------------
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include "includes.h"
+#include "Telemetry.h"
+#include "b_errorcodes.h"
+
+//-----------------------Defines-----------------------------------------------
+#define TLM_RING_MASK		(TLM_RING_SIZE - 1)
+#define TLM_MAX_PACKET_SIZE	(1 + 1 + TLM_FIELD_COUNT + 5 * TLM_FIELD_COUNT + 2)
+#define TLM_SEND_CHUNK		64
+#define CRC_POLYNOM			0x1021	// CRC16 CCITT, same as SUMD
+
+#define TLM_BARRIER()		__asm__ __volatile__("" ::: "memory")
+
+//-----------------------Attributes--------------------------------------------
+enum TelemetryState Telemetry_state = TLM_NOTAVAILABLE;
+
+static uint8_t Telemetry_decimation[TLM_FIELD_COUNT] = {
+	1, 1, 1,			// acceleration
+	1, 1, 1,			// rotation rate
+	8, 8, 8,			// magnetic field
+	2, 2, 2,			// attitude
+	8, 8, 8, 8, 16, 16,	// rc channels
+	2, 2, 2, 2, 2, 2	// motors
+};
+static uint8_t Telemetry_nextDecimation[TLM_FIELD_COUNT];
+static volatile uint8_t Telemetry_decimationChanged = 0;
+static int32_t Telemetry_values[TLM_FIELD_COUNT];
+static int32_t Telemetry_sent[TLM_FIELD_COUNT];	// delta base, last enqueued values
+static uint8_t Telemetry_seq = 0;
+static uint16_t Telemetry_crcTable[256];
+
+static uint8_t Telemetry_packet[TLM_MAX_PACKET_SIZE];
+static uint8_t Telemetry_frame[TLM_MAX_FRAME_SIZE];
+
+static uint8_t Telemetry_ring[TLM_RING_SIZE];
+static volatile uint32_t Telemetry_head = 0;	// written by Telemetry_commit()
+static volatile uint32_t Telemetry_tail = 0;	// written by the send task
+static volatile uint32_t Telemetry_dropped = 0;
+
+static TelemetrySink Telemetry_sink;
+static int Telemetry_fd = -1;
+static OS_STK Telemetry_task_stk[TLM_TASK_STACKSIZE];
+
+//-----------------------Method Implementation---------------------------------
+/*
+ * Default sink, writes to UART_0.
+ */
+static int32_t Telemetry_uartSink(const uint8_t *buffer, uint32_t length) {
+	return write(Telemetry_fd, buffer, length);
+}
+
+static void Telemetry_initCrcTable() {
+	uint16_t crc;
+	uint16_t i;
+	uint8_t bit;
+
+	for (i = 0; i < 256; i++) {
+		crc = i << 8;
+		for (bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ CRC_POLYNOM : (crc << 1);
+		}
+		Telemetry_crcTable[i] = crc;
+	}
+}
+
+static uint16_t Telemetry_crc(const uint8_t *data, uint32_t length) {
+	uint16_t crc = 0;
+
+	while (length--) {
+		crc = (crc << 8) ^ Telemetry_crcTable[(crc >> 8) ^ *data++];
+	}
+	return crc;
+}
+
+/*
+ * Writes value as zig-zag varint to buffer and returns the number of bytes.
+ */
+static uint8_t Telemetry_putVarint(uint8_t *buffer, int32_t value) {
+	uint32_t zigzag = ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+	uint8_t length = 0;
+
+	while (zigzag >= 0x80) {
+		buffer[length++] = (uint8_t) zigzag | 0x80;
+		zigzag >>= 7;
+	}
+	buffer[length++] = (uint8_t) zigzag;
+	return length;
+}
+
+/*
+ * COBS encodes length bytes of src to dst and appends the delimiter.
+ * Returns the number of bytes written to dst.
+ */
+static uint32_t Telemetry_cobsEncode(const uint8_t *src, uint32_t length,
+		uint8_t *dst) {
+	uint32_t code = 0;	// index of the current code byte
+	uint32_t out = 1;
+	uint8_t run = 1;
+	uint32_t i;
+
+	for (i = 0; i < length; i++) {
+		if (src[i] == 0) {
+			dst[code] = run;
+			code = out++;
+			run = 1;
+		} else {
+			dst[out++] = src[i];
+			run++;
+			if (run == 0xFF) {
+				dst[code] = run;
+				code = out++;
+				run = 1;
+			}
+		}
+	}
+	dst[code] = run;
+	dst[out++] = 0;
+	return out;
+}
+
+/*
+ * Sends the content of the ring.
+ */
+static void Telemetry_task(void *pdata) {
+	uint8_t chunk[TLM_SEND_CHUNK];
+	uint32_t available;
+	uint32_t count;
+	int32_t sent;
+
+	while (1) {
+		available = Telemetry_head - Telemetry_tail;
+		if (available == 0) {
+			OSTimeDly(1);
+			continue;
+		}
+		count = 0;
+		while (count < available && count < TLM_SEND_CHUNK) {
+			chunk[count] = Telemetry_ring[(Telemetry_tail + count) & TLM_RING_MASK];
+			count++;
+		}
+		sent = Telemetry_sink(chunk, count);
+		if (sent <= 0) {
+			OSTimeDly(1);
+			continue;
+		}
+		TLM_BARRIER();
+		Telemetry_tail += sent;
+	}
+}
+
+int8_t Telemetry_init(TelemetrySink sink) {
+	INT8U err;
+
+	if (Telemetry_state == TLM_INITIALIZED) {
+		return NO_ERR;
+	}
+	Telemetry_initCrcTable();
+
+	if (sink == NULL) {
+		Telemetry_fd = open(TLM_OUTPUT_UART, O_WRONLY);
+		if (Telemetry_fd < 0) {
+			return ERR_TLM_OUTPUT;
+		}
+		sink = Telemetry_uartSink;
+	}
+	Telemetry_sink = sink;
+
+	err = OSTaskCreateExt(Telemetry_task, NULL,
+			(void *) &Telemetry_task_stk[TLM_TASK_STACKSIZE - 1],
+			TLM_TASK_PRIORITY, TLM_TASK_PRIORITY, Telemetry_task_stk,
+			TLM_TASK_STACKSIZE, NULL, OS_TASK_OPT_STK_CHK);
+	if (err != OS_NO_ERR) {
+		return ERR_TLM_TASK;
+	}
+
+	Telemetry_state = TLM_INITIALIZED;
+	return NO_ERR;
+}
+
+int8_t Telemetry_setDecimation(enum TelemetryField field, uint8_t decimation) {
+	if (field >= TLM_FIELD_COUNT || decimation == 0
+			|| decimation > TLM_MAX_DECIMATION
+			|| (decimation & (decimation - 1)) != 0) {
+		return ERR_TLM_ILLEGAL_RANGE;
+	}
+	if (!Telemetry_decimationChanged) {
+		memcpy(Telemetry_nextDecimation, Telemetry_decimation,
+				sizeof(Telemetry_nextDecimation));
+	}
+	Telemetry_nextDecimation[field] = decimation;
+	TLM_BARRIER();
+	Telemetry_decimationChanged = 1;
+	return NO_ERR;
+}
+
+void Telemetry_set(enum TelemetryField field, int32_t value) {
+	Telemetry_values[field] = value;
+}
+
+int8_t Telemetry_commit() {
+	uint32_t length = 0;
+	uint32_t frameLength;
+	uint32_t head;
+	uint32_t i;
+	uint16_t crc;
+	uint8_t key;
+
+	if (Telemetry_state != TLM_INITIALIZED) {
+		return ERR_TLM_WRONG_STATE;
+	}
+
+	// The decoder only learns the decimations from a key packet, so a new
+	// schedule starts with one.
+	if (Telemetry_decimationChanged) {
+		Telemetry_decimationChanged = 0;
+		TLM_BARRIER();
+		memcpy(Telemetry_decimation, Telemetry_nextDecimation,
+				sizeof(Telemetry_decimation));
+		Telemetry_seq = 0;
+	}
+
+	// The decimations are powers of two that divide 256, so the schedule
+	// stays the same when seq wraps around.
+	key = (Telemetry_seq == 0);
+	Telemetry_packet[length++] = Telemetry_seq;
+	if (key) {
+		Telemetry_packet[length++] = TLM_FIELD_COUNT;
+		for (i = 0; i < TLM_FIELD_COUNT; i++) {
+			Telemetry_packet[length++] = Telemetry_decimation[i];
+		}
+	}
+	for (i = 0; i < TLM_FIELD_COUNT; i++) {
+		if ((Telemetry_seq & (Telemetry_decimation[i] - 1)) == 0) {
+			length += Telemetry_putVarint(&Telemetry_packet[length],
+					key ? Telemetry_values[i] :
+							Telemetry_values[i] - Telemetry_sent[i]);
+		}
+	}
+	crc = Telemetry_crc(Telemetry_packet, length);
+	Telemetry_packet[length++] = crc >> 8;
+	Telemetry_packet[length++] = crc & 0xFF;
+
+	frameLength = Telemetry_cobsEncode(Telemetry_packet, length, Telemetry_frame);
+
+	head = Telemetry_head;
+	if (TLM_RING_SIZE - (head - Telemetry_tail) < frameLength) {
+		// The delta base is not updated, so the next packet is still
+		// decoded correctly after the gap.
+		Telemetry_dropped++;
+		Telemetry_seq++;
+		return ERR_TLM_RING_FULL;
+	}
+	for (i = 0; i < frameLength; i++) {
+		Telemetry_ring[(head + i) & TLM_RING_MASK] = Telemetry_frame[i];
+	}
+	TLM_BARRIER();
+	Telemetry_head = head + frameLength;
+
+	for (i = 0; i < TLM_FIELD_COUNT; i++) {
+		if ((Telemetry_seq & (Telemetry_decimation[i] - 1)) == 0) {
+			Telemetry_sent[i] = Telemetry_values[i];
+		}
+	}
+	Telemetry_seq++;
+	return NO_ERR;
+}
+
+uint32_t Telemetry_getDropped() {
+	return Telemetry_dropped;
+}
@@ -0,0 +1,117 @@
+/*
+ * Compact telemetry stream.
+ * <p>
+ * The values of one control cycle are collected with Telemetry_set() and
+ * encoded into one packet with Telemetry_commit(). Every field is sent as
+ * zig-zag varint of the difference to the value sent before, so slowly
+ * changing values need a single byte. A field is only sent in packets whose
+ * sequence number is a multiple of its decimation.
+ * <p>
+ * Packet (before framing):
+ *   seq (1 byte)
+ *   if seq == 0 (key packet): TLM_FIELD_COUNT, decimation of every field
+ *   zig-zag varints of the scheduled fields
+ *   CRC16 CCITT over all bytes before (2 bytes, high byte first)
+ * Key packets contain the absolute values instead of differences.
+ * The packet is COBS encoded and terminated with a 0x00 byte.
+ * <p>
+ * The packets are buffered in a ring and sent by a low priority task to a
+ * sink. The default sink is UART_0, a node with a MCAPI link can pass a sink
+ * that sends the bytes over a packet channel to the HPS.
+ * tools/telemetrydecode.py decodes a captured stream.
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+//-----------------------Includes----------------------------------------------
+#include "stdint.h" // Include stdint.h for the use of Integers with a defined size
+#include <system.h>
+
+//-----------------------Defines-----------------------------------------------
+#define TLM_RING_SIZE			2048	// bytes, has to be a power of two
+#define TLM_MAX_FRAME_SIZE		160		// bytes of the largest encoded frame
+#define TLM_MAX_DECIMATION		128		// decimations are powers of two up to this
+
+#define TLM_TASK_PRIORITY		(OS_LOWEST_PRIO - 3)
+#define TLM_TASK_STACKSIZE		1024
+
+#define TLM_OUTPUT_UART			UART_0_NAME
+
+//-----------------------Attributes--------------------------------------------
+enum TelemetryState {
+	TLM_NOTAVAILABLE, TLM_INITIALIZED
+};
+
+/*
+ * The order has to match FIELDS in tools/telemetrydecode.py.
+ */
+enum TelemetryField {
+	TLM_ACC_X, TLM_ACC_Y, TLM_ACC_Z,
+	TLM_GYRO_X, TLM_GYRO_Y, TLM_GYRO_Z,
+	TLM_MAG_X, TLM_MAG_Y, TLM_MAG_Z,
+	TLM_ROLL, TLM_PITCH, TLM_YAW,
+	TLM_RC_THROTTLE, TLM_RC_ROLL, TLM_RC_PITCH, TLM_RC_YAW, TLM_RC_AUX1, TLM_RC_AUX2,
+	TLM_MOTOR_1, TLM_MOTOR_2, TLM_MOTOR_3, TLM_MOTOR_4, TLM_MOTOR_5, TLM_MOTOR_6,
+	TLM_FIELD_COUNT
+};
+
+/*
+ * Sends length bytes of buffer. Returns the number of bytes sent or a
+ * negative value on error.
+ */
+typedef int32_t (*TelemetrySink)(const uint8_t *buffer, uint32_t length);
+
+//-----------------------Method Declaration------------------------------------
+/**
+ * This function initializes the telemetry and creates the send task.
+ *
+ * @param	sink	The function the frames are sent with, NULL for UART_0.
+ * @return	ERR_TLM_OUTPUT		If UART_0 could not be opened.
+ * 			ERR_TLM_TASK		If the send task could not be created.
+ * 			NO_ERR				If everything is fine.
+ */
+int8_t Telemetry_init(TelemetrySink sink);
+
+/**
+ * This function sets the decimation of a field.
+ * <p>
+ * The field is sent in every decimation-th packet. The new decimation is
+ * used from the next Telemetry_commit() on, which then sends a key packet.
+ *
+ * @param	field		The field.
+ * 			decimation	A power of two from 1 to TLM_MAX_DECIMATION.
+ * @return	ERR_TLM_ILLEGAL_RANGE	If the decimation is not allowed.
+ * 			NO_ERR					If everything is fine.
+ */
+int8_t Telemetry_setDecimation(enum TelemetryField field, uint8_t decimation);
+
+/**
+ * This function sets the value of a field for the next packet.
+ *
+ * @param	field	The field.
+ * 			value	The value.
+ */
+void Telemetry_set(enum TelemetryField field, int32_t value);
+
+/**
+ * This function encodes the current values into a packet.
+ * <p>
+ * It never blocks. If the ring is full the packet is dropped and counted,
+ * the receiver sees a gap in the sequence numbers.
+ * It has to be called by one task only.
+ *
+ * @return	ERR_TLM_WRONG_STATE	If the telemetry is not initialized.
+ * 			ERR_TLM_RING_FULL	If the packet was dropped.
+ * 			NO_ERR				If everything is fine.
+ */
+int8_t Telemetry_commit();
+
+/**
+ * This function gets the number of dropped packets.
+ *
+ * @return	The number of packets dropped since Telemetry_init().
+ */
+uint32_t Telemetry_getDropped();
+
+#endif /* TELEMETRY_H_ */
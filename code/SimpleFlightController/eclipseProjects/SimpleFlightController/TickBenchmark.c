@@ -0,0 +1,104 @@
+/*
+ * Benchmark of the OS tick.
+ */
+
+//-----------------------Includes----------------------------------------------
+#include <stdio.h>
+#include <sys/alt_irq.h>
+#include "includes.h"
+#include "TickBenchmark.h"
+#include "Drivers/Driver_Timer.h"
+
+//-----------------------Defines-----------------------------------------------
+// Longer than all ticks of the benchmark, the tasks never wake up.
+#define TICKBENCHMARK_DELAY		60000
+
+//-----------------------Attributes--------------------------------------------
+static OS_STK TickBenchmark_stacks[TICKBENCHMARK_MAX_TASKS][TICKBENCHMARK_STACKSIZE];
+
+//-----------------------Method Implementation---------------------------------
+/*
+ * Delayed task, the delays are spread over the slots of the timing wheel.
+ */
+static void TickBenchmark_task(void *pdata) {
+	uint32_t index = (uint32_t) pdata;
+
+	while (1) {
+		OSTimeDly(TICKBENCHMARK_DELAY - 37 * index);
+	}
+}
+
+/*
+ * Calls the tick TICKBENCHMARK_SAMPLES times and prints the times.
+ * <p>
+ * The tick counter and the cursor of the timing wheel (the slot follows
+ * from OSTickWheelTime) are restored after every sample, so the delays of
+ * all tasks keep their expiry. Tasks that expire with the next tick are
+ * made ready by the first sample already.
+ */
+static void TickBenchmark_measure(uint8_t tasks) {
+	alt_irq_context context;
+	uint32_t start;
+	uint32_t ticks;
+	uint32_t sum = 0;
+	uint32_t max = 0;
+	INT32U time;
+#if OS_TICK_WHEEL_EN > 0
+	INT32U wheelTime;
+#endif
+	uint16_t i;
+
+	for (i = 0; i < TICKBENCHMARK_SAMPLES; i++) {
+		// One sample at a time, the timestamp needs the timer interrupt.
+		context = alt_irq_disable_all();
+		time = OSTime;
+#if OS_TICK_WHEEL_EN > 0
+		wheelTime = OSTickWheelTime;
+#endif
+		start = TimerDriver_getTimestamp();
+		OSTimeTick();
+		ticks = TimerDriver_getTimestamp() - start;
+		OSTime = time;
+#if OS_TICK_WHEEL_EN > 0
+		OSTickWheelTime = wheelTime;
+#endif
+		alt_irq_enable_all(context);
+
+		sum += ticks;
+		if (ticks > max) {
+			max = ticks;
+		}
+	}
+	printf("%5u  %7lu  %7lu\n", tasks,
+			(sum / TICKBENCHMARK_SAMPLES) * 1000 / TIMERDRIVER_TICKS_PER_US,
+			max * 1000 / TIMERDRIVER_TICKS_PER_US);
+}
+
+uint8_t TickBenchmark_run(uint8_t firstPriority, uint8_t lastPriority) {
+	uint8_t tasks = 0;
+	uint8_t prio;
+
+	printf("OSTimeTick() benchmark, timing wheel %s\n",
+			OS_TICK_WHEEL_EN > 0 ? "on" : "off");
+	printf("tasks  avg[ns]  max[ns]\n");
+	TickBenchmark_measure(0);
+
+	for (prio = firstPriority; prio <= lastPriority
+			&& tasks < TICKBENCHMARK_MAX_TASKS; prio++) {
+		if (OSTaskCreateExt(TickBenchmark_task, (void *) (uint32_t) tasks,
+				&TickBenchmark_stacks[tasks][TICKBENCHMARK_STACKSIZE - 1], prio,
+				prio, TickBenchmark_stacks[tasks], TICKBENCHMARK_STACKSIZE,
+				NULL, OS_TASK_OPT_NONE) != OS_NO_ERR) {
+			break;
+		}
+		tasks++;
+		// Lets the new task run and delay itself.
+		OSTimeDly(1);
+		TickBenchmark_measure(tasks);
+	}
+
+	for (prio = firstPriority; prio < firstPriority + tasks; prio++) {
+		OSTaskDel(prio);
+	}
+	return tasks;
+}
@@ -0,0 +1,49 @@
+/*
+ * Benchmark of the OS tick.
+ * <p>
+ * Measures the time of OSTimeTick() against the number of delayed tasks.
+ * The benchmark creates one task after the other, every task delays itself
+ * for a long time, so every task stays in the delayed list of the kernel
+ * during the measurement. After each created task the tick is called
+ * TICKBENCHMARK_SAMPLES times with the interrupts disabled and the average
+ * and maximum time are printed:
+ *
+ *   tasks  avg[ns]  max[ns]
+ *
+ * With OS_TICK_WHEEL_EN (see os_cfg.h) the time stays constant, without it
+ * grows with every task. Both BSP and application have to be rebuilt after
+ * OS_TICK_WHEEL_EN was changed, the OS_TCB depends on it.
+ * <p>
+ * The number of tasks is limited by the free TCBs (OS_MAX_TASKS in the BSP)
+ * and by the priorities passed to TickBenchmark_run(). The application is
+ * built with the benchmark instead of the flight control by
+ * make TICK_BENCHMARK=1.
+ */
+
+#ifndef TICKBENCHMARK_H_
+#define TICKBENCHMARK_H_
+
+//-----------------------Includes----------------------------------------------
+#include "stdint.h" // Include stdint.h for the use of Integers with a defined size
+
+//-----------------------Defines-----------------------------------------------
+#define TICKBENCHMARK_MAX_TASKS		16
+#define TICKBENCHMARK_SAMPLES		1000	// ticks per task count
+#define TICKBENCHMARK_STACKSIZE		512
+
+//-----------------------Method Declaration------------------------------------
+/**
+ * This function runs the benchmark and prints the results.
+ * <p>
+ * It has to be called by a task with a higher priority than firstPriority.
+ * The delayed tasks are deleted at the end. The benchmark calls the tick
+ * itself, so the delays of all tasks advance faster than the real time,
+ * OSTime is kept.
+ *
+ * @param	firstPriority	The priority of the first delayed task.
+ * 			lastPriority	The priority of the last delayed task.
+ * @return	The number of delayed tasks that could be created.
+ */
+uint8_t TickBenchmark_run(uint8_t firstPriority, uint8_t lastPriority);
+
+#endif /* TICKBENCHMARK_H_ */
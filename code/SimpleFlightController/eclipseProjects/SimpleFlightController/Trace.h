@@ -0,0 +1,49 @@
+/*
+ * Deferred formatted trace output.
+ * <p>
+ * TRACE(fmt, args...) works like printf but does not format on the target.
+ * The format string is placed in the section .trace_fmt which is not loaded
+ * into memory (see Trace.ld). Only the offset of the string inside this
+ * section and the raw arguments are written to the log ring of the producer.
+ * The host tool tools/logdecode.py reads the strings from
+ * SimpleFlightController.elf and formats the messages.
+ * <p>
+ * Only integer arguments (%d, %i, %u, %x, %X, %o, %c) are supported, every
+ * argument is transferred as 32 bit value. At most TRACE_MAX_ARGS arguments
+ * can be passed, more fail the build.
+ * <p>
+ * The log ring is selected with LOG_TRACE_PRODUCER. A file that traces from
+ * another task than the system producer has to define it before the include:
+ *
+ *   #define LOG_TRACE_PRODUCER LOG_PRODUCER_SENSOR
+ *   #include "Trace.h"
+ *   ...
+ *   TRACE("x: %d y: %d z: %d\n", x, y, z);
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+//-----------------------Includes----------------------------------------------
+#include "stdint.h" // Include stdint.h for the use of Integers with a defined size
+#include "Logger.h"
+
+//-----------------------Defines-----------------------------------------------
+#ifndef LOG_TRACE_PRODUCER
+#define LOG_TRACE_PRODUCER		LOG_PRODUCER_SYSTEM
+#endif
+
+#define TRACE_MAX_ARGS			12
+
+#define TRACE(fmt, ...) \
+	do { \
+		static const char traceFormat[] \
+				__attribute__((section(".trace_fmt"), used)) = fmt; \
+		const uint32_t traceArgs[] = { 0, ##__VA_ARGS__ }; \
+		typedef char traceArgCountCheck[(sizeof(traceArgs) / sizeof(uint32_t) \
+				- 1 <= TRACE_MAX_ARGS) ? 1 : -1] __attribute__((unused)); \
+		Logger_writeTrace(LOG_TRACE_PRODUCER, (uint32_t) traceFormat, \
+				sizeof(traceArgs) / sizeof(uint32_t) - 1, &traceArgs[1]); \
+	} while (0)
+
+#endif /* TRACE_H_ */
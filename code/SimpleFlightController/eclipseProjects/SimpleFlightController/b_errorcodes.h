@@ -8,6 +8,7 @@
 //-----------------------Defines-----------------------------------------------
 // general errors
 #define NO_ERR					  0	// if no error exist
+#define INIT_PENDING			  1	// the device is initializing, call the init step again at the ready time
 
 // I2CDriver Module
 #define ERR_I2C_WRONG_STATE 	-10	// The I2C driver is in the wrong state
@@ -32,4 +33,42 @@
 //Motor Driver
 #define ERR_MOTOR_ILLEGAL_RANGE -60	// The input value is not in the correct range.
 
+// Logger Module
+#define ERR_LOG_WRONG_STATE 	-70	// The logger is not initialized
+#define ERR_LOG_RING_FULL 		-71	// The ring of the producer is full, the record was dropped
+#define ERR_LOG_OUTPUT 			-72	// The output device could not be opened
+#define ERR_LOG_TASK 			-73	// The drain task could not be created
+
+// Telemetry Module
+#define ERR_TLM_WRONG_STATE 	-80	// The telemetry is not initialized
+#define ERR_TLM_RING_FULL 		-81	// The ring is full, the packet was dropped
+#define ERR_TLM_OUTPUT 			-82	// The output device could not be opened
+#define ERR_TLM_TASK 			-83	// The send task could not be created
+#define ERR_TLM_ILLEGAL_RANGE 	-84	// The input value is not in the correct range.
+
+// Blackbox Module
+#define ERR_BB_WRONG_STATE 		-90	// The recorder is not frozen
+#define ERR_BB_DUMP 			-91	// The record could not be sent
+
+// Task Graph
+#define ERR_TG_ILLEGAL_RANGE 	-100	// The input value is not in the correct range.
+#define ERR_TG_NOT_RATE_MONOTONIC -101	// A stage with a shorter period has a lower priority
+#define ERR_TG_NOT_SCHEDULABLE 	-102	// The utilisation is above the rate monotonic bound
+#define ERR_TG_OS 				-103	// The event flags or a task could not be created
+
+// Timer Driver
+#define ERR_TIMER_WRONG_STATE 	-110	// The control timebase is in the wrong state
+#define ERR_TIMER_ILLEGAL_RANGE -111	// The input value is not in the correct range.
+#define ERR_TIMER_OS 			-112	// The release semaphore could not be created
+
+// Message Channels, int8_t ends at -128
+#define ERR_CH_OS 				-123	// A partition, semaphore or queue could not be created
+#define ERR_CH_FULL 			-124	// The channel is full, the message was dropped
+#define ERR_CH_ILLEGAL_BLOCK 	-125	// The block is not part of the pool of the channel
+#define ERR_CH_ILLEGAL_RANGE 	-126	// The input value is not in the correct range.
+
+// Console
+#define ERR_CON_IRQ 			-127	// The interrupt handler of the JTAG UART could not be registered
+#define ERR_CON_OS 				-128	// The lock of the console could not be created
+
 #endif /* S_ERRORCODES_H_ */
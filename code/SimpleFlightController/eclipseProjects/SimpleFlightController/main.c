@@ -1,119 +1,560 @@
-/*************************************************************************
-* Copyright (c) 2004 Altera Corporation, San Jose, California, USA.      *
-* All rights reserved. All use of this software and documentation is     *
-* subject to the License Agreement located at the end of this file below.*
-**************************************************************************
-* Description:                                                           *
-* The following is a simple hello world program running MicroC/OS-II.The * 
-* purpose of the design is to be a very simple application that just     *
-* demonstrates MicroC/OS-II running on NIOS II.The design doesn't account*
-* for issues such as checking system call return codes. etc.             *
-*                                                                        *
-* Requirements:                                                          *
-*   -Supported Example Hardware Platforms                                *
-*     Standard                                                           *
-*     Full Featured                                                      *
-*     Low Cost                                                           *
-*   -Supported Development Boards                                        *
-*     Nios II Development Board, Stratix II Edition                      *
-*     Nios Development Board, Stratix Professional Edition               *
-*     Nios Development Board, Stratix Edition                            *
-*     Nios Development Board, Cyclone Edition                            *
-*   -System Library Settings                                             *
-*     RTOS Type - MicroC/OS-II                                           *
-*     Periodic System Timer                                              *
-*   -Know Issues                                                         *
-*     If this design is run on the ISS, terminal output will take several*
-*     minutes per iteration.                                             *
-**************************************************************************/
-
+/*
+ * Main of the SimpleFlightController.
+ * <p>
+ * Defines the task graph of the flight controller:
+ *
+ *   sensor --> estimator --> control --> mixer --> telemetry
+ *                               ^
+ *   rc ------(latest value)-----'
+ *   housekeeping (statistics, task profile, channels, console)
+ *
+ * sensor, rc and housekeeping are periodic, the other stages are
+ * released by the message of their predecessor. The sensor stage takes a
+ * control cycle block, which is passed through the channels (see
+ * Channel.h) down to telemetry without a copy, every stage fills its part.
+ * The sensor channel keeps the latest sample only, the rc frames are taken
+ * by control as latest value. Control arms with the arm switch of the rc
+ * and triggers the blackbox (see Blackbox.h) on the disarm and with the
+ * blackbox switch. Housekeeping dumps a frozen record to the console when
+ * BLACKBOX_DUMP_COMMAND is received on stdin while disarmed and rearms
+ * the recorder. The sensor stage is
+ * released by the control timebase of the timer driver with CONTROL_RATE_HZ,
+ * independent of the OS tick. The priorities are rate monotonic, stages
+ * with the same period are ordered along the data flow.
+ * <p>
+ * The init task brings up the sensors and arms the motor controllers in
+ * parallel (see DeviceInit.h), sleeping on high resolution timers (see
+ * HiresTimer.h) for their settle times, before it starts the task graph.
+ * After init no buffer comes from the heap: the control cycles and rc
+ * frames come from the fixed-block pools of their channels (see
+ * Channel.h), all other buffers are static. A build with TRAP_MALLOC=1
+ * traps every heap allocation from then on (see MemPool.h). The text output
+ * and the log records go through the non-blocking console (see Console.h).
+ * A build with TICK_BENCHMARK=1 runs the benchmark of the OS tick (see
+ * TickBenchmark.h) instead of the flight control.
+ */
 
+//-----------------------Includes----------------------------------------------
 #include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "includes.h"
+#include "Logger.h"
+#include "Telemetry.h"
+#include "Blackbox.h"
+#include "TaskGraph.h"
+#include "TaskProfiler.h"
+#include "Profiler.h"
+#include "DeviceInit.h"
+#include "MemPool.h"
+#include "Channel.h"
+#include "Console.h"
+#include "TickBenchmark.h"
+#include "HiresTimer.h"
+#include "SensorDataManager.h"
+#include "Drivers/Driver_Accl.h"
+#include "Drivers/Driver_Gyro.h"
+#include "Drivers/Driver_Compa.h"
+#include "Drivers/Driver_Motor.h"
+#include "Drivers/Driver_Timer.h"
+#include "b_errorcodes.h"
+
+//-----------------------Defines-----------------------------------------------
+/* ---- Periods ---- */
+#define CONTROL_RATE_HZ			500
+#define CONTROL_PERIOD			(1000000 / CONTROL_RATE_HZ)	// us, sensor to telemetry
+#define RC_PERIOD				20000	// us
+#define HOUSEKEEPING_PERIOD		1000000	// us
+
+/* ---- Profiling ---- */
+// pc samples per control period, 0 disables the sampling profiler.
+// Can be set with APP_CFLAGS_DEFINED_SYMBOLS.
+#ifndef PROFILER_SAMPLES
+#define PROFILER_SAMPLES		0
+#endif
+
+/* ---- Priorities ---- */
+#define INIT_PRIORITY			4	// above all stages, the stages start after init
+#define SENSOR_PRIORITY			5
+#define ESTIMATOR_PRIORITY		6
+#define CONTROL_PRIORITY		7
+#define MIXER_PRIORITY			8
+#define TELEMETRY_PRIORITY		9
+#define RC_PRIORITY				10
+#define HOUSEKEEPING_PRIORITY	11
+
+/* ---- Stack sizes ---- */
+#define INIT_STACKSIZE			2048
+#define SENSOR_STACKSIZE		1024
+#define ESTIMATOR_STACKSIZE		1024
+#define CONTROL_STACKSIZE		1024
+#define MIXER_STACKSIZE			1024
+#define TELEMETRY_STACKSIZE		1024
+#define RC_STACKSIZE			1024
+#define HOUSEKEEPING_STACKSIZE	2048
+
+/* ---- Log record ids ---- */
+#define LOG_ID_STAGE_STATISTIC	0x0100	// producer SYSTEM, id + stage, data[0]: max us, data[1]: overruns
+#define LOG_ID_CONTROL_LATENCY	0x0110	// producer SYSTEM, data[0]: min << 16 | max release latency in timer ticks, data[1]: overruns
+#define LOG_ID_BOOT_TIME		0x0140	// producer SYSTEM, data[0]: us from start to armed controllers, data[1]: result of the device init
+#define LOG_ID_STAGE_BUDGET		0x0180	// producer SYSTEM, id + stage, data[0]: jobs above the wcet, data[1]: jobs
+#define LOG_ID_BLACKBOX			0x0190	// producer SYSTEM, data[0]: state of the recorder, data[1]: result of the dump
+
+#define SENSOR_VALUES			9
+#define RC_CHANNELS				6
+
+/* ---- RC switches ---- */
+#define RC_ARM_CHANNEL			4		// aux 1, armed while on
+#define RC_BLACKBOX_CHANNEL		5		// aux 2, triggers the blackbox when switched on
+#define RC_SWITCH_ON			0x2ee0	// SUMD value of the neutral position (1500 us), on above
+
+#define BLACKBOX_DUMP_COMMAND	'd'		// received on stdin
+
+/* ---- Channels ---- */
+// Every stage from sensor to telemetry holds one block, the others are
+// queue entries.
+#define CYCLE_BLOCKS			(5 + 1 + 2 + 2 + 2)
+#define RC_FRAME_BLOCKS			3
+
+//-----------------------Attributes--------------------------------------------
+static OS_STK init_stk[INIT_STACKSIZE];
+static OS_STK sensor_stk[SENSOR_STACKSIZE];
+static OS_STK estimator_stk[ESTIMATOR_STACKSIZE];
+static OS_STK control_stk[CONTROL_STACKSIZE];
+static OS_STK mixer_stk[MIXER_STACKSIZE];
+static OS_STK telemetry_stk[TELEMETRY_STACKSIZE];
+static OS_STK rc_stk[RC_STACKSIZE];
+static OS_STK housekeeping_stk[HOUSEKEEPING_STACKSIZE];
+
+/*
+ * One control cycle. The block is passed from the sensor stage to the
+ * telemetry stage, every value is written by one stage only.
+ */
+struct ControlCycle {
+	uint32_t timestamp;				// sensor, see Driver_Timer.h
+	double sensor[SENSOR_VALUES];	// sensor, acc xyz, gyro xyz, mag xyz
+	int16_t attitude[3];			// estimator
+	int16_t rate[3];
+	int16_t setpoint[3];			// control
+	int16_t throttle;
+	uint16_t rc[RC_CHANNELS];		// control, the rc channels used
+	uint8_t armed;
+	uint8_t motor[6];				// mixer
+};
+
+/*
+ * One frame of the rc receiver.
+ */
+struct RcFrame {
+	uint16_t channels[RC_CHANNELS];
+	uint8_t failsafe;
+};
+
+CHANNEL_POOL(cyclePool, struct ControlCycle, CYCLE_BLOCKS);
+CHANNEL(sensorChannel, cyclePool, 1, CHANNEL_LATEST);		// sensor -> estimator
+CHANNEL(estimateChannel, cyclePool, 2, CHANNEL_QUEUE);	// estimator -> control
+CHANNEL(commandChannel, cyclePool, 2, CHANNEL_QUEUE);		// control -> mixer
+CHANNEL(outputChannel, cyclePool, 2, CHANNEL_QUEUE);		// mixer -> telemetry
+CHANNEL_POOL(rcPool, struct RcFrame, RC_FRAME_BLOCKS);
+CHANNEL(rcChannel, rcPool, 1, CHANNEL_LATEST);			// rc -> control
+
+/*
+ * The channels in the order of their log records.
+ */
+static struct Channel * const channels[] = {
+	&sensorChannel, &estimateChannel, &commandChannel, &outputChannel,
+	&rcChannel
+};
+
+#define CHANNEL_COUNT	(sizeof(channels) / sizeof(channels[0]))
+
+/*
+ * The blocks received by the release functions of the stages.
+ */
+static struct ControlCycle *estimatorCycle;
+static struct ControlCycle *controlCycle;
+static struct ControlCycle *mixerCycle;
+static struct ControlCycle *telemetryCycle;
+
+static uint16_t rcChannels[RC_CHANNELS];	// latest rc frame, owned by control
+static volatile uint8_t armed = 0;			// owned by control
+static uint8_t blackboxSwitch = 0;			// owned by control
+
+static uint8_t consoleReady = 0;
+static uint8_t blackboxReported = 0;		// owned by housekeeping
+
+//-----------------------Method Implementation---------------------------------
+static int8_t accelerometerInitStep(uint32_t *readyAt) {
+	// The accelerometer is ready right after its configuration.
+	return Accelerometer_init();
+}
+
+/*
+ * The devices initialized by the init task.
+ */
+static struct DeviceInitStep devices[] = {
+	{ "accelerometer", accelerometerInitStep },
+	{ "gyroscope", Gyroscope_initStep },
+	{ "compass", Compass_initStep },
+	{ "motors", MotorDriver_armStep }
+};
+
+#define DEVICE_COUNT	(sizeof(devices) / sizeof(devices[0]))
+
+static void sensorJob() {
+	struct ControlCycle *cycle = Channel_alloc(&sensorChannel,
+			CHANNEL_NO_WAIT);
+
+	// The other stages hold all blocks, the cycle is skipped.
+	if (cycle == NULL) {
+		return;
+	}
+	cycle->timestamp = TimerDriver_getTimestamp();
+	readSensorData(cycle->sensor);
+	Channel_post(&sensorChannel, cycle);
+}
+
+static int8_t estimatorRelease() {
+	estimatorCycle = Channel_receive(&sensorChannel, CHANNEL_FOREVER);
+	return NO_ERR;
+}
+
+static void estimatorJob() {
+	struct ControlCycle *cycle = estimatorCycle;
+	uint8_t i;
+
+	if (cycle == NULL) {
+		return;
+	}
+	// No attitude filter yet, the rotation rates are passed through.
+	for (i = 0; i < 3; i++) {
+		cycle->attitude[i] = 0;
+		cycle->rate[i] = (int16_t) cycle->sensor[3 + i];
+	}
+	Channel_post(&estimateChannel, cycle);
+}
+
+static int8_t controlRelease() {
+	controlCycle = Channel_receive(&estimateChannel, CHANNEL_FOREVER);
+	return NO_ERR;
+}
+
+static void controlJob() {
+	struct ControlCycle *cycle = controlCycle;
+	struct RcFrame *frame;
+	uint8_t i;
+
+	// The last frame is used until the next one arrives.
+	frame = Channel_receive(&rcChannel, CHANNEL_NO_WAIT);
+	if (frame != NULL) {
+		for (i = 0; i < RC_CHANNELS; i++) {
+			rcChannels[i] = frame->channels[i];
+		}
+		Channel_release(&rcChannel, frame);
+
+		// The switches are evaluated on their edges.
+		if (rcChannels[RC_ARM_CHANNEL] > RC_SWITCH_ON) {
+			armed = 1;
+		} else if (armed) {
+			armed = 0;
+			Blackbox_trigger(BB_TRIGGER_DISARM);
+		}
+		if (rcChannels[RC_BLACKBOX_CHANNEL] > RC_SWITCH_ON) {
+			if (!blackboxSwitch) {
+				Blackbox_trigger(BB_TRIGGER_RC_SWITCH);
+			}
+			blackboxSwitch = 1;
+		} else {
+			blackboxSwitch = 0;
+		}
+	}
+
+	if (cycle == NULL) {
+		return;
+	}
+	// The setpoints follow the rc sticks, the rate controllers (PIDs/)
+	// are not implemented yet.
+	cycle->setpoint[0] = rcChannels[1];
+	cycle->setpoint[1] = rcChannels[2];
+	cycle->setpoint[2] = rcChannels[3];
+	cycle->throttle = rcChannels[0];
+	for (i = 0; i < RC_CHANNELS; i++) {
+		cycle->rc[i] = rcChannels[i];
+	}
+	cycle->armed = armed;
+	Channel_post(&commandChannel, cycle);
+}
+
+static int8_t mixerRelease() {
+	mixerCycle = Channel_receive(&commandChannel, CHANNEL_FOREVER);
+	return NO_ERR;
+}
 
-/* Definition of Task Stacks */
-#define   TASK_STACKSIZE       2048
-OS_STK    task1_stk[TASK_STACKSIZE];
-OS_STK    task2_stk[TASK_STACKSIZE];
-
-/* Definition of Task Priorities */
-
-#define TASK1_PRIORITY      1
-#define TASK2_PRIORITY      2
-
-/* Prints "Hello World" and sleeps for three seconds */
-void task1(void* pdata)
-{
-  while (1)
-  { 
-    printf("Hello from task1\n");
-    OSTimeDlyHMSM(0, 0, 3, 0);
-  }
-}
-/* Prints "Hello World" and sleeps for three seconds */
-void task2(void* pdata)
-{
-  while (1)
-  { 
-    printf("Hello from task2\n");
-    OSTimeDlyHMSM(0, 0, 3, 0);
-  }
-}
-/* The main function creates two task and starts multi-tasking */
-int main(void)
-{
-  
-  OSTaskCreateExt(task1,
-                  NULL,
-                  (void *)&task1_stk[TASK_STACKSIZE-1],
-                  TASK1_PRIORITY,
-                  TASK1_PRIORITY,
-                  task1_stk,
-                  TASK_STACKSIZE,
-                  NULL,
-                  0);
-              
-               
-  OSTaskCreateExt(task2,
-                  NULL,
-                  (void *)&task2_stk[TASK_STACKSIZE-1],
-                  TASK2_PRIORITY,
-                  TASK2_PRIORITY,
-                  task2_stk,
-                  TASK_STACKSIZE,
-                  NULL,
-                  0);
-  OSStart();
-  return 0;
-}
-
-/******************************************************************************
-*                                                                             *
-* License Agreement                                                           *
-*                                                                             *
-* Copyright (c) 2004 Altera Corporation, San Jose, California, USA.           *
-* All rights reserved.                                                        *
-*                                                                             *
-* Permission is hereby granted, free of charge, to any person obtaining a     *
-* copy of this software and associated documentation files (the "Software"),  *
-* to deal in the Software without restriction, including without limitation   *
-* the rights to use, copy, modify, merge, publish, distribute, sublicense,    *
-* and/or sell copies of the Software, and to permit persons to whom the       *
-* Software is furnished to do so, subject to the following conditions:        *
-*                                                                             *
-* The above copyright notice and this permission notice shall be included in  *
-* all copies or substantial portions of the Software.                         *
-*                                                                             *
-* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR  *
-* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,    *
-* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE *
-* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER      *
-* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING     *
-* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER         *
-* DEALINGS IN THE SOFTWARE.                                                   *
-*                                                                             *
-* This agreement shall be governed in all respects by the laws of the State   *
-* of California and by the laws of the United States of America.              *
-* Altera does not recommend, suggest or require that this reference design    *
-* file be used in conjunction or combination with any other product.          *
-******************************************************************************/
+static void mixerJob() {
+	struct ControlCycle *cycle = mixerCycle;
+	struct BlackboxFrame *frame;
+	uint8_t i;
+
+	if (cycle == NULL) {
+		return;
+	}
+	for (i = 0; i < 6; i++) {
+		cycle->motor[i] = 0;
+	}
+
+	frame = Blackbox_begin();
+	if (frame != NULL) {
+		for (i = 0; i < 3; i++) {
+			frame->acc[i] = (int16_t) cycle->sensor[i];
+			frame->gyro[i] = (int16_t) cycle->sensor[3 + i];
+			frame->mag[i] = (int16_t) cycle->sensor[6 + i];
+			frame->attitude[i] = cycle->attitude[i];
+			frame->rate[i] = cycle->rate[i];
+			frame->setpoint[i] = cycle->setpoint[i];
+		}
+		frame->throttle = cycle->throttle;
+		for (i = 0; i < 6; i++) {
+			frame->rc[i] = cycle->rc[i];
+			frame->motor[i] = cycle->motor[i];
+		}
+		frame->flags = cycle->armed;
+		Blackbox_end();
+	}
+	Channel_post(&outputChannel, cycle);
+}
+
+static int8_t telemetryRelease() {
+	telemetryCycle = Channel_receive(&outputChannel, CHANNEL_FOREVER);
+	return NO_ERR;
+}
+
+static void telemetryJob() {
+	struct ControlCycle *cycle = telemetryCycle;
+	uint8_t i;
+
+	if (cycle == NULL) {
+		return;
+	}
+	for (i = 0; i < SENSOR_VALUES; i++) {
+		Telemetry_set(TLM_ACC_X + i, (int32_t) cycle->sensor[i]);
+	}
+	for (i = 0; i < 3; i++) {
+		Telemetry_set(TLM_ROLL + i, cycle->attitude[i]);
+	}
+	for (i = 0; i < 6; i++) {
+		Telemetry_set(TLM_RC_THROTTLE + i, cycle->rc[i]);
+		Telemetry_set(TLM_MOTOR_1 + i, cycle->motor[i]);
+	}
+	Telemetry_commit();
+	Channel_release(&outputChannel, cycle);
+}
+
+static void rcJob() {
+	// The SUMD receiver (RC_Receiver.c) is not connected yet. Its frames
+	// will be taken with Channel_alloc(&rcChannel, CHANNEL_NO_WAIT) and
+	// posted to rcChannel.
+}
+
+/*
+ * Sink of the blackbox dump, the console is locked by the caller.
+ */
+static int32_t blackboxSink(const uint8_t *buffer, uint32_t length) {
+	return write(STDOUT_FILENO, buffer, length);
+}
+
+/*
+ * Dumps a frozen blackbox record to the console on BLACKBOX_DUMP_COMMAND
+ * and starts recording again. The dump only runs while disarmed, it
+ * blocks housekeeping until it is sent. The state is reported with
+ * LOG_ID_BLACKBOX, not with printf(): the first stdio output of a task
+ * allocates its buffer, which traps after MemPool_lockHeap().
+ */
+static void serviceBlackbox() {
+	char command;
+	int8_t result;
+
+	if (Blackbox_getState() != BB_FROZEN) {
+		blackboxReported = 0;
+		return;
+	}
+	if (!blackboxReported) {
+		Logger_write(LOG_PRODUCER_SYSTEM, LOG_ID_BLACKBOX, BB_FROZEN, NO_ERR);
+		blackboxReported = 1;
+	}
+	if (!consoleReady || armed || read(STDIN_FILENO, &command, 1) != 1
+			|| command != BLACKBOX_DUMP_COMMAND) {
+		return;
+	}
+
+	// The dump is not split by text or log records.
+	Console_lock();
+	result = Blackbox_dump(blackboxSink);
+	Console_unlock();
+	if (result == NO_ERR) {
+		Blackbox_rearm();
+	}
+	Logger_write(LOG_PRODUCER_SYSTEM, LOG_ID_BLACKBOX, Blackbox_getState(),
+			(uint32_t) (int32_t) result);
+}
+
+static void housekeepingJob();
+
+/*
+ * The task graph. The worst case execution times are estimates, they are
+ * not measured on the target yet. Housekeeping logs the longest job
+ * (LOG_ID_STAGE_STATISTIC) and the jobs above the estimate
+ * (LOG_ID_STAGE_BUDGET) of every stage, the values have to be replaced
+ * with the measured ones and updated when a stage changes.
+ */
+static const struct TaskGraphStage stages[] = {
+	{ "sensor", sensorJob, SENSOR_PRIORITY, CONTROL_PERIOD,
+			TimerDriver_waitControlRelease, 0, 0, 800, sensor_stk,
+			SENSOR_STACKSIZE },
+	{ "estimator", estimatorJob, ESTIMATOR_PRIORITY, CONTROL_PERIOD,
+			estimatorRelease, 0, 0, 100, estimator_stk, ESTIMATOR_STACKSIZE },
+	{ "control", controlJob, CONTROL_PRIORITY, CONTROL_PERIOD, controlRelease,
+			0, 0, 100, control_stk, CONTROL_STACKSIZE },
+	{ "mixer", mixerJob, MIXER_PRIORITY, CONTROL_PERIOD, mixerRelease, 0, 0,
+			50, mixer_stk, MIXER_STACKSIZE },
+	{ "telemetry", telemetryJob, TELEMETRY_PRIORITY, CONTROL_PERIOD,
+			telemetryRelease, 0, 0, 150, telemetry_stk, TELEMETRY_STACKSIZE },
+	{ "rc", rcJob, RC_PRIORITY, RC_PERIOD, NULL, 0, 0, 200, rc_stk,
+			RC_STACKSIZE },
+	{ "housekeeping", housekeepingJob, HOUSEKEEPING_PRIORITY,
+			HOUSEKEEPING_PERIOD, NULL, 0, 0, 2000, housekeeping_stk,
+			HOUSEKEEPING_STACKSIZE }
+};
+
+#define STAGE_COUNT	(sizeof(stages) / sizeof(stages[0]))
+
+// While init starts the stages, init, the stages, the logger drain and the
+// telemetry task exist at the same time. OS_MAX_TASKS does not count the
+// idle and the statistic task, fail the build if the BSP has too few TCBs.
+#define TASK_COUNT	(1 + STAGE_COUNT + 2)
+typedef char taskCountCheck[(TASK_COUNT <= OS_MAX_TASKS) ? 1 : -1];
+
+static void housekeepingJob() {
+	const struct TaskGraphStatistic *statistic;
+	uint32_t minLatency;
+	uint32_t maxLatency;
+	uint32_t overruns;
+	uint8_t i;
+
+	for (i = 0; i < STAGE_COUNT; i++) {
+		statistic = TaskGraph_getStatistic(i);
+		Logger_write(LOG_PRODUCER_SYSTEM, LOG_ID_STAGE_STATISTIC + i,
+				statistic->maxUs, statistic->overruns);
+		Logger_write(LOG_PRODUCER_SYSTEM, LOG_ID_STAGE_BUDGET + i,
+				statistic->budgetOverruns, statistic->jobs);
+	}
+
+	// The release jitter is maxLatency - minLatency.
+	TimerDriver_getControlLatency(&minLatency, &maxLatency, &overruns);
+	if (minLatency > 0xFFFF) {
+		minLatency = 0xFFFF;
+	}
+	if (maxLatency > 0xFFFF) {
+		maxLatency = 0xFFFF;
+	}
+	Logger_write(LOG_PRODUCER_SYSTEM, LOG_ID_CONTROL_LATENCY,
+			(minLatency << 16) | maxLatency, overruns);
+
+	TaskProfiler_publish();
+	Channel_publish(channels, CHANNEL_COUNT);
+	Console_publish();
+
+	serviceBlackbox();
+}
+
+/*
+ * Creates the pools and the queues of the channels.
+ */
+static int8_t initChannels() {
+	int8_t result;
+	uint8_t i;
+
+	result = Channel_initPool(&cyclePool);
+	if (result != NO_ERR) {
+		return result;
+	}
+	result = Channel_initPool(&rcPool);
+	if (result != NO_ERR) {
+		return result;
+	}
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		result = Channel_init(channels[i]);
+		if (result != NO_ERR) {
+			return result;
+		}
+	}
+	return NO_ERR;
+}
+
+/*
+ * Initializes the devices and starts the flight control.
+ */
+static void initTask(void *pdata) {
+	int8_t result;
+
+#ifdef TICK_BENCHMARK
+	// The priorities of the stages are free, telemetry and logger stay.
+	TickBenchmark_run(SENSOR_PRIORITY, TLM_TASK_PRIORITY - 1);
+	OSTaskDel(OS_PRIO_SELF);
+#endif
+
+	result = DeviceInit_run(devices, DEVICE_COUNT);
+	Logger_write(LOG_PRODUCER_SYSTEM, LOG_ID_BOOT_TIME,
+			TimerDriver_ticksToUs(TimerDriver_getTimestamp()),
+			(uint32_t) (int32_t) result);
+	if (result != NO_ERR) {
+		printf("Devices could not be initialized.\n");
+		OSTaskDel(OS_PRIO_SELF);
+	}
+
+	if (TimerDriver_initControlTimebase(CONTROL_RATE_HZ) != NO_ERR) {
+		printf("Control timebase could not be started.\n");
+		OSTaskDel(OS_PRIO_SELF);
+	}
+	if (PROFILER_SAMPLES > 0 && Profiler_start(PROFILER_SAMPLES) != NO_ERR) {
+		printf("Profiler could not be started.\n");
+	}
+
+	// The stages have a lower priority and start when this task ends.
+	if (TaskGraph_start(stages, STAGE_COUNT) != NO_ERR) {
+		printf("Task graph could not be started.\n");
+	}
+	MemPool_lockHeap();
+	OSTaskDel(OS_PRIO_SELF);
+}
+
+int main(void) {
+	int8_t result;
+	INT8U err;
+
+	// The control stages never wait for the console.
+	result = Console_init(RC_PRIORITY);
+	consoleReady = (result == NO_ERR);
+	// Housekeeping polls stdin for the blackbox dump.
+	fcntl(STDIN_FILENO, F_SETFL, O_NONBLOCK);
+	if (HiresTimer_init() != NO_ERR) {
+		printf("Timer could not be taken over.\n");
+		return 0;
+	}
+	if (initChannels() != NO_ERR) {
+		printf("Channels could not be created.\n");
+		return 0;
+	}
+	Logger_init(result == NO_ERR ? LOG_OUTPUT_CONSOLE : LOG_OUTPUT_JTAG_UART);
+	Telemetry_init(NULL);
+
+	err = OSTaskCreateExt(initTask, NULL, &init_stk[INIT_STACKSIZE - 1],
+			INIT_PRIORITY, INIT_PRIORITY, init_stk, INIT_STACKSIZE, NULL,
+			OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
+	if (err != OS_NO_ERR) {
+		printf("Init task could not be started.\n");
+		return 0;
+	}
+	OSTaskNameSet(INIT_PRIORITY, (INT8U *) "init", &err);
+	OSStart();
+	return 0;
+}
@@ -495,6 +495,9 @@ void  OSMutexPend (OS_EVENT *pevent, INT16U timeout, INT8U *perr)
     OSTCBCur->OSTCBStat     |= OS_STAT_MUTEX;         /* Mutex not available, pend current task        */
     OSTCBCur->OSTCBStatPend  = OS_STAT_PEND_OK;
     OSTCBCur->OSTCBDly       = timeout;               /* Store timeout in current task's TCB           */
+#if OS_TICK_WHEEL_EN > 0
+    OS_TickWheelInsert(OSTCBCur);
+#endif
     OS_EventTaskWait(pevent);                         /* Suspend task until event or timeout occurs    */
     OS_EXIT_CRITICAL();
     OS_Sched();                                       /* Find next highest priority task ready         */
@@ -481,6 +481,9 @@ INT8U  OSTaskDel (INT8U prio)
     }
 #endif
 
+#if OS_TICK_WHEEL_EN > 0
+    OS_TickWheelRemove(ptcb);
+#endif
     ptcb->OSTCBDly      = 0;                            /* Prevent OSTimeTick() from updating          */
     ptcb->OSTCBStat     = OS_STAT_RDY;                  /* Prevent task from being resumed             */
     ptcb->OSTCBStatPend = OS_STAT_PEND_OK;
@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+"""
+Converts a blackbox dump of the SimpleFlightController (Blackbox.h) to CSV.
+
+Usage:
+    blackboxdecode.py dump.bin blackbox.csv
+
+dump.bin is the captured console output (e.g. nios2-terminal) after the
+record froze and 'd' was sent, the text before the dump is skipped.
+"""
+
+import struct
+import sys
+
+BB_MAGIC = 0x31424258
+HEADER = struct.Struct("<IHBBII")
+# Has to match struct BlackboxFrame in Blackbox.h.
+FRAME = struct.Struct("<I3h3h3h3h3h3hh6H6BB3x")
+COLUMNS = (["timestamp"]
+           + ["acc_x", "acc_y", "acc_z", "gyro_x", "gyro_y", "gyro_z", "mag_x", "mag_y", "mag_z"]
+           + ["roll", "pitch", "yaw", "rate_roll", "rate_pitch", "rate_yaw"]
+           + ["sp_roll", "sp_pitch", "sp_yaw", "throttle"]
+           + ["rc_%d" % i for i in range(1, 7)]
+           + ["motor_%d" % i for i in range(1, 7)]
+           + ["flags"])
+TRIGGERS = ["none", "crash", "disarm", "rc switch"]
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write(__doc__)
+        return 1
+    with open(argv[1], "rb") as f:
+        data = f.read()
+    start = data.find(struct.pack("<I", BB_MAGIC))
+    if start < 0:
+        sys.stderr.write("no blackbox header found\n")
+        return 1
+    magic, frame_size, trigger, _, count, trigger_frame = HEADER.unpack_from(data, start)
+    if frame_size != FRAME.size:
+        sys.stderr.write("frame size %d does not match the decoder (%d)\n" % (frame_size, FRAME.size))
+        return 1
+    pos = start + HEADER.size
+    available = min(count, (len(data) - pos) // frame_size)
+    with open(argv[2], "w") as out:
+        out.write("frame," + ",".join(COLUMNS) + "\n")
+        for i in range(available):
+            values = FRAME.unpack_from(data, pos + i * frame_size)
+            out.write("%d,%s\n" % (i - trigger_frame, ",".join(str(v) for v in values)))
+    sys.stderr.write("%d of %d frames, trigger: %s at frame 0\n"
+                     % (available, count, TRIGGERS[trigger] if trigger < len(TRIGGERS) else trigger))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
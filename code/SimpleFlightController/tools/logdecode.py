@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""
+Decoder for the binary log stream of the SimpleFlightController (Logger.h).
+
+Reads the raw bytes the drain task sent over the UART or JTAG UART and
+prints one line per record. TRACE messages are formatted with the format
+strings of the .trace_fmt section of the elf file.
+
+Usage:
+    nios2-terminal > log.bin   (or any serial capture of UART_0)
+    logdecode.py SimpleFlightController.elf log.bin
+"""
+
+import re
+import struct
+import sys
+
+LOG_SYNC = 0xA5
+LOG_RECORD_SIZE = 16
+LOG_ID_DROPPED = 0xFFFF
+LOG_ID_TRACE = 0xFFFE
+LOG_ID_TRACE_ARGS = 0xFFFD
+
+TIMESTAMP_FREQ = 25000000.0  # TIMERDRIVER_FREQ
+
+PRODUCERS = ["CONTROL", "SENSOR", "RC", "SYSTEM", "PROFILER"]
+
+FORMAT_SPEC = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|t)?([diouxXcp%])")
+
+
+def read_section(elf_path, name):
+    """Returns the contents of a section of a 32 bit little endian elf file."""
+    with open(elf_path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF" or elf[4] != 1:
+        raise ValueError("%s is no 32 bit elf file" % elf_path)
+    shoff, = struct.unpack_from("<I", elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+    sections = []
+    for i in range(shnum):
+        sections.append(struct.unpack_from("<IIIIIIIIII", elf, shoff + i * shentsize))
+    strtab = sections[shstrndx]
+    for sec in sections:
+        start = strtab[4] + sec[0]
+        sec_name = elf[start:elf.index(b"\0", start)].decode()
+        if sec_name == name:
+            return elf[sec[4]:sec[4] + sec[5]]
+    return b""
+
+
+def format_trace(formats, offset, args):
+    end = formats.find(b"\0", offset)
+    if offset >= len(formats) or end < 0:
+        return "<unknown format 0x%x> %s" % (offset, " ".join(str(a) for a in args))
+    fmt = formats[offset:end].decode("latin-1")
+    values = iter(args)
+
+    def convert(match):
+        flags, _, conv = match.groups()
+        if conv == "%":
+            return "%"
+        value = next(values, 0)
+        if conv in "di":
+            value = value - (1 << 32) if value & 0x80000000 else value
+            return ("%" + flags + "d") % value
+        if conv == "c":
+            return chr(value & 0xFF)
+        if conv == "p":
+            return "0x%08x" % value
+        return ("%" + flags + conv) % value
+
+    return FORMAT_SPEC.sub(convert, fmt).rstrip("\n")
+
+
+def records(data):
+    """Yields (producer, id, timestamp, data0, data1), resynchronizes on the sync byte."""
+    pos = 0
+    while pos + LOG_RECORD_SIZE <= len(data):
+        if data[pos] != LOG_SYNC or data[pos + 1] >= len(PRODUCERS):
+            pos += 1
+            continue
+        _, producer, rec_id, ts, d0, d1 = struct.unpack_from("<BBHIII", data, pos)
+        pos += LOG_RECORD_SIZE
+        yield producer, rec_id, ts, d0, d1
+
+
+def decode(formats, data, out=sys.stdout):
+    last_ts = None
+    wraps = 0
+    pending = {}  # producer -> [timestamp, format offset, argc, args]
+
+    def emit(producer, ts, text):
+        out.write("%12.6f %-7s %s\n" % (ts / TIMESTAMP_FREQ, PRODUCERS[producer], text))
+
+    def finish(producer):
+        ts, offset, argc, args = pending.pop(producer)
+        emit(producer, ts, format_trace(formats, offset, args[:argc]))
+
+    for producer, rec_id, ts, d0, d1 in records(data):
+        if rec_id == LOG_ID_TRACE_ARGS:
+            if producer in pending:
+                trace = pending[producer]
+                trace[3].extend((ts, d0, d1))
+                if len(trace[3]) >= trace[2]:
+                    finish(producer)
+            continue
+        if producer in pending:
+            finish(producer)
+        # the timestamp wraps around after 2^32 ticks
+        if last_ts is not None and ts < last_ts and last_ts - ts > 0x80000000:
+            wraps += 1
+        last_ts = ts
+        ts += wraps << 32
+        if rec_id == LOG_ID_TRACE:
+            argc = d0 >> 24
+            pending[producer] = [ts, d0 & 0xFFFFFF, argc, [d1] if argc else []]
+            if argc <= 1:
+                finish(producer)
+        elif rec_id == LOG_ID_DROPPED:
+            emit(producer, ts, "<%d records dropped>" % d0)
+        else:
+            emit(producer, ts, "id=0x%04x 0x%08x 0x%08x" % (rec_id, d0, d1))
+    for producer in list(pending):
+        finish(producer)
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write(__doc__)
+        return 1
+    formats = read_section(argv[1], ".trace_fmt")
+    with open(argv[2], "rb") as f:
+        data = f.read()
+    decode(formats, data)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""
+Symbolizer for the pc samples of the SimpleFlightController (Profiler.h).
+
+Reads the log stream (see logdecode.py), maps every sampled pc to the
+function of SimpleFlightController.elf (or the .objdump listing) and prints
+a flat profile. The task names are taken from the task profile records
+(TaskProfiler.h) of the same capture if present.
+
+Usage:
+    pcprofile.py [options] SimpleFlightController.elf|.objdump log.bin
+
+Options:
+    --tasks      print a flat profile for every task
+    --folded     print folded stacks (task;function count) for flamegraph.pl
+    --insns N    print the N most sampled instructions (needs the .objdump)
+"""
+
+import bisect
+import re
+import struct
+import sys
+
+from logdecode import records
+from tasktop import snapshots
+
+PRODUCER_PROFILER = 4
+NO_TASK = 0x7F  # PROFILER_NO_TASK
+
+SHT_SYMTAB = 2
+STT_NOTYPE = 0
+STT_FUNC = 2
+
+OBJDUMP_SYMBOL = re.compile(r"^([0-9a-f]{8}) <(.+)>:$")
+OBJDUMP_INSN = re.compile(r"^\s*([0-9a-f]+):\t[0-9a-f]{8}\s+(.*)$")
+
+
+def elf_symbols(path):
+    """Returns a sorted list of (address, name) of the code symbols of an elf file."""
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF" or elf[4] != 1:
+        raise ValueError("%s is no 32 bit elf file" % path)
+    shoff, = struct.unpack_from("<I", elf, 0x20)
+    shentsize, shnum, _ = struct.unpack_from("<HHH", elf, 0x2E)
+    sections = [struct.unpack_from("<IIIIIIIIII", elf, shoff + i * shentsize)
+                for i in range(shnum)]
+    symbols = {}
+    for sec in sections:
+        if sec[1] != SHT_SYMTAB:
+            continue
+        strtab = sections[sec[6]]
+        for pos in range(sec[4], sec[4] + sec[5], 16):
+            name, value, _, info, _, shndx = struct.unpack_from("<IIIBBH", elf, pos)
+            if info & 0xF not in (STT_FUNC, STT_NOTYPE) or shndx == 0 or shndx >= shnum:
+                continue
+            if not sections[shndx][2] & 0x4:  # SHF_EXECINSTR
+                continue
+            start = strtab[4] + name
+            text = elf[start:elf.index(b"\0", start)].decode("latin-1")
+            if text and not text.startswith(("$", ".L")):
+                symbols.setdefault(value, text)
+    return sorted(symbols.items())
+
+
+def objdump_symbols(path):
+    """Returns the sorted symbols and a map address -> instruction of an objdump listing."""
+    symbols = {}
+    insns = {}
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            match = OBJDUMP_SYMBOL.match(line)
+            if match:
+                symbols.setdefault(int(match.group(1), 16), match.group(2))
+                continue
+            match = OBJDUMP_INSN.match(line)
+            if match:
+                insns[int(match.group(1), 16)] = match.group(2).strip().replace("\t", " ")
+    return sorted(symbols.items()), insns
+
+
+class Symbolizer:
+    def __init__(self, symbols):
+        self.addresses = [a for a, _ in symbols]
+        self.names = [n for _, n in symbols]
+
+    def __call__(self, pc):
+        i = bisect.bisect_right(self.addresses, pc) - 1
+        return self.names[i] if i >= 0 else "0x%08x" % pc
+
+
+def samples(data):
+    """Yields (task priority, pc) of every sample."""
+    for producer, rec_id, _, d0, d1 in records(data):
+        if producer == PRODUCER_PROFILER:
+            yield rec_id >> 8, d0
+            yield rec_id & 0xFF, d1
+
+
+def task_names(data):
+    names = {NO_TASK: "startup"}
+    for snapshot in snapshots(data):
+        for prio, task in snapshot.tasks.items():
+            if task["name"]:
+                names[prio] = task["name"]
+    return names
+
+
+def print_flat(counts, total, out, indent=""):
+    for name, count in sorted(counts.items(), key=lambda c: -c[1]):
+        out.write("%s%8d %6.2f%%  %s\n" % (indent, count, 100.0 * count / total, name))
+
+
+def main(argv):
+    args = argv[1:]
+    per_task = "--tasks" in args
+    folded = "--folded" in args
+    insn_count = 0
+    if "--insns" in args:
+        i = args.index("--insns")
+        insn_count = int(args[i + 1])
+        del args[i:i + 2]
+    args = [a for a in args if a not in ("--tasks", "--folded")]
+    if len(args) != 2:
+        sys.stderr.write(__doc__)
+        return 1
+
+    insns = {}
+    if args[0].endswith(".objdump"):
+        symbols, insns = objdump_symbols(args[0])
+    else:
+        symbols = elf_symbols(args[0])
+    symbolize = Symbolizer(symbols)
+    with open(args[1], "rb") as f:
+        data = f.read()
+    names = task_names(data)
+
+    functions = {}
+    tasks = {}
+    stacks = {}
+    pcs = {}
+    total = 0
+    for prio, pc in samples(data):
+        function = symbolize(pc)
+        task = names.get(prio, "prio%d" % prio)
+        functions[function] = functions.get(function, 0) + 1
+        tasks.setdefault(task, {})
+        tasks[task][function] = tasks[task].get(function, 0) + 1
+        stacks[(task, function)] = stacks.get((task, function), 0) + 1
+        pcs[pc] = pcs.get(pc, 0) + 1
+        total += 1
+    if total == 0:
+        sys.stderr.write("no samples found\n")
+        return 1
+
+    out = sys.stdout
+    if folded:
+        for (task, function), count in sorted(stacks.items()):
+            out.write("%s;%s %d\n" % (task, function, count))
+        return 0
+
+    out.write("%d samples\n\n" % total)
+    print_flat(functions, total, out)
+    if per_task:
+        for task, counts in sorted(tasks.items(), key=lambda t: -sum(t[1].values())):
+            task_total = sum(counts.values())
+            out.write("\n%s: %d samples (%.2f%%)\n" % (task, task_total, 100.0 * task_total / total))
+            print_flat(counts, task_total, out, "  ")
+    if insn_count:
+        out.write("\n")
+        for pc, count in sorted(pcs.items(), key=lambda p: -p[1])[:insn_count]:
+            out.write("%8d %6.2f%%  %08x %-28s %s\n" % (count, 100.0 * count / total, pc,
+                                                       symbolize(pc), insns.get(pc, "")))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""
+Top like view of the task profile of the SimpleFlightController (TaskProfiler.h).
+
+Reads the log stream (see logdecode.py) and shows every snapshot sent by
+TaskProfiler_publish() as a table of the tasks, sorted by cpu time.
+With a file that is still written (e.g. by nios2-terminal) -f follows it
+and refreshes the view like top, otherwise all snapshots are printed.
+
+Usage:
+    nios2-terminal > log.bin
+    tasktop.py [-f] log.bin
+"""
+
+import os
+import struct
+import sys
+import time
+
+from logdecode import LOG_RECORD_SIZE, LOG_SYNC, TIMESTAMP_FREQ, records
+
+PRODUCER_SYSTEM = 3
+LOG_ID_TASK_CPU = 0x0120
+LOG_ID_TASK_STACK = 0x0121
+LOG_ID_TASK_NAME = 0x0122
+LOG_ID_TASK_WINDOW = 0x0123
+
+OS_LOWEST_PRIO = 20
+SYSTEM_TASKS = {OS_LOWEST_PRIO: "idle", OS_LOWEST_PRIO - 1: "statistic"}
+
+
+class Snapshot:
+    def __init__(self):
+        self.tasks = {}  # priority -> dict
+        self.window = 0
+        self.isr = 0
+
+    def task(self, prio):
+        return self.tasks.setdefault(prio, {"prio": prio, "name": "", "switches": 0,
+                                            "cycles": 0, "response": 0,
+                                            "used": 0, "size": 0})
+
+
+def snapshots(data):
+    """Yields complete snapshots, a snapshot ends with its window record."""
+    snapshot = Snapshot()
+    prio = None
+    for producer, rec_id, _, d0, d1 in records(data):
+        if producer != PRODUCER_SYSTEM:
+            continue
+        if rec_id == LOG_ID_TASK_CPU:
+            prio = d0 >> 24
+            task = snapshot.task(prio)
+            task["switches"] = d0 & 0xFFFFFF
+            task["cycles"] = d1
+        elif rec_id == LOG_ID_TASK_STACK and prio is not None:
+            task = snapshot.task(prio)
+            task["response"] = d0
+            task["used"] = d1 >> 16
+            task["size"] = d1 & 0xFFFF
+        elif rec_id == LOG_ID_TASK_NAME and prio is not None:
+            name = struct.pack("<II", d0, d1).rstrip(b"\0").decode("latin-1")
+            snapshot.task(prio)["name"] = name or SYSTEM_TASKS.get(prio, "")
+        elif rec_id == LOG_ID_TASK_WINDOW:
+            snapshot.window = d0
+            snapshot.isr = d1
+            if snapshot.tasks and d0:
+                yield snapshot
+            snapshot = Snapshot()
+            prio = None
+
+
+def render(snapshot, out=sys.stdout):
+    window = float(snapshot.window)
+    seconds = window / TIMESTAMP_FREQ
+    busy = sum(t["cycles"] for p, t in snapshot.tasks.items() if p != OS_LOWEST_PRIO)
+    out.write("window %.3f s  cpu %5.1f%%  isr %5.1f%%\n"
+              % (seconds, 100.0 * (busy + snapshot.isr) / window,
+                 100.0 * snapshot.isr / window))
+    out.write("%4s %-10s %6s %8s %10s %13s %5s\n"
+              % ("PRIO", "NAME", "CPU%", "SW/s", "MAXRESP", "STACK", "STK%"))
+    for task in sorted(snapshot.tasks.values(), key=lambda t: -t["cycles"]):
+        stack = "%d/%d" % (task["used"], task["size"]) if task["size"] else "-"
+        stack_pct = "%5.1f" % (100.0 * task["used"] / task["size"]) if task["size"] else "    -"
+        out.write("%4d %-10s %6.2f %8.0f %8d us %13s %s\n"
+                  % (task["prio"], task["name"], 100.0 * task["cycles"] / window,
+                     task["switches"] / seconds, task["response"], stack, stack_pct))
+    out.write("\n")
+
+
+def follow(path):
+    data = b""
+    offset = 0
+    while True:
+        with open(path, "rb") as f:
+            f.seek(offset)
+            chunk = f.read()
+        offset += len(chunk)
+        data += chunk
+        last = None
+        for last in snapshots(data):
+            pass
+        if last is not None:
+            sys.stdout.write("\x1b[H\x1b[2J")
+            render(last)
+            sys.stdout.flush()
+            # keep the bytes after the last window record, they belong to
+            # the next snapshot
+            end = data.rfind(struct.pack("<BBH", LOG_SYNC, PRODUCER_SYSTEM,
+                                         LOG_ID_TASK_WINDOW))
+            data = data[end + LOG_RECORD_SIZE:]
+        time.sleep(1.0)
+
+
+def main(argv):
+    args = argv[1:]
+    follow_mode = "-f" in args
+    args = [a for a in args if a != "-f"]
+    if len(args) != 1 or not os.path.exists(args[0]):
+        sys.stderr.write(__doc__)
+        return 1
+    if follow_mode:
+        try:
+            follow(args[0])
+        except KeyboardInterrupt:
+            pass
+        return 0
+    with open(args[0], "rb") as f:
+        data = f.read()
+    for snapshot in snapshots(data):
+        render(snapshot)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
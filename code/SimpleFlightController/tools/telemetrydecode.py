@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+"""
+Decoder and recorder for the telemetry stream of the SimpleFlightController
+(Telemetry.h).
+
+Splits the captured bytes at the 0x00 delimiters, COBS decodes and CRC checks
+every frame and undoes the delta / zig-zag varint encoding. The result is
+written as table with one column per field. A .npz output file stores every
+column as own array (needs numpy), every other name is written as CSV.
+Fields that are not part of a packet keep their last value.
+
+Usage:
+    telemetrydecode.py capture.bin telemetry.csv
+    telemetrydecode.py /dev/ttyUSB0 telemetry.npz   (records until Ctrl-C)
+"""
+
+import sys
+
+# Has to match enum TelemetryField in Telemetry.h.
+FIELDS = [
+    "acc_x", "acc_y", "acc_z",
+    "gyro_x", "gyro_y", "gyro_z",
+    "mag_x", "mag_y", "mag_z",
+    "roll", "pitch", "yaw",
+    "rc_throttle", "rc_roll", "rc_pitch", "rc_yaw", "rc_aux1", "rc_aux2",
+    "motor_1", "motor_2", "motor_3", "motor_4", "motor_5", "motor_6",
+]
+
+
+def crc16(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    pos = 0
+    while pos < len(frame):
+        code = frame[pos]
+        if code == 0 or pos + code > len(frame):
+            raise ValueError("broken frame")
+        out += frame[pos + 1:pos + code]
+        pos += code
+        if code < 0xFF and pos < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            break
+    value &= 0xFFFFFFFF
+    return (value >> 1) ^ -(value & 1), pos
+
+
+class Decoder:
+
+    def __init__(self):
+        self.values = None
+        self.decimation = None
+        self.last_seq = None
+        self.rows = []
+        self.crc_errors = 0
+        self.lost = 0
+
+    def packet(self, data):
+        if len(data) < 3 or crc16(data[:-2]) != (data[-2] << 8 | data[-1]):
+            self.crc_errors += 1
+            self.values = None
+            return
+        body = data[:-2]
+        seq = body[0]
+        pos = 1
+        if self.last_seq is not None and seq != (self.last_seq + 1) & 0xFF:
+            self.lost += (seq - self.last_seq - 1) & 0xFF
+        self.last_seq = seq
+        if seq == 0:
+            count = body[pos]
+            pos += 1
+            if count != len(FIELDS):
+                raise ValueError("target sends %d fields, decoder knows %d" % (count, len(FIELDS)))
+            self.decimation = list(body[pos:pos + count])
+            pos += count
+            self.values = [0] * count
+        elif self.values is None:
+            return  # wait for the first key packet
+        for i, decimation in enumerate(self.decimation):
+            if seq & (decimation - 1) == 0:
+                delta, pos = read_varint(body, pos)
+                self.values[i] = delta if seq == 0 else ((self.values[i] + delta + 0x80000000) & 0xFFFFFFFF) - 0x80000000
+        self.rows.append([len(self.rows), seq] + list(self.values))
+
+    def feed(self, stream):
+        for frame in stream.split(b"\0"):
+            if not frame:
+                continue
+            try:
+                self.packet(cobs_decode(frame))
+            except (ValueError, IndexError):
+                # a transmission error breaks the delta chain until the next key packet
+                self.crc_errors += 1
+                self.values = None
+
+
+def write(rows, path):
+    columns = ["packet", "seq"] + FIELDS
+    if path.endswith(".npz"):
+        import numpy
+        table = numpy.array(rows, dtype=numpy.int64).reshape(-1, len(columns))
+        numpy.savez(path, **{name: table[:, i] for i, name in enumerate(columns)})
+    else:
+        with open(path, "w") as f:
+            f.write(",".join(columns) + "\n")
+            for row in rows:
+                f.write(",".join(str(v) for v in row) + "\n")
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write(__doc__)
+        return 1
+    decoder = Decoder()
+    buffered = b""
+    with open(argv[1], "rb", buffering=0) as f:
+        try:
+            while True:
+                chunk = f.read(4096)
+                if not chunk:
+                    break
+                buffered += chunk
+                end = buffered.rfind(b"\0")
+                if end >= 0:
+                    decoder.feed(buffered[:end])
+                    buffered = buffered[end + 1:]
+        except KeyboardInterrupt:
+            pass
+    write(decoder.rows, argv[2])
+    sys.stderr.write("%d packets, %d lost, %d broken\n" % (len(decoder.rows), decoder.lost, decoder.crc_errors))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -44,8 +44,9 @@
 /* Defined and set to $max_attributes. */
 #define MCAPI_MAX_ATTRIBUTES 8
 
-/* Defined and set to $max_buffers. */
-#define MCAPI_MAX_BUFFERS 32
+/* Defined and set to $max_buffers. The sum of the buffers of the size
+   classes, see MCAPI_BUFFERS_x in mcapi_trans_nios.h. */
+#define MCAPI_MAX_BUFFERS 58
 
 /* Defined and set to $max_channels. */
 #define MCAPI_MAX_CHANNELS 8
@@ -652,8 +652,22 @@ void mcapi_endpoint_get_attribute(
 mcapi_endpoint_set_attribute - set endpoint attributes.
 
 DESCRIPTION
-
+Only MCAPI_ENDP_ATTR_LATENCY_CRITICAL of a local endpoint can be set.
 ***********************************************************************/
+void mcapi_endpoint_set_attribute(
+        MCAPI_IN mcapi_endpoint_t endpoint,
+        MCAPI_IN mcapi_uint_t attribute_num,
+        MCAPI_OUT const void* attribute,
+        MCAPI_IN size_t attribute_size,
+        MCAPI_OUT mcapi_status_t* mcapi_status)
+{
+  *mcapi_status = MCAPI_SUCCESS;
+  if ( ! mcapi_trans_valid_endpoint(endpoint)) {
+    *mcapi_status = MCAPI_ERR_ENDP_INVALID;
+  } else {
+    mcapi_trans_endpoint_set_attribute(endpoint,attribute_num,attribute,attribute_size,mcapi_status);
+  }
+}
 
 
 /************************************************************************
@@ -40,6 +40,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *             mcapi_trans_endpoint_get_(),
  *             mcapi_trans_decode_handle(),
  *             mcapi_trans_send()                - ms
+ * 2026-10-19: mcapi_trans_buffer_stats()
+ * 2026-10-19: cache of the remote endpoints for the NS layer
+ * 2026-10-19: mcapi_trans_sclchan_deliver()
+ * 2026-10-19: mcapi_trans_endpoint_latency_critical()
 */
 
 #ifndef IMPLEMENTATION_SPEC_H
@@ -377,10 +381,17 @@ extern void mcapi_trans_cancel( mcapi_request_t* request,mca_status_t* mcapi_sta
 
 /****************** stats ****************************/
 extern void mcapi_trans_display_stats (void* handle);
+extern void mcapi_trans_buffer_stats (mcapi_uint32_t* num_used, mcapi_uint32_t* high_water,
+                                      mcapi_uint32_t* num_exhausted);
 
 /****************** anything else ********************/
 extern mcapi_boolean_t mcapi_trans_decode_handle (uint32_t handle, uint16_t* domain_index, uint16_t *node_index, uint16_t *endpoint_index);
 extern mcapi_boolean_t mcapi_trans_send (uint16_t sd, uint16_t sn,uint16_t se, uint16_t rd,uint16_t rn, uint16_t re, const char* buffer, size_t buffer_size);
+extern mcapi_uint_t mcapi_trans_endpoint_port (mcapi_endpoint_t endpoint);
+extern void mcapi_trans_endpoint_cache_put (mcapi_endpoint_t ep, mcapi_domain_t domain_id, mcapi_uint_t node_num, mcapi_uint_t port_num);
+extern void mcapi_trans_endpoint_cache_invalidate (mcapi_domain_t domain_id, mcapi_uint_t node_num, mcapi_uint_t port_num);
+extern mcapi_boolean_t mcapi_trans_sclchan_deliver (mcapi_endpoint_t receive_endpoint, const char* buffer, size_t size);
+extern mcapi_boolean_t mcapi_trans_endpoint_latency_critical (mcapi_endpoint_t endpoint);
 
 #ifdef __cplusplus
 }
@@ -64,6 +64,50 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  2014-08-11: mcapi_env.h included - ms
  2014-09-30: Changes in mcapi_trans_pktchan_free() because of compiler
              dependent buggy pointer arithmetics - ms
+ 2026-10-19: mcapi_trans_wait(), mcapi_trans_wait_any() and blocking
+             receives block on a completion object of the waiting task
+             (semaphore on uC/OS-II, condition variable on Linux) which
+             is signalled when the message is pushed into the receive
+             queue, no more polling. Timeouts are milliseconds.
+ 2026-10-19: fine-grained locking: DatabaseMutex only guards the topology
+             (node, endpoint create/delete, channel connect/open/close).
+             The receive queues (one lock per endpoint index), the buffer
+             pool and the request table have their own locks, so tasks
+             on different endpoints no longer serialize on the database.
+             Lock order: DatabaseMutex, request lock, endpoint lock,
+             buffer lock, waiter lock (see below for the request lock).
+ 2026-10-19: buffer pool with a free list, mcapi_trans_buffer_get() and
+             mcapi_trans_buffer_put() are O(1) and only clear the header
+             of a buffer. mcapi_trans_buffer_stats() returns the number of
+             used buffers, its high-water mark and the failed gets.
+ 2026-10-19: buffers in size classes, mcapi_trans_buffer_get() takes the
+             smallest class that holds the data, mcapi_trans_buffer_find()
+             maps the data back to its buffer. Receive queues come from a
+             pool and are only taken by the local endpoints.
+ 2026-10-19: the receive queue is a wait-free single producer/single
+             consumer ring, the receiving task pops without the endpoint
+             lock. Receive requests to an empty queue are reserved apart
+             from the ring and get the next messages in their order, so
+             there is no more compaction of the queue.
+ 2026-10-19: mcapi_trans_cancel() gives the request entry back, a
+             receive request that already has its message is completed.
+ 2026-10-19: mcapi_trans_endpoint_get_i() takes remote endpoints from a
+             cache, only the first get of an endpoint asks its node. The
+             NS layer adds the send endpoints of incoming messages and
+             removes the endpoints its peers have deleted.
+ 2026-10-19: scalars to a remote node are sent with
+             NS_sendScalarToRemote_request(), the NS layer hands them
+             to mcapi_trans_sclchan_deliver().
+ 2026-10-19: endpoint attribute MCAPI_ENDP_ATTR_LATENCY_CRITICAL, the NS
+             layer doesn't coalesce the packets of such send endpoints.
+ 2026-10-19: the largest buffer class holds a full receive queue again
+             (MCAPI_BUFFERS_3 = MCAPI_MAX_QUEUE_ELEMENTS), the count of
+             each class can be overridden on its own.
+ 2026-10-19: no more global request lock: a request entry is guarded by
+             the lock of its stripe (REQUEST_LOCK(r)), the free list by
+             the reserve lock which is only held for the list operation.
+             Test, wait and cancel of requests of different endpoints no
+             longer serialize.
 ***************************************************************************/
 
 #ifdef __cplusplus
@@ -84,11 +128,13 @@ extern }
 
 #ifdef UCOSII
 	#include "includes.h"
+	#include "io.h"
 #endif
 
 #ifdef LINUX
 	#include <pthread.h>
 	#include <sched.h>
+	#include <time.h>
 #endif
 
 #define ms 10	// number of ms we have to wait until we try again
@@ -100,13 +146,32 @@ extern }
 //////////////////////////////////////////////////////////////////////////////
 //#define	DEBUG_LOCK_CHECK	// if defined, at several places in code it will be
 							// checked if data base is 'really' locked!
+							// (DatabaseMutex only, not the fine-grained locks)
 
 #define TICKS_TO_WAIT	1
+#define RECHECK_MS		10	// period in ms in which waits re-check requests
+							// that are not completed by a signal
 #define MAGIC_NUM 0xdeadcafe
 #define MCAPI_VALID_MASK 0x80000000
 #define MSG_HEADER 1
 #define MSG_PORT 0
 
+/* Accesses to the indices and elements of the receive rings, which are
+   shared by the producer and the consumer without a lock. On the NIOS they
+   bypass the data cache (ldwio/stwio), which are not reordered by the CPU,
+   the asm statement keeps the compiler from moving the other accesses. */
+#ifdef UCOSII
+#define RING_READ(x)		IORD_32DIRECT(&(x),0)
+#define RING_WRITE(x,v)		IOWR_32DIRECT(&(x),0,(v))
+#define RING_BARRIER()		__asm__ __volatile__ ("" ::: "memory")
+#endif
+
+#ifdef LINUX
+#define RING_READ(x)		(*(volatile uint32_t*)&(x))
+#define RING_WRITE(x,v)		(*(volatile uint32_t*)&(x) = (v))
+#define RING_BARRIER()		__sync_synchronize()
+#endif
+
 //////////////////////////////////////////////////////////////////////////////
 //                                                                          //
 //                   Function prototypes (private)                          //
@@ -131,7 +196,7 @@ int mcapi_trans_send_have_lock (uint16_t sd, uint16_t sn,uint16_t se, uint16_t r
 
 mcapi_boolean_t mcapi_trans_recv_have_lock (uint16_t rd, uint16_t rn, uint16_t re, void** buffer, size_t buffer_size, size_t* received_size, mcapi_boolean_t blocking, uint64_t* scalar);
 
-void mcapi_trans_recv_have_lock_ (uint16_t rd, uint16_t rn, uint16_t re, void** buffer, size_t buffer_size, size_t* received_size, int qindex, uint64_t* scalar);
+void mcapi_trans_recv_have_lock_ (uint16_t rd, uint16_t rn, uint16_t re, void** buffer, size_t buffer_size, size_t* received_size, int32_t buff_index, uint64_t* scalar);
 
 mcapi_boolean_t mcapi_trans_endpoint_get_have_lock (mcapi_endpoint_t *e, mcapi_domain_t domain_id, mcapi_uint_t node_num, mcapi_uint_t port_num);
 
@@ -141,7 +206,7 @@ void mcapi_trans_close_channel_have_lock (uint16_t d,uint16_t n, uint16_t e);
 
 void mcapi_trans_connect_channel_have_lock (mcapi_endpoint_t send_endpoint, mcapi_endpoint_t receive_endpoint, channel_type type);
 
-mcapi_boolean_t mcapi_trans_reserve_request_have_lock(int* r);
+mcapi_boolean_t mcapi_trans_reserve_request(int* r);
 
 mcapi_boolean_t setup_request_have_lock (mcapi_endpoint_t* endpoint,
 									     mcapi_request_t* request,
@@ -157,7 +222,7 @@ mcapi_boolean_t setup_request_have_lock (mcapi_endpoint_t* endpoint,
 
 void check_receive_request_have_lock (mcapi_request_t *request);
 
-void cancel_receive_request_have_lock (mcapi_request_t *request);
+mcapi_boolean_t cancel_receive_request_have_lock (mcapi_request_t *request);
 
 void check_get_endpt_request_have_lock (mcapi_request_t *request);
 
@@ -169,7 +234,15 @@ inline mcapi_boolean_t mcapi_trans_whoami (mcapi_node_t* node_id, uint32_t* n_in
 
 void mcapi_trans_display_state_have_lock (void* handle);
 
-void mcapi_trans_yield_have_lock();
+mcapi_boolean_t mcapi_trans_test_have_lock (mcapi_request_t* request, size_t* size, mcapi_status_t* mcapi_status);
+
+/* completion objects of waiting tasks */
+uint8_t mcapi_trans_waiter_get ();
+void mcapi_trans_waiter_put (uint8_t w);
+void mcapi_trans_waiter_signal (uint8_t w);
+mcapi_boolean_t mcapi_trans_waiter_attach_have_lock (mcapi_request_t* request, uint8_t w);
+void mcapi_trans_waiter_detach_have_lock (mcapi_request_t* request, uint8_t w);
+void mcapi_trans_deliver_have_lock (uint16_t rd, uint16_t rn, uint16_t re, int32_t buff_index);
 
 mcapi_boolean_t mcapi_trans_add_domain_and_node (mcapi_domain_t domain_id, mcapi_node_t node_id, const mcapi_node_attributes_t* node_attrs);
 mcapi_boolean_t mcapi_trans_valid_domain(mcapi_uint_t domain_num);
@@ -177,17 +250,25 @@ mcapi_boolean_t mcapi_trans_valid_domain(mcapi_uint_t domain_num);
 mcapi_boolean_t mcapi_trans_endpoint_exists_(mcapi_domain_t domain_id, uint32_t port_num);
 
 void mcapi_trans_initialize_database();
+void mcapi_trans_init_buffer_pool_have_lock();
+queue* mcapi_trans_queue_get_have_lock();
+buffer_entry* mcapi_trans_buffer_find (void* data);
 
 /* queue management */
-void print_queue (queue q);
-int mcapi_trans_pop_queue (queue *q);
-int mcapi_trans_push_queue (queue *q);
-mcapi_boolean_t mcapi_trans_empty_queue (queue q);
-mcapi_boolean_t mcapi_trans_full_queue (queue q);
-mcapi_boolean_t mcapi_trans_full_queue_wait (queue q);
-void mcapi_trans_compact_queue (queue* q);
+void print_queue (queue* q);
+int32_t mcapi_trans_pop_queue (queue *q);
+mcapi_boolean_t mcapi_trans_push_queue (queue *q, int32_t buff_index);
+mcapi_boolean_t mcapi_trans_empty_queue (queue* q);
+mcapi_boolean_t mcapi_trans_full_queue (queue* q);
+uint32_t mcapi_trans_count_queue (queue* q);
+int mcapi_trans_find_reservation (queue* q, mcapi_request_t request);
+void mcapi_trans_remove_reservation (queue* q, int i);
 mcapi_boolean_t mcapi_trans_endpoint_create_(mcapi_endpoint_t* ep, mcapi_domain_t domain_id, mcapi_node_t node_num, mcapi_uint_t port_num, mcapi_boolean_t anonymous);
 
+/* cache of the remote endpoints */
+endpoint_cache_entry* mcapi_trans_endpoint_cache_slot (mcapi_domain_t domain_id, mcapi_uint_t node_num, mcapi_uint_t port_num);
+mcapi_boolean_t mcapi_trans_endpoint_cache_get (mcapi_endpoint_t* ep, mcapi_domain_t domain_id, mcapi_uint_t node_num, mcapi_uint_t port_num);
+
 #define mcapi_assert(x) MCAPI_ASSERT(x,__LINE__);
 void MCAPI_ASSERT(mcapi_boolean_t condition,unsigned line)
 {
@@ -244,9 +325,94 @@ uint32_t global_rwl = 0; /* the global database lock */
 
 mcapi_boolean_t locked = 0;
 
+/* Locks of the message paths. DatabaseMutex is only taken for topology
+   changes, see mcapi_trans_access_database_pre() for the lock order.
+   On uC/OS-II they are binary semaphores, a mutex would need a priority
+   of its own. */
+#ifdef UCOSII
+	typedef OS_EVENT* mcapi_lock_t;
+#endif
+
+#ifdef LINUX
+	typedef pthread_mutex_t mcapi_lock_t;
+#endif
+
+mcapi_lock_t endpoint_locks[MCAPI_MAX_ENDPOINTS];	/* receive queue, state and
+													   waiter of endpoint index e
+													   (of every node) */
+mcapi_lock_t request_locks[MCAPI_REQUEST_LOCKS];	/* request entries r with
+													   r % MCAPI_REQUEST_LOCKS
+													   == index */
+mcapi_lock_t reserve_lock;		/* reserves header, no other lock is taken
+								   while it is held */
+mcapi_lock_t buffer_lock;		/* allocation of mcapi_db->buffers */
+mcapi_lock_t waiter_lock;		/* allocation of the completion objects */
+mcapi_lock_t cache_lock;		/* mcapi_db->endpoint_cache, no other lock is
+								   taken while it is held */
+
+/* the request lock of request index r */
+#define REQUEST_LOCK(r) (&request_locks[(r) % MCAPI_REQUEST_LOCKS])
+
+mcapi_boolean_t mcapi_trans_lock_create (mcapi_lock_t* lock);
+void mcapi_trans_lock_destroy (mcapi_lock_t* lock);
+void mcapi_trans_lock (mcapi_lock_t* lock);
+void mcapi_trans_unlock (mcapi_lock_t* lock);
+buffer_entry* mcapi_trans_buffer_get (size_t size, int* index);
+void mcapi_trans_buffer_put (buffer_entry* b_e);
+
+/* completion object of a task blocked in mcapi_trans_wait(),
+   mcapi_trans_wait_any() or a blocking receive */
+typedef struct {
+#ifdef UCOSII
+	OS_EVENT *sem;				/* counts the signals */
+#endif
+#ifdef LINUX
+	pthread_mutex_t mutex;		/* guards signalled */
+	pthread_cond_t cond;
+	mcapi_boolean_t signalled;
+#endif
+	mcapi_boolean_t in_use;
+} mcapi_waiter;
+
+mcapi_waiter waiters[MCAPI_MAX_WAITERS];
+
+/* absolute end of a wait */
+#ifdef UCOSII
+	#define MCAPI_TICKS_PER_SEC ((INT32U) OS_TICKS_PER_SEC)
+	#define RECHECK_TICKS ((RECHECK_MS * MCAPI_TICKS_PER_SEC + 999) / 1000)
+	typedef INT32U mcapi_deadline_t;			/* OSTimeGet() ticks */
+#endif
+
+#ifdef LINUX
+	typedef struct timespec mcapi_deadline_t;	/* CLOCK_REALTIME, as used by
+												   pthread_cond_timedwait() */
+#endif
+
+void mcapi_trans_set_deadline (mcapi_deadline_t* deadline, mcapi_timeout_t timeout);
+mcapi_boolean_t mcapi_trans_waiter_block_have_lock (uint8_t w, mcapi_lock_t* lock, const mcapi_deadline_t* deadline, mcapi_boolean_t recheck);
+
 mcapi_database mcapi_db_impl;
 mcapi_database* mcapi_db;
 
+/* size and number of the buffers of each class, see mcapi_trans_nios.h */
+static const size_t buffer_class_size[MCAPI_BUFFER_CLASSES] = {
+	MCAPI_BUFFER_SIZE_0, MCAPI_BUFFER_SIZE_1, MCAPI_BUFFER_SIZE_2, MCAPI_BUFFER_SIZE_3
+};
+static const int buffer_class_count[MCAPI_BUFFER_CLASSES] = {
+	MCAPI_BUFFERS_0, MCAPI_BUFFERS_1, MCAPI_BUFFERS_2, MCAPI_BUFFERS_3
+};
+/* compile time checks: the counts add up to MCAPI_MAX_BUFFERS, the sizes keep
+   the data aligned for the 64 bit scalars and the largest class holds a message */
+typedef char buffer_class_count_check[(MCAPI_BUFFERS_0 + MCAPI_BUFFERS_1 +
+		MCAPI_BUFFERS_2 + MCAPI_BUFFERS_3 == MCAPI_MAX_BUFFERS) ? 1 : -1];
+typedef char buffer_class_size_check[(MCAPI_BUFFER_SIZE_0 % 8 == 0 &&
+		MCAPI_BUFFER_SIZE_1 % 8 == 0 && MCAPI_BUFFER_SIZE_2 % 8 == 0 &&
+		MCAPI_BUFFER_SIZE_3 % 8 == 0 &&
+		MCAPI_BUFFER_SIZE_3 >= MCAPI_MAX(MCAPI_MAX_PKT_SIZE,MCAPI_MAX_MSG_SIZE)) ? 1 : -1];
+/* the entry of an endpoint is selected with a mask */
+typedef char endpoint_cache_size_check[(MCAPI_ENDPOINT_CACHE_SIZE > 0 &&
+		(MCAPI_ENDPOINT_CACHE_SIZE & (MCAPI_ENDPOINT_CACHE_SIZE - 1)) == 0) ? 1 : -1];
+
 /* the debug level */
 int mcapi_debug = 1;
 
@@ -303,12 +469,15 @@ DESCRIPTION: Removes request from array
 PARAMETERS:
 r - request index
 RETURN VALUE: TRUE/FALSE indicating if the request has removed.
+The caller holds the request lock and has cleared the entry, the entry may
+be reserved again as soon as this returns.
 ***************************************************************************/
 mcapi_boolean_t mcapi_trans_remove_request_have_lock(int r) {	/* by etem */
 	int temp_empty_head_index;
 	mcapi_boolean_t rc = MCAPI_FALSE;
 	indexed_array_header *header = &mcapi_db->request_reserves_header;
 
+	mcapi_trans_lock(&reserve_lock);
 	if (header->full_head_index != -1) {
 		if (header->full_head_index == r) {
 			header->full_head_index = header->array[header->full_head_index].next_index;
@@ -329,21 +498,26 @@ mcapi_boolean_t mcapi_trans_remove_request_have_lock(int r) {	/* by etem */
 		header->curr_count--;
 		rc = MCAPI_TRUE;
 	}
+	mcapi_trans_unlock(&reserve_lock);
 	return rc; // if rc=false, then there is no request available (array is empty)
 }
 
 /***************************************************************************
 NAME: mcapi_trans_reserve_request
-DESCRIPTION: Reserves an entry in the requests array
+DESCRIPTION: Reserves an entry in the requests array. The entry belongs
+ to the caller until setup_request_have_lock() has returned its handle,
+ so it is set up without the request lock. The free list is guarded by
+ the reserve lock.
 PARAMETERS: *r - request index pointer
 RETURN VALUE: T/F
 ***************************************************************************/
-mcapi_boolean_t mcapi_trans_reserve_request_have_lock(int *r) {	/* by etem */
+mcapi_boolean_t mcapi_trans_reserve_request(int *r) {	/* by etem */
 	int temp_full_head_index;
 	mcapi_boolean_t rc = MCAPI_FALSE;
 
 	indexed_array_header *header = &mcapi_db->request_reserves_header;
 
+	mcapi_trans_lock(&reserve_lock);
 	if (header->empty_head_index != -1) {
 		*r = header->empty_head_index;
 	  mcapi_db->requests[*r].valid = MCAPI_TRUE;
@@ -359,6 +533,7 @@ mcapi_boolean_t mcapi_trans_reserve_request_have_lock(int *r) {	/* by etem */
 		header->curr_count++;
 		rc = MCAPI_TRUE;
 	}
+	mcapi_trans_unlock(&reserve_lock);
 	return rc;
 }
 
@@ -383,6 +558,35 @@ void mcapi_trans_init_indexed_array_have_lock() {	/* by etem */
 	mcapi_db->request_reserves_header.array[0].prev_index = -1;
 }
 
+/***************************************************************************
+NAME: mcapi_trans_init_buffer_pool_have_lock
+DESCRIPTION: initializes the free list of the buffers, all buffers are free
+PARAMETERS:
+RETURN VALUE: none
+***************************************************************************/
+void mcapi_trans_init_buffer_pool_have_lock() {
+	int c, i, j;
+	char* data = (char*)mcapi_db->buffer_data;
+
+	/* the buffers of a class follow each other, the classes are sorted by size */
+	i = 0;
+	for (c = 0; c < MCAPI_BUFFER_CLASSES; c++) {
+		mcapi_db->buffer_pool.free_head[c] = i;
+		for (j = 0; j < buffer_class_count[c]; j++, i++) {
+			mcapi_db->buffers[i].buff = data;
+			mcapi_db->buffers[i].size_class = c;
+			mcapi_db->buffers[i].magic_num = 0;
+			mcapi_db->buffers[i].size = 0;
+			mcapi_db->buffers[i].next_free = i + 1;
+			data += buffer_class_size[c];
+		}
+		mcapi_db->buffers[i - 1].next_free = -1;
+	}
+	mcapi_db->buffer_pool.num_used = 0;
+	mcapi_db->buffer_pool.high_water = 0;
+	mcapi_db->buffer_pool.num_exhausted = 0;
+}
+
 /***************************************************************************
 
   NAME: mcapi_trans_initialize    OK
@@ -414,6 +618,45 @@ mcapi_boolean_t mcapi_trans_initialize (mcapi_domain_t domain_id, mcapi_node_t n
 	}
 #endif
 
+  // create the locks of the receive queues, the request table, the
+  // buffer pool and the completion objects
+  int e;
+  for (e = 0; e < MCAPI_MAX_ENDPOINTS; e++) {
+	if (!mcapi_trans_lock_create(&endpoint_locks[e])) { return MCAPI_FALSE; }
+  }
+  int r;
+  for (r = 0; r < MCAPI_REQUEST_LOCKS; r++) {
+	if (!mcapi_trans_lock_create(&request_locks[r])) { return MCAPI_FALSE; }
+  }
+  if (!mcapi_trans_lock_create(&reserve_lock) ||
+	  !mcapi_trans_lock_create(&buffer_lock) ||
+	  !mcapi_trans_lock_create(&waiter_lock) ||
+	  !mcapi_trans_lock_create(&cache_lock)) {
+	return MCAPI_FALSE;
+  }
+
+  // create the completion objects of the waiting tasks
+  int w;
+  for (w = 0; w < MCAPI_MAX_WAITERS; w++) {
+	waiters[w].in_use = MCAPI_FALSE;
+#ifdef UCOSII
+	waiters[w].sem = OSSemCreate(0);
+	if(waiters[w].sem == NULL) {
+	  printf("Error in mcapi_trans_nios: OSSemCreate() failed");
+	  return MCAPI_FALSE;
+	}
+#endif
+
+#ifdef LINUX
+	waiters[w].signalled = MCAPI_FALSE;
+	if(((err = pthread_mutex_init(&waiters[w].mutex, NULL)) != 0) ||
+	   ((err = pthread_cond_init(&waiters[w].cond, NULL)) != 0)) {
+	  printf("Error in mcapi_trans_nios: pthread_cond_init() failed");
+	  return MCAPI_FALSE;
+	}
+#endif
+  }
+
   /* lock the database */
   if (!mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE)) { return MCAPI_FALSE; }
 
@@ -481,11 +724,21 @@ void mcapi_trans_initialize_database() {
 			for(e = 0; e < MCAPI_MAX_ENDPOINTS; e++)
 			{
 				mcapi_db->domains[d].nodes[n].node_d.endpoints[e].valid = MCAPI_FALSE;
+				mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue = NULL;
 			}
 		}
 	}
+	/* all receive queues are free */
+	for (e = 0; e < MCAPI_MAX_QUEUES; e++)
+	{
+		mcapi_db->queues[e].in_use = MCAPI_FALSE;
+	}
 	/* init indexed array */
 	mcapi_trans_init_indexed_array_have_lock();
+	/* init free list of the buffers */
+	mcapi_trans_init_buffer_pool_have_lock();
+	/* no remote endpoint is known yet */
+	memset(mcapi_db->endpoint_cache,0,sizeof(mcapi_db->endpoint_cache));
 }
 
 
@@ -646,8 +899,27 @@ mcapi_boolean_t mcapi_trans_finalize ()
 	  printf("Error in mcapi_trans_nios: pthread_mutex_init() failed");
 	  return MCAPI_FALSE;
 	}
+
+	int w;
+	for (w = 0; w < MCAPI_MAX_WAITERS; w++) {
+	  pthread_cond_destroy(&waiters[w].cond);
+	  pthread_mutex_destroy(&waiters[w].mutex);
+	}
 #endif
 
+	int e;
+	for (e = 0; e < MCAPI_MAX_ENDPOINTS; e++) {
+	  mcapi_trans_lock_destroy(&endpoint_locks[e]);
+	}
+	int r;
+	for (r = 0; r < MCAPI_REQUEST_LOCKS; r++) {
+	  mcapi_trans_lock_destroy(&request_locks[r]);
+	}
+	mcapi_trans_lock_destroy(&reserve_lock);
+	mcapi_trans_lock_destroy(&buffer_lock);
+	mcapi_trans_lock_destroy(&waiter_lock);
+	mcapi_trans_lock_destroy(&cache_lock);
+
 	return rc;
 }
 
@@ -672,7 +944,7 @@ channel_type mcapi_trans_channel_type (mcapi_endpoint_t endpoint)
 	mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
 	mcapi_assert(mcapi_trans_decode_handle(endpoint,&d,&n,&e));
-	rc = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.channel_type;
+	rc = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].channel_type;
 
 	/* unlock the database */
 	mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
@@ -697,7 +969,7 @@ mcapi_boolean_t mcapi_trans_send_endpoint (mcapi_endpoint_t endpoint)
 
 	mcapi_assert(mcapi_trans_decode_handle(endpoint,&d,&n,&e));
 	if ((mcapi_db->domains[d].nodes[n].node_d.endpoints[e].connected) &&
-		(mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.recv_endpt == endpoint)) {
+		(mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_endpt == endpoint)) {
 	  /* this endpoint has already been marked as a receive endpoint */
 	  mcapi_dprintf(2,"mcapi_trans_send_endpoint ERROR: this endpoint (0x%x) has already been connected as a receive endpoint",
 					endpoint);
@@ -728,7 +1000,7 @@ mcapi_boolean_t mcapi_trans_recv_endpoint (mcapi_endpoint_t endpoint)
 
 	mcapi_assert(mcapi_trans_decode_handle(endpoint,&d,&n,&e));
 	if ((mcapi_db->domains[d].nodes[n].node_d.endpoints[e].connected) &&
-		(mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.send_endpt == endpoint)) {
+		(mcapi_db->domains[d].nodes[n].node_d.endpoints[e].send_endpt == endpoint)) {
 	  /* this endpoint has already been marked as a send endpoint */
 	  mcapi_dprintf(2,"mcapi_trans_recv_endpoint ERROR: this endpoint (0x%x) has already been connected as a send endpoint",
 					endpoint);
@@ -788,18 +1060,15 @@ mcapi_boolean_t mcapi_trans_valid_endpoint (mcapi_endpoint_t endpoint)
 	uint16_t d,n,e;
 	mcapi_boolean_t rc = MCAPI_FALSE;
 
-	/* lock the database */
-	mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
-	if (mcapi_trans_decode_handle(endpoint,&d,&n,&e) &&
-		mcapi_db->domains[d].nodes[n].node_d.endpoints[e].valid)
+	if (mcapi_trans_decode_handle(endpoint,&d,&n,&e))
 	{
-		rc = MCAPI_TRUE;
+		/* lock the endpoint */
+		mcapi_trans_lock(&endpoint_locks[e]);
+		rc = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].valid;
+		/* unlock the endpoint */
+		mcapi_trans_unlock(&endpoint_locks[e]);
 	}
 
-	/* unlock the database */
-	mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
-
 	return rc;
 }
 
@@ -894,9 +1163,6 @@ mcapi_boolean_t mcapi_trans_valid_endpoints (mcapi_endpoint_t endpoint1,
 	uint16_t d2,n2,e2;
 	mcapi_boolean_t rc = MCAPI_FALSE;
 
-	/* lock the database */
-	mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 	/*FIXME should endpoint handles be
 	 * checked if the refer to valid endpoints
 	 * when sending a message?
@@ -908,9 +1174,6 @@ mcapi_boolean_t mcapi_trans_valid_endpoints (mcapi_endpoint_t endpoint1,
 	  rc = MCAPI_TRUE;
 	}
 
-	/* unlock the database */
-	mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
-
 	return rc;
 }
 
@@ -1042,14 +1305,14 @@ mcapi_boolean_t mcapi_trans_channel_connected (mcapi_endpoint_t endpoint)
 	 */
 	if(d == my_domain_id && n == my_node_id)
 	{
-		/* lock the database */
-		mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
+		/* lock the endpoint */
+		mcapi_trans_lock(&endpoint_locks[e]);
 
 		rc = ((mcapi_db->domains[d].nodes[n].node_d.endpoints[e].valid) &&
 			  (mcapi_db->domains[d].nodes[n].node_d.endpoints[e].connected));
 
-		/* unlock the database */
-		mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
+		/* unlock the endpoint */
+		mcapi_trans_unlock(&endpoint_locks[e]);
 	}
 
 	return rc;
@@ -1081,24 +1344,23 @@ mcapi_boolean_t mcapi_trans_valid_pktchan_send_handle( mcapi_pktchan_send_hndl_t
 
 	int rc = MCAPI_FALSE;
 
-	/* lock the database */
-	mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 	mcapi_dprintf (2,"mcapi_trans_valid_pktchan_send_handle (0x%x);",handle);
 
 	type =MCAPI_PKT_CHAN;
 	if (mcapi_trans_decode_handle(handle,&d,&n,&e)) {
-	  if (mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.channel_type == type) {
+	  /* lock the endpoint */
+	  mcapi_trans_lock(&endpoint_locks[e]);
+	  if (mcapi_db->domains[d].nodes[n].node_d.endpoints[e].channel_type == type) {
 		rc = MCAPI_TRUE;
 	  } else {
 		mcapi_dprintf(2,"mcapi_trans_valid_pktchan_send_handle node=%u,port=%u returning false channel_type != MCAPI_PKT_CHAN",
 					  mcapi_db->domains[d].nodes[n].node_num,
 					  mcapi_db->domains[d].nodes[n].node_d.endpoints[e].port_num);
 	  }
+	  /* unlock the endpoint */
+	  mcapi_trans_unlock(&endpoint_locks[e]);
 	}
 
-	/* unlock the database */
-	mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
 	return rc;
 }
 
@@ -1114,24 +1376,23 @@ mcapi_boolean_t mcapi_trans_valid_pktchan_recv_handle( mcapi_pktchan_recv_hndl_t
 	channel_type type;
 	int rc = MCAPI_FALSE;
 
-	/* lock the database */
-	mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 	mcapi_dprintf (2,"mcapi_trans_valid_pktchan_recv_handle (0x%x);",handle);
 
 	type = MCAPI_PKT_CHAN;
 	if (mcapi_trans_decode_handle(handle,&d,&n,&e)) {
-	  if (mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.channel_type == type) {
+	  /* lock the endpoint */
+	  mcapi_trans_lock(&endpoint_locks[e]);
+	  if (mcapi_db->domains[d].nodes[n].node_d.endpoints[e].channel_type == type) {
 		rc = MCAPI_TRUE;
 	  } else {
 		mcapi_dprintf(2,"mcapi_trans_valid_pktchan_recv_handle node=%u,port=%u returning false channel_type != MCAPI_PKT_CHAN",
 					  mcapi_db->domains[d].nodes[n].node_num,
 					  mcapi_db->domains[d].nodes[n].node_d.endpoints[e].port_num);
 	  }
+	  /* unlock the endpoint */
+	  mcapi_trans_unlock(&endpoint_locks[e]);
 	}
 
-	/* unlock the database */
-	mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
 	return rc;
 }
 
@@ -1147,25 +1408,23 @@ mcapi_boolean_t mcapi_trans_valid_sclchan_send_handle( mcapi_sclchan_send_hndl_t
 	channel_type type;
 	int rc = MCAPI_FALSE;
 
-	/* lock the database */
-	mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 	mcapi_dprintf (2,"mcapi_trans_valid_sclchan_send_handle (0x%x);",handle);
 
 	type = MCAPI_SCL_CHAN;
 	if (mcapi_trans_decode_handle(handle,&d,&n,&e)) {
-	  if (mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.channel_type == type) {
+	  /* lock the endpoint */
+	  mcapi_trans_lock(&endpoint_locks[e]);
+	  if (mcapi_db->domains[d].nodes[n].node_d.endpoints[e].channel_type == type) {
 		rc = MCAPI_TRUE;
 	  } else {
 		mcapi_dprintf(2,"mcapi_trans_valid_sclchan_send_handle node=%u,port=%u returning false channel_type != MCAPI_SCL_CHAN",
 					  mcapi_db->domains[d].nodes[n].node_num,
 					  mcapi_db->domains[d].nodes[n].node_d.endpoints[e].port_num);
 	  }
+	  /* unlock the endpoint */
+	  mcapi_trans_unlock(&endpoint_locks[e]);
 	}
 
-	/* unlock the database */
-	mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
-
 	return rc;
 }
 
@@ -1182,24 +1441,23 @@ mcapi_boolean_t mcapi_trans_valid_sclchan_recv_handle( mcapi_sclchan_recv_hndl_t
 
 	int rc = MCAPI_FALSE;
 
-	/* lock the database */
-	mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 	mcapi_dprintf (2,"mcapi_trans_valid_sclchan_recv_handle (0x%x);",handle);
 
 	type= MCAPI_SCL_CHAN;
 	if (mcapi_trans_decode_handle(handle,&d,&n,&e)) {
-	  if (mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.channel_type == type) {
+	  /* lock the endpoint */
+	  mcapi_trans_lock(&endpoint_locks[e]);
+	  if (mcapi_db->domains[d].nodes[n].node_d.endpoints[e].channel_type == type) {
 		rc = MCAPI_TRUE;
 	  } else {
 		mcapi_dprintf(2,"mcapi_trans_valid_sclchan_recv_handle node=%u,port=%u returning false channel_type != MCAPI_SCL_CHAN",
 					  mcapi_db->domains[d].nodes[n].node_num,
 					  mcapi_db->domains[d].nodes[n].node_d.endpoints[e].port_num);
 	  }
+	  /* unlock the endpoint */
+	  mcapi_trans_unlock(&endpoint_locks[e]);
 	}
 
-	/* unlock the database */
-	mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
 	return rc;
 }
 
@@ -1286,7 +1544,7 @@ mcapi_boolean_t mcapi_trans_connected(mcapi_endpoint_t endpoint)
 	mcapi_dprintf (2,"mcapi_trans_connected (0x%x);",endpoint);
 
 	rc = (mcapi_trans_decode_handle(endpoint,&d,&n,&e) &&
-		 (mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.channel_type != MCAPI_NO_CHAN));
+		 (mcapi_db->domains[d].nodes[n].node_d.endpoints[e].channel_type != MCAPI_NO_CHAN));
 	/* unlock the database */
 	mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
 	return rc;
@@ -1357,6 +1615,38 @@ mcapi_boolean_t mcapi_trans_valid_size_param (size_t* size)
 //                   mcapi_trans API: endpoints                             //
 //                                                                          //
 //////////////////////////////////////////////////////////////////////////////
+/***************************************************************************
+NAME:mcapi_trans_queue_get_have_lock
+DESCRIPTION: takes an empty receive queue from the pool, only the local
+   endpoints have one. Called with the database locked.
+PARAMETERS: none
+RETURN VALUE: the queue, NULL if all MCAPI_MAX_QUEUES queues are in use
+***************************************************************************/
+queue* mcapi_trans_queue_get_have_lock()
+{
+	queue* q;
+	int i, j;
+
+	for (i = 0; i < MCAPI_MAX_QUEUES; i++) {
+		q = &mcapi_db->queues[i];
+		if (!q->in_use) {
+			q->in_use = MCAPI_TRUE;
+			/* the ring is only accessed past the data cache */
+			RING_WRITE(q->head,0);
+			RING_WRITE(q->tail,0);
+			for (j = 0; j < MCAPI_MAX_QUEUE_ENTRIES; j++) {
+				RING_WRITE(q->elements[j],0);
+			}
+			q->num_reserved = 0;
+			q->num_bound = 0;
+			memset (q->reserved,0,sizeof(q->reserved));
+			return q;
+		}
+	}
+	mcapi_dprintf(1,"mcapi_trans_queue_get_have_lock: no free receive queue, increase MCAPI_MAX_QUEUES");
+	return NULL;
+}
+
 /***************************************************************************
 NAME:mcapi_trans_endpoint_create
 DESCRIPTION:create endpoint <node_num,port_num> and return it's handle
@@ -1377,6 +1667,7 @@ mcapi_boolean_t mcapi_trans_endpoint_create (mcapi_endpoint_t* ep,
 	mcapi_boolean_t rc = MCAPI_FALSE;
 	mcapi_domain_t domain_id2;
 	mcapi_node_t node_num2;
+	queue* q;
 
 	/* lock the database */
 	mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
@@ -1400,13 +1691,23 @@ mcapi_boolean_t mcapi_trans_endpoint_create (mcapi_endpoint_t* ep,
 	  }
 	}
 
+	/* the endpoint takes a receive queue from the pool */
+	if (endpoint_index < MCAPI_MAX_ENDPOINTS) {
+		q = mcapi_trans_queue_get_have_lock();
+		if (q == NULL) {
+			endpoint_index = MCAPI_MAX_ENDPOINTS;
+		}
+	}
+
 	if (endpoint_index < MCAPI_MAX_ENDPOINTS) {
 	  /* initialize the endpoint entry*/
+		mcapi_db->domains[domain_index].nodes[node_index].node_d.endpoints[endpoint_index].recv_queue = q;
 		mcapi_db->domains[domain_index].nodes[node_index].node_d.endpoints[endpoint_index].valid = MCAPI_TRUE;
 		mcapi_db->domains[domain_index].nodes[node_index].node_d.endpoints[endpoint_index].port_num = port_num;
 		mcapi_db->domains[domain_index].nodes[node_index].node_d.endpoints[endpoint_index].open = MCAPI_FALSE;
 		mcapi_db->domains[domain_index].nodes[node_index].node_d.endpoints[endpoint_index].anonymous = anonymous;
 		mcapi_db->domains[domain_index].nodes[node_index].node_d.endpoints[endpoint_index].num_attributes = 0;
+		mcapi_db->domains[domain_index].nodes[node_index].node_d.endpoints[endpoint_index].latency_critical = MCAPI_FALSE;
 		mcapi_db->domains[domain_index].nodes[node_index].node_d.num_endpoints++;
 
 		/* set the handle */
@@ -1435,6 +1736,7 @@ mcapi_boolean_t mcapi_trans_endpoint_create_(mcapi_endpoint_t* ep, mcapi_domain_
 {
 	uint32_t i, endpoint_index;
 	mcapi_boolean_t rc = MCAPI_FALSE;
+	queue* q = NULL;
 
 	/* lock the database */
 	mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
@@ -1457,13 +1759,25 @@ mcapi_boolean_t mcapi_trans_endpoint_create_(mcapi_endpoint_t* ep, mcapi_domain_
 	  }
 	}
 
+	/* only local endpoints receive, they take a queue from the pool */
+	if (endpoint_index < MCAPI_MAX_ENDPOINTS && domain_id == my_domain_id && node_num == my_node_id) {
+		q = mcapi_trans_queue_get_have_lock();
+		if (q == NULL) {
+			endpoint_index = MCAPI_MAX_ENDPOINTS;
+		}
+	}
+
 	if (endpoint_index < MCAPI_MAX_ENDPOINTS) {
 	  /* initialize the endpoint entry*/
+		mcapi_trans_lock(&endpoint_locks[endpoint_index]);
+		mcapi_db->domains[domain_id].nodes[node_num].node_d.endpoints[endpoint_index].recv_queue = q;
 		mcapi_db->domains[domain_id].nodes[node_num].node_d.endpoints[endpoint_index].valid = MCAPI_TRUE;
 		mcapi_db->domains[domain_id].nodes[node_num].node_d.endpoints[endpoint_index].port_num = port_num;
 		mcapi_db->domains[domain_id].nodes[node_num].node_d.endpoints[endpoint_index].open = MCAPI_FALSE;
 		mcapi_db->domains[domain_id].nodes[node_num].node_d.endpoints[endpoint_index].anonymous = anonymous;
 		mcapi_db->domains[domain_id].nodes[node_num].node_d.endpoints[endpoint_index].num_attributes = 0;
+		mcapi_db->domains[domain_id].nodes[node_num].node_d.endpoints[endpoint_index].latency_critical = MCAPI_FALSE;
+		mcapi_trans_unlock(&endpoint_locks[endpoint_index]);
 		mcapi_db->domains[domain_id].nodes[node_num].node_d.num_endpoints++;
 
 		/* set the handle */
@@ -1504,9 +1818,16 @@ void mcapi_trans_endpoint_get_attribute(
 		mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
 		if (attribute_num == MCAPI_ENDP_ATTR_NUM_RECV_BUFFERS) {
-		  *attr = MCAPI_MAX_QUEUE_ENTRIES -
-				  mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.num_elements;
+		  *attr = MCAPI_MAX_QUEUE_ELEMENTS -
+				  mcapi_trans_count_queue(mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue);
 		  *mcapi_status = MCAPI_SUCCESS;
+		} else if (attribute_num == MCAPI_ENDP_ATTR_LATENCY_CRITICAL) {
+		  if (attribute_size != sizeof(mcapi_boolean_t)) {
+			*mcapi_status = MCAPI_ERR_ATTR_SIZE;
+		  } else {
+			*(mcapi_boolean_t*) attribute = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].latency_critical;
+			*mcapi_status = MCAPI_SUCCESS;
+		  }
 		}
 
 		/* unlock the database */
@@ -1521,8 +1842,14 @@ void mcapi_trans_endpoint_get_attribute(
 
 /***************************************************************************
 NAME:mcapi_trans_endpoint_set_attribute
-DESCRIPTION:
+DESCRIPTION: sets an attribute of a local endpoint, only
+   MCAPI_ENDP_ATTR_LATENCY_CRITICAL is supported
 PARAMETERS:
+   endpoint - the endpoint handle
+   attribute_num - the attribute
+   attribute - the new value
+   attribute_size - the size of the value
+   mcapi_status - the status to be filled in
 RETURN VALUE: none
 ***************************************************************************/
 void mcapi_trans_endpoint_set_attribute(
@@ -1532,8 +1859,27 @@ void mcapi_trans_endpoint_set_attribute(
                                         size_t attribute_size,
                                         mcapi_status_t* mcapi_status)
 {
+	uint16_t d,n,e;
+
+	mcapi_assert(mcapi_trans_decode_handle(endpoint,&d,&n,&e));
+
+	if (d != my_domain_id || n != my_node_id) {
+		*mcapi_status = MCAPI_ERR_ENDP_REMOTE;
+	} else if (attribute_num != MCAPI_ENDP_ATTR_LATENCY_CRITICAL) {
+		*mcapi_status = MCAPI_ERR_ATTR_NOTSUPPORTED;
+	} else if (attribute_size != sizeof(mcapi_boolean_t)) {
+		*mcapi_status = MCAPI_ERR_ATTR_SIZE;
+	} else {
+		/* lock the database */
+		mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
+
+		mcapi_db->domains[d].nodes[n].node_d.endpoints[e].latency_critical =
+			(*(const mcapi_boolean_t*) attribute) ? MCAPI_TRUE : MCAPI_FALSE;
+		*mcapi_status = MCAPI_SUCCESS;
 
-  fprintf(stderr,"WARNING: setting endpoint attributes not implemented");
+		/* unlock the database */
+		mcapi_assert (mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
+	}
 }
 
 
@@ -1562,7 +1908,7 @@ void mcapi_trans_endpoint_get_i( mcapi_endpoint_t* endpoint,
 	mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
 	/* make sure we have an available request entry*/
-	if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	if ( mcapi_trans_reserve_request(&r)) {
 	  if (valid) {
 		/* try to get the endpoint */
 		/* check if the endpoint node is the local node */
@@ -1572,6 +1918,10 @@ void mcapi_trans_endpoint_get_i( mcapi_endpoint_t* endpoint,
 			  completed = MCAPI_TRUE; /* endpoint received -> reqeuest completed */
 			}
 		}
+		else if (mcapi_trans_endpoint_cache_get (endpoint,domain_id,node_num,port_num))
+		{
+			completed = MCAPI_TRUE; /* endpoint was resolved before -> request completed */
+		}
 		else
 		{
 			/* endpoint node is not the local node -> go to the nex layer */
@@ -1579,6 +1929,7 @@ void mcapi_trans_endpoint_get_i( mcapi_endpoint_t* endpoint,
 			mcapi_assert (mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
 
 			if (NS_getRemoteEndpoint_request(endpoint,domain_id,node_num,port_num) == NS_OK) {
+			  mcapi_trans_endpoint_cache_put (*endpoint,domain_id,node_num,port_num);
 			  completed = MCAPI_TRUE; /* endpoint received -> request completed */
 			}
 
@@ -1727,6 +2078,11 @@ RETURN VALUE: none
 void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 {
 	uint16_t d,n,e;
+	queue* q;
+	int32_t index;
+	int i;
+	uint32_t port_num;
+	mcapi_boolean_t local;
 
 	mcapi_dprintf(1,"mcapi_trans_endpoint_delete(0x%x);",endpoint);
 	/* lock the database */
@@ -1737,13 +2093,173 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	mcapi_dprintf(2,"mcapi_trans_endpoint_delete_have_lock node_num=%u, port_num=%u",
 				  mcapi_db->domains[d].nodes[n].node_num,mcapi_db->domains[d].nodes[n].node_d.endpoints[e].port_num);
 
+	port_num = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].port_num;
+	local = (mcapi_db->domains[d].domain_id == my_domain_id) &&
+			(mcapi_db->domains[d].nodes[n].node_num == my_node_id);
+
 	/* remove the endpoint */
 	mcapi_db->domains[d].nodes[n].node_d.num_endpoints--;
 	/* zero out the old endpoint entry in the shared memory database */
+	mcapi_trans_lock(&endpoint_locks[e]);
+	/* free the buffers of the pending messages and give the queue back */
+	q = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue;
+	if (q != NULL) {
+		while ((index = mcapi_trans_pop_queue(q)) != 0) {
+			mcapi_trans_buffer_put(&mcapi_db->buffers[index &~ MCAPI_VALID_MASK]);
+		}
+		for (i = 0; i < q->num_bound; i++) {
+			mcapi_trans_buffer_put(&mcapi_db->buffers[q->reserved[i].buff_index &~ MCAPI_VALID_MASK]);
+		}
+		q->in_use = MCAPI_FALSE;
+	}
 	memset (&mcapi_db->domains[d].nodes[n].node_d.endpoints[e],0,sizeof(endpoint_entry));
+	mcapi_trans_unlock(&endpoint_locks[e]);
 
 	/* unlock the database */
 	mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
+
+	/* the other nodes remove the endpoint from their caches */
+	if (local) {
+		NS_endpointDeleted_notification(my_domain_id,my_node_id,port_num);
+	}
+}
+
+/***************************************************************************
+NAME:mcapi_trans_endpoint_port
+DESCRIPTION: returns the port of a local endpoint, used by the NS layer to
+   tell the receiver of a message its send endpoint
+PARAMETERS: endpoint - the endpoint handle
+RETURN VALUE: the port number, 0 if the handle is invalid
+***************************************************************************/
+mcapi_uint_t mcapi_trans_endpoint_port (mcapi_endpoint_t endpoint)
+{
+	uint16_t d,n,e;
+
+	if (!mcapi_trans_decode_handle(endpoint,&d,&n,&e)) {
+		return 0;
+	}
+	/* the port of an endpoint doesn't change while it sends */
+	return mcapi_db->domains[d].nodes[n].node_d.endpoints[e].port_num;
+}
+
+/***************************************************************************
+NAME:mcapi_trans_endpoint_latency_critical
+DESCRIPTION: tells the NS layer whether the packets of a local send endpoint
+   must not be coalesced (MCAPI_ENDP_ATTR_LATENCY_CRITICAL)
+PARAMETERS: endpoint - the endpoint handle
+RETURN VALUE: MCAPI_TRUE if the endpoint is latency critical
+***************************************************************************/
+mcapi_boolean_t mcapi_trans_endpoint_latency_critical (mcapi_endpoint_t endpoint)
+{
+	uint16_t d,n,e;
+
+	if (!mcapi_trans_decode_handle(endpoint,&d,&n,&e)) {
+		return MCAPI_FALSE;
+	}
+	/* a single word, set by mcapi_trans_endpoint_set_attribute() */
+	return mcapi_db->domains[d].nodes[n].node_d.endpoints[e].latency_critical;
+}
+
+/***************************************************************************
+NAME:mcapi_trans_endpoint_cache_slot
+DESCRIPTION: returns the cache entry of a remote endpoint, the caller holds
+   the cache lock
+PARAMETERS:
+   domain_id - the domain id
+   node_num - the node id
+   port_num - the port id
+RETURN VALUE: the entry, it may hold another endpoint
+***************************************************************************/
+endpoint_cache_entry* mcapi_trans_endpoint_cache_slot (mcapi_domain_t domain_id,
+													  mcapi_uint_t node_num,
+													  mcapi_uint_t port_num)
+{
+	uint32_t hash = (domain_id * 31 + node_num) * 31 + port_num;
+
+	return &mcapi_db->endpoint_cache[hash & (MCAPI_ENDPOINT_CACHE_SIZE - 1)];
+}
+
+/***************************************************************************
+NAME:mcapi_trans_endpoint_cache_get
+DESCRIPTION: looks up the handle of a remote endpoint in the cache
+PARAMETERS:
+   ep - the endpoint handle to be filled in
+   domain_id - the domain id
+   node_num - the node id
+   port_num - the port id
+RETURN VALUE: MCAPI_TRUE if the endpoint was found
+***************************************************************************/
+mcapi_boolean_t mcapi_trans_endpoint_cache_get (mcapi_endpoint_t* ep,
+											   mcapi_domain_t domain_id,
+											   mcapi_uint_t node_num,
+											   mcapi_uint_t port_num)
+{
+	endpoint_cache_entry* c;
+	mcapi_boolean_t rc = MCAPI_FALSE;
+
+	mcapi_trans_lock(&cache_lock);
+	c = mcapi_trans_endpoint_cache_slot(domain_id,node_num,port_num);
+	if (c->valid && (c->domain_id == domain_id) &&
+		(c->node_num == node_num) && (c->port_num == port_num)) {
+		*ep = c->handle;
+		rc = MCAPI_TRUE;
+	}
+	mcapi_trans_unlock(&cache_lock);
+
+	return rc;
+}
+
+/***************************************************************************
+NAME:mcapi_trans_endpoint_cache_put
+DESCRIPTION: adds the handle of a remote endpoint to the cache, it replaces
+   the endpoint that had the entry before
+PARAMETERS:
+   ep - the endpoint handle
+   domain_id - the domain id
+   node_num - the node id
+   port_num - the port id
+RETURN VALUE: none
+***************************************************************************/
+void mcapi_trans_endpoint_cache_put (mcapi_endpoint_t ep,
+									 mcapi_domain_t domain_id,
+									 mcapi_uint_t node_num,
+									 mcapi_uint_t port_num)
+{
+	endpoint_cache_entry* c;
+
+	mcapi_trans_lock(&cache_lock);
+	c = mcapi_trans_endpoint_cache_slot(domain_id,node_num,port_num);
+	c->domain_id = domain_id;
+	c->node_num = node_num;
+	c->port_num = port_num;
+	c->handle = ep;
+	c->valid = MCAPI_TRUE;
+	mcapi_trans_unlock(&cache_lock);
+}
+
+/***************************************************************************
+NAME:mcapi_trans_endpoint_cache_invalidate
+DESCRIPTION: removes a remote endpoint from the cache, called when its node
+   has deleted it
+PARAMETERS:
+   domain_id - the domain id
+   node_num - the node id
+   port_num - the port id
+RETURN VALUE: none
+***************************************************************************/
+void mcapi_trans_endpoint_cache_invalidate (mcapi_domain_t domain_id,
+											mcapi_uint_t node_num,
+											mcapi_uint_t port_num)
+{
+	endpoint_cache_entry* c;
+
+	mcapi_trans_lock(&cache_lock);
+	c = mcapi_trans_endpoint_cache_slot(domain_id,node_num,port_num);
+	if (c->valid && (c->domain_id == domain_id) &&
+		(c->node_num == node_num) && (c->port_num == port_num)) {
+		c->valid = MCAPI_FALSE;
+	}
+	mcapi_trans_unlock(&cache_lock);
 }
 
 
@@ -1818,11 +2334,8 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_boolean_t completed =  (*mcapi_status == MCAPI_SUCCESS) ? MCAPI_FALSE : MCAPI_TRUE;
 	  mcapi_dprintf(1,"mcapi_trans_msg_send_i (0x%x,0x%x,buffer,%u,&request,&status);",send_endpoint,receive_endpoint,buffer_size);
 
-	  /* lock the database */
-	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 	  /* make sure we have an available request entry*/
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {	// a request will be reserved!!!
+	  if ( mcapi_trans_reserve_request(&r)) {	// a request will be reserved!!!
 		if (!completed) {
 		  completed = MCAPI_TRUE; /* sends complete immediately */
 		  mcapi_assert(mcapi_trans_decode_handle(send_endpoint,&sd,&sn,&se));
@@ -1831,7 +2344,10 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 		  /* check if receive endpoint belongs to the current node */
 		  if(rd == my_domain_id && rn == my_node_id)
 		  {
-			  mcapi_assert (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.channel_type == MCAPI_NO_CHAN);
+			  /* lock the receive endpoint */
+			  mcapi_trans_lock(&endpoint_locks[re]);
+
+			  mcapi_assert (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].channel_type == MCAPI_NO_CHAN);
 //			  if (!mcapi_trans_send_have_lock (sd,sn,se,rd,rn,re,buffer,buffer_size,0)) {
 				/* assume couldn't get a buffer */
 //				*mcapi_status = MCAPI_ERR_MEM_LIMIT;
@@ -1842,8 +2358,8 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 			  // case we will wait until memory will be available.
 			  while ((err = mcapi_trans_send_have_lock (sd,sn,se,rd,rn,re,buffer,buffer_size,0)) != MCAPI_SUCCESS) {
 				if(err == MCAPI_ERR_MEM_LIMIT) {
-					// unlock data base, so that other threads could proceed
-					mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
+					// unlock the endpoint, so that the receiver could proceed
+					mcapi_trans_unlock(&endpoint_locks[re]);
 					// let other tasks do there job first
 #ifdef UCOSII
 					OSTimeDly(TICKS_TO_WAIT);
@@ -1852,33 +2368,32 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 #ifdef LINUX
 					sched_yield();
 #endif
-					// lock data base again before next try
-					mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
+					// lock the endpoint again before next try
+					mcapi_trans_lock(&endpoint_locks[re]);
 				}
 				else {
 					printf("mcapi_tans_msg_send_i(): unexpected error MCAPI_ERR_CHAN_NCNO\n");
 					*mcapi_status = MCAPI_ERR_CHAN_NCNO;
-					// unlock the data base
-					mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
+					// unlock the endpoint
+					mcapi_trans_unlock(&endpoint_locks[re]);
 					return;
 				}
 			  }
+
+			  /* unlock the receive endpoint */
+			  mcapi_trans_unlock(&endpoint_locks[re]);
 			  *mcapi_status = MCAPI_SUCCESS;
 		  }
 		  else
 		  {
-			  mcapi_assert (mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.channel_type == MCAPI_NO_CHAN);
-
-			  /* unlock the database */
-			  	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
+			  mcapi_trans_lock(&endpoint_locks[se]);
+			  mcapi_assert (mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].channel_type == MCAPI_NO_CHAN);
+			  mcapi_trans_unlock(&endpoint_locks[se]);
 
 			  /* receive endpoint does not belong to the local node -> go to the next layer */
 			  if (NS_sendDataToRemote_request(send_endpoint, receive_endpoint, (char *) buffer, buffer_size) != NS_OK) {
 				  *mcapi_status = MCAPI_ERR_MEM_LIMIT;
 			  }
-
-			  /* lock the database */
-			  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 		  }
 		}
 		/* setup the reqeuest depend on the current state */
@@ -1888,9 +2403,6 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  } else {
 		*mcapi_status = MCAPI_ERR_REQUEST_LIMIT;
 	  }
-
-	  /* unlock the database */
-	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
   }
 
   /***************************************************************************
@@ -1946,32 +2458,46 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  size_t received_size = 0;
 	  /* if errors were found at the mcapi layer, then the request is considered complete */
 	  mcapi_boolean_t completed =  (*mcapi_status == MCAPI_SUCCESS) ? MCAPI_FALSE : MCAPI_TRUE;
-
-	  /* lock the database */
-	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
+	  /* otherwise the receive queue is used */
+	  mcapi_boolean_t use_queue = !completed;
 
 	  mcapi_dprintf(1,"mcapi_trans_msg_recv_i(0x%x,buffer,%u,&request,&status);",receive_endpoint,buffer_size);
 
 	  /* make sure we have a request entry */
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	  if ( mcapi_trans_reserve_request(&r)) {
 		if (!completed) {
 		  mcapi_assert(mcapi_trans_decode_handle(receive_endpoint,&rd,&rn,&re));
 
-		  mcapi_assert (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.channel_type == MCAPI_NO_CHAN);
+		  mcapi_assert (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].channel_type == MCAPI_NO_CHAN);
 
+		  /* the receiving task is the consumer of the ring, a waiting
+			 message is taken without the endpoint lock */
 		  if (mcapi_trans_recv_have_lock(rd,rn,re,(void*)&buffer,buffer_size,&received_size,MCAPI_FALSE,NULL)) {
 			completed = MCAPI_TRUE;
 			buffer_size = received_size;
+			use_queue = MCAPI_FALSE;
+		  } else {
+			/* lock the receive endpoint, the request reserves a queue entry */
+			mcapi_trans_lock(&endpoint_locks[re]);
+
+			/* a sender may have pushed in the meantime */
+			if (mcapi_trans_recv_have_lock(rd,rn,re,(void*)&buffer,buffer_size,&received_size,MCAPI_FALSE,NULL)) {
+			  completed = MCAPI_TRUE;
+			  buffer_size = received_size;
+			}
 		  }
 		}
 		/* setup the reqeuest depend on the current state */
 
 		mcapi_assert(setup_request_have_lock(&receive_endpoint,request,mcapi_status,completed,buffer_size,(void**)((void*)&buffer),RECV,0,0,0,r));
+
+		if (use_queue) {
+		  /* unlock the receive endpoint */
+		  mcapi_trans_unlock(&endpoint_locks[re]);
+		}
 	  } else {
 		*mcapi_status = MCAPI_ERR_REQUEST_LIMIT;
 	  }
-	  /* unlock the database */
-	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
   }
 
   /***************************************************************************
@@ -1985,15 +2511,15 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  uint16_t rd,rn,re;
 	  int rc = MCAPI_FALSE;
 
-	  /* lock the database */
-	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 	  mcapi_dprintf(1,"mcapi_trans_msg_available(0x%x);",receive_endpoint);
 	  mcapi_assert(mcapi_trans_decode_handle(receive_endpoint,&rd,&rn,&re));
-	  rc = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.num_elements;
 
-	  /* unlock the database */
-	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
+	  /* lock the endpoint */
+	  mcapi_trans_lock(&endpoint_locks[re]);
+	  rc = mcapi_trans_count_queue(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue) +
+		   mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue->num_bound;
+	  /* unlock the endpoint */
+	  mcapi_trans_unlock(&endpoint_locks[re]);
 
 	  return rc;
   }
@@ -2026,7 +2552,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
 	  /* make sure we have a request entry */
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	  if ( mcapi_trans_reserve_request(&r)) {
 		if (!completed) {
 		  mcapi_trans_connect_channel_have_lock (send_endpoint,receive_endpoint,MCAPI_PKT_CHAN);
 		  completed = MCAPI_TRUE;
@@ -2066,7 +2592,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  /* lock the database */
 	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
-	  mcapi_endpoint_t send_endpoint = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.send_endpt;
+	  mcapi_endpoint_t send_endpoint = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].send_endpt;
 
 	  /* unlock the database */
 	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
@@ -2080,7 +2606,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_dprintf(1,"mcapi_trans_pktchan_recv_open_i (recv_handle,0x%x,&request,&status);",receive_endpoint);
 
 	  /* make sure we have a request entry */
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	  if ( mcapi_trans_reserve_request(&r)) {
 		if (!completed) {
 		  /* mark the endpoint as open */
 		  mcapi_trans_open_channel_have_lock (rd,rn,re);
@@ -2136,7 +2662,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  /* lock the database */
 	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
-	  mcapi_endpoint_t receive_endpoint = mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.recv_endpt;
+	  mcapi_endpoint_t receive_endpoint = mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_endpt;
 
 	  /* unlock the database */
 	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
@@ -2150,7 +2676,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_dprintf(1,"mcapi_trans_pktchan_send_open_i,send_handle,0x%x,&request,&status);",send_endpoint);
 
 	  /* make sure we have a request entry */
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	  if ( mcapi_trans_reserve_request(&r)) {
 		if (!completed) {
 		  /* mark the endpoint as open */
 		  mcapi_trans_open_channel_have_lock (sd,sn,se);
@@ -2196,6 +2722,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
   								 mcapi_status_t* mcapi_status)
   {
 	  uint16_t sd,sn,se,rd,rn,re;
+	  mcapi_endpoint_t receive_endpoint;
 	  int r;
 	  int err;
 
@@ -2204,18 +2731,23 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 
 	  mcapi_dprintf(1,"mcapi_trans_pktchan_send_i(0x%x,buffer,%u,&request,&status);",send_handle,size);
 
-	  /* lock the database */
-	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 	  /* make sure we have a request entry */
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	  if ( mcapi_trans_reserve_request(&r)) {
 		if (!completed) {
 		  mcapi_assert(mcapi_trans_decode_handle(send_handle,&sd,&sn,&se));
-		  mcapi_assert(mcapi_trans_decode_handle(mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.recv_endpt,&rd,&rn,&re));
+
+		  /* the peer of the channel is set under the send endpoint lock */
+		  mcapi_trans_lock(&endpoint_locks[se]);
+		  receive_endpoint = mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_endpt;
+		  mcapi_trans_unlock(&endpoint_locks[se]);
+		  mcapi_assert(mcapi_trans_decode_handle(receive_endpoint,&rd,&rn,&re));
 
 		  /* check if receive endpoint belongs to the current node */
 		  if(rd == my_domain_id && rn == my_node_id)
 		  {
+			  /* lock the receive endpoint */
+			  mcapi_trans_lock(&endpoint_locks[re]);
+
 //			  if (mcapi_trans_send_have_lock (sd,sn,se,rd,rn,re,(char*)buffer,size,0) != MCAPI_SUCCESS) {
 //				  *mcapi_status = MCAPI_ERR_MEM_LIMIT;
 //			  }
@@ -2225,8 +2757,8 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 			  // case we will wait until memory will be available.
 			  while ((err = mcapi_trans_send_have_lock (sd,sn,se,rd,rn,re,(char*)buffer,size,0)) != MCAPI_SUCCESS) {
 				if(err == MCAPI_ERR_MEM_LIMIT) {
-					// unlock data base, so that other threads could proceed
-					mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
+					// unlock the endpoint, so that the receiver could proceed
+					mcapi_trans_unlock(&endpoint_locks[re]);
 					// let other tasks do there job first
 #ifdef UCOSII
 					OSTimeDly(TICKS_TO_WAIT);
@@ -2235,31 +2767,28 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 #ifdef LINUX
 					sched_yield();
 #endif
-					// lock data base again before next try
-					mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
+					// lock the endpoint again before next try
+					mcapi_trans_lock(&endpoint_locks[re]);
 				}
 				else {
 					printf("mcapi_tans_msg_send_i(): unexpected error MCAPI_ERR_CHAN_NCNO\n");
 					*mcapi_status = MCAPI_ERR_CHAN_NCNO;
-					// unlock the data base
-					mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
+					// unlock the endpoint
+					mcapi_trans_unlock(&endpoint_locks[re]);
 					return;
 				}
 			  }
+
+			  /* unlock the receive endpoint */
+			  mcapi_trans_unlock(&endpoint_locks[re]);
 			  *mcapi_status = MCAPI_SUCCESS;
 		  }
 		  else
 		  {
-			  /* unlock the database */
-			  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
-
 			  /* receive endpoint does not belong to the current node -> go to the next layer */
-			  if (NS_sendDataToRemote_request(send_handle, mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.recv_endpt, (char *) buffer,size) != NS_OK) {
+			  if (NS_sendDataToRemote_request(send_handle, receive_endpoint, (char *) buffer,size) != NS_OK) {
 				  *mcapi_status = MCAPI_ERR_MEM_LIMIT;
 			  }
-
-			  /* lock the database */
-			  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 		  }
 
 		  completed = MCAPI_TRUE;
@@ -2271,9 +2800,6 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  } else{
 		*mcapi_status = MCAPI_ERR_REQUEST_LIMIT;
 	  }
-
-	  /* unlock the database */
-	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
   }
 
   /***************************************************************************
@@ -2326,13 +2852,13 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  /* if errors were found at the mcapi layer, then the request is considered complete */
 	  mcapi_boolean_t completed =  (*mcapi_status == MCAPI_SUCCESS) ? MCAPI_FALSE : MCAPI_TRUE;
 
-	  size_t size = MCAPI_MAX_PKT_SIZE;
+	  /* otherwise the receive queue is used */
+	  mcapi_boolean_t use_queue = !completed;
 
-	  /* lock the database */
-	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
+	  size_t size = MCAPI_MAX_PKT_SIZE;
 
 	  /* make sure we have a request entry */
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	  if ( mcapi_trans_reserve_request(&r)) {
 		mcapi_dprintf(1,"mcapi_trans_pktchan_recv_i(0x%x,&buffer,&request,&status);",receive_handle,size);
 
 		if (!completed) {
@@ -2340,18 +2866,31 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 
 		  /* *buffer will be filled in the with a ptr to an mcapi buffer */
 		  *buffer = NULL;
+		  /* the receiving task is the consumer of the ring, a waiting
+			 packet is taken without the endpoint lock */
 		  if (mcapi_trans_recv_have_lock (rd,rn,re,buffer,MCAPI_MAX_PKT_SIZE,&size,MCAPI_FALSE,NULL)) {
 			completed = MCAPI_TRUE;
+			use_queue = MCAPI_FALSE;
+		  } else {
+			/* lock the receive endpoint, the request reserves a queue entry */
+			mcapi_trans_lock(&endpoint_locks[re]);
+
+			/* a sender may have pushed in the meantime */
+			if (mcapi_trans_recv_have_lock (rd,rn,re,buffer,MCAPI_MAX_PKT_SIZE,&size,MCAPI_FALSE,NULL)) {
+			  completed = MCAPI_TRUE;
+			}
 		  }
 		}
 		/* setup the reqeuest depend on the current state */
 		mcapi_assert(setup_request_have_lock(&receive_handle,request,mcapi_status,completed,size,buffer,RECV,0,0,0,r));
+
+		if (use_queue) {
+		  /* unlock the receive endpoint */
+		  mcapi_trans_unlock(&endpoint_locks[re]);
+		}
 	  } else{
 		*mcapi_status = MCAPI_ERR_REQUEST_LIMIT;
 	  }
-
-	  /* unlock the database */
-	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
   }
 
   /***************************************************************************
@@ -2395,16 +2934,16 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  uint16_t rd,rn,re;
 	  int rc = MCAPI_FALSE;
 
-	  /* lock the database */
-	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 	  mcapi_dprintf(1,"mcapi_trans_pktchan_available(0x%x);",receive_handle);
 
 	  mcapi_assert(mcapi_trans_decode_handle(receive_handle,&rd,&rn,&re));
-	  rc = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.num_elements;
 
-	  /* unlock the database */
-	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
+	  /* lock the endpoint */
+	  mcapi_trans_lock(&endpoint_locks[re]);
+	  rc = mcapi_trans_count_queue(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue) +
+		   mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue->num_bound;
+	  /* unlock the endpoint */
+	  mcapi_trans_unlock(&endpoint_locks[re]);
 
 	  return rc;
   }
@@ -2420,28 +2959,17 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  int rc = MCAPI_TRUE;
 	  buffer_entry* b_e;
 
-	  /* lock the database */
-	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 	  mcapi_dprintf(1,"mcapi_trans_pktchan_free(buffer);");
-	  /* optimization - just do pointer arithmetic on the buffer pointer to get
-		 the base address of the buffer_entry structure. */
-	  /* Old buffer_entry struct required following pointer arithmetics:
-	  b_e = buffer-(sizeof(b_e->scalar)+sizeof(b_e->size)+sizeof(b_e->magic_num)+4);
-	  which, in case of Ubuntu 14.1 environment results in an error!
-      Therefore the ordering of the struct elements was changed so that
-      not complex and erroneous buffer arithmetics will be necessary */
-	  b_e = buffer;
-	  if (b_e->magic_num == MAGIC_NUM) {
-		memset(b_e,0,sizeof(buffer_entry));	// clear buffer entry
+	  /* the data of the buffers is kept apart from the buffer entries (size
+		 classes), the class ranges of the data map the pointer back */
+	  b_e = mcapi_trans_buffer_find(buffer);
+	  if (b_e != NULL && b_e->magic_num == MAGIC_NUM) {
+		mcapi_trans_buffer_put(b_e);	// clear buffer entry
 	  } else {
 		/* didn't find the buffer */
 		rc = MCAPI_FALSE;
 	  }
 
-	  /* unlock the database */
-	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
-
 	  return rc;
   }
 
@@ -2456,6 +2984,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
   									   mcapi_request_t* request, mcapi_status_t* mcapi_status)
   {
 	  int r;
+	  int32_t index;
 	  uint16_t rd,rn,re;
 	  /* if errors were found at the mcapi layer, then the request is considered complete */
 
@@ -2466,7 +2995,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  /* lock the database */
 	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
-	  mcapi_endpoint_t send_endpoint = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.send_endpt;
+	  mcapi_endpoint_t send_endpoint = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].send_endpt;
 
 	  /* unlock the database */
 	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
@@ -2478,26 +3007,25 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
 	  /* make sure we have a request entry */
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	  if ( mcapi_trans_reserve_request(&r)) {
 		mcapi_dprintf(1,"mcapi_trans_pktchan_recv_close_i (0x%x,&request,&status);",receive_handle);
 
 		if (!completed) {
 		  mcapi_trans_close_channel_have_lock (rd,rn,re);
 
 		  /* all pending packets are discarded */
-		  while(!mcapi_trans_empty_queue(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue))
+		  mcapi_trans_lock(&endpoint_locks[re]);
+		  while ((index = mcapi_trans_pop_queue(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue)) != 0)
 		  {
-			 int qindex = mcapi_trans_pop_queue(&mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue);
-			 int index = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[qindex].buff_index &~ MCAPI_VALID_MASK;
-			 mcapi_trans_pktchan_free(mcapi_db->buffers[index].buff);
-			 mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[qindex].buff_index = 0;
+			 mcapi_trans_pktchan_free(mcapi_db->buffers[index &~ MCAPI_VALID_MASK].buff);
 		  }
+		  mcapi_trans_unlock(&endpoint_locks[re]);
 
 		  /* has the channel been closed on the other side? */
 		  if ( is_channel_open_on_send_side == MCAPI_FALSE ) {
 			  /* channel is disconnected */
 			  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].connected = MCAPI_FALSE;
-			  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.channel_type = MCAPI_NO_CHAN;
+			  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].channel_type = MCAPI_NO_CHAN;
 			  completed = MCAPI_TRUE;
 		  }
 		}
@@ -2531,7 +3059,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  /* lock the database */
 	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
-	  mcapi_endpoint_t receive_endpoint = mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.recv_endpt;
+	  mcapi_endpoint_t receive_endpoint = mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_endpt;
 
 	  /* unlock the database */
 	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
@@ -2543,7 +3071,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
 	  /* make sure we have a request entry */
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	  if ( mcapi_trans_reserve_request(&r)) {
 		mcapi_dprintf(1,"mcapi_trans_pktchan_send_close_i (0x%x,&request,&status);",send_handle);
 
 		if (!completed) {
@@ -2553,7 +3081,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 		  if ( is_channel_open_on_receive_side == MCAPI_FALSE ) {
 			  /* channel is disconnected */
 			  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].connected = MCAPI_FALSE;
-			  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.channel_type = MCAPI_NO_CHAN;
+			  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].channel_type = MCAPI_NO_CHAN;
 			  completed = MCAPI_TRUE;
 		  }
 		}
@@ -2596,7 +3124,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
 	  /* make sure we have a request entry */
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	  if ( mcapi_trans_reserve_request(&r)) {
 		if (!completed) {
 		  mcapi_trans_connect_channel_have_lock (send_endpoint,receive_endpoint,MCAPI_SCL_CHAN);
 		  completed = MCAPI_TRUE;
@@ -2637,7 +3165,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
 	  /* check the open-state of the other side */
-	  mcapi_endpoint_t send_endpoint = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.send_endpt;
+	  mcapi_endpoint_t send_endpoint = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].send_endpt;
 
 	  /* unlock the database */
 	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
@@ -2650,7 +3178,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_dprintf(1,"mcapi_trans_sclchan_recv_open_i(recv_handle,0x%x,&request,&status);",receive_endpoint);
 
 	  /* make sure we have a request entry */
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	  if ( mcapi_trans_reserve_request(&r)) {
 		if (!completed) {
 		  mcapi_trans_open_channel_have_lock (rd,rn,re);
 
@@ -2704,7 +3232,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
 	  /* check the open-state of the other side */
-	  mcapi_endpoint_t receive_endpoint = mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.recv_endpt;
+	  mcapi_endpoint_t receive_endpoint = mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_endpt;
 
 	  /* unlock the database */
 	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
@@ -2717,7 +3245,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_dprintf(1,"mcapi_trans_sclchan_send_open_i(send_handle,0x%x,&request,&status);",send_endpoint);
 
 	  /* make sure we have a request entry */
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	  if ( mcapi_trans_reserve_request(&r)) {
 		if (!completed) {
 		  /* mark the endpoint as open */
 		  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].open = MCAPI_TRUE;
@@ -2759,34 +3287,34 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
   										uint32_t size)
   {
 	  uint16_t sd,sn,se,rd,rn,re;
+	  mcapi_endpoint_t receive_endpoint;
 	  int rc = MCAPI_FALSE;
 //	  printf("mcapi_trans_sclchan_send(0x%x, 0x%x, 0x%x);\n", send_handle, dataword, size); fflush(stdout);
 
-	  /* lock the database */
-	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 	  mcapi_assert(mcapi_trans_decode_handle(send_handle,&sd,&sn,&se));
-	  mcapi_assert(mcapi_trans_decode_handle(mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.recv_endpt,&rd,&rn,&re));
+
+	  /* the peer of the channel is set under the send endpoint lock */
+	  mcapi_trans_lock(&endpoint_locks[se]);
+	  receive_endpoint = mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_endpt;
+	  mcapi_trans_unlock(&endpoint_locks[se]);
+	  mcapi_assert(mcapi_trans_decode_handle(receive_endpoint,&rd,&rn,&re));
 
 	  /* check if receive endpoint belongs to the current node */
 	  if(rd == my_domain_id && rn == my_node_id)
 	  {
 		  printf("current node\n");
+		  /* lock the receive endpoint */
+		  mcapi_trans_lock(&endpoint_locks[re]);
 		  rc = mcapi_trans_send_have_lock (sd,sn,se,rd,rn,re,NULL,size,dataword);
 		  if(rc == MCAPI_SUCCESS)	rc = MCAPI_TRUE;
 		  else						rc = MCAPI_FALSE;
-		  /* unlock the database */
-		  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
+		  /* unlock the receive endpoint */
+		  mcapi_trans_unlock(&endpoint_locks[re]);
 	  }
 	  else
 	  {
-		  mcapi_endpoint_t receive_endpoint = mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.recv_endpt;
-
-		  /* unlock the database */
-		  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
-
 		  /* receive endpoint does not belong to the current node -> go to the next layer */
-		  rc = NS_sendDataToRemote_request(send_handle, receive_endpoint, (const int8_t *) &dataword, size);
+		  rc = NS_sendScalarToRemote_request(send_handle, receive_endpoint, dataword, size);
 	  }
 
 	  if(rc == NS_OK)	return(MCAPI_TRUE);
@@ -2795,6 +3323,34 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
   }
 
 
+  /***************************************************************************
+  NAME:mcapi_trans_sclchan_deliver
+  DESCRIPTION: delivers a scalar received from a remote node to the receive
+   endpoint of its channel.  The sender is the one the channel was connected
+   to, so the NS layer only has to pass the receive endpoint.
+  PARAMETERS:
+  receive_endpoint - the receive endpoint handle of the channel
+  buffer - the scalar
+  size - the size in bytes of the scalar
+  RETURN VALUE: MCAPI_TRUE/MCAPI_FALSE (MCAPI_FALSE if there is no space in
+   the receive queue or no free buffer, the caller tries again)
+  ***************************************************************************/
+  mcapi_boolean_t mcapi_trans_sclchan_deliver( mcapi_endpoint_t receive_endpoint,
+										const char* buffer, size_t size)
+  {
+	  uint16_t sd,sn,se,rd,rn,re;
+
+	  if (!mcapi_trans_decode_handle(receive_endpoint,&rd,&rn,&re)) {
+		  return MCAPI_TRUE;	/* not one of ours -> drop the scalar */
+	  }
+	  /* the send endpoint is only used for the debug print */
+	  if (!mcapi_trans_decode_handle(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].send_endpt,&sd,&sn,&se)) {
+		  sd = rd; sn = rn; se = re;
+	  }
+
+	  return mcapi_trans_send (sd,sn,se,rd,rn,re,buffer,size);
+  }
+
   /***************************************************************************
   NAME:mcapi_trans_sclchan_recv
   DESCRIPTION: receives a packet on a packet channel (blocking)
@@ -2811,25 +3367,30 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  size_t received_size;
 	  int rc = MCAPI_FALSE;
 
-	  /* lock the database */
-	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 	  mcapi_dprintf(1,"uint64_t data;");
 	  mcapi_dprintf(1,"mcapi_trans_sclchan_send(0x%x,&data,%u);",receive_handle,size);
 
 	  mcapi_assert(mcapi_trans_decode_handle(receive_handle,&rd,&rn,&re));
 
-	  if (mcapi_trans_recv_have_lock (rd,rn,re,NULL,size,&received_size,MCAPI_TRUE,data) &&
-		  received_size == size) {
-		rc = MCAPI_TRUE;
+	  /* a waiting scalar is taken without the endpoint lock */
+	  if (mcapi_trans_recv_have_lock (rd,rn,re,NULL,size,&received_size,MCAPI_FALSE,data)) {
+		rc = (received_size == size);
+	  } else {
+		/* lock the receive endpoint, a blocking receive releases it while it waits */
+		mcapi_trans_lock(&endpoint_locks[re]);
+
+		if (mcapi_trans_recv_have_lock (rd,rn,re,NULL,size,&received_size,MCAPI_TRUE,data) &&
+			received_size == size) {
+		  rc = MCAPI_TRUE;
+		}
+
+		/* unlock the receive endpoint */
+		mcapi_trans_unlock(&endpoint_locks[re]);
 	  }
 
 	  /* FIXME: (errata A2) if size != received_size then we shouldn't remove the item from the
 		 endpoints receive queue */
 
-	  /* unlock the database */
-	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
-
 	  return rc;
   }
 
@@ -2845,16 +3406,16 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  uint16_t rd,rn,re;
 	  int rc = MCAPI_FALSE;
 
-	  /* lock the database */
-	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 	  mcapi_dprintf(1,"mcapi_trans_sclchan_available_i(0x%x);",receive_handle);
 
 	  mcapi_assert(mcapi_trans_decode_handle(receive_handle,&rd,&rn,&re));
-	  rc = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.num_elements;
 
-	  /* unlock the database */
-	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
+	  /* lock the endpoint */
+	  mcapi_trans_lock(&endpoint_locks[re]);
+	  rc = mcapi_trans_count_queue(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue) +
+		   mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue->num_bound;
+	  /* unlock the endpoint */
+	  mcapi_trans_unlock(&endpoint_locks[re]);
 
 	  return rc;
   }
@@ -2874,6 +3435,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
   {
 	  uint16_t rd,rn,re;
 	  int r;
+	  int32_t index;
 
 	  /* if errors were found at the mcapi layer, then the request is considered complete */
 	  mcapi_boolean_t completed =  (*mcapi_status == MCAPI_SUCCESS) ? MCAPI_FALSE : MCAPI_TRUE;
@@ -2883,7 +3445,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  /* lock the database */
 	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
-	  mcapi_endpoint_t send_endpoint = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.send_endpt;
+	  mcapi_endpoint_t send_endpoint = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].send_endpt;
 
 	  /* unlock the database */
 	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
@@ -2897,25 +3459,24 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_dprintf(1,"mcapi_trans_sclchan_recv_close_i(0x%x,&request,&status);",recv_handle);
 
 	  /* make sure we have a request entry */
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	  if ( mcapi_trans_reserve_request(&r)) {
 		if (!completed) {
 		  mcapi_trans_close_channel_have_lock (rd,rn,re);
 
 		  /* all pending packets are discarded */
-		  while(!mcapi_trans_empty_queue(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue))
+		  mcapi_trans_lock(&endpoint_locks[re]);
+		  while ((index = mcapi_trans_pop_queue(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue)) != 0)
 		  {
-			 int qindex = mcapi_trans_pop_queue(&mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue);
-			 int index = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[qindex].buff_index &~ MCAPI_VALID_MASK;
 			 /* free the mcapi buffer */
-			 memset(&mcapi_db->buffers[index],0,sizeof(mcapi_db->buffers[index]));
-			 mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[qindex].buff_index = 0;
+			 mcapi_trans_buffer_put(&mcapi_db->buffers[index &~ MCAPI_VALID_MASK]);
 		  }
+		  mcapi_trans_unlock(&endpoint_locks[re]);
 
 		  /* has the channel been closed on the other side? */
 		  if ( is_channel_open_on_send_side == MCAPI_FALSE ) {
 			  /* channel is disconnected */
 			  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].connected = MCAPI_FALSE;
-			  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.channel_type = MCAPI_NO_CHAN;
+			  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].channel_type = MCAPI_NO_CHAN;
 			  completed = MCAPI_TRUE;
 		  }
 		}
@@ -2953,7 +3514,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  /* lock the database */
 	  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
 
-	  mcapi_endpoint_t receive_endpoint = mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.recv_endpt;
+	  mcapi_endpoint_t receive_endpoint = mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_endpt;
 
 	  /* unlock the database */
 	  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
@@ -2967,7 +3528,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_dprintf(1,"mcapi_trans_sclchan_send_close_i(0x%x,&request,&status);",send_handle);
 
 	  /* make sure we have a request entry */
-	  if ( mcapi_trans_reserve_request_have_lock(&r)) {
+	  if ( mcapi_trans_reserve_request(&r)) {
 		if (!completed) {
 		  mcapi_trans_close_channel_have_lock (sd,sn,se);
 
@@ -2975,7 +3536,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 		  if ( is_channel_open_on_receive_side == MCAPI_FALSE ) {
 			  /* channel is disconnected */
 			  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].connected = MCAPI_FALSE;
-			  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.channel_type = MCAPI_NO_CHAN;
+			  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].channel_type = MCAPI_NO_CHAN;
 			  completed = MCAPI_TRUE;
 		  }
 		}
@@ -3008,6 +3569,35 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
   mcapi_boolean_t mcapi_trans_test_i( mcapi_request_t* request,
   								  size_t* size,
   								  mcapi_status_t* mcapi_status)
+  {
+	  mcapi_boolean_t rc;
+	  uint16_t r;
+
+	  if (!mcapi_trans_decode_request_handle(request,&r)) {
+		*mcapi_status = MCAPI_ERR_REQUEST_INVALID;
+		return MCAPI_TRUE;
+	  }
+
+	  mcapi_trans_lock(REQUEST_LOCK(r));
+	  rc = mcapi_trans_test_have_lock(request,size,mcapi_status);
+	  mcapi_trans_unlock(REQUEST_LOCK(r));
+
+	  return rc;
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_test_have_lock
+  DESCRIPTION: mcapi_trans_test_i() for a caller that holds the lock of the
+  	request (REQUEST_LOCK()).
+  PARAMETERS:
+  request -
+  size -
+  mcapi_status -
+  RETURN VALUE: TRUE/FALSE indicating if the request has completed.
+  ***************************************************************************/
+  mcapi_boolean_t mcapi_trans_test_have_lock (mcapi_request_t* request,
+  										   size_t* size,
+  										   mcapi_status_t* mcapi_status)
   {
 	  /* We return true if it's cancelled, invalid or completed.  We only return
 	         false if the user should continue polling.
@@ -3015,8 +3605,6 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  mcapi_boolean_t rc = MCAPI_FALSE;
 	  uint16_t r;
 
-	  mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE);
-
 	  mcapi_dprintf(3,"mcapi_trans_test_i request handle:0x%lx",*request);
 
 	  if (!mcapi_trans_decode_request_handle(request,&r) ||
@@ -3053,14 +3641,14 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 
 	  /* query completed again because we may have just completed it */
 	  if (mcapi_db->requests[r].completed) {
-		mcapi_trans_remove_request_have_lock(r);	/* by etem */
 		*size = mcapi_db->requests[r].size;
 //		*mcapi_status = mcapi_db->requests[r].status;
 		if((*mcapi_status = mcapi_db->requests[r].status) == MCAPI_ERR_MEM_LIMIT)
 			printf("mcapi_trans_test_i() status = %d\n", *mcapi_status);
 
-		/* clear the entry so that it can be reused */
+		/* clear the entry before it is given back, it can be reused then */
 		memset(&mcapi_db->requests[r],0,sizeof(mcapi_request_data));
+		mcapi_trans_remove_request_have_lock(r);	/* by etem */
 		*request=0;
 
 		rc = MCAPI_TRUE;
@@ -3068,18 +3656,22 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	 }
 
 	  //mcapi_dprintf(2,"mcapi_trans_test_i returning rc=%u,status=%s",rc,mcapi_display_status(*mcapi_status));
-	  mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE);
 
 	  return rc;
   }
 
   /***************************************************************************
   NAME:mcapi_trans_wait
-  DESCRIPTION:Tests if the request has completed yet (non-blocking).
+  DESCRIPTION:Waits until the request has completed (blocking).
+    The calling task blocks on its completion object, a receive request is
+    completed by the signal of the task that pushes the message into the
+    receive queue. Requests that depend on the state of a remote node
+    (endpoint get, channel open and close) are re-checked every RECHECK_MS.
   PARAMETERS:
   send_handle -
   request -
   mcapi_status -
+  timeout - in milliseconds, the resolution is one OS tick on uC/OS-II
   RETURN VALUE:  TRUE indicating the request has completed or FALSE
   indicating the request has been cancelled.
   ***************************************************************************/
@@ -3088,73 +3680,109 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
   								mcapi_status_t* mcapi_status,
   								mcapi_timeout_t timeout)
   {
-	  mcapi_timeout_t time = 0;
+	  mcapi_deadline_t deadline;
+	  mcapi_deadline_t* end = NULL;		/* NULL = no timeout */
+	  mcapi_boolean_t rc;
+	  mcapi_boolean_t signalled;
+	  mcapi_boolean_t blocked;
+	  uint8_t w;
 	  uint16_t r;
+
 	  mcapi_assert(mcapi_trans_decode_request_handle(request,&r));
 	  mcapi_dprintf(1,"mcapi_trans_wait(&request,&size,&status,%u);",timeout);
-	  while(1) {
-		time++;
-		if (mcapi_trans_test_i(request,size,mcapi_status)) {
-		  return MCAPI_TRUE;
-		}
-
-		/* yield */
-		mcapi_dprintf(5,"mcapi_trans_wait - attempting to yield");
-		/* we don't have the lock, it's safe to just yield */
-#ifdef UCOSII
-		OSTimeDly(TICKS_TO_WAIT);
-#endif
+	  if (timeout != MCA_INFINITE) {
+		mcapi_trans_set_deadline(&deadline,timeout);
+		end = &deadline;
+	  }
 
-#ifdef LINUX
-		sched_yield();
-#endif
-		if ((timeout !=  MCA_INFINITE) && (time >= timeout)) {
+	  w = mcapi_trans_waiter_get();
+	  mcapi_trans_lock(REQUEST_LOCK(r));
+	  while (!(rc = mcapi_trans_test_have_lock(request,size,mcapi_status))) {
+		signalled = mcapi_trans_waiter_attach_have_lock(request,w);
+		blocked = mcapi_trans_waiter_block_have_lock(w,REQUEST_LOCK(r),end,!signalled);
+		mcapi_trans_waiter_detach_have_lock(request,w);
+		if (!blocked) {
 		  *mcapi_status = MCAPI_TIMEOUT;
-		  return MCAPI_FALSE;
+		  break;
 		}
 	  }
+	  mcapi_trans_unlock(REQUEST_LOCK(r));
+	  mcapi_trans_waiter_put(w);
+
+	  return rc;
   }
 
   /***************************************************************************
   NAME:mcapi_trans_wait_any
   DESCRIPTION:Tests if any of the requests have completed yet (blocking).
     Note: the request is now cleared if it has been completed or cancelled.
+    The calling task blocks on its completion object like in
+    mcapi_trans_wait(), it is attached to all requests. The requests are
+    tested, attached and detached one at a time under their own lock, the
+    task blocks without a lock (a signal is kept by the completion object).
   PARAMETERS:
   send_handle -
   request -
   mcapi_status -
+  timeout - in milliseconds, the resolution is one OS tick on uC/OS-II
   RETURN VALUE:
   ***************************************************************************/
   unsigned mcapi_trans_wait_any(size_t number, mcapi_request_t** requests, size_t* size,
   								   mcapi_status_t* mcapi_status,
   								   mcapi_timeout_t timeout)
   {
-	  mcapi_timeout_t time = 0;
+	  mcapi_deadline_t deadline;
+	  mcapi_deadline_t* end = NULL;		/* NULL = no timeout */
+	  mcapi_boolean_t signalled;
+	  mcapi_boolean_t blocked;
+	  unsigned rc = MCA_RETURN_VALUE_INVALID;
+	  uint8_t w;
+	  uint16_t r;
 	  int i;
 
 	  mcapi_dprintf(1,"mcapi_trans_wait_any");
-	  while(1) {
-		time++;
+	  if (timeout != MCA_INFINITE) {
+		mcapi_trans_set_deadline(&deadline,timeout);
+		end = &deadline;
+	  }
+
+	  w = mcapi_trans_waiter_get();
+	  while (rc == MCA_RETURN_VALUE_INVALID) {
 		for (i = 0; i < number; i++) {
 		  if (mcapi_trans_test_i(requests[i],size,mcapi_status)) {
-			return i;
+			break;
 		  }
-		  /* yield */
-		  mcapi_dprintf(5,"mcapi_trans_wait_any - attempting to yield");
-		  /* we don't have the lock, it's safe to just yield */
-#ifdef UCOSII
-		OSTimeDly(TICKS_TO_WAIT);
-#endif
+		}
+		if (i < number) {
+		  rc = i;
+		  break;
+		}
 
-#ifdef LINUX
-		sched_yield();
-#endif
-		  if ((timeout !=  MCA_INFINITE) && (time >= timeout)) {
-			*mcapi_status = MCAPI_TIMEOUT;
-			return MCA_RETURN_VALUE_INVALID;
+		signalled = MCAPI_TRUE;
+		for (i = 0; i < number; i++) {
+		  /* the handles are valid, mcapi_trans_test_i() has checked them */
+		  mcapi_assert(mcapi_trans_decode_request_handle(requests[i],&r));
+		  mcapi_trans_lock(REQUEST_LOCK(r));
+		  if (!mcapi_trans_waiter_attach_have_lock(requests[i],w)) {
+			signalled = MCAPI_FALSE;
 		  }
+		  mcapi_trans_unlock(REQUEST_LOCK(r));
+		}
+		blocked = mcapi_trans_waiter_block_have_lock(w,NULL,end,!signalled);
+		for (i = 0; i < number; i++) {
+		  mcapi_assert(mcapi_trans_decode_request_handle(requests[i],&r));
+		  mcapi_trans_lock(REQUEST_LOCK(r));
+		  mcapi_trans_waiter_detach_have_lock(requests[i],w);
+		  mcapi_trans_unlock(REQUEST_LOCK(r));
+		}
+		if (!blocked) {
+		  *mcapi_status = MCAPI_TIMEOUT;
+		  break;
 		}
 	  }
+	  mcapi_trans_waiter_put(w);
+
+	  return rc;
   }
 
   /***************************************************************************
@@ -3171,23 +3799,28 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 
 	  mcapi_dprintf(1,"mcapi_trans_cancel");
 
-	  /* lock the database */
-	  mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE);
-
 	  mcapi_assert(mcapi_trans_decode_request_handle(request,&r));
 
+	  /* lock the request */
+	  mcapi_trans_lock(REQUEST_LOCK(r));
+
 	  if (mcapi_db->requests[r].valid == MCAPI_FALSE) {
 		*mcapi_status = MCAPI_ERR_REQUEST_INVALID;
 	  } else if (mcapi_db->requests[r].cancelled) {
 		/* this reqeust has already been cancelled */
 		mcapi_dprintf(2,"mcapi_trans_cancel - request was already cancelled");
 		*mcapi_status = MCAPI_ERR_REQUEST_CANCELLED;
-	  } else if (!(mcapi_db->requests[r].completed)) {
+	  } else if (mcapi_db->requests[r].completed ||
+				 ((mcapi_db->requests[r].type == RECV) && !cancel_receive_request_have_lock (request))) {
+		/* it's too late, the request has already completed (or a receive
+		   request already had its message and has been completed above) */
+		mcapi_dprintf(2," mcapi_trans_cancel - Unable to cancel because request has already completed");
+	  } else {
 		/* cancel the request */
 		mcapi_db->requests[r].cancelled = MCAPI_TRUE;
 		switch (mcapi_db->requests[r].type) {
 		case (RECV) :
-		  cancel_receive_request_have_lock (request);
+		  /* the reservation has been removed above */
 		  break;
 		case (GET_ENDPT) :
 		  break;
@@ -3195,18 +3828,18 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 		  mcapi_assert(0);
 		  break;
 		};
-		/* clear the request so that it can be re-used */
+		/* wake the task waiting for the request */
+		mcapi_trans_waiter_signal(mcapi_db->requests[r].waiter);
+		/* clear the request and give the entry back so that it can be re-used */
 		memset(&mcapi_db->requests[r],0,sizeof(mcapi_request_data));
+		mcapi_trans_remove_request_have_lock(r);
 		*mcapi_status = MCAPI_SUCCESS;
 		/* invalidate the request handle */
 		//*request = 0;
-	  } else {
-		/* it's too late, the request has already completed */
-		mcapi_dprintf(2," mcapi_trans_cancel - Unable to cancel because request has already completed");
 	  }
 
-	  /* unlock the database */
-	  mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE);
+	  /* unlock the request */
+	  mcapi_trans_unlock(REQUEST_LOCK(r));
   }
 
 
@@ -3240,6 +3873,9 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
       size -
       buffer - the buffer
       type - the type of the request
+      r - the request index reserved by the caller
+    A receive that is not completed reserves an entry of the receive queue,
+    the caller holds the endpoint lock then.
    RETURN VALUE:
    ***************************************************************************/
    mcapi_boolean_t setup_request_have_lock (mcapi_endpoint_t* handle,
@@ -3253,20 +3889,15 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
                                            mcapi_domain_t domain_num,
                                            int r)
    {
-	   int i,qindex;
 	   uint16_t d,n,e;
 	   mcapi_boolean_t rc = MCAPI_TRUE;
-
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
+	   queue* q;
 
 	   mcapi_db->requests[r].status = *mcapi_status;
 	   mcapi_db->requests[r].size = size;
 	   mcapi_db->requests[r].cancelled = MCAPI_FALSE;
 	   mcapi_db->requests[r].completed = completed;
+	   mcapi_db->requests[r].waiter = 0;
 
 	   //encode the request handle (this is the only place in the code we do this)
 	   *request = 0x80000000 | r;
@@ -3274,7 +3905,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	   /* this is hacky, there's probably a better way to do this */
 	   if ((buffer != NULL) && (!completed)) {
 		 mcapi_assert(mcapi_trans_decode_handle(*handle,&d,&n,&e));
-		 if ( mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.channel_type == MCAPI_PKT_CHAN) {
+		 if ( mcapi_db->domains[d].nodes[n].node_d.endpoints[e].channel_type == MCAPI_PKT_CHAN) {
 		   /* packet buffer means system buffer, so save the users pointer to the buffer */
 		   mcapi_db->requests[r].buffer_ptr = buffer;
 		 } else {
@@ -3297,18 +3928,16 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	   /* if this was a non-blocking receive to an empty queue, then reserve the next buffer */
 	   if ((type == RECV) && (!completed)) {
 		 mcapi_assert(mcapi_trans_decode_handle(*handle,&d,&n,&e));
-		 /*find the queue entry that doesn't already have a request associated with it */
-		 for (i = 0; i < MCAPI_MAX_QUEUE_ENTRIES; i++) {
-		   /* walk from head to tail */
-		   qindex = (mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.head + i) % (MCAPI_MAX_QUEUE_ENTRIES);
-		   if ((mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.elements[qindex].request==0) &&
-			   (!mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.elements[qindex].invalid)) {
-			 mcapi_dprintf(4,"receive request r=%u reserving qindex=%i",i,qindex);
-			 mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.elements[qindex].request = *request;
-			 break;
-		   }
-		 }
-		 if (i == MCAPI_MAX_QUEUE_ENTRIES) {
+		 /* the reservations are kept in the order of the requests, the senders
+			hand their messages to them in that order */
+		 q = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue;
+		 if (q->num_reserved < MCAPI_MAX_QUEUE_ELEMENTS) {
+		   mcapi_dprintf(4,"receive request r=%u reserving entry %u",r,q->num_reserved);
+		   q->reserved[q->num_reserved].request = *request;
+		   q->reserved[q->num_reserved].buff_index = 0;
+		   q->reserved[q->num_reserved].waiter = 0;
+		   q->num_reserved++;
+		 } else {
 		   mcapi_dprintf(1,"setup_request_have_lock: MCAPI_ERR_MEM_LIMIT all of this endpoint's buffers already have requests associated with them.  Your receives are outpacing your sends.  Either throttle this at the application layer or reconfigure with a larger endpoint receive queue.");
 		   /* all of this endpoint's buffers already have requests associated with them */
 		   mcapi_db->requests[r].status = MCAPI_ERR_MEM_LIMIT;
@@ -3316,7 +3945,6 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 		 }
 	   }
 
-
 	   return rc;
    }
 
@@ -3376,7 +4004,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 		mcapi_assert(mcapi_trans_decode_handle(*endpoint,&d,&n,&e));
 		printf("\nnode: %u, port: %u, receive queue (num_elements=%i):",
 			   (unsigned)mcapi_db->domains[d].nodes[n].node_num,(unsigned)mcapi_db->domains[d].nodes[n].node_d.endpoints[e].port_num,
-			   (unsigned)mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.num_elements);
+			   (unsigned)mcapi_trans_count_queue(mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue));
 
 		printf("\n    endpoint: %u",e);
 		printf("\n      valid:%u",mcapi_db->domains[d].nodes[n].node_d.endpoints[e].valid);
@@ -3435,19 +4063,19 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
   {
 	  uint16_t d,n,e,r;
 
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
-
 	  if (mcapi_trans_decode_request_handle(request,&r)) {
 
 		mcapi_assert(mcapi_trans_decode_handle(mcapi_db->requests[r].handle,&d,&n,&e));
 
+		/* unlock the request, the topology is locked before it */
+		mcapi_trans_unlock(REQUEST_LOCK(r));
+
+		/* lock the database */
+		mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
+
 		/* has the channel been connected yet? */
-		mcapi_endpoint_t send_endpoint = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.send_endpt;
-		mcapi_endpoint_t recv_endpoint = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.recv_endpt;
+		mcapi_endpoint_t send_endpoint = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].send_endpt;
+		mcapi_endpoint_t recv_endpoint = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_endpt;
 
 		/* unlock the database */
 		mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
@@ -3456,10 +4084,10 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 		mcapi_boolean_t is_channel_open = mcapi_trans_endpoint_channel_isopen(send_endpoint)
 									   && mcapi_trans_endpoint_channel_isopen(recv_endpoint);
 
-		/* lock the database */
-		mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
+		/* lock the request */
+		mcapi_trans_lock(REQUEST_LOCK(r));
 
-		if ( is_channel_open == MCAPI_TRUE )
+		if ( is_channel_open == MCAPI_TRUE && mcapi_db->requests[r].valid )
 		{
 			mcapi_db->requests[r].completed = MCAPI_TRUE;
 		}
@@ -3476,19 +4104,19 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
   {
 	  uint16_t d,n,e,r;
 
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
-
 	  if (mcapi_trans_decode_request_handle(request,&r)) {
 
 		mcapi_assert(mcapi_trans_decode_handle(mcapi_db->requests[r].handle,&d,&n,&e));
 
+		/* unlock the request, the topology is locked before it */
+		mcapi_trans_unlock(REQUEST_LOCK(r));
+
+		/* lock the database */
+		mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
+
 		/* has the channel been connected yet? */
-		mcapi_endpoint_t send_endpoint = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.send_endpt;
-		mcapi_endpoint_t recv_endpoint = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.recv_endpt;
+		mcapi_endpoint_t send_endpoint = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].send_endpt;
+		mcapi_endpoint_t recv_endpoint = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_endpt;
 
 		/* unlock the database */
 		mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
@@ -3497,14 +4125,22 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 		mcapi_boolean_t is_channel_closed = !mcapi_trans_endpoint_channel_isopen(send_endpoint)
 										 && !mcapi_trans_endpoint_channel_isopen(recv_endpoint);
 
-		/* lock the database */
-		mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
-
 		if ( is_channel_closed == MCAPI_TRUE )
 		{
 			/* channel is disconnected */
+			mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
+			mcapi_trans_lock(&endpoint_locks[e]);
 			mcapi_db->domains[d].nodes[n].node_d.endpoints[e].connected = MCAPI_FALSE;
-			mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue.channel_type = MCAPI_NO_CHAN;
+			mcapi_db->domains[d].nodes[n].node_d.endpoints[e].channel_type = MCAPI_NO_CHAN;
+			mcapi_trans_unlock(&endpoint_locks[e]);
+			mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
+		}
+
+		/* lock the request */
+		mcapi_trans_lock(REQUEST_LOCK(r));
+
+		if ( is_channel_closed == MCAPI_TRUE && mcapi_db->requests[r].valid )
+		{
 			mcapi_db->requests[r].completed = MCAPI_TRUE;
 		}
 	  }
@@ -3519,33 +4155,35 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
   void check_get_endpt_request_have_lock (mcapi_request_t *request)
   {
 	  uint16_t r;
-
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
+	  mcapi_boolean_t found = MCAPI_FALSE;
 
 	  mcapi_assert(mcapi_trans_decode_request_handle(request,&r));
 
+	  /* the request entry is not re-used while the request is unlocked,
+		 only the task that waits for it removes it */
+	  mcapi_request_data* req = &mcapi_db->requests[r];
+
+	  /* unlock the request, the topology is locked before it */
+	  mcapi_trans_unlock(REQUEST_LOCK(r));
+
 	  /* check if endpoint belongs to the local node */
-	  if(mcapi_db->requests[r].ep_domain_num == my_domain_id && mcapi_db->requests[r].ep_node_num == my_node_id)
+	  if(req->ep_domain_num == my_domain_id && req->ep_node_num == my_node_id)
 	  {
-		  if (mcapi_trans_endpoint_get_have_lock (mcapi_db->requests[r].ep_endpoint,
-												  mcapi_db->requests[r].ep_domain_num,
-												  mcapi_db->requests[r].ep_node_num,
-												  mcapi_db->requests[r].ep_port_num)) {
-			mcapi_db->requests[r].completed = MCAPI_TRUE;
-			mcapi_db->requests[r].status = MCAPI_SUCCESS;
-		  }
+		  /* lock the database */
+		  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
+
+		  found = mcapi_trans_endpoint_get_have_lock (req->ep_endpoint,
+													  req->ep_domain_num,
+													  req->ep_node_num,
+													  req->ep_port_num);
+
+		  /* unlock the database */
+		  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
 	  }
 	  else
 	  {
-		  /* unlock the database */
-		  mcapi_assert(mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE));
-
 		  /* endpoint does not belong to the local node -> go to the next layer */
-		  switch (mcapi_db->requests[r].type) {
+		  switch (req->type) {
 		  case (RECV) :
 			  printf("check_get_endpt_request_have_lock():  - request.type = RECV\n"); break;
 		  case (GET_ENDPT) :
@@ -3554,12 +4192,15 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 				// only reason for this case could be that remote MCAPI system is
 				// initialized but the requested remote endpoint wasn't installed
 				// at previous request time
-				if (NS_getRemoteEndpoint_request(mcapi_db->requests[r].ep_endpoint,
-							mcapi_db->requests[r].ep_domain_num,
-							mcapi_db->requests[r].ep_node_num,
-							mcapi_db->requests[r].ep_port_num) == NS_OK) {
-					mcapi_db->requests[r].completed = MCAPI_TRUE;
-					mcapi_db->requests[r].status = MCAPI_SUCCESS;
+				if (NS_getRemoteEndpoint_request(req->ep_endpoint,
+							req->ep_domain_num,
+							req->ep_node_num,
+							req->ep_port_num) == NS_OK) {
+					mcapi_trans_endpoint_cache_put (*req->ep_endpoint,
+							req->ep_domain_num,
+							req->ep_node_num,
+							req->ep_port_num);
+					found = MCAPI_TRUE;
 				}
 				break;
 		  case (OPEN_PKTCHAN) :
@@ -3573,81 +4214,65 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 		  default :
 			  printf("check_get_endpt_request_have_lock():  - request.type = unknown\n"); break;
 		  }
+	  }
 
+	  /* lock the request */
+	  mcapi_trans_lock(REQUEST_LOCK(r));
 
-
-		  /* lock the database */
-		  mcapi_assert(mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE));
+	  if (found && req->valid) {
+		req->completed = MCAPI_TRUE;
+		req->status = MCAPI_SUCCESS;
 	  }
   }
 
   /***************************************************************************
   NAME: cancel_receive_request_have_lock
-  DESCRIPTION: Cancels an outstanding receive request.  This is a little tricky
-   because we have to preserve FIFO which means we have to shift all other
-   outstanding receive requests down.
+  DESCRIPTION: Cancels an outstanding receive request by removing its
+   reservation, the later reservations keep their order.  A request that
+   already has its message can't be cancelled any more, it is completed
+   instead, so the message is in the user's buffer when this returns.  The
+   caller holds the request lock, the reservations are changed under the
+   endpoint lock.
   PARAMETERS:
    request -
-  RETURN VALUE: none
+  RETURN VALUE: MCAPI_FALSE if the message has already been handed to the
+   request, MCAPI_TRUE otherwise
   ***************************************************************************/
-  void cancel_receive_request_have_lock (mcapi_request_t *request)
+  mcapi_boolean_t cancel_receive_request_have_lock (mcapi_request_t *request)
   {
 	  uint16_t rd,rn,re,r;
-	  int i,last,start,curr;
-
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
+	  int i;
+	  queue* q;
 
 	  mcapi_assert(mcapi_trans_decode_request_handle(request,&r));
 	  mcapi_assert(mcapi_trans_decode_handle(mcapi_db->requests[r].handle,&rd,&rn,&re));
-	  for (i = 0; i < MCAPI_MAX_QUEUE_ENTRIES; i++) {
-		if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[i].request == *request) {
-		  /* we found the request, now clear the reservation */
-		  mcapi_dprintf(5,"cancel_receive_request - cancelling request at index %i BEFORE:",i);
-		  //print_queue(c_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue);
-		  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[i].request = 0;
-		  break;
-		}
-	  }
+
+	  mcapi_trans_lock(&endpoint_locks[re]);
+	  q = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue;
+	  i = mcapi_trans_find_reservation(q,*request);
 
 	  /* we should have found the outstanding request */
-	  mcapi_assert (i != MCAPI_MAX_QUEUE_ENTRIES);
-
-	  /* shift all pending reservations down*/
-	  start = i;
-	  last = start;
-	  for (i = 0; i < MCAPI_MAX_QUEUE_ENTRIES; i++) {
-		curr = (i+start)%MCAPI_MAX_QUEUE_ENTRIES;
-		/* don't cross over the head or the tail */
-		if ((curr == mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.tail) &&
-			(curr != start)) {
-		  break;
-		}
-		if ((curr == mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.head) &&
-			(curr != start)) {
-		  break;
-		}
-		if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[curr].request) {
-		  mcapi_dprintf(5,"cancel_receive_request - shifting request at index %i to index %i",curr,last);
-		  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[last].request =
-			mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[curr].request;
-		  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[curr].request = 0;
-		  last = curr;
-		}
+	  mcapi_assert (i >= 0);
+
+	  if (i < q->num_bound) {
+		mcapi_trans_unlock(&endpoint_locks[re]);
+		check_receive_request_have_lock (request);
+		return MCAPI_FALSE;
 	  }
+	  mcapi_dprintf(5,"cancel_receive_request - cancelling reservation %i",i);
+	  mcapi_trans_remove_reservation(q,i);
+	  mcapi_trans_unlock(&endpoint_locks[re]);
 
 	  mcapi_db->requests[r].cancelled = MCAPI_TRUE;
+	  return MCAPI_TRUE;
   }
 
   /***************************************************************************
   NAME: check_receive_request
-  DESCRIPTION: Checks if the given non-blocking receive request has completed.
-  	This is a little tricky because we can't just pop from the head of the
-  	endpoints receive queue.  We have to locate the reservation that was
-  	made in the queue (to preserve FIFO) at the time the request was made.
+  DESCRIPTION: Checks if the given non-blocking receive request has completed,
+  	i.e. if a sender has handed a message to its reservation.  The caller
+  	holds the request lock, the reservations are read under the endpoint
+  	lock.
   PARAMETERS: the request pointer (to be filled in)
   RETURN VALUE: none
   ***************************************************************************/
@@ -3656,57 +4281,42 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  uint16_t rd,rn,re,r;
 	  int i;
 	  size_t size;
+	  int32_t index;
+	  queue* q;
 
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
-
-	  int32_t index=-1;
 	  mcapi_assert(mcapi_trans_decode_request_handle(request,&r));
 	  mcapi_assert(mcapi_trans_decode_handle(mcapi_db->requests[r].handle,&rd,&rn,&re));
-	  for (i = 0; i < MCAPI_MAX_QUEUE_ENTRIES; i++) {
-
-		if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[i].request == *request) {
-		  /* we found the request, check to see if there is valid data in the receive queue entry */
-		  if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[i].buff_index ) {
-			/* clear the request reservation */
-			mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[i].request = 0;
-			/* shared memory is zeroed, so we store our index as index+1 so that we can tell if it's valid or not*/
-			index = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[i].buff_index &~ MCAPI_VALID_MASK;
-			/* update the request */
-			mcapi_db->requests[r].completed = MCAPI_TRUE;
-			mcapi_db->requests[r].status = MCAPI_SUCCESS;
-			/* first take the entry out of the queue  this has the potential to fragment our
-			   receive queue since we may not be removing from the head */
-			if ( mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.channel_type == MCAPI_PKT_CHAN) {
-			  /* packet buffer means system buffer, so save the users pointer to the buffer */
-			  mcapi_trans_recv_have_lock_ (rd,rn,re,mcapi_db->requests[r].buffer_ptr,mcapi_db->requests[r].size,&mcapi_db->requests[r].size,i,NULL);
-			} else {
-			  /* message buffer means user buffer, so save the users buffer */
-			  size = mcapi_db->requests[r].size;
-			  mcapi_trans_recv_have_lock_ (rd,rn,re,&mcapi_db->requests[r].buffer,mcapi_db->requests[r].size,&mcapi_db->requests[r].size,i,NULL);
-			  if (mcapi_db->requests[r].size > size) {
-				mcapi_db->requests[r].size = size;
-				mcapi_db->requests[r].status = MCAPI_ERR_MSG_TRUNCATED;
-			  }
-			}
-			/* now update the receive queue state */
-			mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.num_elements--;
-			/* mark this entry as invalid so that the "bubble" won't be re-used */
-			mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[i].invalid = MCAPI_TRUE;
-			mcapi_trans_compact_queue (&mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue);
-			mcapi_dprintf(4,"receive request (test/wait) popped from qindex=%i, num_elements=%i, head=%i, tail=%i",
-						  i,mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.num_elements,
-						  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.head,
-						  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.tail);
+
+	  mcapi_trans_lock(&endpoint_locks[re]);
+	  q = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue;
+	  i = mcapi_trans_find_reservation(q,*request);
+
+	  /* we should have found the outstanding request */
+	  mcapi_assert (i >= 0);
+
+	  if (i < q->num_bound) {
+		/* the message has been handed to the request, take the reservation out */
+		index = q->reserved[i].buff_index;
+		mcapi_trans_remove_reservation(q,i);
+		/* update the request */
+		mcapi_db->requests[r].completed = MCAPI_TRUE;
+		mcapi_db->requests[r].status = MCAPI_SUCCESS;
+		if ( mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].channel_type == MCAPI_PKT_CHAN) {
+		  /* packet buffer means system buffer, so save the users pointer to the buffer */
+		  mcapi_trans_recv_have_lock_ (rd,rn,re,mcapi_db->requests[r].buffer_ptr,mcapi_db->requests[r].size,&mcapi_db->requests[r].size,index,NULL);
+		} else {
+		  /* message buffer means user buffer, so save the users buffer */
+		  size = mcapi_db->requests[r].size;
+		  mcapi_trans_recv_have_lock_ (rd,rn,re,&mcapi_db->requests[r].buffer,mcapi_db->requests[r].size,&mcapi_db->requests[r].size,index,NULL);
+		  if (mcapi_db->requests[r].size > size) {
+			mcapi_db->requests[r].size = size;
+			mcapi_db->requests[r].status = MCAPI_ERR_MSG_TRUNCATED;
 		  }
-		  break;
 		}
+		mcapi_dprintf(4,"receive request (test/wait) completed from reservation %i, num_reserved=%i, num_bound=%i",
+					  i,q->num_reserved,q->num_bound);
 	  }
-	  /* we should have found the outstanding request */
-	  mcapi_assert (i != MCAPI_MAX_QUEUE_ENTRIES);
+	  mcapi_trans_unlock(&endpoint_locks[re]);
   }
 
 
@@ -3741,19 +4351,23 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  if(sd == my_domain_id && sn == my_node_id)
 	  {
 		  /* update the send endpoint */
+		  mcapi_trans_lock(&endpoint_locks[se]);
 		  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].connected = MCAPI_TRUE;
-		  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.recv_endpt = receive_endpoint;
-		  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.send_endpt = send_endpoint;
-		  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_queue.channel_type = type;
+		  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].recv_endpt = receive_endpoint;
+		  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].send_endpt = send_endpoint;
+		  mcapi_db->domains[sd].nodes[sn].node_d.endpoints[se].channel_type = type;
+		  mcapi_trans_unlock(&endpoint_locks[se]);
 	  }
 
 	  if(rd == my_domain_id && rn == my_node_id)
 	  {
 		  /* update the receive endpoint */
+		  mcapi_trans_lock(&endpoint_locks[re]);
 		  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].connected = MCAPI_TRUE;
-		  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.send_endpt = send_endpoint;
-		  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.recv_endpt = receive_endpoint;
-		  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.channel_type = type;
+		  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].send_endpt = send_endpoint;
+		  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_endpt = receive_endpoint;
+		  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].channel_type = type;
+		  mcapi_trans_unlock(&endpoint_locks[re]);
 	  }
 
 	  mcapi_dprintf(1,"channel_type=%u connected sender (node=%u,port=%u) to receiver (node=%u,port=%u)",
@@ -3765,7 +4379,9 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 
   /***************************************************************************
   NAME:mcapi_trans_send
-  DESCRIPTION: Attempts to send a message from one endpoint to another
+  DESCRIPTION: Attempts to send a message from one endpoint to another,
+   the message was received from a remote node.  Takes the receive endpoint
+   lock.
   PARAMETERS:
   sn - the send node index (only used for verbose debug print)
   se - the send endpoint index (only used for verbose debug print)
@@ -3781,11 +4397,10 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
   				 const char* buffer,
   				 size_t buffer_size)
   {
-	  int qindex,i;
+	  int i;
 	  buffer_entry* db_buff = NULL;
 
-	  // lock the database
-	  mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE);
+	  mcapi_trans_lock(&endpoint_locks[re]);
 
 	  mcapi_dprintf(3,"mcapi_trans_send_have_lock sender (node=%u,port=%u) to receiver (node=%u,port=%u) ",
 					mcapi_db->domains[sd].nodes[sn].node_num,
@@ -3793,56 +4408,45 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 					mcapi_db->domains[rd].nodes[rn].node_num,
 					mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].port_num);
 
+	  /* the receive endpoint has been deleted, its queue is gone -> drop the message */
+	  if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue == NULL) {
+		  mcapi_dprintf(1,"mcapi_trans_send: receive endpoint deleted, message dropped");
+		  mcapi_trans_unlock(&endpoint_locks[re]);
+		  return MCAPI_TRUE;
+	  }
+
 	  /* for packets or scalars, check if channel is connected and open */
-	  if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.channel_type != MCAPI_NO_CHAN ) {
+	  if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].channel_type != MCAPI_NO_CHAN ) {
 		  if(!(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].connected)
 		     || !(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].open))
 		  {
-			  // unlock the database
-			  mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE);
+			  mcapi_trans_unlock(&endpoint_locks[re]);
 
 			  return MCAPI_FALSE;
 		  }
 	  }
 
 	if (mcapi_trans_full_queue(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue)) {
-		/* we couldn't get space in the endpoints receive queue, try to compact the queue */
-		mcapi_trans_compact_queue(&mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue);
-
-		// unlock the database
-		mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE);
+		/* we couldn't get space in the endpoints receive queue */
+		mcapi_trans_unlock(&endpoint_locks[re]);
 		return MCAPI_FALSE;
 	}
 
 	/* find a free mcapi buffer (we only have to worry about this on the sending side) */
-	for (i = 0; i < MCAPI_MAX_BUFFERS; i++) {
-		if (!mcapi_db->buffers[i].magic_num) {
-			mcapi_db->buffers[i].magic_num = MAGIC_NUM;
-			db_buff = &mcapi_db->buffers[i];
-			mcapi_dprintf(4,"using buffer index i=%u",i);
-			break;
-		}
-	}
-	if (i == MCAPI_MAX_BUFFERS) {
+	db_buff = mcapi_trans_buffer_get(buffer_size,&i);
+	if (db_buff == NULL) {
 		/* we couldn't get a free buffer */
 		mcapi_dprintf(2,"ERROR mcapi_trans_send_have_lock: No more buffers available - try freeing some buffers. ");
 
-		// unlock the database
-		mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE);
+		mcapi_trans_unlock(&endpoint_locks[re]);
 
 		return MCAPI_FALSE;
 	}
 
 	/* now go about updating buffer into the database... */
-	/* find the next index in the circular queue */
-	qindex = mcapi_trans_push_queue(&mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue);
-	mcapi_dprintf(4,"send pushing %u byte buffer to qindex=%i, num_elements=%i, head=%i, tail=%i",
-			buffer_size,qindex,mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.num_elements,
-			mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.head,
-			mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.tail);
-
-	/* printf(" send pushing to qindex=%i",qindex); */
-	if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.channel_type == MCAPI_SCL_CHAN ) {
+	mcapi_dprintf(4,"send delivering %u byte buffer i=%i",buffer_size,i);
+
+	if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].channel_type == MCAPI_SCL_CHAN ) {
 		memcpy(&(db_buff->scalar), buffer, buffer_size);
 	}
 	else {
@@ -3852,13 +4456,12 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	/* set the size */
 	db_buff->size = buffer_size;
 
-	/* update the ptr in the receive_endpoints queue to point to our mcapi buffer */
+	/* hand our mcapi buffer to the receive endpoint and wake the receiving task */
 	/* shared memory is zeroed, so we store our index as index with a valid bit */
 	/* so that we can tell if it's valid or not*/
-	mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[qindex].buff_index = i | MCAPI_VALID_MASK;
+	mcapi_trans_deliver_have_lock(rd,rn,re,i | MCAPI_VALID_MASK);
 
-	// unlock the database
-	mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE);
+	mcapi_trans_unlock(&endpoint_locks[re]);
 
 	return MCAPI_TRUE;
 }
@@ -3866,7 +4469,8 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 
   /***************************************************************************
   NAME:mcapi_trans_send_have_lock
-  DESCRIPTION: Attempts to send a message from one endpoint to another
+  DESCRIPTION: Attempts to send a message from one endpoint to another.
+   The caller holds the receive endpoint lock.
   PARAMETERS:
   sn - the send node index (only used for verbose debug print)
   se - the send endpoint index (only used for verbose debug print)
@@ -3887,7 +4491,7 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
   										 size_t buffer_size,
   										 uint64_t scalar)
   {
-	  int qindex,i;
+	  int i;
 	  buffer_entry* db_buff = NULL;
 
 	  mcapi_dprintf(3,"mcapi_trans_send_have_lock sender (node=%u,port=%u) to receiver (node=%u,port=%u) ",
@@ -3896,14 +4500,13 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 					mcapi_db->domains[rd].nodes[rn].node_num,
 					mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].port_num);
 
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
+	  /* the receive endpoint has been deleted, it has no queue any more */
+	  if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue == NULL) {
+		  return MCAPI_ERR_CHAN_NCNO;
+	  }
 
 	  /* for packets or scalars, check if channel is connected and open */
-	  if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.channel_type != MCAPI_NO_CHAN ) {
+	  if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].channel_type != MCAPI_NO_CHAN ) {
 		  if(!(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].connected)
 		     || !(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].open))
 		  {
@@ -3912,35 +4515,21 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  }
 
 	  if (mcapi_trans_full_queue(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue)) {
-		/* we couldn't get space in the endpoints receive queue, try to compact the queue */
-		mcapi_trans_compact_queue(&mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue);
+		/* we couldn't get space in the endpoints receive queue */
 		return MCAPI_ERR_MEM_LIMIT;
 	  }
 
 	  /* find a free mcapi buffer (we only have to worry about this on the sending side) */
-	  for (i = 0; i < MCAPI_MAX_BUFFERS; i++) {
-		if (!mcapi_db->buffers[i].magic_num) {
-		  mcapi_db->buffers[i].magic_num = MAGIC_NUM;
-		  db_buff = &mcapi_db->buffers[i];
-		  mcapi_dprintf(4,"using buffer index i=%u",i);
-		  break;
-		}
-	  }
-	  if (i == MCAPI_MAX_BUFFERS) {
+	  db_buff = mcapi_trans_buffer_get(buffer_size,&i);
+	  if (db_buff == NULL) {
 		/* we couldn't get a free buffer */
 		mcapi_dprintf(2,"ERROR mcapi_trans_send_have_lock: No more buffers available - try freeing some buffers. ");
 		return MCAPI_ERR_MEM_LIMIT;
 	  }
 
 	  /* now go about updating buffer into the database... */
-	  /* find the next index in the circular queue */
-	  qindex = mcapi_trans_push_queue(&mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue);
-	  mcapi_dprintf(4,"send pushing %u byte buffer to qindex=%i, num_elements=%i, head=%i, tail=%i",
-					buffer_size,qindex,mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.num_elements,
-					mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.head,
-					mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.tail);
-	  /* printf(" send pushing to qindex=%i",qindex); */
-	  if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.channel_type == MCAPI_SCL_CHAN ) {
+	  mcapi_dprintf(4,"send delivering %u byte buffer i=%i",buffer_size,i);
+	  if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].channel_type == MCAPI_SCL_CHAN ) {
 		db_buff->scalar = scalar;
 	  } else {
 		/* copy the buffer parm into a mcapi buffer */
@@ -3948,50 +4537,43 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  }
 	  /* set the size */
 	  db_buff->size = buffer_size;
-	  /* update the ptr in the receive_endpoints queue to point to our mcapi buffer */
+	  /* hand our mcapi buffer to the receive endpoint and wake the receiving task */
 	  /* shared memory is zeroed, so we store our index as index with a valid bit so that we can tell if it's valid or not*/
-	  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[qindex].buff_index = i | MCAPI_VALID_MASK;
+	  mcapi_trans_deliver_have_lock(rd,rn,re,i | MCAPI_VALID_MASK);
 
 	  return MCAPI_SUCCESS;
   }
 
   /***************************************************************************
     NAME:  mcapi_trans_recv_have_lock_
-    DESCRIPTION: Removes a message (at the given qindex) from the given
-      receive endpoints queue.  This function is used both by check_receive_request
-      and mcapi_trans_recv_have_lock.  We needed to separate the functionality
-      because in order to preserve FIFO, if recv was called to an empty queue we
-      had to set a reservation at the head of the queue.  Thus we can't always
-      just pop from the head of the queue.
+    DESCRIPTION: Copies a message out of the given buffer and frees the
+      buffer (not for packets, their buffer goes to the user).  This function
+      is used both by check_receive_request, with the message that was handed
+      to a reservation, and mcapi_trans_recv_have_lock, with the message that
+      was popped from the receive ring.  The buffer doesn't belong to the
+      queue any more, so no lock is needed.
     PARAMETERS:
       rn - the receive node index
       re - the receive endpoint index
       buffer -
       buffer_size -
       received_size - the actual size (in bytes) of the data received
-      qindex - index into the receive endpoints queue that we should remove from
+      buff_index - the index of the buffer (with the valid bit)
     RETURN VALUE: none
   ***************************************************************************/
   void mcapi_trans_recv_have_lock_ (uint16_t rd,uint16_t rn, uint16_t re, void** buffer, size_t buffer_size,
-  							   size_t* received_size,int qindex,uint64_t* scalar)
+  							   size_t* received_size,int32_t buff_index,uint64_t* scalar)
   {
 	  size_t size;
 
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
-
 	  /* shared memory is zeroed, so we store our index as index w/ a valid bit so that we can tell if it's valid or not*/
-	  int index = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[qindex].buff_index &~ MCAPI_VALID_MASK;
+	  int index = buff_index &~ MCAPI_VALID_MASK;
 	  mcapi_assert (index >= 0);
 
 	  mcapi_dprintf(3,"mcapi_trans_recv_have_lock_ for receiver (node=%u,port=%u)",
 					mcapi_db->domains[rd].nodes[rn].node_num,
 					mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].port_num);
 
-	  /* printf(" recv popping from qindex=%i",qindex); */
 	  /* first make sure buffer is big enough for the message */
 	  if ((buffer_size) < mcapi_db->buffers[index].size) {
 		fprintf(stderr,"ERROR: mcapi_trans_recv_have_lock buffer not big enough - loss of data: buffer_size=%i, element_size=%i",
@@ -4010,12 +4592,12 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 	  }
 
 	  /* copy the buffer out of the receive_endpoint's queue and into the buffer parm */
-	  if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.channel_type == MCAPI_PKT_CHAN) {
+	  if (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].channel_type == MCAPI_PKT_CHAN) {
 		/* mcapi supplied buffer (pkt receive), so just update the pointer */
 		*buffer = mcapi_db->buffers[index].buff;
 	  } else {
 		/* user supplied buffer, copy it in and free the mcapi buffer */
-		if   (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.channel_type == MCAPI_SCL_CHAN) {
+		if   (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].channel_type == MCAPI_SCL_CHAN) {
 		  /* scalar receive */
 		  *scalar = mcapi_db->buffers[index].scalar;
 		} else {
@@ -4023,21 +4605,15 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 		  memcpy (*buffer,mcapi_db->buffers[index].buff,size);
 		}
 		/* free the mcapi  buffer */
-		memset(&mcapi_db->buffers[index],0,sizeof(mcapi_db->buffers[index]));
+		mcapi_trans_buffer_put(&mcapi_db->buffers[index]);
 	  }
-	  mcapi_dprintf(4,"receive popping %u byte buffer from qindex=%i, num_elements=%i, head=%i, tail=%i buffer=[",
-					size,qindex,mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.num_elements,
-					mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.head,
-					mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.tail);
-
-	  /* clear the buffer pointer in the receive queue entry */
-	  mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue.elements[qindex].buff_index = 0;
+	  mcapi_dprintf(4,"receive took %u byte buffer index=%i",size,index);
   }
 
   /***************************************************************************
    NAME: mcapi_trans_recv_have_lock
-   DESCRIPTION: checks if a message is available, if so performs the pop (from
-    the head of the queue) and sends the qindex to be used to mcapi_trans_recv_have_lock_
+   DESCRIPTION: pops a message from the head of the receive ring, if there is
+    one, and sends its buffer to mcapi_trans_recv_have_lock_
    PARAMETERS:
      rn - the receive node index
      re - the receive endpoint index
@@ -4045,33 +4621,43 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
      buffer_size -
      received_size - the actual size (in bytes) of the data received
      blocking - whether or not this is a blocking receive
+   The receiving task is the only consumer of the ring, a non-blocking receive
+   needs no lock. A blocking receive is called with the receive endpoint lock
+   and releases it while it waits.
    RETURN VALUE: true/false indicating success or failure
   ***************************************************************************/
   mcapi_boolean_t mcapi_trans_recv_have_lock (uint16_t rd,uint16_t rn, uint16_t re, void** buffer,
   										size_t buffer_size, size_t* received_size,
   										mcapi_boolean_t blocking,uint64_t* scalar)
   {
-	  int qindex;
-
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
+	  int32_t index;
+	  uint8_t w;
 
-	  if ((!blocking) && (mcapi_trans_empty_queue(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue))) {
-		return MCAPI_FALSE;
-	  }
+	  index = mcapi_trans_pop_queue(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue);
+	  if (index == 0) {
+		if (!blocking) {
+		  return MCAPI_FALSE;
+		}
 
-	  while (mcapi_trans_empty_queue(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue)) {
-		mcapi_dprintf(5,"mcapi_trans_recv_have_lock to empty queue - attempting to yield");
-		/* we have the lock, use this yield */
-		mcapi_trans_yield_have_lock();
+		/* block until the sender signals the endpoint, poll if all completion
+		   objects are in use or another task already waits for the endpoint */
+		w = mcapi_trans_waiter_get();
+		while ((index = mcapi_trans_pop_queue(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue)) == 0) {
+		  if ((w != 0) && (mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].waiter == 0)) {
+			mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].waiter = w;
+			mcapi_trans_waiter_block_have_lock(w,&endpoint_locks[re],NULL,MCAPI_FALSE);
+			mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].waiter = 0;
+		  } else {
+			mcapi_dprintf(5,"mcapi_trans_recv_have_lock to empty queue - attempting to yield");
+			/* no completion object, release the endpoint lock and yield */
+			mcapi_trans_waiter_block_have_lock(0,&endpoint_locks[re],NULL,MCAPI_FALSE);
+		  }
+		}
+		mcapi_trans_waiter_put(w);
 	  }
 
-	  /* remove the element from the receive endpoints queue */
-	  qindex = mcapi_trans_pop_queue(&mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue);
-	  mcapi_trans_recv_have_lock_ (rd,rn,re,buffer,buffer_size,received_size,qindex,scalar);
+	  /* the message has been removed from the receive endpoints ring */
+	  mcapi_trans_recv_have_lock_ (rd,rn,re,buffer,buffer_size,received_size,index,scalar);
 
 	  return MCAPI_TRUE;
   }
@@ -4094,7 +4680,9 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 #endif
 
 	  /* mark the endpoint as open */
+	  mcapi_trans_lock(&endpoint_locks[e]);
 	  mcapi_db->domains[d].nodes[n].node_d.endpoints[e].open = MCAPI_TRUE;
+	  mcapi_trans_unlock(&endpoint_locks[e]);
   }
 
   /***************************************************************************
@@ -4115,50 +4703,533 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
 #endif
 
 	  /* mark the endpoint as closed */
+	  mcapi_trans_lock(&endpoint_locks[e]);
 	  mcapi_db->domains[d].nodes[n].node_d.endpoints[e].open = MCAPI_FALSE;
+	  mcapi_trans_unlock(&endpoint_locks[e]);
   }
 
   /***************************************************************************
-  NAME:mcapi_trans_yield_have_lock
-  DESCRIPTION: releases the lock, attempts to yield, re-acquires the lock.
-  PARAMETERS: none
+  NAME:mcapi_trans_set_deadline
+  DESCRIPTION: Calculates the end of a wait.
+  PARAMETERS:
+    deadline - the end of the wait (to be filled in)
+    timeout - in milliseconds
   RETURN VALUE: none
   ***************************************************************************/
-  void mcapi_trans_yield_have_lock ()
+  void mcapi_trans_set_deadline (mcapi_deadline_t* deadline, mcapi_timeout_t timeout)
   {
-	  // call this version of sched_yield when you have the lock
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
-
-	  // release the lock
-	  mcapi_trans_access_database_post(global_rwl,MCAPI_TRUE);
-
-	  /* yield */
 #ifdef UCOSII
-		OSTimeDly(TICKS_TO_WAIT);
+	  /* round up to whole ticks, split to avoid an overflow */
+	  *deadline = OSTimeGet() + (timeout / 1000) * MCAPI_TICKS_PER_SEC
+				  + ((timeout % 1000) * MCAPI_TICKS_PER_SEC + 999) / 1000;
 #endif
 
 #ifdef LINUX
-		sched_yield();
+	  clock_gettime(CLOCK_REALTIME, deadline);
+	  deadline->tv_sec += timeout / 1000;
+	  deadline->tv_nsec += (long) (timeout % 1000) * 1000000;
+	  if (deadline->tv_nsec >= 1000000000) {
+		deadline->tv_sec++;
+		deadline->tv_nsec -= 1000000000;
+	  }
 #endif
-	  //re-acquire the lock
-	  mcapi_trans_access_database_pre(global_rwl,MCAPI_TRUE);
+  }
 
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
+  /***************************************************************************
+  NAME:mcapi_trans_waiter_get
+  DESCRIPTION: Takes a free completion object for the calling task and
+    clears the signals left over from its last use.
+  PARAMETERS: none
+  RETURN VALUE: index+1 of the completion object, 0 if all are in use (the
+    caller polls then)
+  ***************************************************************************/
+  uint8_t mcapi_trans_waiter_get ()
+  {
+	  uint8_t w;
+#ifdef UCOSII
+	  uint8_t err;
 #endif
 
+	  mcapi_trans_lock(&waiter_lock);
+	  for (w = 0; w < MCAPI_MAX_WAITERS; w++) {
+		if (!waiters[w].in_use) {
+		  waiters[w].in_use = MCAPI_TRUE;
+		  mcapi_trans_unlock(&waiter_lock);
+#ifdef UCOSII
+		  OSSemSet(waiters[w].sem, 0, &err);
+#endif
+
+#ifdef LINUX
+		  pthread_mutex_lock(&waiters[w].mutex);
+		  waiters[w].signalled = MCAPI_FALSE;
+		  pthread_mutex_unlock(&waiters[w].mutex);
+#endif
+		  return w + 1;
+		}
+	  }
+	  mcapi_trans_unlock(&waiter_lock);
+	  mcapi_dprintf(2,"mcapi_trans_waiter_get: all completion objects in use - polling");
+	  return 0;
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_waiter_put
+  DESCRIPTION: Returns a completion object.
+  PARAMETERS: w - index+1 of the completion object, 0 is ignored
+  RETURN VALUE: none
+  ***************************************************************************/
+  void mcapi_trans_waiter_put (uint8_t w)
+  {
+	  if (w != 0) {
+		mcapi_trans_lock(&waiter_lock);
+		waiters[w - 1].in_use = MCAPI_FALSE;
+		mcapi_trans_unlock(&waiter_lock);
+	  }
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_waiter_signal
+  DESCRIPTION: Wakes the task blocked on a completion object. A signal
+    before the task blocks is not lost. The caller holds the lock of the
+    object the task waits for (endpoint or request lock).
+  PARAMETERS: w - index+1 of the completion object, 0 is ignored
+  RETURN VALUE: none
+  ***************************************************************************/
+  void mcapi_trans_waiter_signal (uint8_t w)
+  {
+	  if (w == 0) {
+		return;
+	  }
+#ifdef UCOSII
+	  OSSemPost(waiters[w - 1].sem);
+#endif
+
+#ifdef LINUX
+	  pthread_mutex_lock(&waiters[w - 1].mutex);
+	  waiters[w - 1].signalled = MCAPI_TRUE;
+	  pthread_cond_signal(&waiters[w - 1].cond);
+	  pthread_mutex_unlock(&waiters[w - 1].mutex);
+#endif
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_waiter_attach_have_lock
+  DESCRIPTION: Attaches a completion object to a pending request. For a
+    receive it is also attached to the reservation in the receive queue,
+    the sender signals it under the endpoint lock. The caller holds the
+    request lock.
+  PARAMETERS:
+    request - the request
+    w - index+1 of the completion object
+  RETURN VALUE: TRUE if the completion of the request will be signalled,
+    FALSE if the caller has to re-check the request (no completion object,
+    another task waits for it or it is not a receive)
+  ***************************************************************************/
+  mcapi_boolean_t mcapi_trans_waiter_attach_have_lock (mcapi_request_t* request, uint8_t w)
+  {
+	  uint16_t r,d,n,e;
+	  int i;
+	  queue* q;
+	  mcapi_boolean_t attached = MCAPI_FALSE;
+
+	  if ((w == 0) || !mcapi_trans_decode_request_handle(request,&r) ||
+		  !mcapi_db->requests[r].valid) {
+		return MCAPI_FALSE;
+	  }
+	  if ((mcapi_db->requests[r].waiter != 0) && (mcapi_db->requests[r].waiter != w)) {
+		return MCAPI_FALSE;
+	  }
+	  mcapi_db->requests[r].waiter = w;
+	  /* only receives are completed by the task of the peer */
+	  if ((mcapi_db->requests[r].type != RECV) ||
+		  !mcapi_trans_decode_handle(mcapi_db->requests[r].handle,&d,&n,&e)) {
+		return MCAPI_FALSE;
+	  }
+
+	  mcapi_trans_lock(&endpoint_locks[e]);
+	  q = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue;
+	  i = mcapi_trans_find_reservation(q,*request);
+	  if (i >= 0) {
+		q->reserved[i].waiter = w;
+		/* the message arrived after the last test */
+		if (i < q->num_bound) {
+		  mcapi_trans_waiter_signal(w);
+		}
+		attached = MCAPI_TRUE;
+	  }
+	  mcapi_trans_unlock(&endpoint_locks[e]);
+
+	  return attached;
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_waiter_detach_have_lock
+  DESCRIPTION: Detaches a completion object from a request, if it is still
+    attached. The caller holds the request lock.
+  PARAMETERS:
+    request - the request
+    w - index+1 of the completion object
+  RETURN VALUE: none
+  ***************************************************************************/
+  void mcapi_trans_waiter_detach_have_lock (mcapi_request_t* request, uint8_t w)
+  {
+	  uint16_t r,d,n,e;
+	  int i;
+	  queue* q;
+
+	  if ((w == 0) || !mcapi_trans_decode_request_handle(request,&r)) {
+		return;
+	  }
+	  if (mcapi_db->requests[r].waiter == w) {
+		mcapi_db->requests[r].waiter = 0;
+	  }
+	  if ((mcapi_db->requests[r].type != RECV) ||
+		  !mcapi_trans_decode_handle(mcapi_db->requests[r].handle,&d,&n,&e)) {
+		return;
+	  }
+
+	  mcapi_trans_lock(&endpoint_locks[e]);
+	  q = mcapi_db->domains[d].nodes[n].node_d.endpoints[e].recv_queue;
+	  i = mcapi_trans_find_reservation(q,*request);
+	  if ((i >= 0) && (q->reserved[i].waiter == w)) {
+		q->reserved[i].waiter = 0;
+	  }
+	  mcapi_trans_unlock(&endpoint_locks[e]);
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_waiter_block_have_lock
+  DESCRIPTION: Releases the lock, blocks on the completion object until it
+    is signalled or the deadline has passed and re-acquires the lock.
+    Without a completion object it yields once like before.
+  PARAMETERS:
+    w - index+1 of the completion object, 0 = none
+    lock - the lock held by the caller (request or endpoint lock), NULL if
+      the caller holds none
+    deadline - the end of the wait, NULL = no timeout
+    recheck - if TRUE, the wait ends after RECHECK_MS at the latest
+  RETURN VALUE: FALSE if the deadline had passed before, TRUE otherwise
+  ***************************************************************************/
+  mcapi_boolean_t mcapi_trans_waiter_block_have_lock (uint8_t w,
+  												   mcapi_lock_t* lock,
+  												   const mcapi_deadline_t* deadline,
+  												   mcapi_boolean_t recheck)
+  {
+#ifdef UCOSII
+	  INT32U ticks = 0;	/* 0 = forever */
+	  INT32S left;
+	  uint8_t err;
+
+	  if (deadline != NULL) {
+		left = (INT32S) (*deadline - OSTimeGet());
+		if (left <= 0) {
+		  return MCAPI_FALSE;
+		}
+		ticks = left;
+	  }
+	  if (recheck) {
+		if ((ticks == 0) || (ticks > RECHECK_TICKS)) {
+		  ticks = RECHECK_TICKS;
+		}
+	  }
+	  if (ticks > 0xffff) {
+		ticks = 0xffff;
+	  }
+
+	  if (lock != NULL) {
+		mcapi_trans_unlock(lock);
+	  }
+	  if (w == 0) {
+		OSTimeDly(TICKS_TO_WAIT);
+	  } else {
+		OSSemPend(waiters[w - 1].sem, (INT16U) ticks, &err);
+	  }
+	  if (lock != NULL) {
+		mcapi_trans_lock(lock);
+	  }
+#endif
+
+#ifdef LINUX
+	  mcapi_deadline_t now;
+	  mcapi_deadline_t end;
+	  mcapi_boolean_t bounded = MCAPI_FALSE;
+	  int err = 0;
+
+	  clock_gettime(CLOCK_REALTIME, &now);
+	  if (deadline != NULL) {
+		if ((now.tv_sec > deadline->tv_sec) ||
+			((now.tv_sec == deadline->tv_sec) && (now.tv_nsec >= deadline->tv_nsec))) {
+		  return MCAPI_FALSE;
+		}
+		end = *deadline;
+		bounded = MCAPI_TRUE;
+	  }
+	  if (recheck) {
+		mcapi_trans_set_deadline(&now, RECHECK_MS);
+		if (!bounded || (now.tv_sec < end.tv_sec) ||
+			((now.tv_sec == end.tv_sec) && (now.tv_nsec < end.tv_nsec))) {
+		  end = now;
+		}
+		bounded = MCAPI_TRUE;
+	  }
+
+	  if (lock != NULL) {
+		mcapi_trans_unlock(lock);
+	  }
+	  if (w == 0) {
+		sched_yield();
+	  } else {
+		/* the signal is kept in signalled, it is not lost while the lock
+		   is released */
+		pthread_mutex_lock(&waiters[w - 1].mutex);
+		while (!waiters[w - 1].signalled && (err != ETIMEDOUT)) {
+		  if (bounded) {
+			err = pthread_cond_timedwait(&waiters[w - 1].cond, &waiters[w - 1].mutex, &end);
+		  } else {
+			err = pthread_cond_wait(&waiters[w - 1].cond, &waiters[w - 1].mutex);
+		  }
+		}
+		waiters[w - 1].signalled = MCAPI_FALSE;
+		pthread_mutex_unlock(&waiters[w - 1].mutex);
+	  }
+	  if (lock != NULL) {
+		mcapi_trans_lock(lock);
+	  }
+#endif
+
+	  return MCAPI_TRUE;
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_deliver_have_lock
+  DESCRIPTION: Hands a message to the oldest receive request that waits for
+    one or, if there is none, pushes it into the receive ring. Wakes the
+    task waiting for the request or a task blocked in a blocking receive.
+    The caller holds the receive endpoint lock and has checked with
+    mcapi_trans_full_queue() that there is room.
+  PARAMETERS:
+    rd - the receive domain index
+    rn - the receive node index
+    re - the receive endpoint index
+    buff_index - the index of the buffer with the message (with the valid bit)
+  RETURN VALUE: none
+  ***************************************************************************/
+  void mcapi_trans_deliver_have_lock (uint16_t rd, uint16_t rn, uint16_t re, int32_t buff_index)
+  {
+	  queue* q = mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].recv_queue;
+
+	  if (q->num_bound < q->num_reserved) {
+		q->reserved[q->num_bound].buff_index = buff_index;
+		mcapi_trans_waiter_signal(q->reserved[q->num_bound].waiter);
+		q->num_bound++;
+	  } else {
+		mcapi_assert(mcapi_trans_push_queue(q,buff_index));
+		mcapi_trans_waiter_signal(mcapi_db->domains[rd].nodes[rn].node_d.endpoints[re].waiter);
+	  }
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_lock_create
+  DESCRIPTION: Creates a lock of the message paths.
+  PARAMETERS: lock - the lock to be created
+  RETURN VALUE: true/false indicating success or failure
+  ***************************************************************************/
+  mcapi_boolean_t mcapi_trans_lock_create (mcapi_lock_t* lock)
+  {
+#ifdef UCOSII
+	  *lock = OSSemCreate(1);
+	  return (*lock != NULL);
+#endif
+
+#ifdef LINUX
+	  return (pthread_mutex_init(lock, NULL) == 0);
+#endif
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_lock_destroy
+  DESCRIPTION: Deletes a lock of the message paths.
+  PARAMETERS: lock - the lock
+  RETURN VALUE: none
+  ***************************************************************************/
+  void mcapi_trans_lock_destroy (mcapi_lock_t* lock)
+  {
+#ifdef UCOSII
+	  uint8_t err;
+
+	  if (*lock != NULL) {
+		OSSemDel(*lock, OS_DEL_ALWAYS, &err);
+		*lock = NULL;
+	  }
+#endif
+
+#ifdef LINUX
+	  pthread_mutex_destroy(lock);
+#endif
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_lock
+  DESCRIPTION: Acquires a lock of the message paths.
+  PARAMETERS: lock - the lock
+  RETURN VALUE: none
+  ***************************************************************************/
+  void mcapi_trans_lock (mcapi_lock_t* lock)
+  {
+#ifdef UCOSII
+	  uint8_t err;
+
+	  OSSemPend(*lock, 0, &err);
+#endif
+
+#ifdef LINUX
+	  pthread_mutex_lock(lock);
+#endif
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_unlock
+  DESCRIPTION: Releases a lock of the message paths.
+  PARAMETERS: lock - the lock
+  RETURN VALUE: none
+  ***************************************************************************/
+  void mcapi_trans_unlock (mcapi_lock_t* lock)
+  {
+#ifdef UCOSII
+	  OSSemPost(*lock);
+#endif
+
+#ifdef LINUX
+	  pthread_mutex_unlock(lock);
+#endif
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_buffer_get
+  DESCRIPTION: Takes the first free buffer of the smallest size class that
+    holds size bytes, a larger class if that one is used up (we only have to
+    worry about this on the sending side).
+  PARAMETERS:
+    size - the number of bytes that will be copied into the buffer
+    index - the index of the buffer (to be filled in)
+  RETURN VALUE: the buffer, NULL if all buffers that are large enough are in use
+  ***************************************************************************/
+  buffer_entry* mcapi_trans_buffer_get (size_t size, int* index)
+  {
+	  buffer_entry* b_e;
+	  int c;
+	  int i = -1;
+
+	  mcapi_trans_lock(&buffer_lock);
+	  for (c = 0; c < MCAPI_BUFFER_CLASSES; c++) {
+		if (buffer_class_size[c] >= size && mcapi_db->buffer_pool.free_head[c] >= 0) {
+		  i = mcapi_db->buffer_pool.free_head[c];
+		  break;
+		}
+	  }
+	  if (i < 0) {
+		mcapi_db->buffer_pool.num_exhausted++;
+		mcapi_trans_unlock(&buffer_lock);
+		return NULL;
+	  }
+	  b_e = &mcapi_db->buffers[i];
+	  mcapi_db->buffer_pool.free_head[c] = b_e->next_free;
+	  b_e->magic_num = MAGIC_NUM;
+	  if (++mcapi_db->buffer_pool.num_used > mcapi_db->buffer_pool.high_water) {
+		mcapi_db->buffer_pool.high_water = mcapi_db->buffer_pool.num_used;
+	  }
+	  mcapi_trans_unlock(&buffer_lock);
+
+	  mcapi_dprintf(4,"using buffer index i=%u",i);
+	  *index = i;
+	  return b_e;
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_buffer_put
+  DESCRIPTION: Puts an mcapi buffer back on the free list. Only the header
+    is cleared, the data is left as it is.
+  PARAMETERS: b_e - the buffer
+  RETURN VALUE: none
+  ***************************************************************************/
+  void mcapi_trans_buffer_put (buffer_entry* b_e)
+  {
+	  mcapi_trans_lock(&buffer_lock);
+	  if (b_e->magic_num == MAGIC_NUM) {
+		b_e->magic_num = 0;
+		b_e->size = 0;
+		b_e->scalar = 0;
+		b_e->next_free = mcapi_db->buffer_pool.free_head[b_e->size_class];
+		mcapi_db->buffer_pool.free_head[b_e->size_class] = b_e - mcapi_db->buffers;
+		mcapi_db->buffer_pool.num_used--;
+	  }
+	  mcapi_trans_unlock(&buffer_lock);
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_buffer_find
+  DESCRIPTION: Maps the data pointer of a buffer back to its buffer entry.
+  PARAMETERS: data - the data of the buffer, as returned to the user
+  RETURN VALUE: the buffer, NULL if data is not the start of a buffer
+  ***************************************************************************/
+  buffer_entry* mcapi_trans_buffer_find (void* data)
+  {
+	  char* base = (char*)mcapi_db->buffer_data;
+	  size_t offset;
+	  size_t class_bytes;
+	  int c;
+	  int i = 0;
+
+	  if ((char*)data < base || (char*)data >= base + sizeof(mcapi_db->buffer_data)) {
+		return NULL;
+	  }
+	  offset = (char*)data - base;
+	  for (c = 0; c < MCAPI_BUFFER_CLASSES; c++) {
+		class_bytes = buffer_class_count[c] * buffer_class_size[c];
+		if (offset < class_bytes) {
+		  if (offset % buffer_class_size[c] != 0) {
+			return NULL;
+		  }
+		  return &mcapi_db->buffers[i + offset / buffer_class_size[c]];
+		}
+		offset -= class_bytes;
+		i += buffer_class_count[c];
+	  }
+	  return NULL;
+  }
+
+  /***************************************************************************
+  NAME:mcapi_trans_buffer_stats
+  DESCRIPTION: Returns the statistics of the buffer pool.
+  PARAMETERS:
+    num_used - buffers in use (to be filled in)
+    high_water - maximum number of buffers in use since
+      mcapi_initialize() (to be filled in)
+    num_exhausted - sends that found no free buffer (to be filled in)
+  RETURN VALUE: none
+  ***************************************************************************/
+  void mcapi_trans_buffer_stats (mcapi_uint32_t* num_used, mcapi_uint32_t* high_water,
+  								 mcapi_uint32_t* num_exhausted)
+  {
+	  mcapi_trans_lock(&buffer_lock);
+	  *num_used = mcapi_db->buffer_pool.num_used;
+	  *high_water = mcapi_db->buffer_pool.high_water;
+	  *num_exhausted = mcapi_db->buffer_pool.num_exhausted;
+	  mcapi_trans_unlock(&buffer_lock);
   }
 
   /***************************************************************************
   NAME: mcapi_trans_access_database_pre
   DESCRIPTION: This function will lock the database related mutex in order
-               to ensure exclusive database access
+               to ensure exclusive database access.  The database mutex
+               only guards the topology (endpoints, channels, nodes), the
+               message paths take the lock of the request, the endpoint
+               lock of the receive endpoint and the buffer lock.  Locks are
+               always taken in this order: database mutex, request lock,
+               endpoint lock, buffer lock, waiter lock.  A task holds at
+               most one request lock.  The reserve lock of the request
+               table and the cache lock of the remote endpoints are taken
+               last.
   PARAMETERS: none
   RETURN VALUE:none
   ***************************************************************************/
@@ -4435,235 +5506,183 @@ void mcapi_trans_endpoint_delete( mcapi_endpoint_t endpoint)
     PARAMETERS: q - the queue
     RETURN VALUE: none
   ***************************************************************************/
-  void print_queue (queue q)
+  void print_queue (queue* q)
   {
-	  int i,qindex,index;
+	  int i;
+	  uint32_t qindex;
+	  int32_t index;
 	  uint16_t r;
 	  /*print the recv queue from head to tail*/
 	  printf("\n      recv_queue:");
-	  for (i = 0; i < MCAPI_MAX_QUEUE_ENTRIES; i++) {
-		/* walk the queue from the head to the tail */
-		qindex = (q.head + i) % (MCAPI_MAX_QUEUE_ENTRIES);
-		printf("\n          ----------------QINDEX: %i",qindex);
-		if (q.head == qindex) { printf("\n           *** HEAD ***"); }
-		if (q.tail == qindex) { printf("\n           *** TAIL ***"); }
-		printf("\n          request:0x%lx",(long unsigned int)q.elements[qindex].request);
-		if (q.elements[qindex].request) {
-		  r = q.elements[qindex].request;
-		  printf("\n             valid:%u",mcapi_db->requests[r].valid);
-		  printf("\n             size:%u",(int)mcapi_db->requests[r].size);
-		  switch (mcapi_db->requests[r].type) {
-		  case (OTHER): printf("\n             type:OTHER"); break;
-		  case (SEND): printf("\n             type:SEND"); break;
-		  case (RECV): printf("\n             type:RECV"); break;
-		  case (GET_ENDPT): printf("\n             type:GET_ENDPT"); break;
-		  default:  printf("\n             type:UNKNOWN!!!"); break;
-		  };
-		  printf("\n             buffer:[%s]",(char*)mcapi_db->requests[r].buffer);
-		  printf("\n             buffer_ptr:0x%lx",(long unsigned int)mcapi_db->requests[r].buffer_ptr);
-		  printf("\n             completed:%u",mcapi_db->requests[r].completed);
-		  printf("\n             cancelled:%u",mcapi_db->requests[r].cancelled);
-		  printf("\n             handle:0x%i",(int)mcapi_db->requests[r].handle);
-		  /*   printf("\n             status:%s",mcapi_display_status(c_db->requests[r].status)); */
-		  printf("\n             status:%i",(int)mcapi_db->requests[r].status);
-		  printf("\n             endpoint:0x%lx",(long unsigned int)mcapi_db->requests[r].ep_endpoint);
-		}
-		printf("\n          invalid:%u",q.elements[qindex].invalid);
-
-		printf("\n          b:0x%lx",(long unsigned int)q.elements[qindex].buff_index);
-		if (q.elements[qindex].buff_index) {
-		  index = q.elements[qindex].buff_index &~ MCAPI_VALID_MASK;
-		  printf("\n             size:%u",(unsigned)mcapi_db->buffers[index].size);
-		  printf("\n             magic_num:%x",(unsigned)mcapi_db->buffers[index].magic_num);
-		  printf("\n             buff:[%s]",(char*)mcapi_db->buffers[index].buff);
-		}
+	  for (qindex = RING_READ(q->head); qindex != RING_READ(q->tail); qindex = (qindex + 1) % MCAPI_MAX_QUEUE_ENTRIES) {
+		index = RING_READ(q->elements[qindex]);
+		printf("\n          ----------------QINDEX: %i",(int)qindex);
+		printf("\n          b:0x%lx",(long unsigned int)index);
+		index &= ~MCAPI_VALID_MASK;
+		printf("\n             size:%u",(unsigned)mcapi_db->buffers[index].size);
+		printf("\n             magic_num:%x",(unsigned)mcapi_db->buffers[index].magic_num);
+		printf("\n             buff:[%s]",(char*)mcapi_db->buffers[index].buff);
+	  }
+	  /*print the reservations, the first num_bound have their message*/
+	  printf("\n      reserved (num_bound=%u):",(unsigned)q->num_bound);
+	  for (i = 0; i < q->num_reserved; i++) {
+		printf("\n          ----------------RESERVATION: %i",i);
+		printf("\n          request:0x%lx",(long unsigned int)q->reserved[i].request);
+		r = q->reserved[i].request;
+		printf("\n             valid:%u",mcapi_db->requests[r].valid);
+		printf("\n             size:%u",(int)mcapi_db->requests[r].size);
+		switch (mcapi_db->requests[r].type) {
+		case (OTHER): printf("\n             type:OTHER"); break;
+		case (SEND): printf("\n             type:SEND"); break;
+		case (RECV): printf("\n             type:RECV"); break;
+		case (GET_ENDPT): printf("\n             type:GET_ENDPT"); break;
+		default:  printf("\n             type:UNKNOWN!!!"); break;
+		};
+		printf("\n             buffer:[%s]",(char*)mcapi_db->requests[r].buffer);
+		printf("\n             buffer_ptr:0x%lx",(long unsigned int)mcapi_db->requests[r].buffer_ptr);
+		printf("\n             completed:%u",mcapi_db->requests[r].completed);
+		printf("\n             cancelled:%u",mcapi_db->requests[r].cancelled);
+		printf("\n             handle:0x%i",(int)mcapi_db->requests[r].handle);
+		printf("\n             status:%i",(int)mcapi_db->requests[r].status);
+		printf("\n             endpoint:0x%lx",(long unsigned int)mcapi_db->requests[r].ep_endpoint);
+		printf("\n          b:0x%lx",(long unsigned int)q->reserved[i].buff_index);
 	  }
   }
 
   /***************************************************************************
     NAME: push_queue
-    DESCRIPTION: Returns the qindex that should be used for adding an element.
-       Also updates the num_elements, and tail pointer.
-    PARAMETERS: q - the queue pointer
-    RETURN VALUE: the qindex to be used
+    DESCRIPTION: Adds a message at the tail of the ring. Only called by the
+       producer, which holds the endpoint lock, it never waits for the
+       consumer.
+    PARAMETERS:
+       q - the queue pointer
+       buff_index - the buffer of the message (with the valid bit)
+    RETURN VALUE: MCAPI_FALSE if the ring is full
   ***************************************************************************/
-  int mcapi_trans_push_queue(queue* q)
+  mcapi_boolean_t mcapi_trans_push_queue(queue* q, int32_t buff_index)
   {
-	  int i;
-
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
+	  uint32_t tail = RING_READ(q->tail);
+	  uint32_t next = (tail + 1) % MCAPI_MAX_QUEUE_ENTRIES;
 
-	  if ( (q->tail + 1) % MCAPI_MAX_QUEUE_ENTRIES == q->head) {
-		/* mcapi_assert (q->num_elements ==  MCAPI_MAX_QUEUE_ENTRIES);*/
-		mcapi_assert(!"push_queue called on full queue");
+	  if (next == RING_READ(q->head)) {
+		return MCAPI_FALSE;
 	  }
-	  q->num_elements++;
-	  i = q->tail;
-	  q->tail = ++q->tail % MCAPI_MAX_QUEUE_ENTRIES;
-	  mcapi_assert (q->head != q->tail);
-	  return i;
+	  RING_WRITE(q->elements[tail],buff_index);
+	  /* the element has to be written before the consumer sees the new tail */
+	  RING_BARRIER();
+	  RING_WRITE(q->tail,next);
+	  return MCAPI_TRUE;
   }
 
   /***************************************************************************
     NAME: pop_queue
-    DESCRIPTION: Returns the qindex that should be used for removing an element.
-       Also updates the num_elements, and head pointer.
+    DESCRIPTION: Removes the message at the head of the ring. Only called by
+       the consumer (the task that owns the endpoint), it needs no lock and
+       never waits for the producer.
     PARAMETERS: q - the queue pointer
-    RETURN VALUE: the qindex to be used
+    RETURN VALUE: the buffer of the message (with the valid bit), 0 if the
+       ring is empty
   ***************************************************************************/
-  int mcapi_trans_pop_queue (queue* q)
+  int32_t mcapi_trans_pop_queue (queue* q)
   {
-	  int i,qindex;
-	  int x = 0;
-
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
-
-	  if (q->head == q->tail) {
-		/*mcapi_assert (q->num_elements ==  0);*/
-		mcapi_assert (!"pop_queue called on empty queue");
-	  }
-
-	  /* we can't just pop the first element off the head of the queue, because it
-		 may be reserved for an earlier recv call, we need to take the first element
-		 that doesn't already have a request associated with it.  This can fragment
-		 our queue. */
-	  for (i = 0; i < MCAPI_MAX_QUEUE_ENTRIES; i++) {
-		/* walk the queue from the head to the tail */
-		qindex = (q->head + i) % (MCAPI_MAX_QUEUE_ENTRIES);
-		if ((!q->elements[qindex].request) &&
-			(q->elements[qindex].buff_index)){
-		  x = qindex;
-		  break;
-		}
-	  }
-	  if (i == MCAPI_MAX_QUEUE_ENTRIES) {
-		/* all of this endpoint's buffers already have requests associated with them */
-		mcapi_assert(0); /* mcapi_trans_empty_queue should have already checked for this case */
-	  }
-
-	  q->num_elements--;
+	  uint32_t head = RING_READ(q->head);
+	  int32_t buff_index;
 
-	  /* if we are removing from the front of the queue, then move head */
-	  if (x == q->head) {
-		q->head = ++q->head % MCAPI_MAX_QUEUE_ENTRIES;
-	  } else {
-		/* we are fragmenting the queue, mark this entry as invalid */
-		q->elements[qindex].invalid = MCAPI_TRUE;
+	  if (head == RING_READ(q->tail)) {
+		return 0;
 	  }
-
-	  if (q->num_elements > 0) {
-		if (q->head == q->tail) { printf("num_elements=%d",q->num_elements); }
-		mcapi_assert (q->head != q->tail);
-	  }
-
-	  mcapi_trans_compact_queue (q);
-
-	  return x;
+	  /* the element is read after the tail that published it */
+	  RING_BARRIER();
+	  buff_index = RING_READ(q->elements[head]);
+	  /* and before the producer may re-use the entry */
+	  RING_BARRIER();
+	  RING_WRITE(q->head,(head + 1) % MCAPI_MAX_QUEUE_ENTRIES);
+	  return buff_index;
   }
 
   /***************************************************************************
-    NAME: compact_queue
-    DESCRIPTION: Attempts to compact the queue.  It can become fragmented based
-       on the order that blocking/non-blocking sends/receives/tests come in
-    PARAMETERS: q - the queue pointer
-    RETURN VALUE: none
+    NAME: mcapi_trans_count_queue
+    DESCRIPTION: Counts the messages in the ring. Without the endpoint lock
+       the count is only a snapshot.
+    PARAMETERS: q - the queue
+    RETURN VALUE: the number of messages
   ***************************************************************************/
-  void mcapi_trans_compact_queue (queue* q)
+  uint32_t mcapi_trans_count_queue (queue* q)
   {
-	  int i;
-	  int qindex;
-
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
+	  uint32_t head = RING_READ(q->head);
+	  uint32_t tail = RING_READ(q->tail);
 
-	  mcapi_dprintf(7,"before mcapi_trans_compact_queue head=%i,tail=%i,num_elements=%i",q->head,q->tail,q->num_elements);
-	  for (i = 0; i < MCAPI_MAX_QUEUE_ENTRIES; i++) {
-	  qindex = (q->head + i) % (MCAPI_MAX_QUEUE_ENTRIES);
-	  if ((qindex == q->tail) ||
-		  (q->elements[qindex].request) ||
-		  (q->elements[qindex].buff_index )){
-		break;
-	  } else {
-		/* advance the head pointer */
-		q->elements[qindex].invalid = MCAPI_FALSE;
-		q->head = ++q->head % MCAPI_MAX_QUEUE_ENTRIES;
-		i--;
-	  }
-	  }
-	  mcapi_dprintf(7,"after mcapi_trans_compact_queue head=%i,tail=%i,num_elements=%i",q->head,q->tail,q->num_elements);
-	  if (q->num_elements > 0) {
-		mcapi_assert (q->head != q->tail);
-	  }
+	  return (tail + MCAPI_MAX_QUEUE_ENTRIES - head) % MCAPI_MAX_QUEUE_ENTRIES;
   }
 
   /***************************************************************************
     NAME: mcapi_trans_empty_queue
-    DESCRIPTION: Checks if the queue is empty or not
+    DESCRIPTION: Checks if the ring is empty or not
     PARAMETERS: q - the queue
     RETURN VALUE: true/false
   ***************************************************************************/
-  mcapi_boolean_t mcapi_trans_empty_queue (queue q)
+  mcapi_boolean_t mcapi_trans_empty_queue (queue* q)
   {
-	  int i,qindex;
-
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
-
-	  if  (q.head == q.tail) {
-		/* mcapi_assert (q.num_elements ==  0); */
-		return MCAPI_TRUE;
-	  }
+	  return (RING_READ(q->head) == RING_READ(q->tail));
+  }
 
-	  /* if we have any buffers in our queue that don't have
-		 reservations, then our queue is non-empty */
-	  for (i = 0; i < MCAPI_MAX_QUEUE_ENTRIES; i++) {
-		qindex = (q.head + i) % (MCAPI_MAX_QUEUE_ENTRIES);
-		if ((!q.elements[qindex].request) &&
-			(q.elements[qindex].buff_index )){
-		  break;
-		}
+  /***************************************************************************
+    NAME: mcapi_trans_full_queue
+    DESCRIPTION: Checks if there is room for another message: a reservation
+       that waits for one or a free entry of the ring. The caller holds the
+       endpoint lock.
+    PARAMETERS: q - the queue
+    RETURN VALUE: true/false
+  ***************************************************************************/
+  mcapi_boolean_t mcapi_trans_full_queue (queue* q)
+  {
+	  if (q->num_bound < q->num_reserved) {
+		return MCAPI_FALSE;
 	  }
-	  if (i == MCAPI_MAX_QUEUE_ENTRIES) {
+	  if ((RING_READ(q->tail) + 1) % MCAPI_MAX_QUEUE_ENTRIES == RING_READ(q->head)) {
 		return MCAPI_TRUE;
 	  }
-
 	  return MCAPI_FALSE;
   }
 
   /***************************************************************************
-    NAME: mcapi_trans_full_queue
-    DESCRIPTION: Checks if the queue is full or not
-    PARAMETERS: q - the queue
-    RETURN VALUE: true/false
+    NAME: mcapi_trans_find_reservation
+    DESCRIPTION: Finds the reservation of a receive request. The caller holds
+       the endpoint lock.
+    PARAMETERS:
+       q - the queue
+       request - the receive request
+    RETURN VALUE: the index in reserved[], -1 if there is none
   ***************************************************************************/
-  mcapi_boolean_t mcapi_trans_full_queue (queue q)
+  int mcapi_trans_find_reservation (queue* q, mcapi_request_t request)
   {
+	  int i;
 
-#ifdef DEBUG_LOCK_CHECK
-	/* database should be locked */
-//	if(DatabaseMutex != 0) assert(locked == MCAPI_TRUE);
-	if(pthread_mutex_trylock(&DatabaseMutex) != EBUSY) assert(locked == MCAPI_TRUE);
-#endif
+	  for (i = 0; i < q->num_reserved; i++) {
+		if (q->reserved[i].request == request) {
+		  return i;
+		}
+	  }
+	  return -1;
+  }
 
-	  if ( (q.tail + 1) % MCAPI_MAX_QUEUE_ENTRIES == q.head) {
-		/*  mcapi_assert (q.num_elements ==  (MCAPI_MAX_QUEUE_ENTRIES -1)); */
-		return MCAPI_TRUE;
+  /***************************************************************************
+    NAME: mcapi_trans_remove_reservation
+    DESCRIPTION: Removes a reservation, the later ones move up so that they
+       keep their order. The caller holds the endpoint lock.
+    PARAMETERS:
+       q - the queue
+       i - the index in reserved[]
+    RETURN VALUE: none
+  ***************************************************************************/
+  void mcapi_trans_remove_reservation (queue* q, int i)
+  {
+	  if (i < q->num_bound) {
+		q->num_bound--;
 	  }
-	  return MCAPI_FALSE;
+	  q->num_reserved--;
+	  memmove (&q->reserved[i],&q->reserved[i + 1],(q->num_reserved - i) * sizeof(buffer_descriptor));
+	  memset (&q->reserved[q->num_reserved],0,sizeof(buffer_descriptor));
   }
 
 #ifdef __cplusplus
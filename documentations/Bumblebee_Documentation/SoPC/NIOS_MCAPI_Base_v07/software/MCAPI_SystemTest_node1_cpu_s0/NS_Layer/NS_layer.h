@@ -18,6 +18,9 @@
  * 2014-08-05: v042 changes and ifdef adaptation to
  *             uC/OS-II - ms
  * 2014-08-11: extern decl. of NS_layer_exit() - ms
+ * 2026-10-19: extern decl. of NS_endpointDeleted_notification()
+ * 2026-10-19: extern decl. of NS_sendScalarToRemote_request()
+ * 2026-10-19: extern decl. of NS_setCoalescing()
  *************************************************************/
 
 #ifndef NSLAYER_H_
@@ -40,6 +43,12 @@ extern uint8_t NS_sendDataToRemote_request(uint32_t send_endpoint,
 					uint32_t receive_endpoint,
 					const int8_t* buffer,
 					uint32_t buffer_size);
+extern uint8_t NS_sendScalarToRemote_request(uint32_t send_endpoint,
+					uint32_t receive_endpoint,
+					uint64_t scalar,
+					uint32_t size);
+extern uint8_t NS_endpointDeleted_notification(uint32_t domain_id, uint32_t node_num, uint32_t port_num);
+extern uint8_t NS_setCoalescing(uint32_t node_num, uint32_t flushLatency);
 extern void NS_layer_receive(PH_pdu *data);
 
 #endif /*NSLAYER_H_*/
@@ -6,6 +6,8 @@
 
  * EDITION HISTORY:
  * 2013-12-17: debugging - ms (M. Strahnen)
+ * 2026-10-19: link table nios_node_links_db replaces the
+ *             node to node table nios_node_mapping_db
 ****************************************************************************/
 
 #ifdef __cplusplus
@@ -42,37 +44,43 @@ extern "C" {
 #define NIOS_2_NODE_ID 2
 
 #define NUM_OF_NODES 3
+#define MAX_LINKS_PER_NODE 2	// FIFO bridges of one node
 
-// original nios_node_mapping_db
+// A link is a FIFO bridge of a node to a neighbour node. Only the
+// links are configured, the NS layer computes the routes from this
+// table (NS_initRoutes()). A node which is not a neighbour is reached
+// via the nodes in between, they forward its packets.
+// On Linux link n of a node is driven by /dev/FifoDriver<n>.
 typedef struct {
-	bool valid;
-	unsigned int base;
-	unsigned int irq;
-} destination_node_type;
+	unsigned int node;	// neighbour node at the other end
+	unsigned int base;	// base address of the FIFO bridge
+	unsigned int irq;	// IRQ of the FIFO bridge
+} nios_link_type;
 
 typedef struct {
-	destination_node_type destination_nodes[NUM_OF_NODES];
-} nios_node_mapping_db_type;
+	unsigned int num_links;
+	nios_link_type links[MAX_LINKS_PER_NODE];
+} nios_node_links_type;
 
-static const nios_node_mapping_db_type nios_node_mapping_db[NUM_OF_NODES] =
+static const nios_node_links_type nios_node_links_db[NUM_OF_NODES] =
 {
 	//NIOS 0:
 	{
-		.destination_nodes[0] = { .valid = false, .base = 0, .irq = 0 },
-		.destination_nodes[1] = { .valid = true, .base = FIFO_BRIDGE_NIOS_0_NIOS_1_BASE, .irq = FIFO_BRIDGE_NIOS_0_NIOS_1_IRQ },
-		.destination_nodes[2] = { .valid = true, .base = FIFO_BRIDGE_NIOS_0_NIOS_2_BASE, .irq = FIFO_BRIDGE_NIOS_0_NIOS_2_IRQ }
+		.num_links = 2,
+		.links[0] = { .node = NIOS_1_NODE_ID, .base = FIFO_BRIDGE_NIOS_0_NIOS_1_BASE, .irq = FIFO_BRIDGE_NIOS_0_NIOS_1_IRQ },
+		.links[1] = { .node = NIOS_2_NODE_ID, .base = FIFO_BRIDGE_NIOS_0_NIOS_2_BASE, .irq = FIFO_BRIDGE_NIOS_0_NIOS_2_IRQ }
 	},
 	//NIOS 1:
 	{
-		.destination_nodes[0] = { .valid = true, .base = FIFO_BRIDGE_NIOS_1_NIOS_0_BASE, .irq = FIFO_BRIDGE_NIOS_1_NIOS_0_IRQ },
-		.destination_nodes[1] = { .valid = false, .base = 0, .irq = 0 },
-		.destination_nodes[2] = { .valid = true, .base = FIFO_BRIDGE_NIOS_1_NIOS_2_BASE, .irq = FIFO_BRIDGE_NIOS_1_NIOS_2_IRQ }
+		.num_links = 2,
+		.links[0] = { .node = NIOS_0_NODE_ID, .base = FIFO_BRIDGE_NIOS_1_NIOS_0_BASE, .irq = FIFO_BRIDGE_NIOS_1_NIOS_0_IRQ },
+		.links[1] = { .node = NIOS_2_NODE_ID, .base = FIFO_BRIDGE_NIOS_1_NIOS_2_BASE, .irq = FIFO_BRIDGE_NIOS_1_NIOS_2_IRQ }
 	},
 	//NIOS 2:
 	{
-		.destination_nodes[0] = { .valid = true, .base = FIFO_BRIDGE_NIOS_2_NIOS_0_BASE, .irq = FIFO_BRIDGE_NIOS_2_NIOS_0_IRQ },
-		.destination_nodes[1] = { .valid = true, .base = FIFO_BRIDGE_NIOS_2_NIOS_1_BASE, .irq = FIFO_BRIDGE_NIOS_2_NIOS_1_IRQ },
-		.destination_nodes[2] = { .valid = false, .base = 0, .irq = 0 }
+		.num_links = 2,
+		.links[0] = { .node = NIOS_0_NODE_ID, .base = FIFO_BRIDGE_NIOS_2_NIOS_0_BASE, .irq = FIFO_BRIDGE_NIOS_2_NIOS_0_IRQ },
+		.links[1] = { .node = NIOS_1_NODE_ID, .base = FIFO_BRIDGE_NIOS_2_NIOS_1_BASE, .irq = FIFO_BRIDGE_NIOS_2_NIOS_1_IRQ }
 	}
 };
 
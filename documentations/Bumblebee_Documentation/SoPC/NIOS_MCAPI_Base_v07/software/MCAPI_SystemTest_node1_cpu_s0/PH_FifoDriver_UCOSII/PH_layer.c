@@ -25,16 +25,17 @@
  * calling upper layer's method NS_layer_receive().
  *
  * Message receive operation is implemented with one
- * receive task per FIFO. For example task PH_FIFO1_RcvTask()
- * has to watch FIFO1 and if the entire message has been
- * received, it has to pass the message to the upper layer.
- * In order to do that each PH_FIFOx_RcvTask() is accompanied
- * by an ISR named PH_FIFOx_isr(). Each time the receive FIFO is
- * not empty, it will send an interrupt and CPU will execute
- * the corresponding PH_FIFOx_isr(), which will handle the
- * interrupt request and will inform corresponding
- * PH_FIFOx_RcvTask() to read out and process the received
- * data.
+ * receive task per FIFO, i.e. per link of this node in
+ * nios_node_links_db (mapping.h). Every link runs an instance
+ * of PH_FIFO_RcvTask(), which has to watch the FIFO of its link
+ * and if the entire message has been received, it has to pass
+ * the message to the upper layer. In order to do that each
+ * PH_FIFO_RcvTask() is accompanied by an instance of the ISR
+ * PH_FIFO_ISR(). Each time the receive FIFO is not empty, it
+ * will send an interrupt and CPU will execute PH_FIFO_ISR()
+ * for the link, which will handle the interrupt request and
+ * will inform the PH_FIFO_RcvTask() of the link to read out
+ * and process the received data.
  *
  * PH-layer uses the following very simple packet format:
  *     ---------------------------------------
@@ -43,12 +44,12 @@
  *         |--> packet length in bytes
  *
  * HAVE CARE!
- * For each node a node specific receive task will be
+ * For each link a link specific receive task will be
  * created. Task priorities 11, 12, 13, ... are assigned to
  * that tasks. Priority value 10 is in use by mutex. Therefore
  * we recommend that user tasks should use priority
  * values 20, 21, 22, ...
- * This should work until we have less than 9 NIOS nodes.
+ * This should work until a node has more than 8 links.
  *
  * EDITION HISTORY:
  * 2012-12-19: Version 0.2 integration of BA Blender - ms
@@ -60,6 +61,9 @@
  * 2013-06-28: error detection during OSTaskCreateExt()
  *             and exit() on fatal errors - ms
  * 2014-02-25: debugging - ms
+ * 2026-10-19: PH_FIFO1/2_ISR() and PH_FIFO1/2_RcvTask()
+ *             replaced by PH_FIFO_ISR() and PH_FIFO_RcvTask(),
+ *             one instance per link of nios_node_links_db
  *************************************************************/
 
 #include <sys/alt_irq.h>
@@ -94,96 +98,73 @@ extern void NS_layer_receive(PH_pdu *data);
 #define PH_FIFO_RCVTASK_PRIORITY          11
 #define TASK_STACKSIZE                    2048	//4096
 
-uint32_t bridge_base_fifo_1; // Adresse der CPU_FIFO_BRIDGE 1
-uint32_t bridge_irq_fifo_1;  // IRQ der CPU_FIFO_BRIDGE 1
+// A link is a FIFO bridge to a neighbour node, see nios_node_links_db.
+// Its PH_FIFO_ISR() and PH_FIFO_RcvTask() get a pointer to its PH_link.
+typedef struct
+{
+	uint32_t bridge_base;		// Adresse der CPU_FIFO_BRIDGE
+	uint32_t bridge_irq;		// IRQ der CPU_FIFO_BRIDGE
+	OS_EVENT *semAlmostFull;	// PH_FIFO_ISR() -> PH_FIFO_RcvTask()
+} PH_link;
 
-uint32_t bridge_base_fifo_2; // Adresse der CPU_FIFO_BRIDGE 2
-uint32_t bridge_irq_fifo_2;  // IRQ der CPU_FIFO_BRIDGE 2
+PH_link PH_links[MAX_LINKS_PER_NODE];
 
-OS_STK  PH_FIFO1_RcvTask_stk[TASK_STACKSIZE];
-OS_STK  PH_FIFO2_RcvTask_stk[TASK_STACKSIZE];
+OS_STK  PH_FIFO_RcvTask_stk[MAX_LINKS_PER_NODE][TASK_STACKSIZE];
 
-OS_EVENT *semAlmostFull_fifo_1;
-OS_EVENT *semAlmostFull_fifo_2;
+// receive tasks have to run above NS_flushTask() (priority 19)
+typedef char PH_rcvtask_prio_check[(PH_FIFO_RCVTASK_PRIORITY + MAX_LINKS_PER_NODE <= 19) ? 1 : -1];
 
 OS_EVENT *mutexSend;
 
 /*************************************************************
- * ISR FUNCTION: PH_FIFOx_ISR()
+ * ISR FUNCTION: PH_FIFO_ISR()
  *
  * DESCRIPTION:
- * Waits for an interrupt from fifo_x device and sends
- * signal to waiting receive task PH_FIFOx_RcvTask() via
- * semaphore semAlMostFull_fifo_x.
- *************************************************************/
-void PH_FIFO1_ISR(void *context, uint32_t id)
-{
-    // read FIFOs interrupt register to check for correct interrupt
-    if(IORD_CPU_FIFO_BRIDGE_EVENT(bridge_base_fifo_1) & CPU_FIFO_BRIDGE_EVENT_ALMOSTFULL_MSK) {
-    	// clear interrupt request
-    	// HAVE CARE! It is necessary to re-enable interrupt
-    	// before clearing it because of a bug in FIFO bridge
-    	IOWR_CPU_FIFO_BRIDGE_IENABLE(bridge_base_fifo_1, CPU_FIFO_BRIDGE_IENABLE_ALMOSTFULL_MSK);
-    	IOWR_CPU_FIFO_BRIDGE_EVENT(bridge_base_fifo_1, CPU_FIFO_BRIDGE_EVENT_ALMOSTFULL_MSK);
-
-    	// inform waiting task about interrupt
-        if(semAlmostFull_fifo_1->OSEventCnt == 0) {
-            uint8_t err = OSSemPost(semAlmostFull_fifo_1);
-            if(err != OS_NO_ERR) {
-                printf("PH_FIFO1_ISR: error %d during OSSemPost()\n",err);
-                exit(0);
-            }
-        }
-    }
-    else { // unexpected interrupt has occured
-    	printf("PH_FIFO1_ISR: unexpected interrupt with int reg. = 0x%x occured\n", IORD_CPU_FIFO_BRIDGE_EVENT(bridge_base_fifo_1));
-    	exit(0);
-    }
-}
-
-/*************************************************************
- * ISR FUNCTION: PH_FIFOx_ISR()
+ * Waits for an interrupt from the FIFO of a link and sends
+ * signal to the waiting receive task PH_FIFO_RcvTask() of
+ * that link via its semaphore semAlmostFull.
  *
- * DESCRIPTION:
- * Waits for an interrupt from fifo_x device and sends
- * signal to waiting receive task PH_FIFOx_RcvTask() via
- * semaphore semAlMostFull_fifo_x.
+ * INPUT PARAMETERS:
+ * - context: the PH_link
+ * - id:      IRQ number
  *************************************************************/
-void PH_FIFO2_ISR(void *context, uint32_t id)
+void PH_FIFO_ISR(void *context, uint32_t id)
 {
+	PH_link *link = (PH_link *) context;
+
     // read FIFOs interrupt register to check for correct interrupt
-    if(IORD_CPU_FIFO_BRIDGE_EVENT(bridge_base_fifo_2) & CPU_FIFO_BRIDGE_EVENT_ALMOSTFULL_MSK) {
+    if(IORD_CPU_FIFO_BRIDGE_EVENT(link->bridge_base) & CPU_FIFO_BRIDGE_EVENT_ALMOSTFULL_MSK) {
     	// clear interrupt request
     	// HAVE CARE! It is necessary to re-enable interrupt
     	// before clearing it because of a bug in FIFO bridge
-    	IOWR_CPU_FIFO_BRIDGE_IENABLE(bridge_base_fifo_2, CPU_FIFO_BRIDGE_IENABLE_ALMOSTFULL_MSK);
-    	IOWR_CPU_FIFO_BRIDGE_EVENT(bridge_base_fifo_2, CPU_FIFO_BRIDGE_EVENT_ALMOSTFULL_MSK);
+    	IOWR_CPU_FIFO_BRIDGE_IENABLE(link->bridge_base, CPU_FIFO_BRIDGE_IENABLE_ALMOSTFULL_MSK);
+    	IOWR_CPU_FIFO_BRIDGE_EVENT(link->bridge_base, CPU_FIFO_BRIDGE_EVENT_ALMOSTFULL_MSK);
 
     	// inform waiting task about interrupt
-        if(semAlmostFull_fifo_2->OSEventCnt == 0) {
-            uint8_t err = OSSemPost(semAlmostFull_fifo_2);
+        if(link->semAlmostFull->OSEventCnt == 0) {
+            uint8_t err = OSSemPost(link->semAlmostFull);
             if(err != OS_NO_ERR) {
-                printf("PH_FIFO2_ISR: error %d during OSSemPost()\n",err);
+                printf("PH_FIFO_ISR: error %d during OSSemPost()\n",err);
                 exit(0);
             }
         }
     }
     else { // unexpected interrupt has occured
-    	printf("PH_FIFO2_ISR: unexpected interrupt with int reg. = 0x%x occured\n",
-    			IORD_CPU_FIFO_BRIDGE_EVENT(bridge_base_fifo_2));
+    	printf("PH_FIFO_ISR: unexpected interrupt with int reg. = 0x%x occured\n",
+    			IORD_CPU_FIFO_BRIDGE_EVENT(link->bridge_base));
     	exit(0);
     }
 }
 
 /**************************************************************
- * TASK: PH_FIFOx_RcvTask()
+ * TASK: PH_FIFO_RcvTask()
  *
  * DESCRIPTION:
  * Receive task responsible for receiving data from a
- * dedicated CPU/FIFO-channel. Task will wait for an
- * interrupt from the corresponding FIFO and will then
- * read-out that FIFO. After receipt of an entire packet
- * this will be passed to the upper layer (NS-layer).
+ * dedicated CPU/FIFO-channel, the link given by pdata. Task
+ * will wait for an interrupt from the corresponding FIFO and
+ * will then read-out that FIFO. After receipt of an entire
+ * packet this will be passed to the upper layer (NS-layer).
  * Format of packet (type PH_pdu) passed to NS-layer is:
  *
  * --------------------------------------------------------
@@ -192,95 +173,12 @@ void PH_FIFO2_ISR(void *context, uint32_t id)
  *          |                |--> packet length in bytes
  *          |--> base address of FIFO channel
  *
- * ADAPTATION!!!
- * Parameters 'bridge_base_fifo_x' and 'semAlmostFull_fifo_x'
- * must be adjusted, to receive data from an other CPU.
- * Affected code lines are marked with // !!! adjust ...
- *************************************************************/
-void PH_FIFO1_RcvTask(void *pdata)
-{
-    uint8_t err = OS_NO_ERR;
-    int32_t rcvPacketSize = 0;	// receive packet size
-    PH_pdu dataP;				// PH packet passed to NS-layer
-
-    // alignment of receivebuffer[] forced because later 4 byte load
-    // and store instructions may be used to copy buffer
-    uint8_t receivebuffer[MAX_NS_PACK_SIZE + 4] __attribute__ ((aligned (4)));
-    uint32_t *receivebuffer32 = (uint32_t *) receivebuffer;;
-    dataP.bridge_base = bridge_base_fifo_1;		// !!! adjust bridge_base_fifo_X
-
-    // endless receive loop
-    while(1) {
-      // wait until at least one word has been received
-	  OSSemPend(semAlmostFull_fifo_1,0,&err);	// !!! adjust semAlmostFull_fifo_X
-	  if(err != OS_NO_ERR) {
-		printf("PH_FIFO1_RcvTask: Error in OSSemPend()\n");	// !!! adjust task name
-	  }
-
-	  // read FIFO until empty
-	  while((IORD_CPU_FIFO_BRIDGE_STATUS(dataP.bridge_base) & CPU_FIFO_BRIDGE_RECVSTATUS_EMPTY_MSK) == 0) {
-		  uint32_t data1 = IORD_CPU_FIFO_BRIDGE_DATA(dataP.bridge_base);
-
-		  if(rcvPacketSize == 0) {				// first data word of packet?
-			  rcvPacketSize = data1;			// rcvPacketSize contains packet size in bytes
-			  receivebuffer32 = (uint32_t *) receivebuffer;	// set temporary pointer to
-			  dataP.length = 0;
-#ifdef DEBUG_MODE_VERBOSE
-			  printf("PH_FIFO1_RcvTask: Packet with 0x%x bytes should be received\n", rcvPacketSize);	// !!! adjust FIFOToStubTaskX
-			  fflush(stdout);
-#endif
-		  }
-		  else {		// data word is part of payload area
-			  *receivebuffer32++ = data1;
-#ifdef DEBUG_MODE_VERBOSE
-			  printf("PH_FIFO1_RcvTask:   - data word 0x%x received\n", data1);	// !!! adjust FIFOToStubTaskX
-			  fflush(stdout);
-#endif
-			  dataP.length = dataP.length + 4;
-
-			  if(dataP.length >= rcvPacketSize) {	// did we receive last data word of packet?
-				  dataP.data = receivebuffer;
-				  rcvPacketSize = 0;		// mark that current packet in complete
-#ifdef DEBUG_MODE_VERBOSE
-				  printf("PH_FIFO1_RcvTask: Packet with %d bytes has been received\n", dataP.length);	// !!! adjust FIFOToStubTaskX
-				  fflush(stdout);
-#endif
-
-				  NS_layer_receive(&dataP);	// pass packet to upper layer
-			  }
-		  }
-	  }
-
-	  // normally IOWR_CPU_FIFO_BRIDGE_IENABLE() shouldn't be necessary
-	  // here, must be because of a hardware bug in FIFO bridge module
-	  IOWR_CPU_FIFO_BRIDGE_IENABLE(dataP.bridge_base, CPU_FIFO_BRIDGE_IENABLE_ALMOSTFULL_MSK);
-    }	// end of endless receive loop
-}
-
-/**************************************************************
- * TASK: PH_FIFOx_RcvTask()
- *
- * DESCRIPTION:
- * Receive task responsible for receiving data from a
- * dedicated CPU/FIFO-channel. Task will wait for an
- * interrupt from the corresponding FIFO and will then
- * read-out that FIFO. After receipt of an entire packet
- * this will be passed to the upper layer (NS-layer).
- * Format of packet (type PH_pdu) passed to NS-layer is:
- *
- * --------------------------------------------------------
- * | FIFO_bridge_address | length | payload area          |    |
- * --------------------------------------------------------
- *          |                |--> packet length in bytes
- *          |--> base address of FIFO channel
- *
- * ADAPTATION!!!
- * Parameters 'bridge_base_fifo_x' and 'semAlmostFull_fifo_x'
- * must be adjusted, to receive data from an other CPU.
- * Affected code lines are marked with // !!! adjust ...
+ * INPUT PARAMETERS:
+ * - pdata: the PH_link
  *************************************************************/
-void PH_FIFO2_RcvTask(void *pdata)
+void PH_FIFO_RcvTask(void *pdata)
 {
+	PH_link *link = (PH_link *) pdata;
     uint8_t err = OS_NO_ERR;
     int32_t rcvPacketSize = 0;	// receive packet size
     PH_pdu dataP;				// PH packet passed to NS-layer
@@ -289,14 +187,14 @@ void PH_FIFO2_RcvTask(void *pdata)
     // and store instructions may be used to copy buffer
     uint8_t receivebuffer[MAX_NS_PACK_SIZE + 4] __attribute__ ((aligned (4)));
     uint32_t *receivebuffer32 = (uint32_t *) receivebuffer;;
-    dataP.bridge_base = bridge_base_fifo_2;		// !!! adjust bridge_base_fifo_X
+    dataP.bridge_base = link->bridge_base;
 
     // endless receive loop
     while(1) {
       // wait until at least one word has been received
-	  OSSemPend(semAlmostFull_fifo_2,0,&err);	// !!! adjust semAlmostFull_fifo_X
+	  OSSemPend(link->semAlmostFull,0,&err);
 	  if(err != OS_NO_ERR) {
-		printf("PH_FIFO2_RcvTask: Error in OSSemPend()\n");	// !!! adjust task name
+		printf("PH_FIFO_RcvTask: Error in OSSemPend()\n");
 	  }
 
 	  // read FIFO until empty
@@ -308,14 +206,14 @@ void PH_FIFO2_RcvTask(void *pdata)
 			  receivebuffer32 = (uint32_t *) receivebuffer;	// set temporary pointer to
 			  dataP.length = 0;
 #ifdef DEBUG_MODE_VERBOSE
-			  printf("PH_FIFO2_RcvTask: Packet with 0x%x bytes should be received\n", rcvPacketSize);	// !!! adjust FIFOToStubTaskX
+			  printf("PH_FIFO_RcvTask 0x%x: Packet with 0x%x bytes should be received\n", dataP.bridge_base, rcvPacketSize);
 			  fflush(stdout);
 #endif
 		  }
 		  else {		// data word is part of payload area
 			  *receivebuffer32++ = data1;
 #ifdef DEBUG_MODE_VERBOSE
-			  printf("PH_FIFO2_RcvTask:   - data word 0x%x received\n", data1);	// !!! adjust FIFOToStubTaskX
+			  printf("PH_FIFO_RcvTask 0x%x:   - data word 0x%x received\n", dataP.bridge_base, data1);
 			  fflush(stdout);
 #endif
 			  dataP.length = dataP.length + 4;
@@ -324,7 +222,7 @@ void PH_FIFO2_RcvTask(void *pdata)
 				  dataP.data = receivebuffer;
 				  rcvPacketSize = 0;		// mark that current packet in complete
 #ifdef DEBUG_MODE_VERBOSE
-				  printf("PH_FIFO2_RcvTask: Packet with %d bytes has been received\n", dataP.length);	// !!! adjust FIFOToStubTaskX
+				  printf("PH_FIFO_RcvTask 0x%x: Packet with %d bytes has been received\n", dataP.bridge_base, dataP.length);
 				  fflush(stdout);
 #endif
 
@@ -515,15 +413,6 @@ uint8_t	PH_init(uint32_t nios_node_id)
 {
 	uint8_t err;
 
-	// create semphores used to synchronize PH_FIFOx_ISR() and
-	// corresponding PH_FIFOx_RcvTask()
-    semAlmostFull_fifo_1 = OSSemCreate(0);
-    semAlmostFull_fifo_2 = OSSemCreate(0);
-    if((semAlmostFull_fifo_1 == NULL) || (semAlmostFull_fifo_2 == NULL)) {
-    	printf("PH_init: error on creating semAlmostFull_fifoX semaphores\n");
-    	return(PH_ERROR);
-    }
-
     // mutexSend is used for exclusive access to PH_send_request() method
     mutexSend = OSMutexCreate(MUTEX_SEND_PRIO, &err);
     if(err != OS_NO_ERR) {
@@ -531,73 +420,43 @@ uint8_t	PH_init(uint32_t nios_node_id)
 		return(PH_ERROR);
 	}
 
-    int n, i;
-	for(n = 0, i = 0; n < NUM_OF_NODES; n++) {
-		// check if node is valid
-		if(nios_node_mapping_db[nios_node_id].destination_nodes[n].valid == true) {
-			// Index i is necessary because we use absolute names for rcvTask, isr,
-			// base address and irq level. First legal destination node will be
-			// handled by PH_FIFO1_RcvTask and PH_FIFO1_ISR,
-			// second by PH_FIFO2_RcvTask and PH_FIFO2_ISR and so on.
-
-			/**********************************************************/
-			if(i == 0) { // initialize first valid destination node
-						 // found in nios_node_mapping_db
-				bridge_base_fifo_1 = nios_node_mapping_db[nios_node_id].destination_nodes[n].base;
-				bridge_irq_fifo_1  = nios_node_mapping_db[nios_node_id].destination_nodes[n].irq;
-
-				// Initialize FIFO bridge
-				cpu_fifo_bridge_init(bridge_base_fifo_1,0);
-
-				// enable FIFO receive interrupt and register corresponding ISR
-				alt_irq_register(bridge_irq_fifo_1, 0, PH_FIFO1_ISR);
-				alt_irq_enable(bridge_irq_fifo_1);
-				IOWR_CPU_FIFO_BRIDGE_IENABLE(bridge_base_fifo_1, CPU_FIFO_BRIDGE_IENABLE_ALMOSTFULL_MSK);
-
-				// create corresponding receive task
-				if((err = OSTaskCreateExt(PH_FIFO1_RcvTask,
-								  NULL,
-								  (void *)&PH_FIFO1_RcvTask_stk[TASK_STACKSIZE-1],
-								  PH_FIFO_RCVTASK_PRIORITY + i,
-								  PH_FIFO_RCVTASK_PRIORITY + i,
-								  PH_FIFO1_RcvTask_stk,
-								  TASK_STACKSIZE,
-								  NULL,
-								  0)) != OS_NO_ERR) {
-					printf("PH_init: error %d during OSTaskCreateExt() execution\n", err);
-					return(PH_ERROR);
-				}
-			}
-
-			/**********************************************************/
-			if(i == 1) { // initialize second valid destination node
-						 // found in nios_node_mapping_db
-				bridge_base_fifo_2 = nios_node_mapping_db[nios_node_id].destination_nodes[n].base;
-				bridge_irq_fifo_2 = nios_node_mapping_db[nios_node_id].destination_nodes[n].irq;
-
-				// Initialize FIFO bridge
-				cpu_fifo_bridge_init(bridge_base_fifo_2,0);
-
-				// enable FIFO receive interrupt and register corresponding ISR
-				alt_irq_register(bridge_irq_fifo_2, 0, PH_FIFO2_ISR);
-				alt_irq_enable(bridge_irq_fifo_2);
-				IOWR_CPU_FIFO_BRIDGE_IENABLE(bridge_base_fifo_2, CPU_FIFO_BRIDGE_IENABLE_ALMOSTFULL_MSK);
-
-				if((err = OSTaskCreateExt(PH_FIFO2_RcvTask,
-								  NULL,
-								  (void *)&PH_FIFO2_RcvTask_stk[TASK_STACKSIZE-1],
-								  PH_FIFO_RCVTASK_PRIORITY + i,
-								  PH_FIFO_RCVTASK_PRIORITY + i,
-								  PH_FIFO2_RcvTask_stk,
-								  TASK_STACKSIZE,
-								  NULL,
-								  0)) != OS_NO_ERR) {
-					printf("PH_init: error %d during OSTaskCreateExt() execution\n", err);
-					return(PH_ERROR);
-				}
-			}
-
-			i++;
+    // one ISR and receive task per link of this node
+    const nios_node_links_type *node = &nios_node_links_db[nios_node_id];
+    int i;
+	for(i = 0; i < node->num_links; i++) {
+		PH_link *link = &PH_links[i];
+
+		link->bridge_base = node->links[i].base;
+		link->bridge_irq  = node->links[i].irq;
+
+		// semaphore used to synchronize PH_FIFO_ISR() and
+		// PH_FIFO_RcvTask() of the link
+		link->semAlmostFull = OSSemCreate(0);
+		if(link->semAlmostFull == NULL) {
+			printf("PH_init: error on creating semAlmostFull semaphore\n");
+			return(PH_ERROR);
+		}
+
+		// Initialize FIFO bridge
+		cpu_fifo_bridge_init(link->bridge_base,0);
+
+		// enable FIFO receive interrupt and register corresponding ISR
+		alt_irq_register(link->bridge_irq, link, PH_FIFO_ISR);
+		alt_irq_enable(link->bridge_irq);
+		IOWR_CPU_FIFO_BRIDGE_IENABLE(link->bridge_base, CPU_FIFO_BRIDGE_IENABLE_ALMOSTFULL_MSK);
+
+		// create corresponding receive task
+		if((err = OSTaskCreateExt(PH_FIFO_RcvTask,
+						  link,
+						  (void *)&PH_FIFO_RcvTask_stk[i][TASK_STACKSIZE-1],
+						  PH_FIFO_RCVTASK_PRIORITY + i,
+						  PH_FIFO_RCVTASK_PRIORITY + i,
+						  PH_FIFO_RcvTask_stk[i],
+						  TASK_STACKSIZE,
+						  NULL,
+						  0)) != OS_NO_ERR) {
+			printf("PH_init: error %d during OSTaskCreateExt() execution\n", err);
+			return(PH_ERROR);
 		}
     }
 	return(PH_OK);
@@ -31,6 +31,40 @@
  * a super-cycle. Parameter NUM_OF_CYCLES specifies how many
  * super-cycles are executed in order to test the system.
  *
+ * When ENABLE_LATENCY_TEST is set, two local tasks exchange
+ * LATENCY_ROUNDS messages in a ping-pong and the average round
+ * trip time is printed. The receiving side of the exchange uses
+ * mcapi_wait() and the blocking mcapi_msg_recv(), so the test
+ * shows whether a waiting task is woken by the message or only
+ * with the next OS tick.
+ *
+ * When ENABLE_SCALING_TEST is set (Linux only), 1, 2, ...
+ * SCALING_MAX_PAIRS pairs of local sender and receiver threads
+ * each exchange SCALING_MSGS messages at the same time and the
+ * total message rate is printed for every number of pairs. The
+ * pairs use different endpoints, so the rate should grow with
+ * the number of pairs as long as there are free CPU cores.
+ *
+ * When ENABLE_STRESS_TEST is set (Linux only), STRESS_SENDERS
+ * local sender threads each send STRESS_MSGS numbered messages
+ * to one receive endpoint. The receiving task alternates between
+ * the blocking receive, mcapi_msg_recv_i() with mcapi_wait(), two
+ * outstanding receive requests waited for in reverse order and a
+ * receive request that is cancelled right away. It checks that
+ * the messages of every sender arrive complete and in order and
+ * prints the number of messages, cancelled requests and errors.
+ *
+ * When ENABLE_THROUGHPUT_TEST is set (Linux only), node1 and node2
+ * each send THROUGHPUT_MSGS messages of THROUGHPUT_MSG_SIZE bytes
+ * to the other node, which answers the last message. The sender
+ * prints the bytes per second and the CPU time of the process per
+ * message, so the cost of the NS layer send path for large
+ * messages can be compared. The test has to be enabled on both
+ * nodes. With THROUGHPUT_FLUSH_US > 0 the NS layer coalesces the
+ * messages to the other node (e. g. THROUGHPUT_MSG_SIZE 16 and
+ * THROUGHPUT_FLUSH_US 200), the answer is sent at once by a
+ * latency critical endpoint.
+ *
  * Main function will initialize the system and
  * start the multitasking operating system.
  * Program is used to test MCAPI operation when messages
@@ -51,6 +85,11 @@
  * 2014-06-05: adaptation to Linux - ms
  * 2014-08-05: Additional support of uC/OS-II - ms
  * 2014-08-11: mcapi_env.h included via mcapi.h - ms
+ * 2026-10-19: latency test (ENABLE_LATENCY_TEST)
+ * 2026-10-19: scaling test (ENABLE_SCALING_TEST)
+ * 2026-10-19: receive queue stress test (ENABLE_STRESS_TEST)
+ * 2026-10-19: large message throughput test (ENABLE_THROUGHPUT_TEST)
+ * 2026-10-19: throughput test with coalescing (THROUGHPUT_FLUSH_US)
  *************************************************************/
 
 // Depending on the used operating system and development 
@@ -70,8 +109,10 @@
 	// uClinux specific includes
 	#include <pthread.h>
 	#include <sys/time.h>
+	#include <sys/resource.h>
 	#include "../../MCAPI_Sys/MCAPI_Top/mcapi.h"
 	#include "../../MCAPI_Sys/NS_Layer/mapping.h"
+	#include "../../MCAPI_Sys/NS_Layer/NS_layer.h"
 # endif
 
 // other includes
@@ -87,6 +128,10 @@
 //#define	ENABLE_PATH2	// node1 to node0
 #define	ENABLE_PATH5	// node1 to node2
 #define	ENABLE_PATH6	// node2 to node1
+//#define	ENABLE_LATENCY_TEST	// local ping-pong, round trip time
+//#define	ENABLE_SCALING_TEST	// local sender/receiver pairs, Linux only
+//#define	ENABLE_STRESS_TEST	// local senders to one receiver, Linux only
+//#define	ENABLE_THROUGHPUT_TEST	// large messages to the other node, Linux only
 
 #ifdef UCOSII
 	/* uC/OS-II specific task definitions */
@@ -98,6 +143,8 @@
 	OS_STK	  node1_recvMSG_from_node0_task_stk[TASK_STACKSIZE];
 	OS_STK    node1_sendMSG_to_node2_task_stk[TASK_STACKSIZE];
 	OS_STK	  node1_recvMSG_from_node2_task_stk[TASK_STACKSIZE];
+	OS_STK	  node1_latency_ping_task_stk[TASK_STACKSIZE];
+	OS_STK	  node1_latency_pong_task_stk[TASK_STACKSIZE];
 
 	/* HAVE CARE!
 	 * In the communication layer for each node a node specific
@@ -119,6 +166,8 @@
 	#define	NODE1_RECVMSG_FROM_NODE2_TASK_PRIO	22
 	#define NODE1_SENDMSG_TO_NODE0_TASK_PRIO	23
 	#define NODE1_SENDMSG_TO_NODE2_TASK_PRIO	24
+	#define	NODE1_LATENCY_PONG_TASK_PRIO		25
+	#define	NODE1_LATENCY_PING_TASK_PRIO		26
 #endif
 
 #ifdef LINUX
@@ -127,6 +176,12 @@
 	pthread_t node1_sendMSG_to_node2_thread;
 	pthread_t node1_recvMSG_from_node0_thread;
 	pthread_t node1_recvMSG_from_node2_thread;
+	pthread_t node1_latency_ping_thread;
+	pthread_t node1_latency_pong_thread;
+	pthread_t node1_scaling_thread;
+	pthread_t node1_stress_thread;
+	pthread_t node1_throughput_send_thread;
+	pthread_t node1_throughput_recv_thread;
 	pthread_t init_thread;
 #endif
 
@@ -137,6 +192,12 @@
 	int node1_sendMSG_to_node2_thread_flag = 0;
 	int node1_recvMSG_from_node0_thread_flag = 0;
 	int node1_recvMSG_from_node2_thread_flag = 0;
+	int node1_latency_ping_thread_flag = 0;
+	int node1_latency_pong_thread_flag = 0;
+	int node1_scaling_thread_flag = 0;
+	int node1_stress_thread_flag = 0;
+	int node1_throughput_send_thread_flag = 0;
+	int node1_throughput_recv_thread_flag = 0;
 	int init_thread_flag = 0;
 
 /* Predefined Port ID numbers */
@@ -155,6 +216,20 @@
 #define NODE2_RECVPORT_FROM_NODE0	11
 #define	NODE2_RECVPORT_FROM_NODE1	12
 
+#define	NODE1_LATENCY_PING_PORT		13
+#define	NODE1_LATENCY_PONG_PORT		14
+#define	NODE2_LATENCY_PING_PORT		15
+#define	NODE2_LATENCY_PONG_PORT		16
+
+#define	NODE1_SCALING_PORT			17	// 17 ... 22
+#define	NODE2_SCALING_PORT			23	// 23 ... 28
+
+#define	NODE1_STRESS_PORT			29	// 29 ... 31
+#define	NODE2_STRESS_PORT			32	// 32 ... 34
+
+#define	NODE1_THROUGHPUT_PORT		35	// 35 send, 36 receive
+#define	NODE2_THROUGHPUT_PORT		37	// 37 send, 38 receive
+
 // MCAPI DOMAINS
 #define MY_DOMAIN 0
 
@@ -163,6 +238,16 @@
 #define MSG_SIZE_MAX	64	// maximum message size
 #define ISNONBLOCKING 	0	// if '1' the non-blocking version of MCAPI
 						    // functions will be used
+#define	LATENCY_ROUNDS	1000	// number of ping-pong round trips
+#define	LATENCY_MSG_SIZE	8	// size of the ping and pong messages
+#define	SCALING_MAX_PAIRS	3	// two endpoints per pair
+#define	SCALING_MSGS		10000	// messages per pair
+#define	SCALING_MSG_SIZE	8	// size of the messages
+#define	STRESS_SENDERS		2	// one receive endpoint, a send endpoint per sender
+#define	STRESS_MSGS			20000	// messages per sender
+#define	THROUGHPUT_MSGS		10000	// messages per node
+#define	THROUGHPUT_MSG_SIZE	1024	// size of the messages, MCAPI_MAX_MSG_SIZE
+#define	THROUGHPUT_FLUSH_US	0		// > 0: coalescing, flush latency in us
 
 // endpoint declarations
 mcapi_endpoint_t node0_sendEP_to_node1;
@@ -179,6 +264,15 @@ mcapi_endpoint_t node1_recvEP_from_node2;
 mcapi_endpoint_t node2_recvEP_from_node0;
 mcapi_endpoint_t node2_recvEP_from_node1;
 
+mcapi_endpoint_t node1_latencyEP_ping;
+mcapi_endpoint_t node1_latencyEP_pong;
+
+mcapi_endpoint_t node1_scalingEP[2 * SCALING_MAX_PAIRS];	// send, receive, send, ...
+
+mcapi_endpoint_t node1_stressEP[STRESS_SENDERS + 1];	// receive, send, send, ...
+
+mcapi_endpoint_t node1_throughputEP[2];	// send, receive
+
 mcapi_priority_t prio;
 
 /**************************************************************
@@ -531,6 +625,457 @@ void node1_sendMSG_to_node2_task(void* pdata)
 #endif
 }
 
+/**************************************************************
+ * task: node1_latency_pong_task()
+ * Answers every message of node1_latency_ping_task(). Waits
+ * with the blocking mcapi_msg_recv().
+ *************************************************************/
+void node1_latency_pong_task(void* pdata)
+{
+	mcapi_status_t status = MCAPI_TRUE;
+	char msg[LATENCY_MSG_SIZE];
+	size_t tSize;
+	int	rounds;
+
+	for(rounds = 0; rounds < LATENCY_ROUNDS; rounds++) {
+		mcapi_msg_recv(node1_latencyEP_pong, msg, LATENCY_MSG_SIZE, &tSize, &status);
+		if(status != MCAPI_SUCCESS) {
+			check_status(status);
+			break;
+		}
+		mcapi_msg_send(node1_latencyEP_pong, node1_latencyEP_ping, msg, tSize, prio, &status);
+		check_status(status);
+	}
+
+	node1_latency_pong_thread_flag = 0;
+
+#ifdef UCOSII
+	/* uC/OS-II specific code to stop this task */
+	while(1) OSTaskSuspend(OS_PRIO_SELF);
+#endif
+
+#ifdef LINUX
+	/* uClinux specific code to stop this task */
+	pthread_exit(NULL);
+#endif
+}
+
+/**************************************************************
+ * task: node1_latency_ping_task()
+ * Sends LATENCY_ROUNDS messages to node1_latency_pong_task()
+ * and waits with mcapi_wait() for every answer. Prints the
+ * average round trip time. A waiting task that is only woken
+ * with the next OS tick needs at least two ticks per round
+ * trip.
+ *************************************************************/
+void node1_latency_ping_task(void* pdata)
+{
+	mcapi_status_t status = MCAPI_TRUE;
+	char msg[LATENCY_MSG_SIZE];
+	size_t tSize;
+	mcapi_request_t r1;
+	unsigned long elapsed;	// us
+	int	rounds;
+#ifdef UCOSII
+	INT32U start;
+#endif
+#ifdef LINUX
+	struct timeval start, end;
+#endif
+
+	memset(msg, 0, sizeof(msg));
+
+#ifdef UCOSII
+	start = OSTimeGet();
+#endif
+#ifdef LINUX
+	gettimeofday(&start, NULL);
+#endif
+
+	for(rounds = 0; rounds < LATENCY_ROUNDS; rounds++) {
+		// receive request first, the answer can come before the wait
+		mcapi_msg_recv_i(node1_latencyEP_ping, msg, LATENCY_MSG_SIZE, &r1, &status);
+		mcapi_msg_send(node1_latencyEP_ping, node1_latencyEP_pong, msg, LATENCY_MSG_SIZE, prio, &status);
+		mcapi_wait(&r1, &tSize, MCA_INFINITE, &status);
+		if(status != MCAPI_SUCCESS) {
+			check_status(status);
+			break;
+		}
+	}
+
+#ifdef UCOSII
+	elapsed = (unsigned long) ((OSTimeGet() - start) * (1000000 / OS_TICKS_PER_SEC));
+#endif
+#ifdef LINUX
+	gettimeofday(&end, NULL);
+	elapsed = (end.tv_sec - start.tv_sec) * 1000000 + end.tv_usec - start.tv_usec;
+#endif
+	printf("node1_latency_ping_task: %d round trips in %lu us, %lu us per round trip\n",
+			rounds, elapsed, rounds > 0 ? elapsed / rounds : 0);
+	fflush(stdout);
+
+	// delete local endpoints
+	mcapi_endpoint_delete(node1_latencyEP_ping, &status);
+	check_status(status);
+	mcapi_endpoint_delete(node1_latencyEP_pong, &status);
+	check_status(status);
+
+	node1_latency_ping_thread_flag = 0;
+
+#ifdef UCOSII
+	/* uC/OS-II specific code to stop this task */
+	while(1) OSTaskSuspend(OS_PRIO_SELF);
+#endif
+
+#ifdef LINUX
+	/* uClinux specific code to stop this task */
+	pthread_exit(NULL);
+#endif
+}
+
+#if defined(ENABLE_SCALING_TEST) && defined(LINUX)
+/**************************************************************
+ * task: node1_scaling_send_task()
+ * Sends SCALING_MSGS messages from the send endpoint of one
+ * pair to its receive endpoint.
+ *************************************************************/
+void node1_scaling_send_task(void* pdata)
+{
+	mcapi_endpoint_t* pair = (mcapi_endpoint_t*) pdata;
+	mcapi_status_t status = MCAPI_TRUE;
+	char msg[SCALING_MSG_SIZE];
+	int	i;
+
+	memset(msg, 0, sizeof(msg));
+	for(i = 0; i < SCALING_MSGS; i++) {
+		mcapi_msg_send(pair[0], pair[1], msg, SCALING_MSG_SIZE, prio, &status);
+		if(status != MCAPI_SUCCESS) {
+			check_status(status);
+			break;
+		}
+	}
+	pthread_exit(NULL);
+}
+
+/**************************************************************
+ * task: node1_scaling_recv_task()
+ * Receives SCALING_MSGS messages on the receive endpoint of
+ * one pair with the blocking mcapi_msg_recv().
+ *************************************************************/
+void node1_scaling_recv_task(void* pdata)
+{
+	mcapi_endpoint_t* pair = (mcapi_endpoint_t*) pdata;
+	mcapi_status_t status = MCAPI_TRUE;
+	char msg[SCALING_MSG_SIZE];
+	size_t tSize;
+	int	i;
+
+	for(i = 0; i < SCALING_MSGS; i++) {
+		mcapi_msg_recv(pair[1], msg, SCALING_MSG_SIZE, &tSize, &status);
+		if(status != MCAPI_SUCCESS) {
+			check_status(status);
+			break;
+		}
+	}
+	pthread_exit(NULL);
+}
+
+/**************************************************************
+ * task: node1_scaling_task()
+ * Runs the pairs of node1_scaling_send_task() and
+ * node1_scaling_recv_task() for 1, 2, ... SCALING_MAX_PAIRS
+ * pairs and prints the total message rate.
+ *************************************************************/
+void node1_scaling_task(void* pdata)
+{
+	mcapi_status_t status = MCAPI_TRUE;
+	pthread_t send_threads[SCALING_MAX_PAIRS];
+	pthread_t recv_threads[SCALING_MAX_PAIRS];
+	struct timeval start, end;
+	unsigned long elapsed;	// us
+	int	pairs, i;
+
+	for(pairs = 1; pairs <= SCALING_MAX_PAIRS; pairs++) {
+		// create the local endpoints of the pairs
+		for(i = 0; i < 2 * pairs; i++) {
+			node1_scalingEP[i] = mcapi_endpoint_create(NODE1_SCALING_PORT + i, &status);
+			check_status(status);
+		}
+
+		gettimeofday(&start, NULL);
+		for(i = 0; i < pairs; i++) {
+			if(pthread_create(&recv_threads[i], NULL, (void*)&node1_scaling_recv_task, &node1_scalingEP[2 * i]) != 0 ||
+			   pthread_create(&send_threads[i], NULL, (void*)&node1_scaling_send_task, &node1_scalingEP[2 * i]) != 0) {
+				printf("node1_scaling_task: Error in pthread_create\n");
+				sys_stop();
+			}
+		}
+		for(i = 0; i < pairs; i++) {
+			pthread_join(send_threads[i], NULL);
+			pthread_join(recv_threads[i], NULL);
+		}
+		gettimeofday(&end, NULL);
+		elapsed = (end.tv_sec - start.tv_sec) * 1000000 + end.tv_usec - start.tv_usec;
+
+		printf("node1_scaling_task: %d pairs, %d messages in %lu us, %.0f messages/s\n",
+				pairs, pairs * SCALING_MSGS, elapsed,
+				elapsed > 0 ? (double) pairs * SCALING_MSGS * 1000000 / elapsed : 0.0);
+		fflush(stdout);
+
+		// delete local endpoints
+		for(i = 0; i < 2 * pairs; i++) {
+			mcapi_endpoint_delete(node1_scalingEP[i], &status);
+			check_status(status);
+		}
+	}
+
+	node1_scaling_thread_flag = 0;
+
+	/* uClinux specific code to stop this task */
+	pthread_exit(NULL);
+}
+#endif // SCALING_TEST
+
+#if defined(ENABLE_STRESS_TEST) && defined(LINUX)
+/**************************************************************
+ * task: node1_stress_send_task()
+ * Sends STRESS_MSGS messages {sender, number} from the send
+ * endpoint of one sender to the receive endpoint.
+ *************************************************************/
+void node1_stress_send_task(void* pdata)
+{
+	uint32_t sender = *(uint32_t*) pdata;
+	mcapi_status_t status = MCAPI_TRUE;
+	uint32_t msg[2];
+	int	i;
+
+	msg[0] = sender;
+	for(i = 0; i < STRESS_MSGS; i++) {
+		msg[1] = i;
+		mcapi_msg_send(node1_stressEP[1 + sender], node1_stressEP[0], msg, sizeof(msg), prio, &status);
+		if(status != MCAPI_SUCCESS) {
+			check_status(status);
+			break;
+		}
+	}
+	pthread_exit(NULL);
+}
+
+/**************************************************************
+ * function: node1_stress_check()
+ * Checks a received message against the next expected number
+ * of its sender. Returns 1 if the message is correct.
+ *************************************************************/
+int node1_stress_check(mcapi_status_t status, uint32_t* msg, size_t size, uint32_t* next)
+{
+	if(status != MCAPI_SUCCESS || size != 2 * sizeof(uint32_t) ||
+	   msg[0] >= STRESS_SENDERS || msg[1] != next[msg[0]]) {
+		printf("node1_stress_task: wrong message, status %i, size %u, sender %u, number %u\n",
+				status, (unsigned) size, msg[0], msg[1]);
+		return 0;
+	}
+	next[msg[0]]++;
+	return 1;
+}
+
+/**************************************************************
+ * task: node1_stress_task()
+ * Starts STRESS_SENDERS node1_stress_send_task() threads and
+ * receives their messages with the blocking and non-blocking
+ * receive functions in turn.
+ *************************************************************/
+void node1_stress_task(void* pdata)
+{
+	mcapi_status_t status = MCAPI_TRUE;
+	pthread_t send_threads[STRESS_SENDERS];
+	uint32_t senders[STRESS_SENDERS];
+	uint32_t next[STRESS_SENDERS];		// next expected number per sender
+	uint32_t msg[2][2];
+	mcapi_request_t request[2];
+	size_t size[2];
+	int	received = 0, cancelled = 0, errors = 0;
+	int	i;
+
+#ifdef ENABLE_SCALING_TEST
+	// the scaling test needs the free endpoints first
+	while(node1_scaling_thread_flag != 0)
+		usleep(100000);
+#endif
+
+	for(i = 0; i < STRESS_SENDERS + 1; i++) {
+		node1_stressEP[i] = mcapi_endpoint_create(NODE1_STRESS_PORT + i, &status);
+		check_status(status);
+	}
+	for(i = 0; i < STRESS_SENDERS; i++) {
+		senders[i] = i;
+		next[i] = 0;
+		if(pthread_create(&send_threads[i], NULL, (void*)&node1_stress_send_task, &senders[i]) != 0) {
+			printf("node1_stress_task: Error in pthread_create\n");
+			sys_stop();
+		}
+	}
+
+	for(i = 0; received < STRESS_SENDERS * STRESS_MSGS; i++) {
+		switch(i % 4) {
+		case 0:	// blocking receive
+			mcapi_msg_recv(node1_stressEP[0], msg[0], sizeof(msg[0]), &size[0], &status);
+			errors += !node1_stress_check(status, msg[0], size[0], next);
+			received++;
+			break;
+		case 1:	// non-blocking receive and wait
+			mcapi_msg_recv_i(node1_stressEP[0], msg[0], sizeof(msg[0]), &request[0], &status);
+			mcapi_wait(&request[0], &size[0], MCA_INFINITE, &status);
+			errors += !node1_stress_check(status, msg[0], size[0], next);
+			received++;
+			break;
+		case 2:	// two non-blocking receives, the second one is waited for first
+			if(received + 2 > STRESS_SENDERS * STRESS_MSGS)
+				break;
+			mcapi_msg_recv_i(node1_stressEP[0], msg[0], sizeof(msg[0]), &request[0], &status);
+			mcapi_msg_recv_i(node1_stressEP[0], msg[1], sizeof(msg[1]), &request[1], &status);
+			mcapi_wait(&request[1], &size[1], MCA_INFINITE, &status);
+			if(status != MCAPI_SUCCESS)
+				errors++;
+			mcapi_wait(&request[0], &size[0], MCA_INFINITE, &status);
+			// the first request gets the older message
+			errors += !node1_stress_check(status, msg[0], size[0], next);
+			errors += !node1_stress_check(MCAPI_SUCCESS, msg[1], size[1], next);
+			received += 2;
+			break;
+		default: // non-blocking receive that is cancelled
+			msg[0][0] = STRESS_SENDERS;	// no sender
+			mcapi_msg_recv_i(node1_stressEP[0], msg[0], sizeof(msg[0]), &request[0], &status);
+			mcapi_cancel(&request[0], &status);
+			if(msg[0][0] == STRESS_SENDERS) {
+				cancelled++;
+				break;
+			}
+			// too late, the request already had its message
+			mcapi_test(&request[0], &size[0], &status);
+			errors += !node1_stress_check(status, msg[0], size[0], next);
+			received++;
+			break;
+		}
+	}
+
+	for(i = 0; i < STRESS_SENDERS; i++) {
+		pthread_join(send_threads[i], NULL);
+	}
+	printf("node1_stress_task: %d messages, %d receive requests cancelled, %d errors\n",
+			received, cancelled, errors);
+	fflush(stdout);
+
+	// delete local endpoints
+	for(i = 0; i < STRESS_SENDERS + 1; i++) {
+		mcapi_endpoint_delete(node1_stressEP[i], &status);
+		check_status(status);
+	}
+
+	node1_stress_thread_flag = 0;
+
+	/* uClinux specific code to stop this task */
+	pthread_exit(NULL);
+}
+#endif // STRESS_TEST
+
+#if defined(ENABLE_THROUGHPUT_TEST) && defined(LINUX)
+/**************************************************************
+ * function: node1_cpu_time()
+ * Returns the user and system CPU time of the process in us.
+ *************************************************************/
+double node1_cpu_time(void)
+{
+	struct rusage usage;
+
+	getrusage(RUSAGE_SELF, &usage);
+	return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000.0 +
+			usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+/**************************************************************
+ * task: node1_throughput_send_task()
+ * Sends THROUGHPUT_MSGS messages to node2, waits for the
+ * answer to the last one and prints bytes per second and CPU
+ * time per message.
+ *************************************************************/
+void node1_throughput_send_task(void* pdata)
+{
+	mcapi_status_t status = MCAPI_TRUE;
+	mcapi_endpoint_t remoteEP;
+	static char msg[THROUGHPUT_MSG_SIZE];
+	uint32_t answer;
+	size_t tSize;
+	struct timeval start, end;
+	unsigned long elapsed;
+	double cpu;
+	int	i;
+
+	remoteEP = mcapi_endpoint_get(MY_DOMAIN, NIOS_2_NODE_ID, NODE2_THROUGHPUT_PORT + 1, MCAPI_TIMEOUT_INFINITE, &status);
+	check_status(status);
+	for(i = 0; i < THROUGHPUT_MSG_SIZE; i++) {
+		msg[i] = i % 256;
+	}
+
+	cpu = node1_cpu_time();
+	gettimeofday(&start, NULL);
+	for(i = 0; i < THROUGHPUT_MSGS; i++) {
+		mcapi_msg_send(node1_throughputEP[0], remoteEP, msg, THROUGHPUT_MSG_SIZE, prio, &status);
+		if(status != MCAPI_SUCCESS) {
+			check_status(status);
+			break;
+		}
+	}
+	mcapi_msg_recv(node1_throughputEP[0], &answer, sizeof(answer), &tSize, &status);
+	check_status(status);
+	gettimeofday(&end, NULL);
+	cpu = node1_cpu_time() - cpu;
+	elapsed = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_usec - start.tv_usec);
+
+	printf("node1_throughput_send_task: %d messages of %d bytes in %lu us, %.0f bytes/s, %.1f us CPU per message\n",
+			i, THROUGHPUT_MSG_SIZE, elapsed,
+			elapsed > 0 ? (double) i * THROUGHPUT_MSG_SIZE * 1000000 / elapsed : 0.0,
+			i > 0 ? cpu / i : 0.0);
+	fflush(stdout);
+
+	node1_throughput_send_thread_flag = 0;
+	pthread_exit(NULL);
+}
+
+/**************************************************************
+ * task: node1_throughput_recv_task()
+ * Receives THROUGHPUT_MSGS messages from node2 and answers
+ * the last one.
+ *************************************************************/
+void node1_throughput_recv_task(void* pdata)
+{
+	mcapi_status_t status = MCAPI_TRUE;
+	mcapi_endpoint_t remoteEP;
+	static char msg[THROUGHPUT_MSG_SIZE];
+	uint32_t answer;
+	size_t tSize;
+	int	i, errors = 0;
+
+	for(i = 0; i < THROUGHPUT_MSGS; i++) {
+		mcapi_msg_recv(node1_throughputEP[1], msg, THROUGHPUT_MSG_SIZE, &tSize, &status);
+		if(status != MCAPI_SUCCESS || tSize != THROUGHPUT_MSG_SIZE ||
+		   msg[THROUGHPUT_MSG_SIZE - 1] != (char) ((THROUGHPUT_MSG_SIZE - 1) % 256)) {
+			errors++;
+		}
+	}
+
+	answer = errors;
+	remoteEP = mcapi_endpoint_get(MY_DOMAIN, NIOS_2_NODE_ID, NODE2_THROUGHPUT_PORT, MCAPI_TIMEOUT_INFINITE, &status);
+	check_status(status);
+	mcapi_msg_send(node1_throughputEP[1], remoteEP, &answer, sizeof(answer), prio, &status);
+	check_status(status);
+	printf("node1_throughput_recv_task: %d messages received from node2 with %d errors\n", i, errors);
+	fflush(stdout);
+
+	node1_throughput_recv_thread_flag = 0;
+	pthread_exit(NULL);
+}
+#endif // THROUGHPUT_TEST
+
 /**************************************************************
  * task: init_task()
  * Initialization task which initializes MCAPI, creates
@@ -704,11 +1249,117 @@ void init_task(void* pdata)
 	node1_sendMSG_to_node2_thread_flag = 1;	// mark thread as alive
 #endif // PATH5
 
+/* LATENCY test related initialization ***************************/
+#ifdef	ENABLE_LATENCY_TEST
+	// create local endpoints of the ping-pong
+	node1_latencyEP_ping = mcapi_endpoint_create(NODE1_LATENCY_PING_PORT, &status);
+	check_status(status);
+	node1_latencyEP_pong = mcapi_endpoint_create(NODE1_LATENCY_PONG_PORT, &status);
+	check_status(status);
+	printf("init_task:   - Local endpoints of the latency test created\n"); fflush(stdout);
+
+	// create pong and ping task
+	node1_latency_pong_thread_flag = 1;	// mark thread as alive
+	node1_latency_ping_thread_flag = 1;	// mark thread as alive
+#ifdef UCOSII
+	/* uC/OS-II specific code */
+	err = OSTaskCreateExt(node1_latency_pong_task,
+						  NULL,
+						  (void *)&node1_latency_pong_task_stk[TASK_STACKSIZE-1],
+						  NODE1_LATENCY_PONG_TASK_PRIO,
+						  NODE1_LATENCY_PONG_TASK_PRIO,
+						  node1_latency_pong_task_stk,
+						  TASK_STACKSIZE,
+						  NULL,
+						  0);
+	if(err != OS_NO_ERR) {
+		printf("init_task: Error in OSTaskCreateExt(): %i\n",err);
+	}
+	err = OSTaskCreateExt(node1_latency_ping_task,
+						  NULL,
+						  (void *)&node1_latency_ping_task_stk[TASK_STACKSIZE-1],
+						  NODE1_LATENCY_PING_TASK_PRIO,
+						  NODE1_LATENCY_PING_TASK_PRIO,
+						  node1_latency_ping_task_stk,
+						  TASK_STACKSIZE,
+						  NULL,
+						  0);
+	if(err != OS_NO_ERR) {
+		printf("init_task: Error in OSTaskCreateExt(): %i\n",err);
+	}
+#endif // UCOSII
+
+#ifdef LINUX
+	/* uClinux specific code */
+	err = pthread_create(&node1_latency_pong_thread, NULL, (void*)&node1_latency_pong_task, NULL);
+	if(err != 0) {
+		printf("init_task: Error in pthread_create\n");
+	}
+	err = pthread_create(&node1_latency_ping_thread, NULL, (void*)&node1_latency_ping_task, NULL);
+	if(err != 0) {
+		printf("init_task: Error in pthread_create\n");
+	}
+#endif // LINUX
+#endif // LATENCY_TEST
+
+/* SCALING test related initialization ***************************/
+#if defined(ENABLE_SCALING_TEST) && defined(LINUX)
+	node1_scaling_thread_flag = 1;	// mark thread as alive
+	err = pthread_create(&node1_scaling_thread, NULL, (void*)&node1_scaling_task, NULL);
+	if(err != 0) {
+		printf("init_task: Error in pthread_create\n");
+	}
+#endif // SCALING_TEST
+
+/* STRESS test related initialization ****************************/
+#if defined(ENABLE_STRESS_TEST) && defined(LINUX)
+	node1_stress_thread_flag = 1;	// mark thread as alive
+	err = pthread_create(&node1_stress_thread, NULL, (void*)&node1_stress_task, NULL);
+	if(err != 0) {
+		printf("init_task: Error in pthread_create\n");
+	}
+#endif // STRESS_TEST
+
+/* THROUGHPUT test related initialization *************************/
+#if defined(ENABLE_THROUGHPUT_TEST) && defined(LINUX)
+	// create local send and receive endpoint
+	node1_throughputEP[0] = mcapi_endpoint_create(NODE1_THROUGHPUT_PORT, &status);
+	check_status(status);
+	node1_throughputEP[1] = mcapi_endpoint_create(NODE1_THROUGHPUT_PORT + 1, &status);
+	check_status(status);
+	mcapi_boolean_t critical = MCAPI_TRUE;	// the answer is never coalesced
+	mcapi_endpoint_set_attribute(node1_throughputEP[1], MCAPI_ENDP_ATTR_LATENCY_CRITICAL, &critical, sizeof(critical), &status);
+	check_status(status);
+#if THROUGHPUT_FLUSH_US > 0
+	if(NS_setCoalescing(NIOS_2_NODE_ID, THROUGHPUT_FLUSH_US) != NS_OK) {
+		printf("init_task: Error in NS_setCoalescing\n");
+	}
+#endif
+	printf("init_task:   - Local endpoints of the throughput test created\n"); fflush(stdout);
+
+	node1_throughput_recv_thread_flag = 1;	// mark thread as alive
+	node1_throughput_send_thread_flag = 1;	// mark thread as alive
+	err = pthread_create(&node1_throughput_recv_thread, NULL, (void*)&node1_throughput_recv_task, NULL);
+	if(err != 0) {
+		printf("init_task: Error in pthread_create\n");
+	}
+	err = pthread_create(&node1_throughput_send_thread, NULL, (void*)&node1_throughput_send_task, NULL);
+	if(err != 0) {
+		printf("init_task: Error in pthread_create\n");
+	}
+#endif // THROUGHPUT_TEST
+
 	// wait till the created threads have been finished.
 	while((node1_sendMSG_to_node0_thread_flag +
 		   node1_sendMSG_to_node2_thread_flag +
 		   node1_recvMSG_from_node0_thread_flag +
-		   node1_recvMSG_from_node2_thread_flag) != 0)
+		   node1_recvMSG_from_node2_thread_flag +
+		   node1_latency_ping_thread_flag +
+		   node1_latency_pong_thread_flag +
+		   node1_scaling_thread_flag +
+		   node1_stress_thread_flag +
+		   node1_throughput_send_thread_flag +
+		   node1_throughput_recv_thread_flag) != 0)
 		usleep(1000000);
 
 	// finalize MCAPI system
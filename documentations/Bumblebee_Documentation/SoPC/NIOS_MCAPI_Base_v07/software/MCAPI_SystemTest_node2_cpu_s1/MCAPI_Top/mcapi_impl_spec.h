@@ -64,6 +64,11 @@ extern "C" {
 #define MCAPI_MAX_STATUS_MSG_LEN 32
 #endif
 
+/* implementation specific endpoint attribute (mcapi_boolean_t), set on a
+   local send endpoint: its messages, packets and scalars are sent at once
+   and never coalesced with other packets to the same node */
+#define MCAPI_ENDP_ATTR_LATENCY_CRITICAL 0x100
+
 /******************************************************************
           a few convenience functions (not part of API) 
 ******************************************************************/
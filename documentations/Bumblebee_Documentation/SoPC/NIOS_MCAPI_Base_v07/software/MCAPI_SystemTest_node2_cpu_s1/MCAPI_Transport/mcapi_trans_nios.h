@@ -42,6 +42,19 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  2014-09-30: Changes in buffer_entry structure because of compiler
              dependent buggy pointer arithmetics in function
              mcapi_trans_pktchan_free() - ms
+ 2026-10-19: completion objects of waiting tasks (MCAPI_MAX_WAITERS),
+             referenced by requests and endpoints
+ 2026-10-19: completion object per reserved receive queue entry
+ 2026-10-19: free list and statistics of the buffer pool
+ 2026-10-19: size classes of the buffers (MCAPI_BUFFER_SIZE_x), receive
+             queues only for the local endpoints (MCAPI_MAX_QUEUES), the
+             channel state moved from the queue to the endpoint
+ 2026-10-19: the receive queue is a single producer/single consumer ring
+             of buffer indices, the receive requests that wait for a
+             message are kept apart from it (reserved[])
+ 2026-10-19: cache of the resolved remote endpoint handles
+             (MCAPI_ENDPOINT_CACHE_SIZE)
+ 2026-10-19: endpoint attribute MCAPI_ENDP_ATTR_LATENCY_CRITICAL
 ****************************************************************************/
 
 #ifdef __cplusplus
@@ -74,6 +87,63 @@ extern int mcapi_debug;
 
 #define MCAPI_MAX_REQUESTS MCA_MAX_REQUESTS
 
+/* number of tasks that can block in mcapi_wait(), mcapi_wait_any() or a
+   blocking receive at the same time, further tasks poll */
+#define MCAPI_MAX_WAITERS 8
+
+/* number of request locks, request r is guarded by lock r % MCAPI_REQUEST_LOCKS.
+   Each lock is a semaphore on uC/OS-II (OS_MAX_EVENTS). */
+#ifndef MCAPI_REQUEST_LOCKS
+#define MCAPI_REQUEST_LOCKS MCAPI_MAX_ENDPOINTS
+#endif
+
+/* size classes of the buffer pool: a message gets a buffer of the smallest
+   class that holds it, of a larger class if that one is used up. The sizes
+   have to grow with the class and have to be multiples of 8 bytes, the
+   last class has to hold the largest message or packet. The numbers of
+   buffers have to add up to MCAPI_MAX_BUFFERS. Scalars only use the
+   buffer header, they take a buffer of the smallest class.
+   The last class holds a full receive queue of messages of the largest
+   size, like the pool did before the size classes. With fewer of them a
+   stream of large messages from a remote node runs out of buffers before
+   the receive queue is full, NS_sendDataToRemote_indication() then
+   retries every TIM_DEL1_MS in the receive task of the link. */
+#define MCAPI_BUFFER_CLASSES 4
+#ifndef MCAPI_BUFFER_SIZE_0
+#define MCAPI_BUFFER_SIZE_0 16
+#define MCAPI_BUFFER_SIZE_1 64
+#define MCAPI_BUFFER_SIZE_2 256
+#define MCAPI_BUFFER_SIZE_3 MCAPI_MAX(MCAPI_MAX_PKT_SIZE,MCAPI_MAX_MSG_SIZE)
+#endif
+#ifndef MCAPI_BUFFERS_0
+#define MCAPI_BUFFERS_0 12
+#endif
+#ifndef MCAPI_BUFFERS_1
+#define MCAPI_BUFFERS_1 8
+#endif
+#ifndef MCAPI_BUFFERS_2
+#define MCAPI_BUFFERS_2 6
+#endif
+#ifndef MCAPI_BUFFERS_3
+#define MCAPI_BUFFERS_3 MCAPI_MAX_QUEUE_ELEMENTS
+#endif
+#define MCAPI_BUFFER_DATA_SIZE (MCAPI_BUFFERS_0 * MCAPI_BUFFER_SIZE_0 + \
+                                MCAPI_BUFFERS_1 * MCAPI_BUFFER_SIZE_1 + \
+                                MCAPI_BUFFERS_2 * MCAPI_BUFFER_SIZE_2 + \
+                                MCAPI_BUFFERS_3 * MCAPI_BUFFER_SIZE_3)
+
+/* receive queues, only the endpoints of the local node have one */
+#ifndef MCAPI_MAX_QUEUES
+#define MCAPI_MAX_QUEUES MCAPI_MAX_ENDPOINTS
+#endif
+
+/* entries of the cache of resolved remote endpoint handles, has to be a
+   power of two. An endpoint <domain,node,port> has one entry, a later
+   endpoint with the same entry replaces it. */
+#ifndef MCAPI_ENDPOINT_CACHE_SIZE
+#define MCAPI_ENDPOINT_CACHE_SIZE 16
+#endif
+
 #define mcapi_dprintf mca_dprintf
 
 #define MCAPI_MAX(X,Y) ((X) > (Y) ? (X) : (Y))
@@ -83,18 +153,27 @@ extern int mcapi_debug;
 *******************************************************************/
 
 /* buffer entry is used for msgs, pkts and scalars */
-/* NOTE: if you change the buffer_entry data structure then you also
-   need to update the pointer arithmetic in mcapi_trans_pktchan_free */
+/* NOTE: the data of a packet is passed to mcapi_trans_pktchan_free, it is
+   mapped back to its buffer entry by mcapi_trans_buffer_find */
 
 typedef struct {
-  char buff [MCAPI_MAX(MCAPI_MAX_PKT_SIZE,MCAPI_MAX_MSG_SIZE)]; // the buffer 
-											// is used for both pkts and msgs
+  char* buff; /* data of the size class, used for both pkts and msgs */
   uint32_t magic_num;
   size_t size; /* size (in bytes) of the buffer */
   mcapi_boolean_t in_use;
   uint64_t scalar;
+  int16_t next_free; /* index of the next free buffer, -1 = end of the free list */
+  uint8_t size_class;
 } buffer_entry;
 
+/* free lists of mcapi_db->buffers, guarded by the buffer lock */
+typedef struct {
+  int16_t free_head[MCAPI_BUFFER_CLASSES]; /* first free buffer per class, -1 = none */
+  uint16_t num_used;      /* buffers in use */
+  uint16_t high_water;    /* maximum of num_used */
+  uint32_t num_exhausted; /* failed gets because all buffers were in use */
+} buffer_pool_header;
+
 typedef enum {
   OTHER,
   OPEN_PKTCHAN,
@@ -120,6 +199,7 @@ typedef struct {
   mcapi_endpoint_t handle;
   mca_status_t status;
   mcapi_endpoint_t* ep_endpoint;
+  uint8_t waiter; /* index+1 of the completion object of the waiting task, 0 = none */
 } mcapi_request_data;
 
 typedef struct  {
@@ -137,20 +217,28 @@ typedef struct  {
 
 typedef struct {
   mcapi_request_t request; //angepasst /* holds a reservation for an outstanding receive request */
-  int32_t buff_index; //angepasst    /* the pointer to the actual buffer entry in the buffer pool */
-  mcapi_boolean_t invalid;
+  int32_t buff_index; //angepasst    /* the message handed to the request (index with the valid bit), 0 = none yet */
+  uint8_t waiter;      /* index+1 of the completion object of the task waiting
+                          for the request, 0 = none */
 } buffer_descriptor;
 
-typedef struct {  
-  /* the next 3 data members are only valid for channels */
-  mcapi_endpoint_t send_endpt;
-  mcapi_endpoint_t recv_endpt;
-  uint8_t channel_type;
-
-  uint32_t num_elements;
-  uint16_t head;
-  uint16_t tail;
-  buffer_descriptor elements[MCAPI_MAX_QUEUE_ENTRIES+1];
+/* The messages of an endpoint are kept in a ring of buffer indices (with the
+   valid bit). The ring has one producer, the senders take turns under the
+   endpoint lock, and one consumer, the task that owns the endpoint, which
+   pops without a lock. head is only written by the consumer, tail and the
+   elements only by the producer.
+   Non-blocking receives to an empty ring reserve an entry of reserved[],
+   oldest first. A sender hands its message to the first reservation without
+   one instead of pushing it, so the ring never has holes. reserved[] is
+   changed under the endpoint lock. */
+typedef struct {
+  mcapi_boolean_t in_use;
+  uint32_t head;
+  uint32_t tail;
+  int32_t elements[MCAPI_MAX_QUEUE_ENTRIES];
+  uint16_t num_reserved;    /* receive requests waiting for a message */
+  uint16_t num_bound;       /* the first num_bound of them have their message */
+  buffer_descriptor reserved[MCAPI_MAX_QUEUE_ELEMENTS];
 }queue;
 
 typedef struct {
@@ -161,7 +249,13 @@ typedef struct {
   mcapi_boolean_t connected;
   uint32_t num_attributes;
   mcapi_endpt_attributes_t attributes; // angepasst
-  queue recv_queue;
+  mcapi_boolean_t latency_critical; /* MCAPI_ENDP_ATTR_LATENCY_CRITICAL */
+  /* the next 3 data members are only valid for channels */
+  mcapi_endpoint_t send_endpt;
+  mcapi_endpoint_t recv_endpt;
+  uint8_t channel_type;
+  queue* recv_queue; /* taken from mcapi_db->queues for local endpoints, NULL otherwise */
+  uint8_t waiter; /* index+1 of the completion object of a blocking receive, 0 = none */
 } endpoint_entry;
 
 typedef struct {
@@ -180,6 +274,16 @@ typedef struct {
   //pthread_t tid;
 } node_entry;
 
+/* handle of a remote endpoint, resolved by mcapi_trans_endpoint_get_i() or
+   learned from a message of the endpoint */
+typedef struct {
+  mcapi_boolean_t valid;
+  mca_domain_t domain_id;
+  uint32_t node_num;
+  uint32_t port_num;
+  mcapi_endpoint_t handle;
+} endpoint_cache_entry;
+
 typedef struct {
   uint16_t num_nodes;
   mca_domain_t domain_id;
@@ -190,10 +294,14 @@ typedef struct {
 typedef struct {
   domain_entry domains[MCA_MAX_DOMAINS];
   buffer_entry buffers[MCAPI_MAX_BUFFERS];
+  uint64_t buffer_data[MCAPI_BUFFER_DATA_SIZE / sizeof(uint64_t)]; /* data of all size classes */
+  buffer_pool_header buffer_pool;
+  queue queues[MCAPI_MAX_QUEUES];
   mcapi_request_data requests[MCAPI_MAX_REQUESTS];
   // global header and array that we keep all requests
   indexed_array_node request_reserves[MCAPI_MAX_REQUESTS];
   indexed_array_header request_reserves_header;
+  endpoint_cache_entry endpoint_cache[MCAPI_ENDPOINT_CACHE_SIZE]; /* guarded by the cache lock */
   uint16_t num_domains;
 } mcapi_database;
 
@@ -6,7 +6,7 @@
  * to communicate with other MCAPI nodes using existing
  * physical communication channels between the MCAPI nodes.
  *
- * It provides three different network services. Each service
+ * It provides five different network services. Each service
  * has a different packet format. NS-layer takes the multiplexer
  * and demultiplexer job to send and receive the service
  * specific packets via the PI-layer.
@@ -21,6 +21,20 @@
  *   - 'sendDataToRemote' service implemented with the functions:
  *          NS_sendDataToRemote_request() and
  *          NS_sendDataToRemote_indication()
+ *   - 'sendScalarToRemote' service implemented with the functions:
+ *          NS_sendScalarToRemote_request() and
+ *          NS_sendScalarToRemote_indication()
+ *     Its packets have no NS header but a single header word,
+ *     see NS_SCALAR_FLAG.
+ *   - 'endpointDeleted' service implemented with the functions:
+ *          NS_endpointDeleted_notification() and
+ *          NS_endpointDeleted_indication()
+ *
+ * Data packets and scalars to a node may be coalesced, see
+ * NS_setCoalescing(). They are collected in one PH frame
+ * (NS_PACK_FLAG), which is sent when it is full or when its
+ * first packet has waited for the flush latency of the link.
+ * NS_layer_receive() splits the frame into its packets.
  *
  * Furthermore NS-layer takes the routing job, which means that
  * the logical network address is translated to the physical
@@ -31,6 +45,11 @@
  * has to be used. E. g. if this communication channel is a
  * TCP based channel, than the physical address would be given
  * by TCP channel's socket descriptor.
+ * The interfaces are the links of nios_node_links_db (mapping.h).
+ * NS_initRoutes() computes the link to the next hop for every
+ * node, a packet to another node is forwarded unchanged by
+ * NS_layer_dispatch(), so nodes without a FIFO bridge between
+ * them talk via the nodes in between.
  *
  * EDITION HISTORY:
  * 2013-11-20: getting started - ms (M. Strahnen)
@@ -64,6 +83,43 @@
  *             enabled - ms
  * 2014-10-14: In NS_sendDataToRemote_request(): copy of
  *             payload data only for linux version - ms
+ * 2026-10-19: Variable length arrays replaced by buffers of
+ *             fixed size, the uC/OS-II version of
+ *             NS_sendDataToRemote_request() only builds the
+ *             header on the stack
+ * 2026-10-19: Service 'endpointDeleted' added. Data packets
+ *             carry the port of the send endpoint, the send
+ *             endpoint is added to the endpoint cache of
+ *             MCAPI_trans. Endpoints of incoming data packets
+ *             are read with 32 bit.
+ * 2026-10-19: Linux/FIFO: NS_sendDataToRemote_request()
+ *             sends header and payload with writev(), the
+ *             payload is not copied any more
+ * 2026-10-19: callIDs are allocated from a bitmap, the
+ *             serviceRequest[] elements from a free list. A
+ *             response finds its waiting request via
+ *             callIDslot[] instead of a search.
+ * 2026-10-19: Service 'sendScalarToRemote' added, scalars
+ *             of connected scalar channels are sent with a
+ *             single header word
+ * 2026-10-19: Optional coalescing of data packets and scalars
+ *             per link (NS_setCoalescing(), NS_flushTask()),
+ *             not for latency critical send endpoints
+ * 2026-10-19: Table driven routing: routes are computed from
+ *             nios_node_links_db, packets to other nodes are
+ *             forwarded. The NS header carries the destination
+ *             node (dstNode). getIndex() and NS_receiveTask0/1()
+ *             replaced by link numbers and NS_receiveTask(),
+ *             one thread per link. Coalescing is done per link.
+ * 2026-10-19: Linux/FIFO: header and payload are copied into
+ *             one buffer again and sent with one write(), the
+ *             FIFO driver sent the iovecs of writev() as two
+ *             packets
+ * 2026-10-19: uC/OS-II: the flush latency is kept in us, the
+ *             time within a tick is read from the system timer.
+ *             NS_packAdd() sends a frame that is due before it
+ *             adds the next packet, NS_flushTask() only sends
+ *             the frames no further packet comes for.
  *************************************************************/
 
 #include "../MCAPI_Top/mcapi_env.h"
@@ -75,6 +131,8 @@
 	#include <signal.h>
 	#include <fcntl.h>	// O_RDWR
 	#include <unistd.h>	// sleep()
+	#include <string.h>	// memcpy()
+	#include <time.h>	// clock_gettime()
 	#include "../MCAPI_Transport/mcapi_trans_nios.h"
 	#include "../MCAPI_Transport/mcapi_trans.h"
 	#include "../PH_FifoDriver_UCOSII/PH_layer.h"
@@ -86,6 +144,8 @@
 	#include "../MCAPI_Transport/mcapi_trans.h"
 	#include "../PH_FifoDriver_UCOSII/PH_layer.h"
 	#include "includes.h"
+	#include "altera_avalon_timer_regs.h"
+	#include <string.h>	// memcpy()
 #endif
 
 #include "globals.h"
@@ -107,12 +167,16 @@ extern uint32_t	my_node_id;		// this node's ID
 // Threads, etc
 
 #ifdef LINUX
-	pthread_t thread0, thread1; // receive threads
-	int filedescriptor[2];
+	pthread_t receiveThread[MAX_LINKS_PER_NODE]; // receive threads, one per link
+	int numReceiveThreads = 0;					 // receive threads created
+	int filedescriptor[MAX_LINKS_PER_NODE];		 // FIFO driver of each link
 #endif
 
-#define BASE_ADDRESS_FIFO_0 0x04000000
-#define BASE_ADDRESS_FIFO_1 0x04000400
+/************************************************************/
+// Routing: link of this node to the next hop on the way to a
+// node, -1 if the node is not reachable or is this node.
+// Computed by NS_initRoutes() from nios_node_links_db.
+int8_t routeLink[NUM_OF_NODES];
 
 /************************************************************/
 // ID numbers for NS service related packets:
@@ -121,6 +185,41 @@ extern uint32_t	my_node_id;		// this node's ID
 #define	ENDPOINT_CHANNEL_ISOPEN_REQUEST		20
 #define	ENDPOINT_CHANNEL_ISOPEN_RESPONSE	21
 #define SEND_DATA_TO_REMOTE_REQUEST			30
+#define ENDPOINT_DELETED_NOTIFICATION		40
+
+// NS header: source domain ID (32 bit), source node ID (16 bit),
+// destination node ID (16 bit), service ID (16 bit), callID (16 bit)
+#define NS_HEADER_SIZE						12
+
+// Sizes of the NS request packets. All packet buffers have a
+// fixed size, so the stack usage of the NS layer is bounded.
+#define GET_REMOTE_ENDPOINT_REQUEST_SIZE	24
+#define ENDPOINT_CHANNEL_ISOPEN_REQUEST_SIZE 16
+#define SEND_DATA_TO_REMOTE_HEADER_SIZE		28
+#define ENDPOINT_DELETED_NOTIFICATION_SIZE	24
+
+// A scalar of a connected scalar channel is sent with one
+// header word instead of the NS header, followed by the scalar:
+//   bit 31      NS_SCALAR_FLAG, the first word of every other
+//               packet is the source domain ID, which is smaller
+//   bits 30..28 size of the scalar in bytes - 1
+//   bits 27..24 sequence number per channel
+//   bits 23..0  receive endpoint handle, it identifies the channel
+#define NS_SCALAR_FLAG				0x80000000
+#define NS_SCALAR_SIZE_SHIFT		28
+#define NS_SCALAR_SEQ_SHIFT			24
+#define NS_SCALAR_SEQ_MASK			0xF
+#define NS_SCALAR_CHANNEL_MASK		0x00FFFFFF
+#define NS_SCALAR_HEADER_SIZE		4
+
+// Several data packets and scalars to the same node may be sent
+// in one coalesced frame. Its first word is NS_PACK_FLAG, then
+// every packet follows as its length word and the packet, padded
+// to whole words. Bit 31 is clear, so the frame is not taken
+// for a scalar.
+#define NS_PACK_FLAG				0x40000000
+#define NS_PACK_HEADER_SIZE			4
+#define NS_PACK_ALIGN(size)			(((size) + 3) & ~3)
 
 // NS layer may return following error/status codes:
 #define NS_OK				 		  0	// no error, everything works fine
@@ -136,6 +235,7 @@ extern uint32_t	my_node_id;		// this node's ID
 typedef struct {
 	uint32_t	srcDomain;
 	uint32_t	srcNode;
+	uint32_t	dstNode;
     uint16_t	NS_serviceID;
     uint16_t	callID;
     uint32_t	payloadLength;
@@ -151,6 +251,7 @@ typedef struct {
 typedef struct {
 	uint32_t	srcDomain;
 	uint32_t	srcNode;
+	uint32_t	dstNode;
     uint16_t	NS_serviceID;
     uint16_t	callID;
     uint32_t	payloadLength;
@@ -201,11 +302,77 @@ wServiceDescriptor serviceRequest[MAX_NS_SERVICE_REQUESTS];
 // callID parameter. Before sending a request we have to
 // acquire a unique callID number. The instance responding
 // to a request will include callID in it's response.
+// A callID is a bit in callIDmap, the first free bit from
+// nextCallID on is taken, so a callID is not reused at once.
 #define MAX_CALLIDS 16		// maximum number of outstanding calls
-#define MAX_CALLID_NUM 32
-uint16_t nextCallID = 0;	// index of next free callID entry
-int16_t  callIDs[MAX_CALLIDS];	// array of callIDs
-uint16_t callIDcount = 0;	// array entries in use
+#define MAX_CALLID_NUM 32	// callIDs 0 ... MAX_CALLID_NUM-1
+#define CALLID_ALL ((uint32_t) (((uint64_t) 1 << MAX_CALLID_NUM) - 1))
+uint16_t nextCallID = 0;	// first callID to be checked
+uint32_t callIDmap = 0;		// bit n set: callID n is in use
+uint16_t callIDcount = 0;	// callIDs in use
+
+// callIDs have to fit into callIDmap
+typedef char callID_map_size_check[(MAX_CALLID_NUM <= 32) ? 1 : -1];
+
+// serviceRequest[] element waiting for the response to a
+// callID, -1 if nobody waits. Set before the request is sent,
+// so the response can be matched without taking reentMutex.
+int8_t	callIDslot[MAX_CALLID_NUM];
+
+// sequence numbers of the scalar channels, indexed by the
+// send resp. receive endpoint index. The channels are reliable,
+// a gap is reported only.
+uint8_t	scalarSendSeq[MCAPI_MAX_ENDPOINTS];
+uint8_t	scalarRecvSeq[MCAPI_MAX_ENDPOINTS];
+
+// free serviceRequest[] elements, linked by their index
+int8_t	serviceRequestNext[MAX_NS_SERVICE_REQUESTS];
+int8_t	serviceRequestFree = -1;	// first free element, -1: none
+
+/************************************************************/
+// Coalescing: one frame per link collects the data
+// packets and scalars until it is full or its first packet has
+// waited flushTime. Requests, responses and the packets of latency
+// critical endpoints are sent at once, the frame of their link is
+// sent before them, so the order per link is kept.
+typedef struct {
+	uint32_t flushTime;		// flush latency in us, 0: coalescing disabled
+	uint32_t firstTime;		// NS_packTime() the first packet was added
+	uint32_t length;		// bytes in frame, 0: frame is empty
+	uint32_t count;			// packets in frame
+	uint8_t  frame[MAX_NS_PACK_SIZE] __attribute__ ((aligned (4)));
+} NS_packLink;
+
+NS_packLink packLink[MAX_LINKS_PER_NODE];
+
+// packLock guards packLink[], it is taken before the PH layer
+// sends. packPending wakes NS_flushTask() when a frame gets
+// its first packet.
+#ifdef UCOSII
+	OS_EVENT	*packLock;
+	OS_EVENT	*packPending;
+	#define	NS_FLUSH_TASK_PRIORITY		19	// above the user tasks, below
+											// the PH receive tasks
+	#define	NS_FLUSH_TASK_STACKSIZE		1024
+	OS_STK	NS_flushTask_stk[NS_FLUSH_TASK_STACKSIZE];
+
+	// The system timer (ALT_SYS_CLK) counts down from its load
+	// value to 0 once per tick, NS_packTime() reads it for the
+	// time within the tick.
+	#define	NS_SYSCLK_(clk, reg)	clk ## reg
+	#define	NS_SYSCLK(clk, reg)		NS_SYSCLK_(clk, reg)
+	#define	NS_SYSCLK_BASE			NS_SYSCLK(ALT_SYS_CLK, _BASE)
+	#define	NS_SYSCLK_LOAD			NS_SYSCLK(ALT_SYS_CLK, _LOAD_VALUE)
+	#define	NS_SYSCLK_PER_US		(NS_SYSCLK(ALT_SYS_CLK, _FREQ) / 1000000)
+	#define	NS_TICK_US				((NS_SYSCLK_LOAD + 1) / NS_SYSCLK_PER_US)
+#endif
+
+#ifdef LINUX
+	pthread_mutex_t packLock;
+	pthread_cond_t	packPending;
+	pthread_t		flushThread;
+	uint8_t			packExit = 0;	// NS_flushTask() has to end
+#endif
 
 /************************************************************/
 // Mutex reentMutex is used to ensure reentrancy of some
@@ -223,48 +390,183 @@ uint16_t callIDcount = 0;	// array entries in use
 // necessary function prototypes
 int16_t	NS_getCallID(void);
 void	NS_releaseCallID(int16_t id);
-int16_t	NS_get_serviceRequestID();
+int16_t	NS_get_serviceRequestID(int16_t callID);
+void	NS_release_serviceRequestID(int16_t id);
 void	NS_unlock_waiting_request(NS_pduA *packet);
+void	NS_layer_dispatch(PH_pdu *data);
+uint8_t	NS_packAdd(int link_num, uint8_t coalesce, uint8_t *header,
+				   uint32_t header_length, const uint8_t *payload,
+				   uint32_t payload_length);
+void	NS_packFlush(int link_num);
 void 	NS_layer_receive(PH_pdu *data);
 
 /**************************************************************
- * FUNCTION: getIndex
+ * FUNCTION: NS_initRoutes()
  *
  * DESCRIPTION:
- * the function helps to find out the right index for filedescriptor
+ * Computes routeLink[] from the links of all nodes in
+ * nios_node_links_db. The nodes are visited breadth first
+ * from this node on, so every node is reached with the least
+ * number of hops. A neighbour is reached via its own link,
+ * every other node via the link of the first hop.
+ *
+ * INPUT PARAMETERS: -
+ *
+ * RETURN VALUE: -
+ *************************************************************/
+void NS_initRoutes(void)
+{
+	uint32_t queue[NUM_OF_NODES];
+	uint32_t head = 0, tail = 0;
+	uint32_t n, l, next;
+
+	for(n = 0; n < NUM_OF_NODES; n++) {
+		routeLink[n] = -1;
+	}
+
+	queue[tail++] = my_node_id;
+	while(head < tail) {
+		n = queue[head++];
+		for(l = 0; l < nios_node_links_db[n].num_links; l++) {
+			next = nios_node_links_db[n].links[l].node;
+			if(next == my_node_id || next >= NUM_OF_NODES || routeLink[next] >= 0) {
+				continue;	// this node, wrong entry or already reached
+			}
+			routeLink[next] = (n == my_node_id) ? l : routeLink[n];
+			queue[tail++] = next;
+		}
+	}
+
+#ifdef NS_DEBUG_ON
+	for(n = 0; n < NUM_OF_NODES; n++) {
+		printf("NS_initRoutes: node %d via link %d\n", n, routeLink[n]);
+	}
+#endif
+}
+
+/**************************************************************
+ * FUNCTION: NS_route()
+ *
+ * DESCRIPTION:
+ * Returns the link of this node to the next hop on the way
+ * to a node.
  *
  * INPUT PARAMETERS:
- * - bridge_base
+ * - node_num: destination node
  *
  * RETURN VALUE:
- * - integer value
+ * - link number or -1 if the node is not reachable
  *************************************************************/
-int getIndex(uint32_t bridge_base)
+int NS_route(uint32_t node_num)
 {
-	switch(bridge_base) {
-		case BASE_ADDRESS_FIFO_0:
-			return(0);
-			break;
-		case BASE_ADDRESS_FIFO_1:
-			return(1);
-			break;
-		default:
-			break;
+	if(node_num >= NUM_OF_NODES) {
+		return(-1);
+	}
+	return(routeLink[node_num]);
+}
+
+/**************************************************************
+ * FUNCTION: NS_linkSend()
+ *
+ * DESCRIPTION:
+ * Sends a packet over a link of this node. The packet is
+ * given as header and payload like for PH_send_request().
+ * On Linux the payload is copied behind the header, because
+ * the FIFO driver and the PH layer of the socket frame every
+ * write as one packet. The FIFO driver has no gather write,
+ * a writev() would send header and payload as two packets.
+ * Linux/FIFO writes the packet to the FIFO driver of the
+ * link, Linux/SOCK has a single link, the socket.
+ *
+ * INPUT PARAMETERS:
+ * - link:           link of this node
+ * - header:         header of the packet
+ * - header_length:  header size in bytes
+ * - payload:        payload of the packet
+ * - payload_length: payload size in bytes
+ *
+ * RETURN VALUE:
+ * - NS_OK      everything works fine
+ * - NS_ERROR   error occured
+ *************************************************************/
+uint8_t NS_linkSend(int link, uint8_t *header, uint32_t header_length,
+					const uint8_t *payload, uint32_t payload_length)
+{
+#ifdef UCOSII
+	if(PH_send_request(nios_node_links_db[my_node_id].links[link].base,
+			(uint32_t *)header, header_length, (uint32_t *)payload, payload_length) != PH_OK) {
+		return(NS_ERROR);
+	}
+#endif
+#ifdef LINUX
+	uint8_t frame[MAX_NS_PACK_SIZE] __attribute__ ((aligned (4)));
+
+	if(payload_length > 0) {
+		assert(header_length + payload_length <= MAX_NS_PACK_SIZE);
+		memcpy(frame, header, header_length);
+		memcpy(&frame[header_length], payload, payload_length);
+		header = frame;
+	}
+#ifdef FIFO
+	if(write(filedescriptor[link], header, header_length + payload_length) != header_length + payload_length) {
+		return(NS_ERROR);
+	}
+#endif // FIFO
+
+#ifdef SOCK
+	if(PH_TCPSock_send(header, header_length + payload_length) != header_length + payload_length) {
+		return(NS_ERROR);
 	}
+#endif // SOCK
+#endif // LINUX
 
-	return(-1);
+	return(NS_OK);
+}
+
+/**************************************************************
+ * FUNCTION: NS_forward()
+ *
+ * DESCRIPTION:
+ * Passes a packet to another node on over the next hop of
+ * its route. The packet is sent unchanged and at once, the
+ * frame of the link is sent before it.
+ *
+ * INPUT PARAMETERS:
+ * - node_num: destination node of the packet
+ * - data:     the packet
+ *
+ * RETURN VALUE: -
+ *************************************************************/
+void NS_forward(uint32_t node_num, PH_pdu *data)
+{
+	int link = NS_route(node_num);
+
+	if(link < 0) {
+		printf("NS_forward: node %d is not reachable\n", node_num);
+		return;
+	}
+
+#ifdef NS_DEBUG_ON
+	printf("NS_forward: packet with %d bytes to node %d via link %d\n", data->length, node_num, link);
+#endif
+
+	NS_packFlush(link);	// coalesced packets go first
+	if(NS_linkSend(link, data->data, data->length, NULL, 0) != NS_OK) {
+		printf("NS_forward: sending data failed\n");
+	}
 }
 
 /**************************************************************
  * FUNCTION: NS_get_serviceRequestID()
  *
  * DESCRIPTION:
- * Utility function which checks if there is a free element in
- * serviceRequest[] array available. If yes, index number of element
- * found will be returned. If not, error code -1 will be
- * returned.
+ * Utility function which takes a free element of the
+ * serviceRequest[] array from the free list. The element will
+ * wait for the response to callID. If an element is available,
+ * its index number will be returned.
  *
- * INPUT PARAMETERS: -
+ * INPUT PARAMETERS:
+ * - callID: callID of the request, see NS_getCallID()
  *
  * RETURN VALUE:
  * - index number of free array entry or one of the
@@ -272,7 +574,7 @@ int getIndex(uint32_t bridge_base)
  *   - NS_NO_FREE_SERVICEREQUEST_ID
  *   - NS_ERROR
  *************************************************************/
-int16_t NS_get_serviceRequestID(void) {
+int16_t NS_get_serviceRequestID(int16_t callID) {
 	int16_t i;
 	uint8_t err;
 
@@ -293,26 +595,16 @@ int16_t NS_get_serviceRequestID(void) {
 	}
 #endif
 
-	// search for next free element
-	for(i = 0; i < MAX_NS_SERVICE_REQUESTS; i++) {
-		if(serviceRequest[i].inuse == 0) {
-			serviceRequest[i].inuse = 1;	// lock element
-			// Release reentMutex
-#ifdef UCOSII
-			if((err = OSMutexPost(reentMutex)) != OS_NO_ERR) {
-				printf("NS_get_serviceRequestID: reentMutex-post error\n");
-				return(NS_ERROR);
-			}
-#endif
-
-#ifdef LINUX
-			if((err = pthread_mutex_unlock(&reentMutex)) != 0) {
-				printf("NS_get_serviceRequestID: reentMutex-post error\n");
-				return(NS_ERROR);
-			}
-#endif
-			return(i);
-		}
+	// take the first free element
+	i = serviceRequestFree;
+	if(i >= 0) {
+		serviceRequestFree = serviceRequestNext[i];
+		serviceRequest[i].inuse = 1;	// lock element
+		serviceRequest[i].callID = (((uint16_t)0x3FFF) & callID);
+		callIDslot[serviceRequest[i].callID] = i;
+	}
+	else {
+		i = NS_NO_FREE_SERVICEREQUEST_ID;	// no free ID available
 	}
 
 	// Release reentMutex
@@ -330,8 +622,59 @@ int16_t NS_get_serviceRequestID(void) {
 	}
 #endif
 
-	return(NS_NO_FREE_SERVICEREQUEST_ID);	// no free ID
-}											// available
+	return(i);
+}
+
+/**************************************************************
+ * FUNCTION: NS_release_serviceRequestID()
+ *
+ * DESCRIPTION:
+ * Gives an element of the serviceRequest[] array back to the
+ * free list, as soon as its response has been handled. Has to
+ * be called before the callID of the element is released.
+ *
+ * INPUT PARAMETERS:
+ * - id: index number of the element
+ *
+ * RETURN VALUE:
+ * - none
+ *************************************************************/
+void NS_release_serviceRequestID(int16_t id) {
+	uint8_t err;
+
+	// Take reentMutex to ensure reentrancy
+#ifdef UCOSII
+	OSMutexPend(reentMutex, 0, &err);
+	if(err != OS_NO_ERR) {
+		printf("NS_release_serviceRequestID: reentMutex-pend error\n");
+		return;
+	}
+#endif
+#ifdef LINUX
+	err = pthread_mutex_lock(&reentMutex);
+	if(err != 0) {
+		printf("NS_release_serviceRequestID: reentMutex-pend error\n");
+		return;
+	}
+#endif
+
+	callIDslot[serviceRequest[id].callID] = -1;	// nobody waits any more
+	serviceRequest[id].inuse = 0;	// free serviceRequest[] element
+	serviceRequestNext[id] = serviceRequestFree;
+	serviceRequestFree = id;
+
+	// Release reentMutex
+#ifdef UCOSII
+	if((err = OSMutexPost(reentMutex)) != OS_NO_ERR) {
+		printf("NS_release_serviceRequestID: reentMutex-post error\n");
+	}
+#endif
+#ifdef LINUX
+	if((err = pthread_mutex_unlock(&reentMutex)) != 0) {
+		printf("NS_release_serviceRequestID: reentMutex-post error\n");
+	}
+#endif
+}
 
 /*************************************************************
  * FUNCTION: NS_getCallID()
@@ -341,6 +684,8 @@ int16_t NS_get_serviceRequestID(void) {
  * outstanding request. Each response message contains the
  * callID of the requesting unit, and by that, the waiting
  * request clearly could be identified.
+ * The first free bit of callIDmap from nextCallID on is
+ * found with one count trailing zeros, there is no search.
  *
  * RETURN VALUE:
  * - 16-bit unique callID number
@@ -349,8 +694,8 @@ int16_t NS_get_serviceRequestID(void) {
  *************************************************************/
 int16_t NS_getCallID(void)
 {
-	uint8_t free = 1;
-	int i = 0;
+	uint32_t free;
+	int16_t callID;
 	uint8_t err;
 
 	// Take reentMutex to ensure reentrancy
@@ -370,70 +715,44 @@ int16_t NS_getCallID(void)
 	}
 #endif
 
-	// nextCallID contains next regular callID number.
-	// But we have to check if this number is still in use.
-	// If true we have to check the next nextCallID.
-	do {	// generate new free call ID number
-		free = 1;
-
-		if (nextCallID > MAX_CALLID_NUM) {	// callIDs should have
-			nextCallID = 0;			// value in range
-		}					// 0 to MAX_CALLID_NUM
-
-		for (i = 0; i < callIDcount; ++i) {
-			if (callIDs[i] == nextCallID) {
-				free = 0;
-			}
-		}
-		++nextCallID;
-	} while(!free);
-
-	// check if there is enough storage capacity for the new call ID
+	// check if there is enough storage capacity for the new call ID,
+	// then at least one bit of callIDmap is free
 	if(callIDcount < MAX_CALLIDS) {
-		callIDs[callIDcount] = nextCallID - 1;	// store call ID number
-		++callIDcount;
-
-		// Release reentMutex
-#ifdef UCOSII
-		if((err = OSMutexPost(reentMutex)) != OS_NO_ERR) {
-			printf("NS_getCallID: reentMutex-post error\n");
-			return(NS_ERROR);
-		}
-#endif
-#ifdef LINUX
-		if((err = pthread_mutex_unlock(&reentMutex)) != 0) {
-			printf("NS_getCallID: reentMutex-post error\n");
-			return(NS_ERROR);
+		// free callIDs from nextCallID on, else from 0 on
+		free = ~callIDmap & CALLID_ALL & (CALLID_ALL << nextCallID);
+		if(free == 0) {
+			free = ~callIDmap & CALLID_ALL;
 		}
-#endif
-		return(nextCallID -1);	// return callID
+		callID = __builtin_ctz(free);
+		callIDmap |= (uint32_t) 1 << callID;	// store call ID number
+		++callIDcount;
+		nextCallID = (callID + 1) % MAX_CALLID_NUM;
 	}
 	else {
-		--nextCallID;	// because the generated call id will not
-				// be used now
+		callID = NS_NO_FREE_CALLID;
+	}
 
-		// Release reentMutex
+	// Release reentMutex
 #ifdef UCOSII
-		if((err = OSMutexPost(reentMutex)) != OS_NO_ERR) {
-			printf("NS_getCallID: reentMutex-post error\n");
-			return(NS_ERROR);
-		}
+	if((err = OSMutexPost(reentMutex)) != OS_NO_ERR) {
+		printf("NS_getCallID: reentMutex-post error\n");
+		return(NS_ERROR);
+	}
 #endif
 #ifdef LINUX
-		if((err = pthread_mutex_unlock(&reentMutex)) != 0) {
-			printf("NS_getCallID: reentMutex-post error\n");
-			return(NS_ERROR);
-		}
-#endif
-		return((int16_t) NS_NO_FREE_CALLID);	// return error code
+	if((err = pthread_mutex_unlock(&reentMutex)) != 0) {
+		printf("NS_getCallID: reentMutex-post error\n");
+		return(NS_ERROR);
 	}
+#endif
+	return(callID);		// return callID or error code
 }
 
 /*************************************************************
  * FUNCTION: NS_releaseCallID()
  *
  * DESCRIPTION:
- * Array callIDs[] stores the callID numbers of any outstanding
+ * Bitmap callIDmap stores the callID numbers of any outstanding
  * requests. As soon as a request has been handled, we have
  * to mark request's callID number as free. This is done in
  * this function:
@@ -447,8 +766,6 @@ int16_t NS_getCallID(void)
 void NS_releaseCallID(int16_t id) {
 	int16_t callID = (0x3FFF & id);	// clear most significant two bits
 					// which represent typeID parameter
-	int	i;
-	int	k;
 	uint8_t err;
 
 	// Take reentMutex to ensure reentrancy
@@ -467,29 +784,9 @@ void NS_releaseCallID(int16_t id) {
 	}
 #endif
 
-	for (i = 0; i < callIDcount; ++i) {
-		if (callID == callIDs[i]) {
-			for(k=i; k < callIDcount - 1; ++k) { // rearrange array
-				callIDs[k] = callIDs[k+1];
-			}
+	if(callID < MAX_CALLID_NUM && (callIDmap & ((uint32_t) 1 << callID))) {
+		callIDmap &= ~((uint32_t) 1 << callID);
 		--callIDcount;
-
-		// Release reentMutex
-#ifdef UCOSII
-		if((err = OSMutexPost(reentMutex)) != OS_NO_ERR) {
-			printf("NS_releaseCallID: reentMutex-post error\n");
-			return;
-		}
-#endif
-#ifdef LINUX
-		if((err = pthread_mutex_unlock(&reentMutex)) != 0) {
-			printf("NS_releaseCallID: reentMutex-post error\n");
-			return;
-		}
-#endif
-
-		return;
-		}
 	}
 
 	// Release reentMutex
@@ -507,113 +804,423 @@ void NS_releaseCallID(int16_t id) {
 #endif
 }
 
-// -------------------------------------- Receive-Threads --------------------------------------
-#ifdef LINUX	// receive threads are only required for Linux
+#ifdef UCOSII
 /*************************************************************
- * TASK: NS_receiveThread0()
+ * FUNCTION: NS_sysclkCount()
  *
  * DESCRIPTION:
- * Have care! Description only concern FIFO com. channel!!!
- * Each FIFO channel has its own FIFO driver, which
- * supports a blocking read operation. Driver's read function
- * will return if physical interface layer (PI-layer) has
- * received a new packet. In order not to block the entire
- * NS layer software we have to spend a receive thread for
- * each FIFO channel.
+ * Returns a snapshot of the down counter of the system timer.
+ *************************************************************/
+static uint32_t NS_sysclkCount(void)
+{
+	IOWR_ALTERA_AVALON_TIMER_SNAPL(NS_SYSCLK_BASE, 0);
+	return((IORD_ALTERA_AVALON_TIMER_SNAPL(NS_SYSCLK_BASE) & ALTERA_AVALON_TIMER_SNAPL_MSK) |
+		   ((IORD_ALTERA_AVALON_TIMER_SNAPH(NS_SYSCLK_BASE) & ALTERA_AVALON_TIMER_SNAPH_MSK) << 16));
+}
+#endif
+
+/*************************************************************
+ * FUNCTION: NS_packTime()
  *
- * INPUT PARAMETERS: -
+ * DESCRIPTION:
+ * Returns the time used for the flush latency of the
+ * coalesced frames in us. It wraps around, only differences
+ * are used. On uC/OS-II it is made of the OS ticks and the
+ * system timer.
+ *************************************************************/
+uint32_t NS_packTime(void)
+{
+#ifdef UCOSII
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+	uint32_t ticks, count;
+
+	// ticks and timer are read together, a tick whose interrupt
+	// is still pending is counted here
+	OS_ENTER_CRITICAL();
+	ticks = OSTimeGet();
+	count = NS_sysclkCount();
+	if(IORD_ALTERA_AVALON_TIMER_STATUS(NS_SYSCLK_BASE) & ALTERA_AVALON_TIMER_STATUS_TO_MSK) {
+		ticks++;
+		count = NS_sysclkCount();	// taken after the reload
+	}
+	OS_EXIT_CRITICAL();
+
+	return(ticks * NS_TICK_US + (NS_SYSCLK_LOAD - count) / NS_SYSCLK_PER_US);
+#endif
+#ifdef LINUX
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return(now.tv_sec * 1000000 + now.tv_nsec / 1000);
+#endif
+}
+
+/*************************************************************
+ * FUNCTION: NS_packLock(), NS_packUnlock()
  *
- * RETURN VALUE: -
+ * DESCRIPTION:
+ * Take and release packLock.
  *************************************************************/
-/* receive thread for FIFO channel 0 */
-void NS_receiveTask0(void *arg)
+void NS_packLock(void)
 {
-	int *filep = (int*) arg;
-	uint32_t length;
-	uint32_t bufferSize = MAX_NS_PACK_SIZE;
-	uint8_t staticBuffer[bufferSize];
+	uint8_t err;
 
-	PH_pdu data;
-	data.bridge_base = BASE_ADDRESS_FIFO_0;	// We have to indicate
-						// the FIFO channel because in some case we
-						// have to send back a response
+#ifdef UCOSII
+	OSSemPend(packLock, 0, &err);
+	if(err != OS_NO_ERR) {
+		printf("NS_packLock: packLock-pend error\n");
+	}
+#endif
+#ifdef LINUX
+	if((err = pthread_mutex_lock(&packLock)) != 0) {
+		printf("NS_packLock: packLock-pend error\n");
+	}
+#endif
+}
 
-	// allow the thread to be cancelled asychonously with pthread_cancel()
-	if(pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL) != 0)
-               printf("NS_receiveTask0: error with pthread_setcancelstate()\n");
-	if(pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS,NULL) != 0)
-               printf("NS_receiveTask0: error with pthread_setcancelstate()\n");
+void NS_packUnlock(void)
+{
+	uint8_t err;
 
-	while(1) {
-#ifdef FIFO
-		length = read(*filep, staticBuffer, bufferSize);
+#ifdef UCOSII
+	if((err = OSSemPost(packLock)) != OS_NO_ERR) {
+		printf("NS_packUnlock: packLock-post error\n");
+	}
 #endif
-#ifdef SOCK
-		if((length = PH_TCPSock_recv(staticBuffer, bufferSize)) <= 0) {
-			printf("NS_receiveTask0: error in socket read/recv function\n"); fflush(stdout);
-		}
+#ifdef LINUX
+	if((err = pthread_mutex_unlock(&packLock)) != 0) {
+		printf("NS_packUnlock: packLock-post error\n");
+	}
 #endif
-		data.length = length;
-		data.data = staticBuffer;
+}
+
+/*************************************************************
+ * FUNCTION: NS_packFlush_have_lock()
+ *
+ * DESCRIPTION:
+ * Sends the coalesced frame of a link, if it holds packets.
+ * A frame with a single packet is sent as that packet. The
+ * caller holds packLock.
+ *
+ * INPUT PARAMETERS:
+ * - link_num: link of this node
+ *
+ * RETURN VALUE:
+ * - none
+ *************************************************************/
+void NS_packFlush_have_lock(int link_num)
+{
+	NS_packLink *link = &packLink[link_num];
+	uint8_t *frame = link->frame;
+	uint32_t length = link->length;
+
+	if(length == 0) {
+		return;
+	}
+
+	if(link->count == 1) {
+		// the packet behind the frame header and its length word
+		length = pack_get_u32(frame, NS_PACK_HEADER_SIZE);
+		frame += NS_PACK_HEADER_SIZE + 4;
+	}
+	else {
+		pack_add_u32(frame, 0, NS_PACK_FLAG);
+	}
 
 #ifdef NS_DEBUG_ON
-		printf("NS_receiveTask0:  Packet with %d bytes received\n", data.length); fflush(stdout);
-	int ii = 0;
-	printf("NS_receiveTask0: ");
-	for(ii = 0; ((ii < data.length) && (ii < 30)); ii++)
-		printf("0x%x, ", staticBuffer[ii]);
-	printf("\n");
+	printf("NS_packFlush_have_lock: %d packets with %d bytes on link %d\n", link->count, length, link_num);
 #endif
-		NS_layer_receive(&data);	// Analyse received packet and do
-									// the requested operations
+
+	if(NS_linkSend(link_num, frame, length, NULL, 0) != NS_OK) {
+		printf("NS_packFlush_have_lock: sending data failed\n");
 	}
 
+	link->length = 0;
+	link->count = 0;
+}
+
+/*************************************************************
+ * FUNCTION: NS_packFlush()
+ *
+ * DESCRIPTION:
+ * Sends the coalesced frame of a link before a packet that
+ * is not coalesced is sent on it, so the packets of a link
+ * keep their order.
+ *
+ * INPUT PARAMETERS:
+ * - link_num: link of this node
+ *
+ * RETURN VALUE:
+ * - none
+ *************************************************************/
+void NS_packFlush(int link_num)
+{
+	// an empty frame needs no lock, packets added concurrently
+	// by other tasks have no order to this one anyway
+	if(packLink[link_num].length == 0) {
+		return;
+	}
+
+	NS_packLock();
+	NS_packFlush_have_lock(link_num);
+	NS_packUnlock();
+}
+
+/*************************************************************
+ * FUNCTION: NS_packAdd()
+ *
+ * DESCRIPTION:
+ * Adds a packet to the coalesced frame of a link. If the
+ * link has no coalescing, the packet must not be coalesced
+ * or it doesn't fit into an empty frame, the frame is sent
+ * and the caller has to send the packet itself.
+ * A frame that is full or has waited for the flush latency is
+ * sent before the packet is added, so while packets keep
+ * coming the flush latency holds without NS_flushTask().
+ * The packet is given as header and payload like for
+ * PH_send_request(), both are copied.
+ *
+ * INPUT PARAMETERS:
+ * - link_num:       link of this node
+ * - coalesce:       0: the packet is sent at once
+ * - header:         header of the packet
+ * - header_length:  header size in bytes
+ * - payload:        payload of the packet
+ * - payload_length: payload size in bytes
+ *
+ * RETURN VALUE:
+ * - 1 the packet has been added, 0 it has to be sent
+ *************************************************************/
+uint8_t NS_packAdd(int link_num, uint8_t coalesce, uint8_t *header,
+				   uint32_t header_length, const uint8_t *payload,
+				   uint32_t payload_length)
+{
+	NS_packLink *link = &packLink[link_num];
+	uint32_t size = header_length + payload_length;
+	uint32_t need = 4 + NS_PACK_ALIGN(size);	// length word and packet
+	uint8_t added = 0;
+
+	// without coalescing nothing is ever added to the frame
+	if(link->flushTime == 0 && link->length == 0) {
+		return(0);
+	}
+
+	NS_packLock();
+	if(coalesce && link->flushTime != 0 && NS_PACK_HEADER_SIZE + need <= MAX_NS_PACK_SIZE) {
+		if(link->length + need > MAX_NS_PACK_SIZE ||
+		   (link->length != 0 && NS_packTime() - link->firstTime >= link->flushTime)) {
+			NS_packFlush_have_lock(link_num);	// frame is full or due
+		}
+		if(link->length == 0) {
+			link->length = NS_PACK_HEADER_SIZE;
+			link->firstTime = NS_packTime();
+#ifdef UCOSII
+			OSSemPost(packPending);
+#endif
+#ifdef LINUX
+			pthread_cond_signal(&packPending);
+#endif
+		}
+		pack_add_u32(link->frame, link->length, size);
+		memcpy(&link->frame[link->length + 4], header, header_length);
+		if(payload_length > 0) {
+			memcpy(&link->frame[link->length + 4 + header_length], payload, payload_length);
+		}
+		link->length += need;
+		link->count++;
+		added = 1;
+	}
+	else {
+		NS_packFlush_have_lock(link_num);
+	}
+	NS_packUnlock();
+
+	return(added);
+}
+
+/*************************************************************
+ * FUNCTION: NS_setCoalescing()
+ *
+ * DESCRIPTION:
+ * Enables or disables the coalescing of the data packets and
+ * scalars on the link to a node, i.e. for all nodes reached
+ * via that link. With coalescing they are collected in one
+ * PH frame, which is sent when it is full (MAX_NS_PACK_SIZE) or
+ * when its first packet has waited flushLatency. Requests,
+ * responses and the packets of send endpoints with attribute
+ * MCAPI_ENDP_ATTR_LATENCY_CRITICAL are never coalesced.
+ * On uC/OS-II a frame no further packet is added to waits for
+ * the next tick at most, see NS_flushTask().
+ *
+ * INPUT PARAMETERS:
+ * - node_num:     destination node
+ * - flushLatency: flush latency in us (e. g. 200),
+ *                 0: coalescing disabled (default)
+ *
+ * RETURN VALUE:
+ * - NS_OK      everything works fine
+ * - NS_ERROR   node is not reachable
+ *************************************************************/
+uint8_t NS_setCoalescing(uint32_t node_num, uint32_t flushLatency)
+{
+	int link = NS_route(node_num);
+
+	if(link < 0) {
+		return(NS_ERROR);
+	}
+
+	NS_packLock();
+	NS_packFlush_have_lock(link);	// collected with the old latency
+	packLink[link].flushTime = flushLatency;
+	NS_packUnlock();
+
+	return(NS_OK);
+}
+
+/*************************************************************
+ * TASK: NS_flushTask()
+ *
+ * DESCRIPTION:
+ * Sends the coalesced frames whose first packet has waited
+ * for the flush latency of its link. The task sleeps while
+ * all frames are empty. On Linux it waits until the first
+ * frame is due. uC/OS-II has no timer below the OS tick, the
+ * task checks the frames every tick. A frame that gets
+ * further packets is sent by NS_packAdd() when it is due, only
+ * the last frame of a burst waits for the tick.
+ *
+ * INPUT PARAMETERS: -
+ *
+ * RETURN VALUE: -
+ *************************************************************/
+void NS_flushTask(void *arg)
+{
+	uint32_t n, now;
+	uint8_t pending;
+#ifdef UCOSII
+	uint8_t err;
+
+	while(1) {
+		// wait until a frame gets its first packet
+		OSSemPend(packPending, 0, &err);
+		do {
+			OSTimeDly(1);
+			pending = 0;
+			NS_packLock();
+			now = NS_packTime();
+			for(n = 0; n < MAX_LINKS_PER_NODE; n++) {
+				if(packLink[n].length == 0) {
+					continue;
+				}
+				if(now - packLink[n].firstTime >= packLink[n].flushTime) {
+					NS_packFlush_have_lock(n);
+				}
+				else {
+					pending = 1;
+				}
+			}
+			NS_packUnlock();
+		} while(pending);
+	}
+#endif
+#ifdef LINUX
+	uint32_t age, wait;
+	struct timespec deadline;
+
+	NS_packLock();
+	while(!packExit) {
+		pending = 0;
+		wait = 0;
+		now = NS_packTime();
+		for(n = 0; n < MAX_LINKS_PER_NODE; n++) {
+			if(packLink[n].length == 0) {
+				continue;
+			}
+			age = now - packLink[n].firstTime;
+			if(age >= packLink[n].flushTime) {
+				NS_packFlush_have_lock(n);
+			}
+			else if(!pending || packLink[n].flushTime - age < wait) {
+				pending = 1;
+				wait = packLink[n].flushTime - age;
+			}
+		}
+
+		if(!pending) {
+			pthread_cond_wait(&packPending, &packLock);
+		}
+		else {
+			clock_gettime(CLOCK_MONOTONIC, &deadline);
+			deadline.tv_nsec += (long) (wait % 1000000) * 1000;
+			deadline.tv_sec += wait / 1000000 + deadline.tv_nsec / 1000000000;
+			deadline.tv_nsec %= 1000000000;
+			pthread_cond_timedwait(&packPending, &packLock, &deadline);
+		}
+	}
+	NS_packUnlock();
+
 	pthread_exit(NULL);
+#endif
 }
 
-/**************************************************************
- * TASK: NS_receiveTask1()
+// -------------------------------------- Receive-Threads --------------------------------------
+#ifdef LINUX	// receive threads are only required for Linux
+/*************************************************************
+ * TASK: NS_receiveTask()
  *
- * receive thread for FIFO channel 1
+ * DESCRIPTION:
+ * Have care! Description only concern FIFO com. channel!!!
+ * Each FIFO channel has its own FIFO driver, which
+ * supports a blocking read operation. Driver's read function
+ * will return if physical interface layer (PI-layer) has
+ * received a new packet. In order not to block the entire
+ * NS layer software we have to spend a receive thread for
+ * each FIFO channel, i.e. for each link of this node.
  * HAVE CARE!
- * Because actually only 1 SOCK-channel is supported, the 
- * therefore required code is disabled in this task. It is 
- * enabled only in NS_receiveTask0() code.
+ * Because actually only 1 SOCK-channel is supported, only
+ * one receive thread reads the socket.
+ *
+ * INPUT PARAMETERS:
+ * - arg: link of this node
+ *
+ * RETURN VALUE: -
  *************************************************************/
-void NS_receiveTask1(void *arg)
+void NS_receiveTask(void *arg)
 {
-	int *filep = (int*) arg;
+	int link = (int) (intptr_t) arg;
 	uint32_t length;
 	uint32_t bufferSize = MAX_NS_PACK_SIZE;
-	uint8_t staticBuffer[bufferSize];
+	uint8_t staticBuffer[MAX_NS_PACK_SIZE];
 
 	PH_pdu data;
-	data.bridge_base = BASE_ADDRESS_FIFO_1;	// We have to indicate
-						// the FIFO channel because in some case we
-						// have to send back a response
+	data.bridge_base = nios_node_links_db[my_node_id].links[link].base;	// We
+						// indicate the FIFO channel the packet was
+						// received from
 
 	// allow the thread to be cancelled asychonously with pthread_cancel()
 	if(pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL) != 0)
-               printf("NS_receiveTask1: error with pthread_setcancelstate()\n");
+               printf("NS_receiveTask%d: error with pthread_setcancelstate()\n", link);
 	if(pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS,NULL) != 0)
-               printf("NS_receiveTask1: error with pthread_setcancelstate()\n");
+               printf("NS_receiveTask%d: error with pthread_setcancelstate()\n", link);
 
 	while(1) {
 #ifdef FIFO
-		length = read(*filep, staticBuffer, bufferSize);
+		length = read(filedescriptor[link], staticBuffer, bufferSize);
 #endif
 #ifdef SOCK
-//		if((length = PH_TCPSock_recv(staticBuffer, bufferSize)) <= 0) {
-//			printf("NS_receiveTask0: error in socket read/recv function\n"); fflush(stdout);
-//		}
+		if((length = PH_TCPSock_recv(staticBuffer, bufferSize)) <= 0) {
+			printf("NS_receiveTask%d: error in socket read/recv function\n", link); fflush(stdout);
+		}
 #endif
 		data.length = length;
 		data.data = staticBuffer;
 
 #ifdef NS_DEBUG_ON
-		printf("NS_receiveTask1:  Packet with %d bytes received\n", data.length); fflush(stdout);
+		printf("NS_receiveTask%d:  Packet with %d bytes received\n", link, data.length); fflush(stdout);
 	int ii = 0;
-	printf("NS_receiveTask1: ");
+	printf("NS_receiveTask%d: ", link);
 	for(ii = 0; ((ii < data.length) && (ii < 30)); ii++)
 		printf("0x%x, ", staticBuffer[ii]);
 	printf("\n");
@@ -647,33 +1254,35 @@ int NS_layer_exit()
 	int	err = NS_OK;
 
 #ifdef LINUX
-	if(pthread_cancel(thread0) != 0) {
-		printf("NS_layer_exit: can't cancel receive thread0\n");
-		err = NS_ERROR;
-	}
+	int n;
 
-#ifdef FIFO	// actually SOCK option supports only one receive thread
-	if(pthread_cancel(thread1) != 0) {
-		printf("NS_layer_exit: can't cancel receive thread1\n");
+	// send the coalesced frames and end NS_flushTask()
+	NS_packLock();
+	for(n = 0; n < MAX_LINKS_PER_NODE; n++) {
+		NS_packFlush_have_lock(n);
+	}
+	packExit = 1;
+	pthread_cond_signal(&packPending);
+	NS_packUnlock();
+	if(pthread_join(flushThread, NULL) != 0) {
+		printf("NS_layer_exit: can't join flush thread\n");
 		err = NS_ERROR;
 	}
-#endif
-
-//	if(pthread_kill(thread1, SIGTERM) != 0) {
-//	if(pthread_cancel(thread1) != 0) {
-//		printf("NS_layer_exit: can't kill receive thread1\n");
-//		err = NS_ERROR;
-//	}
 
-#ifdef FIFO
-	if(close(filedescriptor[0]) != 0) {
-		printf("NS_layer_exit: can't close communication device!\n");
-		err = NS_ERROR;
+	for(n = 0; n < numReceiveThreads; n++) {
+		if(pthread_cancel(receiveThread[n]) != 0) {
+			printf("NS_layer_exit: can't cancel receive thread%d\n", n);
+			err = NS_ERROR;
+		}
 	}
+	numReceiveThreads = 0;
 
-	if(close(filedescriptor[1]) != 0) {
-		printf("NS_layer_exit: can't close communication device!\n");
-		err = NS_ERROR;
+#ifdef FIFO
+	for(n = 0; n < nios_node_links_db[my_node_id].num_links; n++) {
+		if(close(filedescriptor[n]) != 0) {
+			printf("NS_layer_exit: can't close communication device!\n");
+			err = NS_ERROR;
+		}
 	}
 #endif // FIFO
 
@@ -724,6 +1333,8 @@ uint8_t NS_init(uint32_t domain_id, uint32_t node_id)
 		serviceRequest[i].syncResponse.callID = -1;
 		serviceRequest[i].syncResponse.NS_serviceID = -1;
 		serviceRequest[i].syncResponse.payloadLength = 0;
+		serviceRequestNext[i] = serviceRequestFree;	// free list
+		serviceRequestFree = i;
 #ifdef UCOSII
 		sem_serviceRequest[i] = OSSemCreate(0);
 		if(sem_serviceRequest[i] == NULL) {
@@ -742,6 +1353,10 @@ uint8_t NS_init(uint32_t domain_id, uint32_t node_id)
 #endif
 	}
 
+	for(i = 0; i < MAX_CALLID_NUM; i++) {
+		callIDslot[i] = -1;
+	}
+
 #ifdef NS_DEBUG_ON
 	printf("NS_init: serviceRequest structures initialized\n");
 	fflush(stdout);
@@ -768,26 +1383,70 @@ uint8_t NS_init(uint32_t domain_id, uint32_t node_id)
 	fflush(stdout);
 #endif
 
+	NS_initRoutes();
+
+	// no link coalesces before NS_setCoalescing()
+	for(i = 0; i < MAX_LINKS_PER_NODE; i++) {
+		packLink[i].flushTime = 0;
+		packLink[i].length = 0;
+		packLink[i].count = 0;
+	}
+#ifdef UCOSII
+	packLock = OSSemCreate(1);
+	packPending = OSSemCreate(0);
+	if((packLock == NULL) || (packPending == NULL)) {
+		printf("NS_init: error when creating packLock\n");
+		return(NS_ERROR);
+	}
+#endif
+#ifdef LINUX
+	pthread_condattr_t condattr;
+
+	packExit = 0;
+	pthread_condattr_init(&condattr);
+	pthread_condattr_setclock(&condattr, CLOCK_MONOTONIC);
+	if((pthread_mutex_init(&packLock, NULL) != 0) ||
+	   (pthread_cond_init(&packPending, &condattr) != 0)) {
+		printf("NS_init: error when creating packLock\n");
+		return(NS_ERROR);
+	}
+	pthread_condattr_destroy(&condattr);
+#endif
+
 	// initialize lower layer software
 #ifdef UCOSII
 	if(PH_init(my_node_id) != PH_OK) {	// Initialize next (lower) layer
 		printf("NS_init: error on PH_layer initialization\n");
 		return(NS_ERROR);
 	}
-#endif
 
-#ifdef LINUX
-#ifdef FIFO
-	// Open driver device which handles FIFO0 communication channel
-	if((filedescriptor[0] = open("/dev/FifoDriver0", O_RDWR)) == -1) {
-		printf("NS_init: error when opening device /dev/FifoDriver0\n");
+	// task which sends the coalesced frames
+	if((err = OSTaskCreateExt(NS_flushTask,
+					  NULL,
+					  (void *)&NS_flushTask_stk[NS_FLUSH_TASK_STACKSIZE-1],
+					  NS_FLUSH_TASK_PRIORITY,
+					  NS_FLUSH_TASK_PRIORITY,
+					  NS_flushTask_stk,
+					  NS_FLUSH_TASK_STACKSIZE,
+					  NULL,
+					  0)) != OS_NO_ERR) {
+		printf("NS_init: error %d during OSTaskCreateExt() execution\n", err);
 		return(NS_ERROR);
 	}
+#endif
 
-	// Open driver device which handles FIFO1 communication channel
-	if((filedescriptor[1] = open("/dev/FifoDriver1", O_RDWR)) == -1) {
-		printf("NS_init: error when opening device /dev/FifoDriver1\n");
-		return(NS_ERROR);
+#ifdef LINUX
+#ifdef FIFO
+	// Open driver device which handles the FIFO communication
+	// channel of each link, link n is driven by /dev/FifoDriver<n>
+	for(i = 0; i < nios_node_links_db[my_node_id].num_links; i++) {
+		char device[32];
+
+		snprintf(device, sizeof(device), "/dev/FifoDriver%d", i);
+		if((filedescriptor[i] = open(device, O_RDWR)) == -1) {
+			printf("NS_init: error when opening device %s\n", device);
+			return(NS_ERROR);
+		}
 	}
 #endif // FIFO
 
@@ -801,19 +1460,27 @@ uint8_t NS_init(uint32_t domain_id, uint32_t node_id)
 #endif
 
 	// Create one receive thread per FIFO communication channel
-	err = pthread_create(&thread0, NULL, (void *) NS_receiveTask0, &filedescriptor[0]);
-	if(err != 0){
-		printf("NS_init: Pthread_create failed");
-		return(NS_ERROR);
+#ifdef FIFO
+	int links = nios_node_links_db[my_node_id].num_links;
+#endif
+#ifdef SOCK
+	int links = 1;	// actually SOCK option supports only one receive thread
+#endif
+	for(i = 0; i < links; i++) {
+		err = pthread_create(&receiveThread[i], NULL, (void *) NS_receiveTask, (void *) (intptr_t) i);
+		if(err != 0){
+			printf("NS_init: Pthread_create failed");
+			return(NS_ERROR);
+		}
+		numReceiveThreads++;
 	}
 
-#ifdef FIFO	// actually SOCK option supports only one receive thread
-	err = pthread_create(&thread1, NULL, (void *) NS_receiveTask1, &filedescriptor[1]);
+	// thread which sends the coalesced frames
+	err = pthread_create(&flushThread, NULL, (void *) NS_flushTask, NULL);
 	if(err != 0){
 		printf("NS_init: Pthread_create failed");
 		return(NS_ERROR);
 	}
-#endif
 
 #ifdef NS_DEBUG_ON
 	printf("NS_init: receive threads have been created\n");
@@ -848,13 +1515,12 @@ uint8_t NS_getRemoteEndpoint_request(uint32_t *endpoint, uint32_t domain_id, uin
 {
 	uint8_t  err;
 	uint16_t NS_serviceID = GET_REMOTE_ENDPOINT_REQUEST;
-	uint32_t bufferSize = 24; 	// request message size
+	uint32_t bufferSize = GET_REMOTE_ENDPOINT_REQUEST_SIZE; 	// request message size
 	int16_t	 serviceRequestID;
-	uint32_t bridge_base;		// Avalon slave address of dest. FIFO
-	int index;      			// ???
+	int link;					// link to the next hop
 
-	//check if destination node parameters are valid
-	if(!nios_node_mapping_db[my_node_id].destination_nodes[node_num].valid) {
+	// check if destination node is reachable
+	if((link = NS_route(node_num)) < 0) {
 		return(NS_ERROR);
 	}
 
@@ -870,7 +1536,7 @@ uint8_t NS_getRemoteEndpoint_request(uint32_t *endpoint, uint32_t domain_id, uin
 
 	// alignment of msg[] buffer forced because later 4 byte load
 	// and store instructions may be used to copy buffer
-	uint8_t msg[bufferSize] __attribute__ ((aligned (4)));
+	uint8_t msg[GET_REMOTE_ENDPOINT_REQUEST_SIZE] __attribute__ ((aligned (4)));
 
 #ifdef NS_DEBUG_ON
 	printf("NS_getRemoteEndpoint_request: \n"); fflush(stdout);
@@ -880,7 +1546,8 @@ uint8_t NS_getRemoteEndpoint_request(uint32_t *endpoint, uint32_t domain_id, uin
 
 	// Prepare service request packet
 	pack_add_u32(msg,  0, my_domain_id);	// Header: source domain ID
-	pack_add_u32(msg,  4, my_node_id);		// Header: source node ID
+	pack_add_u16(msg,  4, my_node_id);		// Header: source node ID
+	pack_add_u16(msg,  6, node_num);		// Header: destination node ID
 	pack_add_u16(msg,  8, NS_serviceID);	// Header: Service-ID
 	pack_add_u16(msg, 10, callID);			// Header: callID
 	pack_add_u32(msg, 12, domain_id);		// Payload: endpoint's domain number
@@ -889,27 +1556,26 @@ uint8_t NS_getRemoteEndpoint_request(uint32_t *endpoint, uint32_t domain_id, uin
 
 	// Get a service request specification entry where we could
 	// specify that we are waiting for a response.
-	serviceRequestID = NS_get_serviceRequestID();
-	if(serviceRequestID == -1) {
+	serviceRequestID = NS_get_serviceRequestID(callID);
+	if(serviceRequestID < 0) {
 		printf("NS_getRemoteEndpoint_request: no free serviceRequest-structure available\n");
+		NS_releaseCallID(callID);
 		return(NS_ERROR);
 	}
 
 	// Specify our soon waiting request
 	serviceRequest[serviceRequestID].NS_serviceID = NS_serviceID;
-	serviceRequest[serviceRequestID].callID = (((uint16_t)0x3FFF) & callID);
-
-	// Find out the route, i.e. the base address of the FIFO
-	// bridge or the index of the Linux driver module which
-	// is connected to the remote endpoint and send request
-	bridge_base = nios_node_mapping_db[my_node_id].destination_nodes[node_num].base;
-	// find out the right index for filedescriptor
-	index = getIndex(bridge_base);
-//	index = nios_node_mapping_db[my_node_id].destination_nodes[node_num].index;
-	//printf("index: %i ", index);
-#ifdef UCOSII
-	PH_send_request(bridge_base, (uint32_t *)msg, (uint32_t) bufferSize, (uint32_t *)NULL, (uint32_t) 0);
 
+	// Send request over the link to the next hop of the route
+	NS_packFlush(link);		// coalesced packets go first
+	if(NS_linkSend(link, msg, bufferSize, NULL, 0) != NS_OK) {
+		printf("NS_getRemoteEndpoint_request: Error on writing to com. device!\n");
+		NS_release_serviceRequestID(serviceRequestID);	// nobody will answer
+		NS_releaseCallID(callID);
+		return(NS_ERROR);
+	}
+
+#ifdef UCOSII
 	// Wait for the answer from the remote side
 	OSSemPend(serviceRequest[serviceRequestID].semSync, 0, &err);
 	if(err != OS_NO_ERR) {
@@ -918,20 +1584,6 @@ uint8_t NS_getRemoteEndpoint_request(uint32_t *endpoint, uint32_t domain_id, uin
 	}
 #endif
 #ifdef LINUX
-#ifdef FIFO
-	if(write(filedescriptor[index], msg, bufferSize) != bufferSize) {
-		printf("NS_getRemoteEndpoint_request: Error on writing to com. device!\n");
-		return(NS_ERROR);
-	}
-#endif // FIFO
-
-#ifdef SOCK
-	if(PH_TCPSock_send(msg, bufferSize) != bufferSize) {
-		printf("NS_getRemoteEndpoint_request: Error on writing to com. device!\n");
-		return(NS_ERROR);
-	}
-#endif // SOCK
-
 	// Wait for the answer from the remote side
 	err = sem_wait(serviceRequest[serviceRequestID].semSync);
 	if(err != 0) {
@@ -952,7 +1604,7 @@ uint8_t NS_getRemoteEndpoint_request(uint32_t *endpoint, uint32_t domain_id, uin
 	fflush(stdout);
 #endif
 
-	serviceRequest[serviceRequestID].inuse = 0;	// free serviceRequest[] element
+	NS_release_serviceRequestID(serviceRequestID);	// free serviceRequest[] element
 	NS_releaseCallID(callID);
 
 	if(remote_MCAPI_status) return(NS_OK);		// remote node has delivered MCAPI_TRUE
@@ -969,14 +1621,14 @@ uint8_t NS_getRemoteEndpoint_request(uint32_t *endpoint, uint32_t domain_id, uin
  * requested endpoint and will respond the endpoint handle to
  * the requesting node.
  *
+ * The response is routed to the source node of the request.
+ *
  * INPUT PARAMETERS:
- *  bridge_base  - base address of the FIFO we have to use
- *                 to send the response
  *  packet       - pointer to the original request message
  *
  * RETURN VALUE: -
  *************************************************************/
-void NS_getRemoteEndpoint_response(uint32_t bridge_base, NS_pduA *packet)
+void NS_getRemoteEndpoint_response(NS_pduA *packet)
 {
 	uint32_t endpoint = 0;
 
@@ -1005,30 +1657,22 @@ void NS_getRemoteEndpoint_response(uint32_t bridge_base, NS_pduA *packet)
 	uint8_t msg[17] __attribute__ ((aligned (4)));
 
 	pack_add_u32(msg,  0, my_domain_id);							// Header: source domain ID
-	pack_add_u32(msg,  4, my_node_id);								// Header: source node ID
+	pack_add_u16(msg,  4, my_node_id);								// Header: source node ID
+	pack_add_u16(msg,  6, packet->srcNode);							// Header: destination node ID
 	pack_add_u16(msg,  8, (uint16_t) GET_REMOTE_ENDPOINT_RESPONSE);	// Header: Service-ID
 	pack_add_u16(msg, 10, packet->callID);							// Header: callID
 	pack_add_u8(msg, 12, retPtr);									// Payload: local MCAPI return status
 	pack_add_u32(msg,13, endpoint);									// Payload: endpoint handle
 
 	// Send response message
-#ifdef UCOSII
-	 PH_send_request(bridge_base, (uint32_t *)msg, (uint32_t) 17, (uint32_t *)NULL, (uint32_t) 0);
-#endif
-#ifdef LINUX
-	int index = getIndex(bridge_base);
-
-#ifdef FIFO
-	if(write(filedescriptor[index], msg, 17) != 17)
-		printf("NS_getRemoteEndpoint_response: error when sending response\n");
-#endif // FIFO
-
-#ifdef SOCK
-	if(PH_TCPSock_send(msg, 17) != 17)
+	int link = NS_route(packet->srcNode);
+	if(link < 0) {
+		printf("NS_getRemoteEndpoint_response: node %d is not reachable\n", packet->srcNode);
+		return;
+	}
+	NS_packFlush(link);	// coalesced packets go first
+	if(NS_linkSend(link, msg, 17, NULL, 0) != NS_OK)
 		printf("NS_getRemoteEndpoint_response: error when sending response\n");
-#endif // SOCK
-
-#endif // LINUX
 }
 
 /*************************************************************
@@ -1052,14 +1696,14 @@ uint8_t NS_endpointChannelIsopen_request(uint32_t endpoint)
 {
 	uint16_t rd,rn,re;
 	uint8_t err;
-	uint32_t bridge_base;
+	int link;
 	uint16_t NS_serviceID = ENDPOINT_CHANNEL_ISOPEN_REQUEST;
-	uint32_t bufferSize = 16; // buffer size
+	uint32_t bufferSize = ENDPOINT_CHANNEL_ISOPEN_REQUEST_SIZE; // buffer size
 	int16_t	serviceRequestID;
 
 	mcapi_trans_decode_handle(endpoint,&rd,&rn,&re);
-	// check if destination node parameters are valid
-	if(!nios_node_mapping_db[my_node_id].destination_nodes[rn].valid) {
+	// check if destination node is reachable
+	if((link = NS_route(rn)) < 0) {
 		return(NS_ERROR);
 	}
 
@@ -1075,11 +1719,12 @@ uint8_t NS_endpointChannelIsopen_request(uint32_t endpoint)
 
 	// alignment of msg[] buffer forced because later 4 byte load
 	// and store instructions may be used to copy buffer
-	uint8_t msg[bufferSize] __attribute__ ((aligned (4)));
+	uint8_t msg[ENDPOINT_CHANNEL_ISOPEN_REQUEST_SIZE] __attribute__ ((aligned (4)));
 
 	// Now request packet will be built
 	pack_add_u32(msg,  0, my_domain_id);	// Header: source domain ID
-	pack_add_u32(msg,  4, my_node_id);		// Header: source node ID
+	pack_add_u16(msg,  4, my_node_id);		// Header: source node ID
+	pack_add_u16(msg,  6, rn);				// Header: destination node ID
 	pack_add_u16(msg,  8, NS_serviceID);	// Header: Service-ID
 	pack_add_u16(msg, 10, callID);			// Header: callID
 	pack_add_u32(msg, 12, endpoint);		// Payload: endpoint
@@ -1087,22 +1732,25 @@ uint8_t NS_endpointChannelIsopen_request(uint32_t endpoint)
 	// Function we have to wait for will be described
 	// with one of the structures in serviceRequest[].
 	// First get index number of a free serviceRequest[] structure
-	serviceRequestID = NS_get_serviceRequestID();
-	if(serviceRequestID == -1) {
+	serviceRequestID = NS_get_serviceRequestID(callID);
+	if(serviceRequestID < 0) {
 		printf("NS_endpointChannelIsopen_request: no serviceRequestID[] structure available\n");
+		NS_releaseCallID(callID);
 		return(NS_ERROR);
 		}
 	// Specify our soon waiting request
 	serviceRequest[serviceRequestID].NS_serviceID = NS_serviceID;
-	serviceRequest[serviceRequestID].callID = (((uint16_t)0x3FFF) & callID);
 
-	// Find out the route, i.e. the base address of the FIFO bridge
-	bridge_base = nios_node_mapping_db[my_node_id].destination_nodes[rn].base;
+	// Send packet over the link to the next hop of the route
+	NS_packFlush(link);	// coalesced packets go first
+	if(NS_linkSend(link, msg, bufferSize, NULL, 0) != NS_OK) {
+		printf("NS_endpointChannelIsopen_request: error when sending data\n");
+		NS_release_serviceRequestID(serviceRequestID);	// nobody will answer
+		NS_releaseCallID(callID);
+		return(NS_ERROR);
+	}
 
-	// Send packet using PI layer service
 #ifdef UCOSII
-	PH_send_request(bridge_base, (uint32_t *)msg, (uint32_t) bufferSize, (uint32_t *)NULL, (uint32_t) 0);
-
 	// Wait for answer from remote node
 	OSSemPend(serviceRequest[serviceRequestID].semSync, 0, &err);
 	if(err != OS_NO_ERR) {
@@ -1111,22 +1759,6 @@ uint8_t NS_endpointChannelIsopen_request(uint32_t endpoint)
 	}
 #endif
 #ifdef LINUX
-	int index = getIndex(bridge_base);  //find out the right index for filedescriptor
-
-#ifdef FIFO
-	if(write(filedescriptor[index], msg, bufferSize) != bufferSize) {
-		printf("NS_endpointChannelIsopen_request: error when sending data\n");
-		return(NS_ERROR);
-	}
-#endif // FIFO
-
-#ifdef SOCK
-	if(PH_TCPSock_send(msg, bufferSize) != bufferSize) {
-		printf("NS_endpointChannelIsopen_request: error when sending data\n");
-		return(NS_ERROR);
-	}
-#endif // SOCK
-
 	// Wait for answer from remote node
 	err = sem_wait(serviceRequest[serviceRequestID].semSync);
 	if(err != 0) {
@@ -1138,7 +1770,7 @@ uint8_t NS_endpointChannelIsopen_request(uint32_t endpoint)
 	// Get payload part of slave's answer
 	uint8_t remote_MCAPI_status = pack_get_u8(serviceRequest[serviceRequestID].syncResponse.payload,0);
 
-	serviceRequest[serviceRequestID].inuse = 0;	// free serviceRequest[] element
+	NS_release_serviceRequestID(serviceRequestID);	// free serviceRequest[] element
 	NS_releaseCallID(callID);
 
 	if(remote_MCAPI_status) return(NS_OK);		// remote node has delivered MCAPI_TRUE
@@ -1155,14 +1787,14 @@ uint8_t NS_endpointChannelIsopen_request(uint32_t endpoint)
  * is an opened channel with the specified endpoint and will
  * respond the status to the requesting node.
  *
+ * The response is routed to the source node of the request.
+ *
  * INPUT PARAMETERS:
- *  bridge_base  - base address of the FIFO we have to use
- *                 to send the response
  *  packet       - pointer to the original request message
  *
  * RETURN VALUE: -
  *************************************************************/
-void NS_endpointChannelIsopen_response(uint32_t bridge_base, NS_pduA *packet)
+void NS_endpointChannelIsopen_response(NS_pduA *packet)
 {
 	// extract parameters send by remote node
 	uint32_t endpoint = pack_get_u32(packet->payload, 0);
@@ -1180,7 +1812,8 @@ void NS_endpointChannelIsopen_response(uint32_t bridge_base, NS_pduA *packet)
 	uint8_t msg[13] __attribute__ ((aligned (4)));
 
 	pack_add_u32(msg,  0, my_domain_id);							// Header: source domain ID
-	pack_add_u32(msg,  4, my_node_id);								// Header: source node ID
+	pack_add_u16(msg,  4, my_node_id);								// Header: source node ID
+	pack_add_u16(msg,  6, packet->srcNode);							// Header: destination node ID
 	pack_add_u16(msg,  8, (uint16_t) ENDPOINT_CHANNEL_ISOPEN_RESPONSE);	// Header: Service-ID
 	pack_add_u16(msg, 10, packet->callID);							// Header: callID
 	pack_add_u8(msg, 12, retPtr);		      // Payload: local MCAPI return status
@@ -1193,23 +1826,14 @@ void NS_endpointChannelIsopen_response(uint32_t bridge_base, NS_pduA *packet)
 	fflush(stdout);
 #endif
 	// send response message
-#ifdef UCOSII
-	PH_send_request(bridge_base, (uint32_t *)msg, (uint32_t) 13, (uint32_t *)NULL, (uint32_t) 0);
-#endif
-#ifdef LINUX
-	int index = getIndex(bridge_base);
-
-#ifdef FIFO
-	if(write(filedescriptor[index], msg, 13) != 13)
-		printf("NS_endpointChannelIsopen_response: Send Data failed");
-#endif // FIFO
-
-#ifdef SOCK
-	if(PH_TCPSock_send(msg, 13) != 13)
+	int link = NS_route(packet->srcNode);
+	if(link < 0) {
+		printf("NS_endpointChannelIsopen_response: node %d is not reachable\n", packet->srcNode);
+		return;
+	}
+	NS_packFlush(link);	// coalesced packets go first
+	if(NS_linkSend(link, msg, 13, NULL, 0) != NS_OK)
 		printf("NS_endpointChannelIsopen_response: Send Data failed");
-#endif // SOCK
-
-#endif // LINUX
 }
 
 /*************************************************************
@@ -1238,10 +1862,8 @@ uint8_t NS_sendDataToRemote_request(uint32_t send_endpoint,
 					const int8_t* buffer,
 					uint32_t buffer_size)
 {
-	uint32_t bridge_base;
+	int link;
 	uint16_t NS_serviceID = SEND_DATA_TO_REMOTE_REQUEST;
-	uint32_t msgSize = 24 + buffer_size;	// header size + payload size
-	int i;
 
 #ifdef NS_DEBUG_ON
 	printf("NS_sendDataToRemote_request:\n"); fflush(stdout);
@@ -1255,56 +1877,43 @@ uint8_t NS_sendDataToRemote_request(uint32_t send_endpoint,
 	uint16_t rd,rn,re;
 	mcapi_trans_decode_handle(receive_endpoint,&rd,&rn,&re);
 
-	// check if destination node parameters are valid
-	if(!nios_node_mapping_db[my_node_id].destination_nodes[rn].valid) {
+	// check if destination node is reachable
+	if((link = NS_route(rn)) < 0) {
 		return(NS_ERROR);
 	}
 
+	// check if payload does not exceed maximum message size
+	assert(buffer_size <= MAX_MCAPI_MSGPKT_SIZE);
+
 	// alignment of msg[] buffer forced because later 4 byte load
-	// and store instructions may be used to copy buffer
-	uint8_t msg[msgSize] __attribute__ ((aligned (4)));
+	// and store instructions may be used to copy buffer.
+	// The payload is passed on separately (see NS_linkSend()),
+	// so only the header is built here.
+	uint8_t msg[SEND_DATA_TO_REMOTE_HEADER_SIZE] __attribute__ ((aligned (4)));
 
 	// Now request packet will be build
 	pack_add_u32(msg,  0, my_domain_id);	 // Header: source domain ID
-	pack_add_u32(msg,  4, my_node_id);		 // Header: source node ID
+	pack_add_u16(msg,  4, my_node_id);		 // Header: source node ID
+	pack_add_u16(msg,  6, rn);				 // Header: destination node ID
 	pack_add_u16(msg,  8, NS_serviceID);	 // Header: Service-ID
 	pack_add_u16(msg, 10, 0);				 // Header: callID
 
 	pack_add_u32(msg, 12, send_endpoint);	 // Payload: Sending endpoint
 	pack_add_u32(msg, 16, receive_endpoint); // Payload: Receiving endpoint
-	pack_add_u32(msg, 20, buffer_size);		 // Payload: size of payload area
-#ifdef LINUX
-	for(i = 0; i < buffer_size; i++) {		 // Payload: now payload area will be copied
-		msg[24+i] = buffer[i];
-	}
-#endif
-
-	// Find out the route, i.e. the base address of the FIFO bridge
-	bridge_base = nios_node_mapping_db[my_node_id].destination_nodes[rn].base;
-
-	// Send packet using PI layer service
-#ifdef UCOSII
-	PH_send_request(bridge_base, (uint32_t *)msg, 24, (uint32_t *)buffer, (uint32_t) buffer_size);
-#endif
-
-#ifdef LINUX
-	int index = getIndex(bridge_base); //find out the right index for filedescriptor
+	pack_add_u32(msg, 20, mcapi_trans_endpoint_port(send_endpoint)); // Payload: port of sending endpoint
+	pack_add_u32(msg, 24, buffer_size);		 // Payload: size of payload area
 
-#ifdef FIFO
-	if(write(filedescriptor[index], msg, msgSize) != msgSize) {
-		printf("NS_sendDataToRemote_request: sending data failed");
-		return(NS_ERROR);
+	// coalesced with other packets on the link, if enabled
+	if(NS_packAdd(link, !mcapi_trans_endpoint_latency_critical(send_endpoint), msg,
+				  SEND_DATA_TO_REMOTE_HEADER_SIZE, (const uint8_t *) buffer, buffer_size)) {
+		return(NS_OK);
 	}
-#endif // FIFO
 
-#ifdef SOCK
-	if(PH_TCPSock_send(msg, msgSize) != msgSize) {
+	// Send packet over the link to the next hop of the route
+	if(NS_linkSend(link, msg, SEND_DATA_TO_REMOTE_HEADER_SIZE, (const uint8_t *) buffer, buffer_size) != NS_OK) {
 		printf("NS_sendDataToRemote_request: sending data failed");
 		return(NS_ERROR);
 	}
-#endif // SOCK
-
-#endif // LINUX
 	return(NS_OK);	// ret an Okay!
 }
 
@@ -1316,7 +1925,9 @@ uint8_t NS_sendDataToRemote_request(uint32_t send_endpoint,
  * by calling NS_sendDataToRemote_request() this will lead
  * to a call of this function. Function will receive the
  * message and will transfer it to the upper layer
- * software, which is the MCAPI_trans layer.
+ * software, which is the MCAPI_trans layer. The send
+ * endpoint is added to the endpoint cache of MCAPI_trans,
+ * so a later mcapi_endpoint_get() of it needs no request.
  *
  * INPUT PARAMETERS:
  *   - send_endpoint:    source endpoint
@@ -1326,13 +1937,14 @@ uint8_t NS_sendDataToRemote_request(uint32_t send_endpoint,
  *
  * RETURN VALUE: -
  *************************************************************/
-void NS_sendDataToRemote_indication(uint32_t bridge_base, NS_pduA *packet)
+void NS_sendDataToRemote_indication(NS_pduA *packet)
 {
 	// extract parameters send by remote node
-	uint32_t send_endpoint = pack_get_u16(packet->payload, 0);
-	uint32_t receive_endpoint = pack_get_u16(packet->payload, 4);;
-	uint32_t buffer_size = pack_get_u32(packet->payload, 8);
-	uint8_t *buffer = (packet->payload) + 12;
+	uint32_t send_endpoint = pack_get_u32(packet->payload, 0);
+	uint32_t receive_endpoint = pack_get_u32(packet->payload, 4);
+	uint32_t send_port = pack_get_u32(packet->payload, 8);
+	uint32_t buffer_size = pack_get_u32(packet->payload, 12);
+	uint8_t *buffer = (packet->payload) + 16;
 
 #ifdef NS_DEBUG_ON
 	printf("NS_sendDataToRemote_indication: send_endpoint    = 0x%x\n", send_endpoint);
@@ -1351,6 +1963,8 @@ void NS_sendDataToRemote_indication(uint32_t bridge_base, NS_pduA *packet)
 	while(mcapi_trans_initialized() != MCAPI_TRUE)
 		usleep(TIM_DEL1_MS * 1000);	// wait until MCAPI is initialized
 
+	mcapi_trans_endpoint_cache_put(send_endpoint, packet->srcDomain, packet->srcNode, send_port);
+
 	// error return MCAPI_FALSE of mcapi_trans_send() normally indicates that
 	// temporally no receive buffer is available, ie. we have to wait a little
 	// bit and have to try again later.
@@ -1367,6 +1981,212 @@ void NS_sendDataToRemote_indication(uint32_t bridge_base, NS_pduA *packet)
 		usleep(TIM_DEL1_MS * 1000);	// wait for 1 tick
 }
 
+/*************************************************************
+ * FUNCTION: NS_sendScalarToRemote_request()
+ *
+ * DESCRIPTION:
+ * With this function upper layer software, in our case
+ * MCAPI_trans, requests the service 'sendScalarToRemote'.
+ * Function will send a scalar of a connected scalar channel
+ * to its remote receive endpoint. Instead of the NS header
+ * a single header word is sent (see NS_SCALAR_FLAG), so a
+ * scalar needs 3 or 4 FIFO words including the PH length.
+ *
+ * INPUT PARAMETERS:
+ *   - send_endpoint:    send endpoint of the channel
+ *   - receive_endpoint: receive endpoint of the channel
+ *   - scalar:           the scalar
+ *   - size:             size of the scalar in bytes (1 ... 8)
+ *
+ * RETRUN VALUE:
+ * - NS_OK      everything works fine
+ * - NS_ERROR   error occured
+ *************************************************************/
+uint8_t NS_sendScalarToRemote_request(uint32_t send_endpoint,
+					uint32_t receive_endpoint,
+					uint64_t scalar,
+					uint32_t size)
+{
+	int link;
+	uint32_t header;
+
+	// get source and dest. endpoint IDs
+	uint16_t sd,sn,se;
+	uint16_t rd,rn,re;
+	mcapi_trans_decode_handle(send_endpoint,&sd,&sn,&se);
+	mcapi_trans_decode_handle(receive_endpoint,&rd,&rn,&re);
+
+	// check if destination node is reachable
+	if((link = NS_route(rn)) < 0) {
+		return(NS_ERROR);
+	}
+	assert((size >= 1) && (size <= 8));
+	assert((receive_endpoint & ~NS_SCALAR_CHANNEL_MASK) == 0);
+
+	// only the task of the channel sends, scalarSendSeq[se]
+	// needs no lock
+	header = NS_SCALAR_FLAG |
+			 ((size - 1) << NS_SCALAR_SIZE_SHIFT) |
+			 ((scalarSendSeq[se]++ & NS_SCALAR_SEQ_MASK) << NS_SCALAR_SEQ_SHIFT) |
+			 receive_endpoint;
+
+	// the scalar is sent from its first byte on, like the
+	// payload of NS_sendDataToRemote_request()
+	uint8_t msg[NS_SCALAR_HEADER_SIZE] __attribute__ ((aligned (4)));
+	pack_add_u32(msg, 0, header);
+
+	// coalesced with other packets on the link, if enabled
+	if(NS_packAdd(link, !mcapi_trans_endpoint_latency_critical(send_endpoint), msg,
+				  NS_SCALAR_HEADER_SIZE, (const uint8_t *) &scalar, size)) {
+		return(NS_OK);
+	}
+
+	// Send packet over the link to the next hop of the route
+	if(NS_linkSend(link, msg, NS_SCALAR_HEADER_SIZE, (const uint8_t *) &scalar, size) != NS_OK) {
+		printf("NS_sendScalarToRemote_request: sending data failed");
+		return(NS_ERROR);
+	}
+	return(NS_OK);	// ret an Okay!
+}
+
+/*************************************************************
+ * FUNCTION: NS_sendScalarToRemote_indication()
+ *
+ * DESCRIPTION:
+ * If a remote instance has called service 'sendScalarToRemote'
+ * by calling NS_sendScalarToRemote_request() this will lead
+ * to a call of this function. The channel is given by the
+ * header word, the scalar is passed to the receive endpoint
+ * of the channel without the NS service dispatch.
+ *
+ * INPUT PARAMETERS:
+ *  header  - the header word
+ *  scalar  - pointer to the scalar
+ *
+ * RETURN VALUE: -
+ *************************************************************/
+void NS_sendScalarToRemote_indication(uint32_t header, uint8_t *scalar)
+{
+	uint32_t receive_endpoint = header & NS_SCALAR_CHANNEL_MASK;
+	uint32_t size = ((header >> NS_SCALAR_SIZE_SHIFT) & 0x7) + 1;
+	uint8_t seq = (header >> NS_SCALAR_SEQ_SHIFT) & NS_SCALAR_SEQ_MASK;
+	uint16_t rd,rn,re;
+
+	mcapi_trans_decode_handle(receive_endpoint,&rd,&rn,&re);
+	if(re >= MCAPI_MAX_ENDPOINTS) {
+		printf("NS_sendScalarToRemote_indication: unknown channel 0x%x\n", receive_endpoint);
+		return;
+	}
+
+	// only this receive task delivers to the endpoint
+	if(seq != (scalarRecvSeq[re] & NS_SCALAR_SEQ_MASK)) {
+		printf("NS_sendScalarToRemote_indication: channel 0x%x, scalar %d expected, %d received\n",
+				receive_endpoint, scalarRecvSeq[re] & NS_SCALAR_SEQ_MASK, seq);
+	}
+	scalarRecvSeq[re] = seq + 1;
+
+#ifdef NS_DEBUG_ON
+	printf("NS_sendScalarToRemote_indication: receive_endpoint = 0x%x, size = %d, seq = %d\n",
+			receive_endpoint, size, seq);
+#endif
+
+	// If remote node is up before we are up, we have to wait
+	// until MCAPI_Transport layer is fully initialized.
+	while(mcapi_trans_initialized() != MCAPI_TRUE)
+		usleep(TIM_DEL1_MS * 1000);	// wait until MCAPI is initialized
+
+	while(mcapi_trans_sclchan_deliver(receive_endpoint, (const char *) scalar, size) != MCAPI_TRUE)
+		usleep(TIM_DEL1_MS * 1000);	// wait for 1 tick
+}
+
+/*************************************************************
+ * FUNCTION: NS_endpointDeleted_notification()
+ *
+ * DESCRIPTION:
+ * With this function upper layer software, in our case
+ * MCAPI_trans, requests the service 'endpointDeleted'.
+ * Function tells all remote nodes that a local endpoint
+ * was deleted, so they remove it from their endpoint caches.
+ * The service is not confirmed.
+ *
+ * INPUT PARAMETERS:
+ *   - domain_id: domain of the deleted endpoint
+ *   - node_num:  node of the deleted endpoint
+ *   - port_num:  port of the deleted endpoint
+ *
+ * RETRUN VALUE:
+ * - NS_OK      everything works fine
+ * - NS_ERROR   error occured
+ *************************************************************/
+uint8_t NS_endpointDeleted_notification(uint32_t domain_id, uint32_t node_num, uint32_t port_num)
+{
+	uint16_t NS_serviceID = ENDPOINT_DELETED_NOTIFICATION;
+	uint32_t bufferSize = ENDPOINT_DELETED_NOTIFICATION_SIZE; // buffer size
+	uint8_t rc = NS_OK;
+	int n, link;
+
+	// alignment of msg[] buffer forced because later 4 byte load
+	// and store instructions may be used to copy buffer
+	uint8_t msg[ENDPOINT_DELETED_NOTIFICATION_SIZE] __attribute__ ((aligned (4)));
+
+	// Now notification packet will be built
+	pack_add_u32(msg,  0, my_domain_id);	// Header: source domain ID
+	pack_add_u16(msg,  4, my_node_id);		// Header: source node ID
+	pack_add_u16(msg,  8, NS_serviceID);	// Header: Service-ID
+	pack_add_u16(msg, 10, 0);				// Header: callID
+	pack_add_u32(msg, 12, domain_id);		// Payload: domain ID
+	pack_add_u32(msg, 16, node_num);		// Payload: node ID
+	pack_add_u32(msg, 20, port_num);		// Payload: port ID
+
+	// every node reachable from here gets the notification,
+	// the nodes in between forward it
+	for(n = 0; n < NUM_OF_NODES; n++) {
+		if((link = NS_route(n)) < 0) {
+			continue;
+		}
+		pack_add_u16(msg,  6, n);			// Header: destination node ID
+		NS_packFlush(link);	// coalesced packets go first
+		if(NS_linkSend(link, msg, bufferSize, NULL, 0) != NS_OK) {
+			printf("NS_endpointDeleted_notification: error when sending data\n");
+			rc = NS_ERROR;
+		}
+	}
+
+	return(rc);
+}
+
+/*************************************************************
+ * FUNCTION: NS_endpointDeleted_indication()
+ *
+ * DESCRIPTION:
+ * If a remote instance has called service 'endpointDeleted'
+ * by calling NS_endpointDeleted_notification() this will
+ * lead to a call of this function. Function removes the
+ * deleted endpoint from the endpoint cache of MCAPI_trans.
+ *
+ * INPUT PARAMETERS:
+ *  packet       - pointer to the notification
+ *
+ * RETURN VALUE: -
+ *************************************************************/
+void NS_endpointDeleted_indication(NS_pduA *packet)
+{
+	// extract parameters send by remote node
+	uint32_t domain_id = pack_get_u32(packet->payload, 0);
+	uint32_t node_num = pack_get_u32(packet->payload, 4);
+	uint32_t port_num = pack_get_u32(packet->payload, 8);
+
+#ifdef NS_DEBUG_ON
+	printf("NS_endpointDeleted_indication: domain_id = %d, node_num = %d, port_num = %d\n",
+			domain_id, node_num, port_num);
+#endif
+
+	// the cache is cleared by MCAPI_trans initialization
+	if(mcapi_trans_initialized() == MCAPI_TRUE) {
+		mcapi_trans_endpoint_cache_invalidate(domain_id, node_num, port_num);
+	}
+}
+
 /*************************************************************
  * FUNCTION: NS_unlock_waiting_request()
  *
@@ -1383,32 +2203,34 @@ void NS_unlock_waiting_request(NS_pduA *packet)
 {
 	int	i, d;
 	uint8_t err;
+	uint16_t callID = (0x3FFF & packet->callID);
 
-	// Check which function is waiting for this
+	// Find the function which is waiting for this
 	// return, copy payload data to return data structure
 	// post the corresponding semaphore
-	for(i = 0; i < MAX_NS_SERVICE_REQUESTS; i++) {
-		if(serviceRequest[i].callID == packet->callID) {
-			serviceRequest[i].syncResponse.payloadLength = packet->payloadLength;
-			serviceRequest[i].syncResponse.NS_serviceID = packet->NS_serviceID;
+	if(callID >= MAX_CALLID_NUM || (i = callIDslot[callID]) < 0) {
+		printf("NS_unlock_waiting_request: no request waits for callID %d\n", callID);
+		return;
+	}
 
-			for(d = 0; d < packet->payloadLength; d++) {	// copy payload area
-				serviceRequest[i].syncResponse.payload[d] = packet->payload[d];
-			}
+	serviceRequest[i].syncResponse.payloadLength = packet->payloadLength;
+	serviceRequest[i].syncResponse.NS_serviceID = packet->NS_serviceID;
+
+	for(d = 0; d < packet->payloadLength; d++) {	// copy payload area
+		serviceRequest[i].syncResponse.payload[d] = packet->payload[d];
+	}
 #ifdef UCOSII
-			err = OSSemPost(serviceRequest[i].semSync);
-						if(err != OS_NO_ERR) {
-							printf("NS_unlock_waiting_request: Error in OSSemPost: %i\n",err);
-						}
+	err = OSSemPost(serviceRequest[i].semSync);
+	if(err != OS_NO_ERR) {
+		printf("NS_unlock_waiting_request: Error in OSSemPost: %i\n",err);
+	}
 #endif
 #ifdef LINUX
-			err = sem_post(serviceRequest[i].semSync);
-			if(err != 0) {
-				printf("NS_unlock_waiting_request: Error in sem_post(): %i\n",err);
-			}
-#endif
-		}
+	err = sem_post(serviceRequest[i].semSync);
+	if(err != 0) {
+		printf("NS_unlock_waiting_request: Error in sem_post(): %i\n",err);
 	}
+#endif
 }
 
 /*************************************************************
@@ -1416,29 +2238,91 @@ void NS_unlock_waiting_request(NS_pduA *packet)
  *
  * DESCRIPTION:
  * PH layer calls this function in case of a message receipt.
+ * A coalesced frame is split into its packets, every packet
+ * is passed to NS_layer_dispatch().
+ *
+ * INPUT PARAMETERS:
+ *  *  data: pointer to the received frame
+ *
+ * RETURN VALUE:
+ ************************************************************/
+void NS_layer_receive(PH_pdu *data)
+{
+	uint32_t header = pack_get_u32(&(data->data[0]), 0);
+	uint32_t offset, size;
+	PH_pdu packet;
+
+	if((header & (NS_SCALAR_FLAG | NS_PACK_FLAG)) != NS_PACK_FLAG) {
+		NS_layer_dispatch(data);
+		return;
+	}
+
+	// the frame may be padded to whole words by the PH layer
+	packet.bridge_base = data->bridge_base;
+	for(offset = NS_PACK_HEADER_SIZE; offset + 4 <= data->length; offset += 4 + NS_PACK_ALIGN(size)) {
+		size = pack_get_u32(data->data, offset);
+		if(size == 0 || offset + 4 + size > data->length) {
+			printf("NS_layer_receive: coalesced frame with wrong packet size %d\n", size);
+			break;
+		}
+		packet.length = size;
+		packet.data = data->data + offset + 4;
+		NS_layer_dispatch(&packet);
+	}
+}
+
+/*************************************************************
+ * FUNCTION: NS_layer_dispatch()
+ *
+ * DESCRIPTION:
  * Function acts as a service demultiplexer. It will analyze
  * the passed packet and will pass it to corresponding
- * service function.
+ * service function. A packet to another node is forwarded
+ * over the next hop of its route (NS_forward()), the
+ * destination node of a scalar is the node of its receive
+ * endpoint.
  *
  * INPUT PARAMETERS:
- *  *  data: pointer to the response packet
+ *  *  data: pointer to the packet
  *
  * RETURN VALUE:
  ************************************************************/
-void NS_layer_receive(PH_pdu *data)
+void NS_layer_dispatch(PH_pdu *data)
 {
+    // A scalar has a single header word, it goes to its
+    // channel without the service dispatch
+    uint32_t header = pack_get_u32(&(data->data[0]), 0);
+    if(header & NS_SCALAR_FLAG) {
+    	uint16_t rd,rn,re;
+
+    	mcapi_trans_decode_handle(header & NS_SCALAR_CHANNEL_MASK,&rd,&rn,&re);
+    	if(rn != my_node_id) {
+    		NS_forward(rn, data);
+    		return;
+    	}
+    	NS_sendScalarToRemote_indication(header, (data->data) + NS_SCALAR_HEADER_SIZE);
+    	return;
+    }
+
     // Extract NS layer specific parameters
     NS_pduA packet;
-    packet.payloadLength = data->length - 12;
+    packet.payloadLength = data->length - NS_HEADER_SIZE;
 	packet.srcDomain 	= pack_get_u32(&(data->data[0]),  0);
-	packet.srcNode   	= pack_get_u32(&(data->data[0]),  4);
+	packet.srcNode   	= pack_get_u16(&(data->data[0]),  4);
+	packet.dstNode   	= pack_get_u16(&(data->data[0]),  6);
 	packet.NS_serviceID	= pack_get_u16(&(data->data[0]),  8);
 	packet.callID		= pack_get_u16(&(data->data[0]), 10);
-    packet.payload = (data->data) + 12;
+    packet.payload = (data->data) + NS_HEADER_SIZE;
+
+    if(packet.dstNode != my_node_id) {
+    	NS_forward(packet.dstNode, data);
+    	return;
+    }
 
 #ifdef NS_DEBUG_ON
 	printf("NS_layer_receive: srcDomain     = %d\n", packet.srcDomain);
 	printf("                  srcNode       = %d\n", packet.srcNode);
+	printf("                  dstNode       = %d\n", packet.dstNode);
 	printf("                  NS_serviceID  = %d\n", packet.NS_serviceID);
 	printf("                  callID        = %d\n", packet.callID);
 	printf("                  payloadLength = %d\n", packet.payloadLength);
@@ -1448,14 +2332,17 @@ void NS_layer_receive(PH_pdu *data)
     switch(packet.NS_serviceID)
     {
     case SEND_DATA_TO_REMOTE_REQUEST:
-    	NS_sendDataToRemote_indication(data->bridge_base, &packet);
+    	NS_sendDataToRemote_indication(&packet);
 	break;
     case GET_REMOTE_ENDPOINT_REQUEST:
-    	NS_getRemoteEndpoint_response(data->bridge_base, &packet);
+    	NS_getRemoteEndpoint_response(&packet);
     	break;
     case ENDPOINT_CHANNEL_ISOPEN_REQUEST:
-    	NS_endpointChannelIsopen_response(data->bridge_base, &packet);
+    	NS_endpointChannelIsopen_response(&packet);
 	break;
+    case ENDPOINT_DELETED_NOTIFICATION:
+    	NS_endpointDeleted_indication(&packet);
+    	break;
     case GET_REMOTE_ENDPOINT_RESPONSE:
     case ENDPOINT_CHANNEL_ISOPEN_RESPONSE:
 		NS_unlock_waiting_request(&packet);
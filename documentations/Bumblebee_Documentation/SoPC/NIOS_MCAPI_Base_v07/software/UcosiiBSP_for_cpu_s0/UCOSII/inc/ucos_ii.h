@@ -627,6 +627,11 @@ typedef struct os_tcb {
 #endif
 
     INT16U           OSTCBDly;              /* Nbr ticks to delay task or, timeout waiting for event   */
+#if OS_TICK_WHEEL_EN > 0
+    INT32U           OSTCBDlyExpiry;        /* Value of OSTickWheelTime at which the delay expires     */
+    struct os_tcb   *OSTCBDlyNext;          /* Pointer to next     TCB in the same timing wheel slot   */
+    struct os_tcb   *OSTCBDlyPrev;          /* Pointer to previous TCB in the same timing wheel slot   */
+#endif
     INT8U            OSTCBStat;             /* Task      status                                        */
     INT8U            OSTCBStatPend;         /* Task PEND status                                        */
     INT8U            OSTCBPrio;             /* Task priority (0 == highest)                            */
@@ -759,6 +764,11 @@ OS_EXT  OS_TCB            OSTCBTbl[OS_MAX_TASKS + OS_N_SYS_TASKS];   /* Table of
 OS_EXT  INT8U             OSTickStepState;          /* Indicates the state of the tick step feature    */
 #endif
 
+#if OS_TICK_WHEEL_EN > 0
+OS_EXT  OS_TCB           *OSTickWheel[OS_TICK_WHEEL_SIZE];  /* Delayed TCBs, indexed by expiry time    */
+OS_EXT  INT32U            OSTickWheelTime;                  /* Ticks processed by OSTimeTick()         */
+#endif
+
 #if (OS_MEM_EN > 0) && (OS_MAX_MEM_PART > 0)
 OS_EXT  OS_MEM           *OSMemFreeList;            /* Pointer to free list of memory partitions       */
 OS_EXT  OS_MEM            OSMemTbl[OS_MAX_MEM_PART];/* Storage for memory partition manager            */
@@ -1334,6 +1344,12 @@ INT8U         OS_TCBInit              (INT8U            prio,
                                        void            *pext,
                                        INT16U           opt);
 
+#if OS_TICK_WHEEL_EN > 0
+void          OS_TickWheelInsert      (OS_TCB          *ptcb);
+
+void          OS_TickWheelRemove      (OS_TCB          *ptcb);
+#endif
+
 #if OS_TMR_EN > 0
 void          OSTmr_Init              (void);
 #endif
@@ -1837,6 +1853,17 @@ void          OSCtxSw                 (void);
 #endif
 
 
+#ifndef OS_TICK_WHEEL_EN
+#error  "OS_CFG.H, Missing OS_TICK_WHEEL_EN: Keep delayed tasks in a timing wheel"
+#elif   OS_TICK_WHEEL_EN > 0
+    #ifndef OS_TICK_WHEEL_SIZE
+    #error  "OS_CFG.H, Missing OS_TICK_WHEEL_SIZE: Number of slots of the timing wheel"
+    #elif  (OS_TICK_WHEEL_SIZE & (OS_TICK_WHEEL_SIZE - 1)) != 0
+    #error  "OS_CFG.H, OS_TICK_WHEEL_SIZE must be a power of two"
+    #endif
+#endif
+
+
 #ifndef OS_TIME_TICK_HOOK_EN
 #error  "OS_CFG.H, Missing OS_TIME_TICK_HOOK_EN: Allows you to include the code for OSTimeTickHook() or not"
 #endif
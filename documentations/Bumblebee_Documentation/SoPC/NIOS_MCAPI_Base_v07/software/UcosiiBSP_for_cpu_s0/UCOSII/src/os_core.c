@@ -459,6 +459,9 @@ INT16U  OSEventPendMulti (OS_EVENT **pevents_pend, OS_EVENT **pevents_rdy, void
                                OS_STAT_MULTI;           /* ... pend on multiple events                 */
     OSTCBCur->OSTCBStatPend  = OS_STAT_PEND_OK;
     OSTCBCur->OSTCBDly       = timeout;                 /* Store pend timeout in TCB                   */
+#if OS_TICK_WHEEL_EN > 0
+    OS_TickWheelInsert(OSTCBCur);
+#endif
     OS_EventTaskWaitMulti(pevents_pend);                /* Suspend task until events or timeout occurs */
 
     OS_EXIT_CRITICAL();
@@ -851,6 +854,9 @@ void  OSStatInit (void)
 void  OSTimeTick (void)
 {
     OS_TCB    *ptcb;
+#if OS_TICK_WHEEL_EN > 0
+    OS_TCB    *pnext;
+#endif
 #if OS_TICK_STEP_EN > 0
     BOOLEAN    step;
 #endif
@@ -893,6 +899,32 @@ void  OSTimeTick (void)
             return;
         }
 #endif
+#if OS_TICK_WHEEL_EN > 0
+        OS_ENTER_CRITICAL();
+        OSTickWheelTime++;                                 /* Only the TCBs in the slot of this tick ...   */
+        ptcb = OSTickWheel[OSTickWheelTime & (OS_TICK_WHEEL_SIZE - 1)];  /* ... can expire              */
+        while (ptcb != (OS_TCB *)0) {
+            pnext = ptcb->OSTCBDlyNext;
+            if (ptcb->OSTCBDlyExpiry == OSTickWheelTime) { /* Skip TCBs of a later round of the wheel      */
+                OS_TickWheelRemove(ptcb);
+                ptcb->OSTCBDly = 0;
+                                                           /* Check for timeout                            */
+                if ((ptcb->OSTCBStat & OS_STAT_PEND_ANY) != OS_STAT_RDY) {
+                    ptcb->OSTCBStat  &= ~(INT8U)OS_STAT_PEND_ANY;              /* Yes, Clear status flag   */
+                    ptcb->OSTCBStatPend = OS_STAT_PEND_TO;                     /* Indicate PEND timeout    */
+                } else {
+                    ptcb->OSTCBStatPend = OS_STAT_PEND_OK;
+                }
+
+                if ((ptcb->OSTCBStat & OS_STAT_SUSPEND) == OS_STAT_RDY) {      /* Is task suspended?       */
+                    OSRdyGrp               |= ptcb->OSTCBBitY;                 /* No,  Make ready          */
+                    OSRdyTbl[ptcb->OSTCBY] |= ptcb->OSTCBBitX;
+                }
+            }
+            ptcb = pnext;                                  /* Point at next TCB in the slot                */
+        }
+        OS_EXIT_CRITICAL();
+#else
         ptcb = OSTCBList;                                  /* Point at first TCB in TCB list               */
         while (ptcb->OSTCBPrio != OS_TASK_IDLE_PRIO) {     /* Go through all TCBs in TCB list              */
             OS_ENTER_CRITICAL();
@@ -915,6 +947,7 @@ void  OSTimeTick (void)
             ptcb = ptcb->OSTCBNext;                        /* Point at next TCB in TCB list                */
             OS_EXIT_CRITICAL();
         }
+#endif
     }
 }
 
@@ -1017,6 +1050,9 @@ INT8U  OS_EventTaskRdy (OS_EVENT *pevent, void *pmsg, INT8U msk, INT8U pend_stat
 #endif
 
     ptcb                  =  OSTCBPrioTbl[prio];        /* Point to this task's OS_TCB                 */
+#if OS_TICK_WHEEL_EN > 0
+    OS_TickWheelRemove(ptcb);
+#endif
     ptcb->OSTCBDly        =  0;                         /* Prevent OSTimeTick() from readying task     */
 #if ((OS_Q_EN > 0) && (OS_MAX_QS > 0)) || (OS_MBOX_EN > 0)
     ptcb->OSTCBMsg        =  pmsg;                      /* Send message directly to waiting task       */
@@ -1312,6 +1348,11 @@ static  void  OS_InitMisc (void)
     OSCtxSwCtr    = 0;                                     /* Clear the context switch counter         */
     OSIdleCtr     = 0L;                                    /* Clear the 32-bit idle counter            */
 
+#if OS_TICK_WHEEL_EN > 0
+    OS_MemClr((INT8U *)&OSTickWheel[0], sizeof(OSTickWheel));  /* No task is delayed                   */
+    OSTickWheelTime = 0L;
+#endif
+
 #if OS_TASK_STAT_EN > 0
     OSIdleCtrRun  = 0L;
     OSIdleCtrMax  = 0L;
@@ -1942,6 +1983,11 @@ INT8U  OS_TCBInit (INT8U prio, OS_STK *ptos, OS_STK *pbos, INT16U id, INT32U stk
         ptcb->OSTCBStat          = OS_STAT_RDY;            /* Task is ready to run                     */
         ptcb->OSTCBStatPend      = OS_STAT_PEND_OK;        /* Clear pend status                        */
         ptcb->OSTCBDly           = 0;                      /* Task is not delayed                      */
+#if OS_TICK_WHEEL_EN > 0
+        ptcb->OSTCBDlyExpiry     = 0L;
+        ptcb->OSTCBDlyNext       = (OS_TCB *)0;
+        ptcb->OSTCBDlyPrev       = (OS_TCB *)0;
+#endif
 
 #if OS_TASK_CREATE_EXT_EN > 0
         ptcb->OSTCBExtPtr        = pext;                   /* Store pointer to TCB extension           */
@@ -2022,3 +2068,78 @@ INT8U  OS_TCBInit (INT8U prio, OS_STK *ptos, OS_STK *pbos, INT16U id, INT32U stk
     OS_EXIT_CRITICAL();
     return (OS_ERR_TASK_NO_MORE_TCB);
 }
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                   INSERT A DELAYED TASK INTO THE TIMING WHEEL
+*
+* Description: This function is called to link a TCB into the timing wheel after its OSTCBDly has been
+*              loaded.  The TCB is put into the slot of the tick at which the delay expires, so
+*              OSTimeTick() only looks at the TCBs of one slot instead of all TCBs.  A delay longer
+*              than OS_TICK_WHEEL_SIZE ticks stays in its slot for more than one round of the wheel.
+*
+* Arguments  : ptcb   is a pointer to the TCB of the task.  Nothing is done if its OSTCBDly is 0.
+*
+* Returns    : none
+*
+* Note(s)    : 1) This function is INTERNAL to uC/OS-II and your application should not call it.
+*              2) Interrupts are assumed to be disabled when calling this function.
+*              3) OSTCBDly is not decremented while the task is in the wheel, a non-zero OSTCBDly only
+*                 indicates that the task is delayed or waiting with a timeout.
+*********************************************************************************************************
+*/
+
+#if OS_TICK_WHEEL_EN > 0
+void  OS_TickWheelInsert (OS_TCB *ptcb)
+{
+    OS_TCB  **pslot;
+
+
+    if (ptcb->OSTCBDly == 0) {                             /* 0 means no timeout                       */
+        return;
+    }
+    ptcb->OSTCBDlyExpiry = OSTickWheelTime + ptcb->OSTCBDly;
+    pslot                = &OSTickWheel[ptcb->OSTCBDlyExpiry & (OS_TICK_WHEEL_SIZE - 1)];
+    ptcb->OSTCBDlyPrev   = (OS_TCB *)0;                    /* Link at the head of the slot             */
+    ptcb->OSTCBDlyNext   = *pslot;
+    if (*pslot != (OS_TCB *)0) {
+        (*pslot)->OSTCBDlyPrev = ptcb;
+    }
+    *pslot               = ptcb;
+}
+#endif
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                   REMOVE A DELAYED TASK FROM THE TIMING WHEEL
+*
+* Description: This function is called to unlink a TCB from the timing wheel before its OSTCBDly is
+*              cleared, i.e. when the task is readied by an event, resumed or deleted.
+*
+* Arguments  : ptcb   is a pointer to the TCB of the task.  Nothing is done if its OSTCBDly is 0.
+*
+* Returns    : none
+*
+* Note(s)    : 1) This function is INTERNAL to uC/OS-II and your application should not call it.
+*              2) Interrupts are assumed to be disabled when calling this function.
+*********************************************************************************************************
+*/
+
+#if OS_TICK_WHEEL_EN > 0
+void  OS_TickWheelRemove (OS_TCB *ptcb)
+{
+    if (ptcb->OSTCBDly == 0) {                             /* Task is not in the wheel                 */
+        return;
+    }
+    if (ptcb->OSTCBDlyPrev != (OS_TCB *)0) {
+        ptcb->OSTCBDlyPrev->OSTCBDlyNext = ptcb->OSTCBDlyNext;
+    } else {                                               /* First TCB of its slot                    */
+        OSTickWheel[ptcb->OSTCBDlyExpiry & (OS_TICK_WHEEL_SIZE - 1)] = ptcb->OSTCBDlyNext;
+    }
+    if (ptcb->OSTCBDlyNext != (OS_TCB *)0) {
+        ptcb->OSTCBDlyNext->OSTCBDlyPrev = ptcb->OSTCBDlyPrev;
+    }
+    ptcb->OSTCBDlyNext = (OS_TCB *)0;
+    ptcb->OSTCBDlyPrev = (OS_TCB *)0;
+}
+#endif
@@ -61,6 +61,9 @@ void  OSTimeDly (INT16U ticks)
             OSRdyGrp &= ~OSTCBCur->OSTCBBitY;
         }
         OSTCBCur->OSTCBDly = ticks;              /* Load ticks in TCB                                  */
+#if OS_TICK_WHEEL_EN > 0
+        OS_TickWheelInsert(OSTCBCur);
+#endif
         OS_EXIT_CRITICAL();
         OS_Sched();                              /* Find next task to run!                             */
     }
@@ -191,6 +194,9 @@ INT8U  OSTimeDlyResume (INT8U prio)
         return (OS_ERR_TIME_NOT_DLY);                          /* Indicate that task was not delayed   */
     }
 
+#if OS_TICK_WHEEL_EN > 0
+    OS_TickWheelRemove(ptcb);
+#endif
     ptcb->OSTCBDly = 0;                                        /* Clear the time delay                 */
     if ((ptcb->OSTCBStat & OS_STAT_PEND_ANY) != OS_STAT_RDY) {
         ptcb->OSTCBStat     &= ~OS_STAT_PEND_ANY;              /* Yes, Clear status flag               */
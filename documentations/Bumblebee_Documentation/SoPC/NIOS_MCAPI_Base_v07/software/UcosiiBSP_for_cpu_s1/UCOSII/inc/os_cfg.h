@@ -45,6 +45,9 @@ extern "C"
                                        /* ---------------------- MISCELLANEOUS ----------------------- */
 #define OS_APP_HOOKS_EN           1    /* Application-defined hooks are called from the uC/OS-II hooks */
 #define OS_EVENT_MULTI_EN         1    /* Include code for OSEventPendMulti()                          */
+#define OS_TICK_WHEEL_EN          1    /* Keep delayed tasks in a timing wheel instead of walking ...  */
+                                       /* ... all TCBs in OSTimeTick()                                 */
+#define OS_TICK_WHEEL_SIZE      128    /*     Number of slots of the timing wheel, a power of two      */
 
                                        /* -------------------- MESSAGE MAILBOXES --------------------- */
 #define OS_MBOX_PEND_ABORT_EN     1    /*     Include code for OSMboxPendAbort()                       */
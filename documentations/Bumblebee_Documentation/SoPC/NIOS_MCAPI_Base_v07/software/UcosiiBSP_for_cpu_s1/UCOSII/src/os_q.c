@@ -431,6 +431,9 @@ void  *OSQPend (OS_EVENT *pevent, INT16U timeout, INT8U *perr)
     OSTCBCur->OSTCBStat     |= OS_STAT_Q;        /* Task will have to pend for a message to be posted  */
     OSTCBCur->OSTCBStatPend  = OS_STAT_PEND_OK;
     OSTCBCur->OSTCBDly       = timeout;          /* Load timeout into TCB                              */
+#if OS_TICK_WHEEL_EN > 0
+    OS_TickWheelInsert(OSTCBCur);
+#endif
     OS_EventTaskWait(pevent);                    /* Suspend task until event or timeout occurs         */
     OS_EXIT_CRITICAL();
     OS_Sched();                                  /* Find next highest priority task ready to run       */